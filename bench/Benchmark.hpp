@@ -0,0 +1,110 @@
+#ifndef _BENCHMARK_HPP
+#define _BENCHMARK_HPP
+
+/**
+ * Helpers shared by the benchmarks in bench/, (build them with
+ * -DCMAKE_BUILD_TYPE=Release, the numbers of a Debug build mean little).
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <extras/interfaces.hpp>
+#include "../include/CppWallet/KeyPairIds.hpp"
+
+/**
+ * class Stopwatch
+ */
+
+class Stopwatch
+{
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+public:
+  void restart() { _start = std::chrono::steady_clock::now(); }
+  double seconds() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+  }
+  double nanosecondsPer(std::size_t count) const { return seconds() * 1e9 / double(count); }
+};
+
+/**
+ * keep the optimizer from dropping a computed value
+ */
+
+template<typename T>
+inline void keep(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * class KeyBytes
+ *
+ * Deterministic pseudo random key material, (xorshift64*).
+ */
+
+class KeyBytes
+{
+  std::uint64_t _state;
+
+public:
+  explicit KeyBytes(std::uint64_t seed) : _state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+  std::uint64_t next()
+  {
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    return _state * 0x2545F4914F6CDD1DULL;
+  }
+
+  std::string key(std::size_t length)
+  {
+    std::string bytes(length, '\0');
+    for (auto &byte : bytes) byte = static_cast<char>(next());
+    return bytes;
+  }
+};
+
+/**
+ * class BenchKeyPair
+ */
+
+class BenchKeyPair implements KeyPairInterface
+{
+  KeyPairId _keyPairId;
+  KeyPairId _publicKeyId;
+  KeyPairId _privateKeyId;
+  KeyPairPublicKey _publicKey;
+  KeyPairPrivateKey _privateKey;
+
+public:
+  BenchKeyPair(const KeyPairPublicKey &publicKey, const KeyPairPrivateKey &privateKey, KeyPairIdMode mode)
+    : _keyPairId(keyPairIdOf(publicKey, privateKey, mode)),
+      _publicKeyId(publicKeyIdOf(publicKey, mode)),
+      _privateKeyId(privateKeyIdOf(privateKey, mode)),
+      _publicKey(publicKey),
+      _privateKey(privateKey) {}
+
+  virtual KeyPairId generate(const KeyPairSeedList &) const override { return _keyPairId; };
+  virtual const KeyPairPublicKey &publicKey() const override { return _publicKey; };
+  virtual const KeyPairPrivateKey &privateKey() const override { return _privateKey; };
+
+  virtual const KeyPairId &keyPairId() const override { return _keyPairId; };
+  virtual const KeyPairId &publicKeyId() const override { return _publicKeyId; };
+  virtual const KeyPairId &privateKeyId() const override { return _privateKeyId; };
+};
+
+/**
+ * the first command line argument as a count, (or fallback)
+ */
+
+inline std::size_t countArgument(int argc, const char *argv[], std::size_t fallback)
+{
+  return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback;
+}
+
+#endif// _BENCHMARK_HPP
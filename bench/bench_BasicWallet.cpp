@@ -0,0 +1,79 @@
+/**
+ * bench-basicwallet [count]
+ *
+ * 10M retrieve() calls, (reading the publicKeyId of each KeyPair found),
+ * over a Wallet of count KeyPairs: through WalletInterface, (virtual, a
+ * Wallet and a WalletAdapter), and straight on a BasicWallet, (static,
+ * inlined). The default count keeps the tables in the cache, so that the
+ * cost of the calls is not hidden behind cache misses.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "../include/CppWallet/BasicWallet.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static constexpr size_t lookups = 10000000;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
+// not inlined, (the compiler must not see which WalletInterface it gets)
+NOINLINE static double virtualNanoseconds(const WalletInterface &wallet, const KeyPairIdVector &keyPairIds)
+{
+  long sum = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < lookups; ++i)
+    if (const KeyPairInterface *keyPair = wallet.tryRetrieve(keyPairIds[i % keyPairIds.size()])) sum += keyPair->publicKeyId();
+  keep(sum);
+  return stopwatch.nanosecondsPer(lookups);
+}
+
+template<typename Engine>
+static double staticNanoseconds(const Engine &wallet, const KeyPairIdVector &keyPairIds)
+{
+  long sum = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < lookups; ++i)
+    if (const KeyPairRecord *keyPair = wallet.tryRetrieve(keyPairIds[i % keyPairIds.size()])) sum += keyPair->publicKeyId();
+  keep(sum);
+  return stopwatch.nanosecondsPer(lookups);
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 100000);
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+
+  Wallet wallet(KeyPairIdMode::Hash64, count);
+  WalletAdapter<BasicWallet<StableStorage, Hash64KeyPairIds>> adapter(count);
+  BasicWallet<ContiguousStorage, Hash64KeyPairIds> contiguous(count);
+  for (const auto &keyPair : keyPairs) {
+    wallet.store(keyPair);
+    adapter.store(keyPair);
+    contiguous.store(keyPair);
+  }
+
+  // a shuffled order, the same for every candidate
+  KeyPairIdVector keyPairIds;
+  KeyBytes order(7);
+  for (size_t i = 0; i < count; ++i) keyPairIds.push_back(keyPairs[order.next() % count].keyPairId());
+
+  printf("%zu lookups over %zu KeyPairs\n\n", lookups, count);
+  printf("%-38s %12s\n", "", "retrieve ns");
+  printf("%-38s %12.1f\n", "Wallet, (virtual)", virtualNanoseconds(wallet, keyPairIds));
+  printf("%-38s %12.1f\n", "WalletAdapter<BasicWallet>, (virtual)", virtualNanoseconds(adapter, keyPairIds));
+  printf("%-38s %12.1f\n", "BasicWallet<StableStorage>", staticNanoseconds(adapter.engine(), keyPairIds));
+  printf("%-38s %12.1f\n", "BasicWallet<ContiguousStorage>", staticNanoseconds(contiguous, keyPairIds));
+  return 0;
+}
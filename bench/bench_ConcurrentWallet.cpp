@@ -0,0 +1,121 @@
+/**
+ * bench-concurrentwallet [count]
+ *
+ * Throughput of a 95/5 find/store-or-remove mix from 1 to 64 threads,
+ * ConcurrentWallet and EpochWallet against a Wallet behind a single
+ * reader-writer lock.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "../include/CppWallet/ConcurrentWallet.hpp"
+#include "../include/CppWallet/EpochWallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static constexpr size_t operationsPerThread = 200000;
+static constexpr size_t writerKeys = 1024;
+
+/**
+ * class LockedWallet
+ *
+ * The baseline: one lock around one Wallet.
+ */
+
+class LockedWallet
+{
+  mutable shared_mutex _lock;
+  Wallet _wallet;
+
+public:
+  explicit LockedWallet(KeyPairIdMode mode) : _wallet(mode) {}
+
+  const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+  {
+    shared_lock<shared_mutex> lock(_lock);
+    return _wallet.tryFindByPublicKeyId(publicKeyId);
+  }
+
+  void store(const KeyPairInterface &keyPair)
+  {
+    unique_lock<shared_mutex> lock(_lock);
+    _wallet.store(keyPair);
+  }
+
+  void remove(const KeyPairId &keyPairId)
+  {
+    unique_lock<shared_mutex> lock(_lock);
+    _wallet.remove(keyPairId);
+  }
+};
+
+template<typename Target>
+static double run(Target &target, const vector<BenchKeyPair> &preloaded, size_t threads)
+{
+  atomic<bool> go{ false };
+  vector<thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      KeyBytes bytes(1000 + t), order(t + 1);
+      vector<BenchKeyPair> own;
+      for (size_t i = 0; i < writerKeys; ++i) own.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+      size_t writes = 0, found = 0;
+      while (!go) this_thread::yield();
+      for (size_t i = 0; i < operationsPerThread; ++i) {
+        uint64_t r = order.next();
+        if (r % 100 < 95) {
+          found += target.tryFindByPublicKeyId(preloaded[(r >> 8) % preloaded.size()].publicKeyId()) != nullptr;
+        } else {
+          const BenchKeyPair &keyPair = own[(writes / 2) % writerKeys];
+          if (writes++ % 2 == 0)
+            target.store(keyPair);
+          else
+            target.remove(keyPair.keyPairId());
+        }
+      }
+      // leave the target as it was
+      if (writes % 2 == 1) target.remove(own[(writes / 2) % writerKeys].keyPairId());
+      keep(found);
+      EpochDomain::instance().quiesce();
+    });
+  }
+  Stopwatch stopwatch;
+  go = true;
+  for (auto &worker : workers) worker.join();
+  return double(threads * operationsPerThread) / stopwatch.seconds() / 1e6;
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> preloaded;
+  preloaded.reserve(count);
+  for (size_t i = 0; i < count; ++i) preloaded.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+
+  ConcurrentWallet concurrent(KeyPairIdMode::Hash64);
+  EpochWallet epoch(KeyPairIdMode::Hash64);
+  LockedWallet locked(KeyPairIdMode::Hash64);
+  for (const auto &keyPair : preloaded) {
+    concurrent.store(keyPair);
+    epoch.store(keyPair);
+    locked.store(keyPair);
+  }
+
+  printf("%zu keys, %u hardware threads, 95%% finds, 5%% stores/removes\n", count, thread::hardware_concurrency());
+  printf("%8s %18s %18s %18s\n", "threads", "ConcurrentWallet", "EpochWallet", "single lock");
+  printf("%8s %18s %18s %18s\n", "", "Mops/s", "Mops/s", "Mops/s");
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    double sharded = run(concurrent, preloaded, threads);
+    double lockFree = run(epoch, preloaded, threads);
+    printf("%8zu %18.2f %18.2f %18.2f\n", threads, sharded, lockFree, run(locked, preloaded, threads));
+  }
+  return 0;
+}
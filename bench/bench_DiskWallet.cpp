@@ -0,0 +1,68 @@
+/**
+ * bench-diskwallet [count] [direct]
+ *
+ * Random findManyByPublicKeyId() lookups on a DiskWallet of count
+ * KeyPairs, (page reads per second), at queue depths from 1 to 256,
+ * with blocking pread() against io_uring. With direct, (1), the file is
+ * read with O_DIRECT, so every lookup goes to the device, (put the file
+ * on the NVMe to measure, O_DIRECT is refused by tmpfs).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/DiskWallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static double readsPerSecond(const string &path, IoBackendKind backend, unsigned queueDepth, bool direct,
+  const vector<BenchKeyPair> &keyPairs)
+{
+  DiskWalletOptions options;
+  options.backend = backend;
+  options.queueDepth = queueDepth;
+  options.direct = direct;
+  DiskWallet disk(path, options);
+  KeyBytes order(queueDepth);
+  KeyPairIdVector publicKeyIds;
+  KeyPairBatch results;
+  size_t found = 0, lookups = max<size_t>(4096, 64 * queueDepth);
+  for (size_t i = 0; i < lookups; ++i) publicKeyIds.push_back(keyPairs[order.next() % keyPairs.size()].publicKeyId());
+  Stopwatch stopwatch;
+  disk.findManyByPublicKeyId(publicKeyIds, results);
+  double seconds = stopwatch.seconds();
+  for (const KeyPairInterface *keyPair : results) found += keyPair != nullptr;
+  keep(found);
+  return double(disk.reads()) / seconds;
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  bool direct = argc > 2 && atoi(argv[2]) != 0;
+  string path = "bench-diskwallet.wallet";
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+  WalletFileWriter writer(KeyPairIdMode::Hash64);
+  writer.reserve(count);
+  for (const auto &keyPair : keyPairs) writer.add(keyPair);
+  writer.write(path);
+
+  auto uring = makeIoBackend(IoBackendKind::Uring, 1);
+  printf("%zu KeyPairs, %s, io_uring %s\n", count, direct ? "O_DIRECT" : "page cache",
+    uring->kind() == IoBackendKind::Uring ? "available" : "not available, (pread fallback)");
+  printf("%8s %14s %14s\n", "depth", "pread", "io_uring");
+  printf("%8s %14s %14s\n", "", "reads/s", "reads/s");
+  for (unsigned depth = 1; depth <= 256; depth *= 2) {
+    double blocking = readsPerSecond(path, IoBackendKind::Pread, depth, direct, keyPairs);
+    double batched = readsPerSecond(path, IoBackendKind::Uring, depth, direct, keyPairs);
+    printf("%8u %14.0f %14.0f\n", depth, blocking, batched);
+  }
+  remove(path.c_str());
+  return 0;
+}
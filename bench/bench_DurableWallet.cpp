@@ -0,0 +1,135 @@
+/**
+ * bench-durablewallet [stores] [commitDelay]
+ *
+ * Durable store() throughput from 1 to 64 threads, each storing
+ * stores/threads KeyPairs, with the fdatasync() count, (how many callers
+ * group commit put behind each one). commitDelay is in microseconds.
+ *
+ * Then compaction: the time to open a Wallet whose log has seen 64
+ * stores per KeyPair, (a churning Wallet of 16 * stores KeyPairs),
+ * before and after compact(), and find throughput while it runs.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "../include/CppWallet/DurableWallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static double findsPerSecond(const DurableWallet &wallet, const vector<BenchKeyPair> &keyPairs, const atomic<bool> &done)
+{
+  KeyBytes order(3);
+  size_t finds = 0, found = 0;
+  Stopwatch stopwatch;
+  do {
+    for (int i = 0; i < 1000; ++i, ++finds)
+      found += wallet.tryFindByPublicKey(keyPairs[order.next() % keyPairs.size()].publicKey()) != nullptr;
+  } while (!done);
+  keep(found);
+  EpochDomain::instance().quiesce();
+  return double(finds) / stopwatch.seconds();
+}
+
+static void compaction(const string &directory, size_t count)
+{
+  WalletLogOptions unsynced;
+  unsynced.sync = false;
+  WalletCompactionOptions manual;
+  manual.background = false;
+  KeyBytes bytes(2);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Hash64, unsynced, manual);
+    for (const auto &keyPair : keyPairs) wallet.store(keyPair);
+    for (int round = 1; round < 64; ++round)
+      for (size_t i = round % 16; i < count; i += 16) {
+        wallet.remove(keyPairs[i].keyPairId());
+        wallet.store(keyPairs[i]);
+      }
+  }
+
+  double openMs, compactMs, idle = 0, compacting = 0;
+  uint64_t entries;
+  {
+    Stopwatch opening;
+    DurableWallet wallet(directory, KeyPairIdMode::Hash64, unsynced, manual);
+    openMs = opening.seconds() * 1e3;
+    entries = wallet.log().lastSequence();
+
+    atomic<bool> done{ false };
+    thread finder([&] { idle = findsPerSecond(wallet, keyPairs, done); });
+    this_thread::sleep_for(chrono::milliseconds(200));
+    done = true;
+    finder.join();
+    done = false;
+    finder = thread([&] { compacting = findsPerSecond(wallet, keyPairs, done); });
+    Stopwatch compactor;
+    wallet.compact();
+    compactMs = compactor.seconds() * 1e3;
+    done = true;
+    finder.join();
+  }
+
+  Stopwatch reopening;
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Hash64, unsynced, manual);
+    keep(wallet.size());
+  }
+  double reopenMs = reopening.seconds() * 1e3;
+
+  printf("\n%zu KeyPairs, %llu log entries, compaction at %llu MiB/s\n", count,
+    static_cast<unsigned long long>(entries), static_cast<unsigned long long>(manual.bytesPerSecond >> 20));
+  printf("open %.1f ms before compact(), %.1f ms after, compact() %.1f ms\n", openMs, reopenMs, compactMs);
+  printf("finds/s idle %.0f, while compacting %.0f\n", idle, compacting);
+  ::unlink((directory + "/" + DurableWallet::checkpointName).c_str());
+  ::unlink((directory + "/" + DurableWallet::segmentName(entries + 1)).c_str());
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t stores = countArgument(argc, argv, 4096);
+  WalletLogOptions options;
+  options.commitDelay = chrono::microseconds(argc > 2 ? strtoull(argv[2], nullptr, 10) : 0);
+  string directory = "bench-durablewallet";
+  string path = directory + "/" + DurableWallet::segmentName(1);
+
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(stores);
+  for (size_t i = 0; i < stores; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+
+  printf("%zu stores, commitDelay %lld us\n", stores, static_cast<long long>(options.commitDelay.count()));
+  printf("%8s %14s %12s %16s\n", "threads", "stores/s", "fdatasyncs", "stores/fdatasync");
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    ::unlink(path.c_str());
+    DurableWallet wallet(directory, KeyPairIdMode::Hash64, options);
+    atomic<bool> go{ false };
+    vector<thread> storers;
+    for (size_t t = 0; t < threads; ++t)
+      storers.emplace_back([&, t] {
+        while (!go) this_thread::yield();
+        for (size_t i = t; i < stores; i += threads) wallet.store(keyPairs[i]);
+      });
+    Stopwatch stopwatch;
+    go = true;
+    for (auto &storer : storers) storer.join();
+    double seconds = stopwatch.seconds();
+    uint64_t syncs = wallet.log().syncCount();
+    printf("%8zu %14.0f %12llu %16.1f\n", threads, double(stores) / seconds,
+      static_cast<unsigned long long>(syncs), double(stores) / double(syncs));
+    EpochDomain::instance().quiesce();
+  }
+  ::unlink(path.c_str());
+  compaction(directory, 16 * stores);
+  ::rmdir(directory.c_str());
+  return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * bench-frozenwallet [count]
+ *
+ * Time to freeze a Wallet of count KeyPairs, (building its perfect
+ * hashes), to load the frozen file, and the findByPublicKey() and
+ * retrieve() latency of the FrozenWallet against the Wallet and a
+ * MappedWallet of the same KeyPairs, with the memory of each.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include "../include/CppWallet/FrozenWallet.hpp"
+#include "../include/CppWallet/MappedWallet.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static double fileMiB(const string &path)
+{
+  struct stat status;
+  return ::stat(path.c_str(), &status) == 0 ? double(status.st_size) / (1 << 20) : 0;
+}
+
+template<typename Target>
+static double findNanoseconds(const Target &wallet, const vector<BenchKeyPair> &keyPairs)
+{
+  KeyBytes order(7);
+  size_t found = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < keyPairs.size(); ++i)
+    found += wallet.tryFindByPublicKey(keyPairs[order.next() % keyPairs.size()].publicKey()) != nullptr;
+  keep(found);
+  return stopwatch.nanosecondsPer(keyPairs.size());
+}
+
+template<typename Target>
+static double retrieveNanoseconds(const Target &wallet, const vector<BenchKeyPair> &keyPairs)
+{
+  KeyBytes order(11);
+  size_t found = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < keyPairs.size(); ++i)
+    found += wallet.tryRetrieve(keyPairs[order.next() % keyPairs.size()].keyPairId()) != nullptr;
+  keep(found);
+  return stopwatch.nanosecondsPer(keyPairs.size());
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  string walletPath = "bench-frozenwallet.wallet", frozenPath = "bench-frozenwallet.frozen";
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+  Wallet wallet(KeyPairIdMode::Hash64, count);
+  for (const auto &keyPair : keyPairs) wallet.store(keyPair);
+
+  Stopwatch freezing;
+  size_t frozenBytes;
+  {
+    FrozenWallet frozen(wallet, KeyPairIdMode::Hash64);
+    frozenBytes = frozen.memorySize();
+    printf("%zu KeyPairs frozen in %.1f ms\n", count, freezing.seconds() * 1e3);
+    frozen.write(frozenPath);
+  }
+  WalletFileWriter writer(KeyPairIdMode::Hash64);
+  writer.addAll(wallet);
+  writer.write(walletPath);
+
+  Stopwatch loading;
+  FrozenWallet frozen(frozenPath);
+  printf("frozen file loaded in %.3f ms\n\n", loading.seconds() * 1e3);
+  MappedWallet mapped(walletPath);
+
+  printf("%-14s %12s %12s %12s\n", "", "find ns", "retrieve ns", "MiB");
+  printf("%-14s %12.1f %12.1f %12s\n", "Wallet", findNanoseconds(wallet, keyPairs), retrieveNanoseconds(wallet, keyPairs), "-");
+  printf("%-14s %12.1f %12.1f %12.1f\n", "MappedWallet", findNanoseconds(mapped, keyPairs), retrieveNanoseconds(mapped, keyPairs),
+    fileMiB(walletPath));
+  printf("%-14s %12.1f %12.1f %12.1f\n", "FrozenWallet", findNanoseconds(frozen, keyPairs), retrieveNanoseconds(frozen, keyPairs),
+    double(frozenBytes) / (1 << 20));
+  remove(walletPath.c_str());
+  remove(frozenPath.c_str());
+  return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * bench-hdkeychain [count]
+ *
+ * An address-gap scan: the KeyPairs of the first count children, (default
+ * 2000), of m/44'/0'/0'/0, each derived from the root, (hdMasterKey() and
+ * a walk of the whole path, what a chain without a cache does), against
+ * HdKeyChain::derive(), (the path once, then one step a child).
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "../include/CppWallet/HdKeyChain.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 2000);
+  KeyBytes bytes(1);
+  string seed = bytes.key(32);
+  HdPath receive = hdPath("m/44'/0'/0'/0");
+
+  printf("%zu children of %s\n\n", count, hdPathText(receive).c_str());
+  printf("%-38s %12s %12s\n", "", "us each", "child steps");
+
+  Stopwatch stopwatch;
+  HdExtendedKey key, child;
+  for (size_t i = 0; i < count; ++i) {
+    hdMasterKey(seed.data(), seed.size(), key);
+    for (uint32_t index : receive) {
+      hdChildKey(key, index, child);
+      key = child;
+    }
+    hdChildKey(key, uint32_t(i), child);
+    keep(child.publicKey[1]);
+  }
+  printf("%-38s %12.1f %12zu\n", "from the root", stopwatch.seconds() * 1e6 / double(count), count * (receive.size() + 1));
+
+  HdKeyChain chain(seed);
+  vector<KeyPair> keyPairs;
+  stopwatch.restart();
+  chain.derive(receive, 0, count, keyPairs);
+  printf("%-38s %12.1f %12llu\n", "HdKeyChain::derive()", stopwatch.seconds() * 1e6 / double(count),
+    static_cast<unsigned long long>(chain.stats().childSteps));
+  return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * bench-keypairgenerator [count]
+ *
+ * KeyPairGenerator making count KeyPairs, (default 100K), each from its
+ * own list of seeds, with 1, 2, 4, ... threads up to the hardware's, and
+ * what each step of making one costs on a single thread: the entropy,
+ * the SHA-256 of the seeds, the public key, (secp256k1), and the ids.
+ * The entropy is drawn three ways: a getrandom() per KeyPair, one per
+ * chunk of 256, and from the thread's EntropyPool, (what
+ * KeyPairGenerator does).
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/random.h>
+
+#include "../include/CppWallet/EntropyPool.hpp"
+#include "../include/CppWallet/KeyPairGenerator.hpp"
+#include "../include/CppWallet/KeyPairIds.hpp"
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "../include/CppWallet/Sha256.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+template<typename Step>
+static void measureStep(const char *name, size_t count, Step &&step, size_t keyPairsPerStep = 1)
+{
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < count; ++i) step(i);
+  printf("%-38s %12.1f\n", name, stopwatch.nanosecondsPer(count * keyPairsPerStep));
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 100000);
+  vector<KeyPairSeedList> seedLists;
+  seedLists.reserve(count);
+  for (size_t n = 0; n < count; ++n) seedLists.push_back({ "onboarding", to_string(n) });
+
+  unsigned hardware = max(1u, thread::hardware_concurrency());
+  printf("%zu KeyPairs, %u hardware threads\n\n", count, hardware);
+  printf("%-38s %12s %12s %12s\n", "", "KeyPairs/s", "ns each", "scaling");
+  double single = 0;
+  for (unsigned threads = 1;; threads = min(hardware, threads * 2)) {
+    KeyPairGenerator generator(KeyPairGeneratorOptions{ threads, KeyPairIdMode::Crc32, 256, false });
+    vector<KeyPair> keyPairs;
+    Stopwatch stopwatch;
+    generator.generate(seedLists, keyPairs);
+    double seconds = stopwatch.seconds();
+    keep(keyPairs.back().keyPairId());
+    if (threads == 1) single = seconds;
+    string name = "KeyPairGenerator, " + to_string(threads) + " thread" + (threads > 1 ? "s" : "");
+    printf("%-38s %12.0f %12.1f %11.2fx\n", name.c_str(), double(count) / seconds, seconds * 1e9 / double(count), single / seconds);
+    if (threads == hardware) break;
+  }
+
+  size_t steps = min<size_t>(count, 20000);
+  uint8_t entropy[32 * 256];
+  uint8_t publicKey[secp256k1PublicKeyBytes];
+  Sha256Digest privateKey = sha256("onboarding");
+  printf("\n%-38s %12s\n", "one thread, per KeyPair", "ns");
+  measureStep("getrandom(), 32 bytes", steps, [&](size_t) { keep(::getrandom(entropy, 32, 0)); });
+  measureStep("getrandom(), 8 KiB a chunk of 256", steps / 256 + 1,
+    [&](size_t) { keep(::getrandom(entropy, sizeof(entropy), 0)); }, 256);
+  measureStep("EntropyPool, 32 bytes", steps, [&](size_t) { randomBytes(entropy, 32); });
+  measureStep("SHA-256 of the seeds", steps, [&](size_t i) {
+    Sha256 hash;
+    hash.update(entropy, 32);
+    for (const auto &seed : seedLists[i]) hash.update(seed);
+    privateKey = hash.finish();
+    keep(privateKey);
+  });
+  measureStep("secp256k1 public key", steps, [&](size_t) {
+    keep(secp256k1PublicKey(privateKey.data(), publicKey));
+    privateKey[0] = publicKey[1] & 0x7F;
+  });
+  KeyPairPublicKey key(string_view(reinterpret_cast<const char *>(publicKey), sizeof(publicKey)));
+  measureStep("ids, (CRC32)", steps, [&](size_t) { keep(publicKeyIdOf(key, KeyPairIdMode::Crc32)); });
+  return 0;
+}
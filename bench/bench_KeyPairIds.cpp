@@ -0,0 +1,87 @@
+/**
+ * bench-keypairids [count]
+ *
+ * Collision rate and findByPublicKey() latency of the CRC32 and the
+ * Hash64 KeyPairId modes, (33 byte public keys, 32 byte private keys).
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static size_t collisions(vector<KeyPairId> ids)
+{
+  sort(ids.begin(), ids.end());
+  return ids.size() - size_t(unique(ids.begin(), ids.end()) - ids.begin());
+}
+
+static void run(const char *name, KeyPairIdMode mode, const vector<string> &publicKeys, const vector<string> &privateKeys)
+{
+  size_t count = publicKeys.size();
+  vector<KeyPairId> publicKeyIds, keyPairIds;
+  publicKeyIds.reserve(count);
+  keyPairIds.reserve(count);
+  Stopwatch hashing;
+  for (size_t i = 0; i < count; ++i) publicKeyIds.push_back(publicKeyIdOf(publicKeys[i], mode));
+  double hashNs = hashing.nanosecondsPer(count);
+  for (size_t i = 0; i < count; ++i) keyPairIds.push_back(keyPairIdOf(publicKeys[i], privateKeys[i], mode));
+
+  Wallet wallet(mode, count);
+  size_t rejected = 0;
+  for (size_t i = 0; i < count; ++i) {
+    try {
+      wallet.store(BenchKeyPair(publicKeys[i], privateKeys[i], mode));
+    } catch (const KeyPairAlreadyExistsException &) {
+      ++rejected;
+    }
+  }
+
+  KeyBytes order(7);
+  size_t lookups = count, found = 0;
+  Stopwatch finding;
+  for (size_t i = 0; i < lookups; ++i) {
+    try {
+      found += wallet.findByPublicKey(publicKeys[order.next() % count]).publicKey().size();
+    } catch (const KeyPairNotFoundException &) {
+    }
+  }
+  double findNs = finding.nanosecondsPer(lookups);
+  keep(found);
+
+  printf("%-8s %10zu %14zu %14zu %12zu %10.1f %12.1f\n",
+    name,
+    count,
+    collisions(publicKeyIds),
+    collisions(keyPairIds),
+    rejected,
+    hashNs,
+    findNs);
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  KeyBytes bytes(1);
+  vector<string> publicKeys, privateKeys;
+  for (size_t i = 0; i < count; ++i) {
+    publicKeys.push_back(bytes.key(33));
+    privateKeys.push_back(bytes.key(32));
+  }
+  printf("%-8s %10s %14s %14s %12s %10s %12s\n",
+    "mode",
+    "keys",
+    "publicKeyId",
+    "keyPairId",
+    "rejected",
+    "hash ns",
+    "find ns");
+  printf("%-8s %10s %14s %14s %12s %10s %12s\n", "", "", "collisions", "collisions", "stores", "", "");
+  run("crc32", KeyPairIdMode::Crc32, publicKeys, privateKeys);
+  run("hash64", KeyPairIdMode::Hash64, publicKeys, privateKeys);
+  return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * bench-mappedwallet [count]
+ *
+ * Time to get a Wallet file of count KeyPairs ready for lookups, mapping
+ * it with MappedWallet against reloading every KeyPair into a Wallet,
+ * and the findByPublicKey() latency of both afterwards.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/MappedWallet.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+template<typename Target>
+static double findNanoseconds(const Target &wallet, const vector<BenchKeyPair> &keyPairs)
+{
+  KeyBytes order(7);
+  size_t found = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < keyPairs.size(); ++i)
+    found += wallet.tryFindByPublicKey(keyPairs[order.next() % keyPairs.size()].publicKey()) != nullptr;
+  keep(found);
+  return stopwatch.nanosecondsPer(keyPairs.size());
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  string path = "bench-mappedwallet.wallet";
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+
+  Stopwatch writing;
+  WalletFileWriter writer(KeyPairIdMode::Hash64);
+  writer.reserve(count);
+  for (const auto &keyPair : keyPairs) writer.add(keyPair);
+  writer.write(path);
+  printf("%zu KeyPairs written in %.1f ms\n\n", count, writing.seconds() * 1e3);
+
+  Stopwatch mapping;
+  MappedWallet mapped(path);
+  double mapMs = mapping.seconds() * 1e3;
+
+  Stopwatch loading;
+  Wallet loaded(KeyPairIdMode::Hash64, count);
+  {
+    MappedWallet file(path);
+    KeyPairIdVector page;
+    for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+      cursor = file.listPage(cursor, 4096, page);
+      for (KeyPairId keyPairId : page) loaded.store(file.retrieve(keyPairId));
+    }
+  }
+  double loadMs = loading.seconds() * 1e3;
+
+  printf("%-14s %12s %12s\n", "", "open ms", "find ns");
+  printf("%-14s %12.3f %12.1f\n", "MappedWallet", mapMs, findNanoseconds(mapped, keyPairs));
+  printf("%-14s %12.3f %12.1f\n", "Wallet reload", loadMs, findNanoseconds(loaded, keyPairs));
+  remove(path.c_str());
+  return 0;
+}
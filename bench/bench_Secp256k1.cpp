@@ -0,0 +1,64 @@
+/**
+ * bench-secp256k1 [count]
+ *
+ * Public keys derived per second from count private keys, (default 20K),
+ * by each Secp256k1Engine on one thread, then by the comb on every core,
+ * (a thread per core, each deriving count keys), and the time it takes
+ * to make the comb table.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+// count valid private keys, each derived from the public key before it
+static void derive(Secp256k1Engine engine, size_t count, uint64_t seed)
+{
+  KeyBytes bytes(seed);
+  uint8_t privateKey[secp256k1PrivateKeyBytes], publicKey[secp256k1PublicKeyBytes];
+  string key = bytes.key(sizeof(privateKey));
+  copy(key.begin(), key.end(), privateKey);
+  privateKey[0] &= 0x7F;
+  for (size_t i = 0; i < count; ++i) {
+    keep(secp256k1PublicKeyWith(engine, privateKey, publicKey));
+    copy(publicKey + 1, publicKey + 1 + sizeof(privateKey), privateKey);
+    privateKey[0] &= 0x7F;
+  }
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 20000);
+  unsigned cores = max(1u, thread::hardware_concurrency());
+
+  Stopwatch stopwatch;
+  secp256k1Precompute();
+  printf("comb table made in %.2f ms\n\n", stopwatch.seconds() * 1e3);
+
+  printf("%-38s %12s %12s\n", "", "keys/s", "us each");
+  for (auto engine : { Secp256k1Engine::Window, Secp256k1Engine::Comb }) {
+    stopwatch.restart();
+    derive(engine, count, 1);
+    double seconds = stopwatch.seconds();
+    printf("%-38s %12.0f %12.2f\n", engine == Secp256k1Engine::Comb ? "Comb, 1 thread" : "Window, 1 thread",
+      double(count) / seconds, seconds * 1e6 / double(count));
+  }
+
+  vector<thread> threads;
+  stopwatch.restart();
+  for (unsigned core = 0; core < cores; ++core)
+    threads.emplace_back([count, core] { derive(Secp256k1Engine::Comb, count, core + 2); });
+  for (auto &thread : threads) thread.join();
+  double seconds = stopwatch.seconds();
+  string name = "Comb, " + to_string(cores) + " thread" + (cores > 1 ? "s" : "");
+  printf("%-38s %12.0f %12.2f  (%.0f keys/s per core)\n", name.c_str(), double(count) * cores / seconds,
+    seconds * 1e6 / double(count), double(count) / seconds);
+  return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * bench-walletfilter [count]
+ *
+ * The findByPublicKey() latency of a Wallet of count KeyPairs when most
+ * of the keys looked up are not in it, (as in a block scan), without a
+ * BloomFilter and with filters of a few false positive rates.
+ *
+ * The missing keys come from a small pool, (hot in the cache, as the keys
+ * of the block being scanned are), so the cost measured is the Wallet's.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+static constexpr size_t lookups = 2000000;
+static constexpr unsigned hitsPerMille = 10;
+
+static double findNanoseconds(const Wallet &wallet, const vector<BenchKeyPair> &keyPairs, const vector<string> &misses)
+{
+  KeyBytes order(7);
+  size_t found = 0;
+  Stopwatch stopwatch;
+  for (size_t i = 0; i < lookups; ++i) {
+    uint64_t pick = order.next();
+    if (pick % 1000 < hitsPerMille)
+      found += wallet.tryFindByPublicKey(keyPairs[(pick >> 10) % keyPairs.size()].publicKey()) != nullptr;
+    else
+      found += wallet.tryFindByPublicKey(misses[(pick >> 10) % misses.size()]) != nullptr;
+  }
+  keep(found);
+  return stopwatch.nanosecondsPer(lookups);
+}
+
+static void run(const char *name, Wallet &wallet, const vector<BenchKeyPair> &keyPairs, const vector<string> &misses)
+{
+  for (const auto &keyPair : keyPairs) wallet.store(keyPair);
+  WalletStats stats = wallet.stats();
+  printf("%-12s %12.1f %12.2f %12.5f\n", name, findNanoseconds(wallet, keyPairs, misses),
+    double(stats.filterBytes) / double(1 << 20), stats.filterFalsePositiveRate);
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+  vector<string> misses;
+  for (size_t i = 0; i < 4096; ++i) misses.push_back(bytes.key(33));
+
+  printf("%zu KeyPairs, %u in 1000 lookups hit\n\n", count, hitsPerMille);
+  printf("%-12s %12s %12s %12s\n", "", "find ns", "filter MiB", "filter fpr");
+  {
+    Wallet wallet(KeyPairIdMode::Hash64, count);
+    run("no filter", wallet, keyPairs, misses);
+  }
+  for (double rate : { 0.1, 0.01, 0.001 }) {
+    char name[32];
+    snprintf(name, sizeof(name), "fpr %g", rate);
+    Wallet wallet(KeyPairIdMode::Hash64, count, BloomFilterOptions{ rate, 0 });
+    run(name, wallet, keyPairs, misses);
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * bench-walletimport [count]
+ *
+ * A bulk import of count KeyPairs, (default 1M), followed by closing the
+ * Wallet: records in a std::deque of std::optional, (what Wallet used to
+ * do, BasicWallet<StableStorage>), against records in the slabs of a
+ * RecordArena, (Wallet, BasicWallet<ArenaStorage>), with the default
+ * resource, (new and delete), a std::pmr::monotonic_buffer_resource and
+ * a LockedMemoryResource for the records, (the indexes on the heap).
+ * Every candidate is presized, so that only the records are measured.
+ */
+
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "../include/CppWallet/BasicWallet.hpp"
+#include "../include/CppWallet/LockedMemory.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "Benchmark.hpp"
+
+using namespace std;
+
+template<typename Make>
+static void measure(const char *name, const vector<BenchKeyPair> &keyPairs, Make &&make)
+{
+  Stopwatch stopwatch;
+  auto wallet = make();
+  for (const auto &keyPair : keyPairs) wallet->store(keyPair);
+  double store = stopwatch.nanosecondsPer(keyPairs.size());
+  keep(wallet->size());
+  stopwatch.restart();
+  wallet.reset();
+  printf("%-38s %12.1f %12.2f\n", name, store, stopwatch.seconds() * 1e3);
+}
+
+int main(int argc, const char *argv[])
+{
+  size_t count = countArgument(argc, argv, 1000000);
+  KeyBytes bytes(1);
+  vector<BenchKeyPair> keyPairs;
+  keyPairs.reserve(count);
+  for (size_t i = 0; i < count; ++i) keyPairs.emplace_back(bytes.key(33), bytes.key(32), KeyPairIdMode::Hash64);
+
+  printf("%zu KeyPairs\n\n", count);
+  printf("%-38s %12s %12s\n", "", "store ns", "close ms");
+  measure("BasicWallet<StableStorage>", keyPairs,
+    [count] { return make_unique<BasicWallet<StableStorage, Hash64KeyPairIds>>(count); });
+  measure("BasicWallet<ArenaStorage>", keyPairs,
+    [count] { return make_unique<BasicWallet<ArenaStorage, Hash64KeyPairIds>>(count); });
+  measure("Wallet", keyPairs,
+    [count] { return make_unique<Wallet>(KeyPairIdMode::Hash64, count); });
+  {
+    pmr::monotonic_buffer_resource import;
+    measure("Wallet, (monotonic_buffer_resource)", keyPairs,
+      [count, &import] { return make_unique<Wallet>(KeyPairIdMode::Hash64, count, &import); });
+  }
+  {
+    LockedMemoryResource locked;
+    measure("Wallet, (LockedMemoryResource)", keyPairs,
+      [count, &locked] { return make_unique<Wallet>(KeyPairIdMode::Hash64, count, &locked, pmr::get_default_resource()); });
+  }
+  return 0;
+}
@@ -0,0 +1,430 @@
+#ifndef _BASICWALLET_HPP
+#define _BASICWALLET_HPP
+
+/**
+ * @brief BasicWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that every WalletInterface and KeyPairInterface call is virtual
+ * WHEN a tight loop looks up millions of KeyPairs and reads their ids
+ * THEN it should be able to use a Wallet whose calls the compiler sees
+ *      through, (inlined, no dispatch), and still hand that same Wallet
+ *      to code that wants a WalletInterface, (see WalletAdapter)
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "KeyPairIds.hpp"
+#include "KeyPairIndex.hpp"
+#include "KeyPair.hpp"
+#include "KeyPairRecord.hpp"
+#include "RecordArena.hpp"
+#include "WalletInterface.hpp"
+
+/**
+  * @brief Crc32KeyPairIds, Hash64KeyPairIds
+  *
+  * The hashing policies of a BasicWallet: how ids are derived from keys,
+  * (KeyPairIdMode::Crc32 and KeyPairIdMode::Hash64 of KeyPairIds.hpp,
+  * fixed at compile time).
+  *
+  */
+struct Crc32KeyPairIds
+{
+  static constexpr KeyPairIdMode mode = KeyPairIdMode::Crc32;
+  static KeyPairId publicKeyId(std::string_view publicKey) { return static_cast<KeyPairId>(crc32(publicKey)); }
+  static KeyPairId privateKeyId(std::string_view privateKey) { return static_cast<KeyPairId>(crc32(privateKey)); }
+};
+
+struct Hash64KeyPairIds
+{
+  static constexpr KeyPairIdMode mode = KeyPairIdMode::Hash64;
+  static KeyPairId publicKeyId(std::string_view publicKey) { return static_cast<KeyPairId>(hash64(publicKey)); }
+  static KeyPairId privateKeyId(std::string_view privateKey) { return static_cast<KeyPairId>(hash64(privateKey)); }
+};
+
+/**
+  * @brief StableStorage, ContiguousStorage, ArenaStorage
+  *
+  * The storage policies of a BasicWallet, (slots recycled after erase()):
+  *
+  *   StableStorage     - records in a std::deque: a record never moves,
+  *                       references stay valid until it is removed
+  *   ContiguousStorage - records in one std::vector, (denser, faster to
+  *                       scan), but a store() may move every record, so
+  *                       references are only good until the next store()
+  *   ArenaStorage      - records in the slabs of a RecordArena, as Wallet
+  *                       keeps them, (stable too, one allocation per
+  *                       slabRecords records)
+  *
+  * All three keep the records in lockedMemoryResource(), (see
+  * LockedMemory.hpp), and wipe an erased record that owns nothing, (a
+  * KeyPair or a KeyPairRecord), in place. Whole records are locked, so
+  * past RLIMIT_MEMLOCK they go on unlocked, (counted in
+  * lockedMemoryResource()->stats().lockFailures).
+  *
+  */
+template<typename Record, bool Stable>
+class SlotStorage
+{
+  // records that own nothing are kept bare, (an erased one is wiped and
+  // made again when its slot is reused), with a byte per slot saying which
+  // are in use: no std::optional flag padded out to the alignment of the
+  // record
+  static constexpr bool bare = std::is_trivially_destructible<Record>::value && std::is_copy_assignable<Record>::value;
+  using Element = std::conditional_t<bare, Record, std::optional<Record>>;
+  using Container = std::conditional_t<Stable, std::pmr::deque<Element>, std::pmr::vector<Element>>;
+
+  Container _slots{ lockedMemoryResource() };
+  std::vector<std::uint8_t> _used;
+  std::vector<KeyPairIndex::Slot> _freeSlots;
+
+  static const Record &get(const Element &element)
+  {
+    if constexpr (bare) return element;
+    else return *element;
+  }
+
+public:
+  using Slot = KeyPairIndex::Slot;
+  static constexpr bool stable = Stable;
+
+  template<typename... Arguments>
+  Slot emplace(Arguments &&...arguments)
+  {
+    if (_freeSlots.empty()) {
+      if constexpr (bare) _slots.emplace_back(std::forward<Arguments>(arguments)...);
+      else _slots.emplace_back(std::in_place, std::forward<Arguments>(arguments)...);
+      _used.push_back(1);
+      return static_cast<Slot>(_slots.size() - 1);
+    }
+    Slot slot = _freeSlots.back();
+    if constexpr (bare) ::new (static_cast<void *>(&_slots[slot])) Record(std::forward<Arguments>(arguments)...);
+    else _slots[slot].emplace(std::forward<Arguments>(arguments)...);
+    _freeSlots.pop_back();
+    _used[slot] = 1;
+    return slot;
+  }
+
+  void erase(Slot slot)
+  {
+    if constexpr (bare) secureZero(&_slots[slot], sizeof(Element));
+    else _slots[slot].reset();
+    _used[slot] = 0;
+    _freeSlots.push_back(slot);
+  }
+
+  // at least twofold, (as RecordArena::reserve()), so that a reserve of
+  // size() + n before each of many small batches stays linear
+  void reserve(std::size_t capacity)
+  {
+    if (capacity <= _used.capacity()) return;
+    capacity = std::max(capacity, 2 * _used.capacity());
+    if constexpr (!Stable) _slots.reserve(capacity);
+    _used.reserve(capacity);
+  }
+
+  const Record &operator[](Slot slot) const { return get(_slots[slot]); }
+  bool used(std::size_t slot) const { return _used[slot] != 0; }
+  std::size_t bound() const { return _slots.size(); }
+};
+
+template<typename Record>
+using StableStorage = SlotStorage<Record, true>;
+
+template<typename Record>
+using ContiguousStorage = SlotStorage<Record, false>;
+
+template<typename Record>
+using ArenaStorage = RecordArena<Record>;
+
+/**
+  * @brief BasicWallet
+  *
+  * The Wallet engine as a template, (header only): the same KeyPairIndex
+  * tables and rules as Wallet, (see Wallet.hpp), with the storage and the
+  * id hashing as policies, and no virtual function anywhere on the path of
+  * a lookup. Lookups return the stored KeyPairRecord, (a final class, so
+  * keyPairId(), publicKey(), ... are direct calls, inlined), and store()
+  * takes the KeyPair by its own type, (its ids are read with direct calls
+  * when that type is final). The record type is a policy too: KeyPair,
+  * (see KeyPair.hpp), keeps every record on cache lines of its own.
+  *
+  *   BasicWallet<> wallet;// StableStorage, Crc32KeyPairIds, KeyPairRecord
+  *   BasicWallet<ContiguousStorage, Hash64KeyPairIds, KeyPair> dense;
+  *   wallet.store(keyPair);
+  *   if (const KeyPairRecord *found = wallet.tryFindByPublicKey(key)) ...
+  *
+  * @note a BasicWallet is not a WalletInterface, wrap it in a WalletAdapter
+  * where one is needed.
+  *
+  * @note as with Wallet, const member functions may run concurrently,
+  * (nothing else may run alongside a store() or remove()).
+  *
+  */
+template<template<typename> class Storage = StableStorage, typename Ids = Crc32KeyPairIds, typename Value = KeyPairRecord>
+class BasicWallet
+{
+public:
+  using Record = Value;
+  using Slot = KeyPairIndex::Slot;
+  using Hashing = Ids;
+  static constexpr KeyPairIdMode idMode = Ids::mode;
+
+private:
+  Storage<Record> _storage;
+  KeyPairIndex _byKeyPairId;
+  KeyPairIndex _byPublicKeyId;
+  KeyPairIndex _byPrivateKeyId;
+
+  const Record *at(Slot slot) const { return slot == KeyPairIndex::npos ? nullptr : &_storage[slot]; }
+
+  static const Record &found(const Record *record, const KeyPairId &id)
+  {
+    if (record == nullptr) throw KeyPairNotFoundException(id);
+    return *record;
+  }
+
+  Slot findPublicKey(const KeyPairId &publicKeyId, std::string_view publicKey) const
+  {
+    return _byPublicKeyId.findIf(publicKeyId, [this, &publicKey](Slot slot) { return _storage[slot].publicKey().view() == publicKey; });
+  }
+
+  Slot findPrivateKey(const KeyPairId &privateKeyId, std::string_view privateKey) const
+  {
+    return _byPrivateKeyId.findIf(privateKeyId, [this, &privateKey](Slot slot) { return _storage[slot].privateKey().view() == privateKey; });
+  }
+
+public:
+  BasicWallet() = default;
+  explicit BasicWallet(std::size_t capacity) { reserve(capacity); }
+
+  void reserve(std::size_t capacity)
+  {
+    _storage.reserve(capacity);
+    _byKeyPairId.reserve(capacity);
+    _byPublicKeyId.reserve(capacity);
+    _byPrivateKeyId.reserve(capacity);
+  }
+
+  /**
+    * @brief tryStore()
+    * @return WalletStatus::AlreadyExists if the keyPairId, public key or
+    * private key is already in the Wallet, (nothing is stored)
+    */
+  template<typename Source>
+  WalletStatus tryStore(const Source &keyPair)
+  {
+    if (_byKeyPairId.find(keyPair.keyPairId()) != KeyPairIndex::npos
+        || findPublicKey(keyPair.publicKeyId(), keyPair.publicKey()) != KeyPairIndex::npos
+        || findPrivateKey(keyPair.privateKeyId(), keyPair.privateKey()) != KeyPairIndex::npos)
+      return WalletStatus::AlreadyExists;
+    Slot slot = _storage.emplace(keyPair);
+    const Record &record = _storage[slot];
+    _byKeyPairId.insert(record.keyPairId(), slot);
+    _byPublicKeyId.insertMulti(record.publicKeyId(), slot);
+    _byPrivateKeyId.insertMulti(record.privateKeyId(), slot);
+    return WalletStatus::Ok;
+  }
+
+  /**
+    * @brief store()
+    * @exception KeyPairAlreadyExistsException, (with the id that clashed)
+    */
+  template<typename Source>
+  KeyPairId store(const Source &keyPair)
+  {
+    if (tryStore(keyPair) != WalletStatus::Ok) {
+      if (_byKeyPairId.find(keyPair.keyPairId()) != KeyPairIndex::npos)
+        throw KeyPairAlreadyExistsException(keyPair.keyPairId());
+      if (findPublicKey(keyPair.publicKeyId(), keyPair.publicKey()) != KeyPairIndex::npos)
+        throw KeyPairAlreadyExistsException(keyPair.publicKeyId());
+      throw KeyPairAlreadyExistsException(keyPair.privateKeyId());
+    }
+    return keyPair.keyPairId();
+  }
+
+  WalletStatus tryRemove(const KeyPairId &keyPairId)
+  {
+    Slot slot = _byKeyPairId.find(keyPairId);
+    if (slot == KeyPairIndex::npos) return WalletStatus::NotFound;
+    const Record &record = _storage[slot];
+    _byPublicKeyId.erase(record.publicKeyId(), slot);
+    _byPrivateKeyId.erase(record.privateKeyId(), slot);
+    _byKeyPairId.erase(keyPairId);
+    _storage.erase(slot);
+    return WalletStatus::Ok;
+  }
+
+  void remove(const KeyPairId &keyPairId)
+  {
+    if (tryRemove(keyPairId) != WalletStatus::Ok) throw KeyPairNotFoundException(keyPairId);
+  }
+
+  const Record *tryRetrieve(const KeyPairId &keyPairId) const { return at(_byKeyPairId.find(keyPairId)); }
+  const Record *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const { return at(_byPublicKeyId.find(publicKeyId)); }
+  const Record *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const { return at(_byPrivateKeyId.find(privateKeyId)); }
+
+  const Record *tryFindByPublicKey(std::string_view publicKey) const
+  {
+    return at(findPublicKey(Ids::publicKeyId(publicKey), publicKey));
+  }
+
+  const Record *tryFindByPrivateKey(std::string_view privateKey) const
+  {
+    return at(findPrivateKey(Ids::privateKeyId(privateKey), privateKey));
+  }
+
+  const Record &retrieve(const KeyPairId &keyPairId) const { return found(tryRetrieve(keyPairId), keyPairId); }
+  const Record &findByPublicKeyId(const KeyPairId &publicKeyId) const { return found(tryFindByPublicKeyId(publicKeyId), publicKeyId); }
+  const Record &findByPrivateKeyId(const KeyPairId &privateKeyId) const { return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId); }
+
+  const Record &findByPublicKey(std::string_view publicKey) const
+  {
+    return found(tryFindByPublicKey(publicKey), Ids::publicKeyId(publicKey));
+  }
+
+  const Record &findByPrivateKey(std::string_view privateKey) const
+  {
+    return found(tryFindByPrivateKey(privateKey), Ids::privateKeyId(privateKey));
+  }
+
+  /**
+    * @brief forEach()
+    *
+    * Call visit(record) for every KeyPair, (in slot order)
+    *
+    */
+  template<typename Visit>
+  void forEach(Visit &&visit) const
+  {
+    for (std::size_t slot = 0; slot < _storage.bound(); ++slot)
+      if (_storage.used(slot)) visit(_storage[Slot(slot)]);
+  }
+
+  /**
+    * @brief listPage()
+    *
+    * As WalletInterface::listPage(), a cursor being a slot number
+    *
+    */
+  KeyPairIdCursor listPage(const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const
+  {
+    limit = std::max<std::size_t>(limit, 1);
+    keyPairIds.clear();
+    if (cursor >= _storage.bound()) return noMorePages;
+    std::size_t slot = cursor;
+    for (; slot < _storage.bound() && keyPairIds.size() < limit; ++slot)
+      if (_storage.used(slot)) keyPairIds.push_back(_storage[Slot(slot)].keyPairId());
+    return slot < _storage.bound() ? slot : noMorePages;
+  }
+
+  void prefetchPublicKeyId(const KeyPairId &publicKeyId) const { _byPublicKeyId.prefetch(publicKeyId); }
+  void prefetchKeyPairId(const KeyPairId &keyPairId) const { _byKeyPairId.prefetch(keyPairId); }
+
+  std::size_t size() const { return _byKeyPairId.size(); }
+};
+
+/**
+  * @brief WalletAdapter
+  *
+  * A BasicWallet, (or anything with its member functions), behind
+  * WalletInterface, for the code that wants runtime polymorphism. The
+  * engine stays reachable, (engine()), for the hot loops next to it.
+  *
+  *   WalletAdapter<BasicWallet<>> wallet;
+  *   WalletInterface &any = wallet;// virtual, as usual
+  *   wallet.engine().tryRetrieve(keyPairId)->publicKeyId();// inlined
+  *
+  */
+template<typename Engine>
+class WalletAdapter implements WalletInterface
+{
+  Engine _engine;
+
+  static constexpr std::size_t prefetchDistance = 8;
+
+public:
+  template<typename... Arguments>
+  explicit WalletAdapter(Arguments &&...arguments) : _engine(std::forward<Arguments>(arguments)...) {}
+
+  Engine &engine() { return _engine; }
+  const Engine &engine() const { return _engine; }
+  std::size_t size() const { return _engine.size(); }
+  KeyPairIdMode idMode() const { return Engine::idMode; }
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override { return _engine.store(keyPair); }
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override { return _engine.retrieve(keyPairId); }
+  virtual void remove(const KeyPairId &keyPairId) override { _engine.remove(keyPairId); }
+
+  virtual KeyPairIdList list() const override
+  {
+    KeyPairIdList keyPairIds;
+    _engine.forEach([&keyPairIds](const KeyPairInterface &keyPair) { keyPairIds.push_back(keyPair.keyPairId()); });
+    return keyPairIds;
+  }
+
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override
+  {
+    keyPairIds.reserve(keyPairIds.size() + _engine.size());
+    _engine.forEach([&keyPairIds](const KeyPairInterface &keyPair) { keyPairIds.push_back(keyPair.keyPairId()); });
+  }
+
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override
+  {
+    return _engine.listPage(cursor, limit, keyPairIds);
+  }
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override { return _engine.retrieve(keyPair.keyPairId()); }
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override { return _engine.retrieve(keyPairId); }
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override { return _engine.findByPublicKey(publicKey); }
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override { return _engine.findByPublicKeyId(publicKeyId); }
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override { return _engine.findByPrivateKey(privateKey); }
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override { return _engine.findByPrivateKeyId(privateKeyId); }
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override { return _engine.tryRetrieve(keyPairId); }
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override { return _engine.tryRetrieve(keyPair.keyPairId()); }
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override { return _engine.tryRetrieve(keyPairId); }
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override { return _engine.tryFindByPublicKey(publicKey); }
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override { return _engine.tryFindByPublicKeyId(publicKeyId); }
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override { return _engine.tryFindByPrivateKey(privateKey); }
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override { return _engine.tryFindByPrivateKeyId(privateKeyId); }
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override
+  {
+    results.resize(keyPairs.size());
+    _engine.reserve(_engine.size() + keyPairs.size());
+    for (std::size_t i = 0; i < keyPairs.size(); ++i) results[i] = _engine.tryStore(*keyPairs[i]);
+  }
+
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override
+  {
+    results.resize(keyPairIds.size());
+    for (std::size_t i = 0; i < keyPairIds.size(); ++i) {
+      if (i + prefetchDistance < keyPairIds.size()) _engine.prefetchKeyPairId(keyPairIds[i + prefetchDistance]);
+      results[i] = _engine.tryRemove(keyPairIds[i]);
+    }
+  }
+
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override
+  {
+    results.resize(publicKeyIds.size());
+    for (std::size_t i = 0; i < publicKeyIds.size(); ++i) {
+      if (i + prefetchDistance < publicKeyIds.size()) _engine.prefetchPublicKeyId(publicKeyIds[i + prefetchDistance]);
+      results[i] = _engine.tryFindByPublicKeyId(publicKeyIds[i]);
+    }
+  }
+};
+
+#endif// _BASICWALLET_HPP
@@ -0,0 +1,151 @@
+#ifndef _BLOOMFILTER_HPP
+#define _BLOOMFILTER_HPP
+
+/**
+ * @brief BloomFilter
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that most keys a block scan looks up are not in the Wallet
+ * WHEN such a key is looked up
+ * THEN a single cache line should be enough to say so, (rather than a
+ *      probe sequence through a hash table of millions of entries)
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "KeyPairIndex.hpp"
+
+/**
+  * @brief BloomFilterOptions
+  *
+  *   falsePositiveRate - what a filter filled to capacity should let
+  *                       through, (of the ids that were never added)
+  *   maxBytes          - a cap on the memory of a filter, 0 for none,
+  *                       (the false positive rate goes up instead)
+  *
+  */
+struct BloomFilterOptions
+{
+  double falsePositiveRate = 0.01;
+  std::size_t maxBytes = 0;
+};
+
+/**
+  * @brief BlockedBloomFilter
+  *
+  * A Bloom filter over KeyPairId values whose bits are split in 64 byte
+  * blocks: an id picks one block and sets, (or tests), all its bits in
+  * there, so a lookup touches one cache line whatever the number of bits.
+  *
+  * mayContain() never answers false for an id that was added; it answers
+  * true for about falsePositiveRate() of the others.
+  *
+  * @note there is no remove, (a Bloom filter cannot forget an id); the
+  * owner rebuilds the filter when it sees fit, (see Wallet).
+  *
+  * @note mayContain() may be called concurrently, add() and reset() may not.
+  *
+  */
+class BlockedBloomFilter
+{
+  static constexpr unsigned blockBits = 512;
+
+  struct alignas(64) Block
+  {
+    std::uint64_t words[blockBits / 64];
+  };
+
+  BloomFilterOptions _options;
+  std::vector<Block> _blocks;
+  std::size_t _capacity = 0;
+  std::size_t _count = 0;
+  unsigned _hashes = 0;
+
+  std::size_t blockOf(std::uint64_t hash) const
+  {
+    // the high half of the hash picks the block, (no modulo needed)
+    return std::size_t(((hash >> 32) * _blocks.size()) >> 32);
+  }
+
+  template<typename Visit>
+  void forEachBit(std::uint64_t hash, Visit &&visit) const
+  {
+    // 9 bits per position, (7 positions per remix)
+    std::uint64_t bits = KeyPairIndex::mix(KeyPairId(hash ^ 0x9e3779b97f4a7c15ULL));
+    for (unsigned i = 0, left = 7; i < _hashes; ++i, --left) {
+      if (left == 0) {
+        bits = KeyPairIndex::mix(KeyPairId(bits + hash));
+        left = 7;
+      }
+      unsigned bit = unsigned(bits) & (blockBits - 1);
+      bits >>= 9;
+      visit(bit >> 6, std::uint64_t(1) << (bit & 63));
+    }
+  }
+
+public:
+  explicit BlockedBloomFilter(const BloomFilterOptions &options = BloomFilterOptions());
+
+  /**
+    * @brief reset()
+    *
+    * Forget every id and size the filter for capacity of them
+    *
+    */
+  void reset(std::size_t capacity);
+
+  void add(const KeyPairId &id)
+  {
+    std::uint64_t hash = KeyPairIndex::mix(id);
+    Block &block = _blocks[blockOf(hash)];
+    forEachBit(hash, [&block](unsigned word, std::uint64_t mask) { block.words[word] |= mask; });
+    ++_count;
+  }
+
+  bool mayContain(const KeyPairId &id) const
+  {
+    std::uint64_t hash = KeyPairIndex::mix(id);
+    const Block &block = _blocks[blockOf(hash)];
+    bool all = true;
+    forEachBit(hash, [&block, &all](unsigned word, std::uint64_t mask) { all &= (block.words[word] & mask) != 0; });
+    return all;
+  }
+
+  void prefetch(const KeyPairId &id) const
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&_blocks[blockOf(KeyPairIndex::mix(id))]);
+#endif
+  }
+
+  const BloomFilterOptions &options() const { return _options; }
+
+  /**
+    * @brief capacity()
+    * @return the number of ids the filter was sized for
+    */
+  std::size_t capacity() const { return _capacity; }
+
+  /**
+    * @brief count()
+    * @return the number of add() calls since the last reset()
+    */
+  std::size_t count() const { return _count; }
+
+  unsigned hashes() const { return _hashes; }
+  std::size_t memorySize() const { return _blocks.size() * sizeof(Block); }
+
+  /**
+    * @brief falsePositiveRate()
+    * @return the expected false positive rate for count() ids, (at
+    * capacity() that is options().falsePositiveRate, unless maxBytes
+    * got in the way)
+    */
+  double falsePositiveRate() const { return falsePositiveRateFor(_count); }
+  double falsePositiveRateFor(std::size_t count) const;
+};
+
+#endif// _BLOOMFILTER_HPP
@@ -0,0 +1,127 @@
+#ifndef _CONCURRENTWALLET_HPP
+#define _CONCURRENTWALLET_HPP
+
+/**
+ * @brief ConcurrentWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that dozens of worker threads call find...() on the same Wallet
+ * WHEN a background importer keeps calling store() at the same time
+ * THEN the Wallet has to be thread-safe without serializing the readers
+ *
+ */
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "Wallet.hpp"
+
+/**
+  * @brief ConcurrentWallet
+  *
+  * Thread-safe implementation of WalletInterface. KeyPairs are spread
+  * over shards by the bits of their keyPairId, each shard being a Wallet
+  * guarded by its own reader-writer lock. Two sharded routing indexes map
+  * publicKeyId and privateKeyId values onto the shard holding the KeyPair,
+  * (they are sharded by those ids, with a lock per routing shard as well).
+  *
+  * Lookups take one lock at a time, (a routing shard, then a Wallet shard),
+  * writers take the Wallet shards they need in ascending order and then
+  * the routing shards, (the publicKeyId ones before the privateKeyId
+  * ones, each in ascending order), so nothing can deadlock. storeMany()
+  * and removeMany() go a Wallet shard at a time, taking those locks once
+  * for all the items of the batch that live in it.
+  *
+  * @note references, (and pointers), returned by retrieve(), find...()
+  * and try...() are only safe to use as long as no other thread removes
+  * that KeyPair.
+  *
+  * @note the shards keep their records in lockedMemoryResource(), (the
+  * Wallet default).
+  *
+  */
+class ConcurrentWallet implements WalletInterface
+{
+  using Slot = KeyPairIndex::Slot;
+
+  struct alignas(64) Shard
+  {
+    mutable std::shared_mutex lock;
+    Wallet wallet;
+    explicit Shard(KeyPairIdMode idMode) : wallet(idMode) {}
+  };
+
+  struct alignas(64) Route
+  {
+    mutable std::shared_mutex lock;
+    KeyPairIndex shards;// publicKeyId (or privateKeyId) => shard number
+  };
+
+  unsigned _shardBits;
+  KeyPairIdMode _idMode;
+  std::vector<std::unique_ptr<Shard>> _shards;
+  std::vector<std::unique_ptr<Route>> _publicKeyRoutes;
+  std::vector<std::unique_ptr<Route>> _privateKeyRoutes;
+
+  Slot shardOf(const KeyPairId &keyPairId) const;
+  Route &routeOf(const std::vector<std::unique_ptr<Route>> &routes, const KeyPairId &id) const;
+  using RoutedIds = std::vector<std::pair<Slot, KeyPairId>>;// (routing shard, id), sorted
+
+  void candidates(const std::vector<std::unique_ptr<Route>> &routes, const KeyPairId &id, std::vector<Slot> &shards) const;
+  void candidates(const std::vector<std::unique_ptr<Route>> &routes, const RoutedIds &ids, std::vector<Slot> &shards) const;
+  static void lockRoutes(const std::vector<std::unique_ptr<Route>> &routes, const RoutedIds &ids, std::vector<std::unique_lock<std::shared_mutex>> &locks);
+  WalletStatus insert(const KeyPairInterface &keyPair, KeyPairId &clash);
+  WalletStatus insertLocked(const KeyPairInterface &keyPair, Slot home, Route &publicKeyRoute, Route &privateKeyRoute,
+    const std::vector<Slot> &shards, KeyPairId &clash);
+  WalletStatus erase(const KeyPairId &keyPairId);
+
+  template<typename Find>
+  const KeyPairInterface *findVia(const std::vector<std::unique_ptr<Route>> &routes, const KeyPairId &id, Find &&find) const;
+
+public:
+  /**
+    * @param shardBits 2^shardBits shards, (the default gives 64)
+    */
+  explicit ConcurrentWallet(KeyPairIdMode idMode = KeyPairIdMode::Crc32, unsigned shardBits = 6);
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  /**
+    * @brief size()
+    * @return the number of KeyPairs stored, (a moment ago)
+    */
+  std::size_t size() const;
+  std::size_t shardCount() const { return _shards.size(); }
+  KeyPairIdMode idMode() const { return _idMode; }
+};
+
+#endif// _CONCURRENTWALLET_HPP
@@ -0,0 +1,77 @@
+#ifndef _CRC32_HPP
+#define _CRC32_HPP
+
+/**
+ * @brief Crc32
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that KeyPairInterface recommends CRC32 values for KeyPairIds
+ * WHEN every string based find...() call has to hash its argument
+ * THEN the CRC32 has to be as fast as the CPU allows
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+  * @brief Crc32Engine
+  *
+  * The implementations of crc32(), (all of them compute the same value).
+  *
+  *   SlicingBy8 - portable, table driven, eight bytes per step
+  *   Sse42      - the SSE4.2 crc32 instruction, eight bytes per step
+  *   Pclmul     - PCLMULQDQ folding of 64 byte blocks, (long inputs only),
+  *                finished with the SSE4.2 crc32 instruction
+  *
+  */
+enum class Crc32Engine {
+  SlicingBy8,
+  Sse42,
+  Pclmul
+};
+
+/**
+  * @brief crc32()
+  *
+  * CRC-32C, (Castagnoli polynomial 0x1EDC6F41, the one implemented by
+  * the SSE4.2 crc32 instruction). The engine is picked once at startup
+  * according to what the CPU supports.
+  *
+  * @param crc the value returned for the preceding data, (so a CRC can
+  * be computed piecewise), 0 to start
+  * @return the CRC-32C of data
+  *
+  */
+std::uint32_t crc32(const void *data, std::size_t length, std::uint32_t crc = 0);
+
+inline std::uint32_t crc32(std::string_view data, std::uint32_t crc = 0)
+{
+  return crc32(data.data(), data.size(), crc);
+}
+
+/**
+  * @brief crc32With()
+  *
+  * Same as crc32() but using the given engine, (for testing and benchmarks)
+  *
+  * @exception std::invalid_argument if the CPU does not support the engine
+  *
+  */
+std::uint32_t crc32With(Crc32Engine engine, const void *data, std::size_t length, std::uint32_t crc = 0);
+
+/**
+  * @brief crc32Supported()
+  * @return true if engine can run on this CPU
+  */
+bool crc32Supported(Crc32Engine engine);
+
+/**
+  * @brief crc32Engine()
+  * @return the engine used by crc32()
+  */
+Crc32Engine crc32Engine();
+
+#endif// _CRC32_HPP
@@ -0,0 +1,161 @@
+#ifndef _DISKWALLET_HPP
+#define _DISKWALLET_HPP
+
+/**
+ * @brief DiskWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a Wallet file too large, (or too cold), to keep in memory
+ * WHEN a batch of KeyPairs is looked up
+ * THEN the reads for the whole batch are in flight at once, (through an
+ *      IoBackend), rather than one page fault after another
+ *
+ */
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "IoBackend.hpp"
+#include "KeyPairIds.hpp"
+#include "KeyPairRecord.hpp"
+#include "RecordArena.hpp"
+#include "WalletFile.hpp"
+#include "WalletInterface.hpp"
+
+/**
+  * @brief DiskWalletOptions
+  *
+  *   backend    - IoBackendKind::Uring falls back to Pread where need be
+  *   queueDepth - reads in flight at most
+  *   direct     - O_DIRECT, (bypass the page cache: every lookup reads
+  *                the device, as a cold tier does)
+  *
+  */
+struct DiskWalletOptions
+{
+  IoBackendKind backend = IoBackendKind::Uring;
+  unsigned queueDepth = 64;
+  bool direct = false;
+};
+
+/**
+  * @brief DiskWallet
+  *
+  * Read-only implementation of WalletInterface over a Wallet file, (see
+  * WalletFile.hpp), that is read, not mapped. A lookup reads the page of
+  * the hash table its id falls in, then the page of each candidate record;
+  * the batch lookups, (findManyByPublicKeyId()), do so for up to
+  * queueDepth ids at once.
+  *
+  * Records read are kept, (the KeyPairInterface references handed out
+  * live as long as the DiskWallet, or until release()), hash table pages
+  * are not. So the cache grows, up to every record of the file, until
+  * release() wipes it; it and the page buffers live in
+  * lockedMemoryResource(), (see LockedMemory.hpp).
+  *
+  * @note store(), remove(), storeMany() and removeMany() throw
+  * WalletReadOnlyException.
+  *
+  * @note lookups are thread-safe, (one at a time: an IoBackend is not,
+  * concurrency at the device comes from the batches).
+  *
+  */
+class DiskWallet implements WalletInterface
+{
+  using Slot = std::uint32_t;
+
+  struct Lookup;
+
+  std::string _path;
+  int _fd = -1;
+  WalletFileHeader _header{};
+  std::uint64_t _mask = 0;
+  KeyPairIdMode _idMode = KeyPairIdMode::Crc32;
+  std::size_t _batch;
+
+  mutable std::mutex _lock;
+  mutable std::unique_ptr<IoBackendInterface> _io;
+  mutable RecordArena<KeyPairRecord> _records;// the records read so far
+  mutable std::vector<Slot> _cached;// by file slot, where in _records, (or KeyPairIndex::npos)
+  mutable char *_pages = nullptr;// _batch page aligned buffers
+  mutable std::uint64_t _reads = 0;
+
+  char *page(std::size_t i) const { return _pages + i * pageSize; }
+  void readPages(IoRequest *requests, std::size_t count) const;
+  void lookupMany(std::uint64_t tableOffset, Lookup *lookups, std::size_t count) const;
+  const KeyPairInterface *lookup(std::uint64_t tableOffset, const KeyPairId &id, const std::string_view *publicKey, const std::string_view *privateKey) const;
+
+public:
+  static constexpr std::size_t pageSize = 4096;
+
+  /**
+    * @brief DiskWallet()
+    * @exception WalletFileException if path cannot be read or is not a
+    * valid Wallet file
+    */
+  explicit DiskWallet(const std::string &path, const DiskWalletOptions &options = DiskWalletOptions());
+  virtual ~DiskWallet();
+
+  DiskWallet(const DiskWallet &) = delete;
+  DiskWallet &operator=(const DiskWallet &) = delete;
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  std::size_t size() const { return _header.count; }
+  KeyPairIdMode idMode() const { return _idMode; }
+  const std::string &path() const { return _path; }
+  IoBackendKind backend() const { return _io->kind(); }
+
+  /**
+    * @brief reads()
+    * @return the number of page reads issued so far
+    */
+  std::uint64_t reads() const;
+
+  /**
+    * @brief release()
+    *
+    * Wipe and drop the records read so far, (the references and pointers
+    * handed out before are invalid afterwards), they are read again
+    * when next looked up
+    *
+    */
+  void release();
+
+  /**
+    * @brief cachedRecords()
+    * @return the number of records read and kept since the last release()
+    */
+  std::size_t cachedRecords() const;
+};
+
+#endif// _DISKWALLET_HPP
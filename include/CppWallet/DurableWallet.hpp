@@ -0,0 +1,213 @@
+#ifndef _DURABLEWALLET_HPP
+#define _DURABLEWALLET_HPP
+
+/**
+ * @brief DurableWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a stored KeyPair must survive a crash
+ * WHEN store() or remove() returns
+ * THEN the operation is on disk, (and is replayed when the Wallet opens)
+ *
+ * GIVEN a long-lived Wallet
+ * WHEN KeyPairs keep being stored and removed
+ * THEN neither its disk usage nor the time to open it grows without
+ *      bound, (compaction)
+ *
+ * The directory holds a checkpoint, (a Wallet file, see WalletFile.hpp,
+ * of everything up to some log sequence), and the log segments after it:
+ *
+ *   wallet.checkpoint                  KeyPairs up to sequence S
+ *   wallet-00000000000000000001.log    WalletLog entries from 1, (only
+ *   wallet-00000000000000004097.log    the entries after S are replayed)
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "EpochWallet.hpp"
+#include "WalletLog.hpp"
+
+/**
+  * @brief WalletCompactionOptions
+  *
+  *   background     - compact in a background thread when due, (otherwise
+  *                    only when compact() is called)
+  *   minEntries     - compaction is due once the log holds this many
+  *                    entries after the checkpoint...
+  *   logRatio       - ...and at least logRatio entries per KeyPair stored
+  *   bytesPerSecond - the disk bandwidth a compaction may use, (0 - all)
+  *   interval       - how often the background thread checks
+  *
+  */
+struct WalletCompactionOptions
+{
+  bool background = true;
+  std::uint64_t minEntries = 65536;
+  double logRatio = 1.0;
+  std::uint64_t bytesPerSecond = 64 << 20;
+  std::chrono::milliseconds interval{ 1000 };
+};
+
+/**
+  * @brief DurableWallet
+  *
+  * Thread-safe, persistent implementation of WalletInterface: an
+  * EpochWallet, (so lookups take no lock), in front of a WalletLog kept
+  * in a directory of its own. store() and remove() apply the operation
+  * and queue its log entry under one lock, (so the log has the order the
+  * Wallet saw), then wait for group commit outside of it, so concurrent
+  * callers share an fdatasync().
+  *
+  * Compaction starts a new log segment, (briefly holding the write
+  * lock), then, without any lock, merges the previous checkpoint with
+  * the segments before the new one into a new checkpoint, (throttled to
+  * bytesPerSecond), and deletes those segments. Lookups never wait for
+  * it, the in-memory Wallet is not involved.
+  *
+  * @note a KeyPair can be found by other threads a moment before the
+  * store() that adds it returns, (before it is durable).
+  *
+  * @note a failed commit fails the DurableWallet: that call and every
+  * later one, (lookups included), throw WalletFileException, since the
+  * in-memory Wallet may hold operations the disk does not. Opening the
+  * directory again carries on from what is on disk.
+  *
+  * @note references returned follow the EpochWallet rules.
+  *
+  * @note the records, the log queue and the compaction's merge all live
+  * in lockedMemoryResource(), (see LockedMemory.hpp).
+  *
+  */
+class DurableWallet implements WalletInterface
+{
+  using Sequence = WalletLog::Sequence;
+
+  std::string _directory;
+  KeyPairIdMode _idMode;
+  WalletLogOptions _logOptions;
+  WalletCompactionOptions _compaction;
+  EpochWallet _wallet;
+
+  mutable std::mutex _writeLock;
+  std::shared_ptr<WalletLog> _log;// the current segment, (swapped by compact())
+  std::vector<std::string> _sealed;// older segments with entries after the checkpoint
+
+  std::mutex _compactLock;
+  std::atomic<Sequence> _checkpointSequence{ 0 };
+  std::atomic<std::uint64_t> _compactions{ 0 };
+  Sequence _replayed = 0;
+
+  std::atomic<bool> _failed{ false };
+  std::string _failure;// set once, (under _writeLock), before _failed
+
+  std::mutex _stopLock;
+  std::condition_variable _stop;
+  bool _stopping = false;
+  std::thread _compactor;
+
+  void open();
+  void commit(WalletLog &log, Sequence sequence);
+  void fail(const WalletFileException &exception);// _writeLock held
+  void healthy() const;
+  void replay(const WalletLogEntry &entry);
+  bool compactionDue() const;
+  bool stopping();
+  void compactInBackground();
+  std::string pathOf(const std::string &name) const { return _directory + "/" + name; }
+
+public:
+  static constexpr const char *checkpointName = "wallet.checkpoint";
+
+  /**
+    * @brief segmentName()
+    * @return the file name of the log segment starting at firstSequence
+    */
+  static std::string segmentName(Sequence firstSequence);
+
+  /**
+    * @brief DurableWallet()
+    *
+    * Open the Wallet kept in directory, (created if need be), loading
+    * its checkpoint and replaying the log after it
+    *
+    * @exception WalletFileException
+    */
+  explicit DurableWallet(const std::string &directory,
+    KeyPairIdMode idMode = KeyPairIdMode::Crc32,
+    const WalletLogOptions &options = WalletLogOptions(),
+    const WalletCompactionOptions &compaction = WalletCompactionOptions());
+  virtual ~DurableWallet();
+
+  DurableWallet(const DurableWallet &) = delete;
+  DurableWallet &operator=(const DurableWallet &) = delete;
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  /**
+    * @note storeMany() and removeMany() commit the whole batch at once
+    */
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  /**
+    * @brief compact()
+    *
+    * Checkpoint everything logged so far and delete the log segments
+    * the checkpoint covers, (what the background thread does when due)
+    *
+    * @return false if nothing was logged since the last checkpoint
+    * @exception WalletFileException
+    */
+  bool compact();
+
+  /**
+    * @brief failed()
+    * @return whether a commit failed, (see above, every call throws)
+    */
+  bool failed() const { return _failed.load(std::memory_order_acquire); }
+
+  std::size_t size() const { return _wallet.size(); }
+  KeyPairIdMode idMode() const { return _idMode; }
+  const std::string &directory() const { return _directory; }
+  Sequence checkpointSequence() const { return _checkpointSequence; }
+  std::uint64_t compactions() const { return _compactions; }
+
+  /**
+    * @brief log()
+    * @return the current log segment, (valid until the next compaction)
+    */
+  const WalletLog &log() const;
+};
+
+#endif// _DURABLEWALLET_HPP
@@ -0,0 +1,139 @@
+#ifndef _ENTROPYPOOL_HPP
+#define _ENTROPYPOOL_HPP
+
+/**
+ * @brief EntropyPool
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that every generated KeyPair needs fresh randomness
+ * WHEN a bulk run generates hundreds of thousands of them
+ * THEN the randomness comes from a ChaCha20 generator per thread,
+ *      reseeded from the kernel now and then, rather than from a
+ *      getrandom() per KeyPair
+ *
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * @brief EntropyPoolOptions
+  *
+  *   reseedBytes    - output between reseeds
+  *   reseedInterval - time between reseeds, (checked each 1 KiB of output)
+  *
+  */
+struct EntropyPoolOptions
+{
+  std::uint64_t reseedBytes = 1 << 20;
+  std::chrono::milliseconds reseedInterval{ 60000 };
+};
+
+/**
+  * @brief EntropyPoolStats
+  *
+  *   kernelReads - getrandom() calls, (one a reseed)
+  *   reseeds     - new keys mixed in from the kernel's bytes
+  *   bytes       - output
+  *
+  */
+struct EntropyPoolStats
+{
+  std::uint64_t kernelReads = 0;
+  std::uint64_t reseeds = 0;
+  std::uint64_t bytes = 0;
+};
+
+/**
+  * @brief EntropyPool
+  *
+  * A ChaCha20 generator, (RFC 8439), with fast key erasure: each 1 KiB of
+  * keystream starts with the key for the next, (the key in use is never
+  * kept after it), the rest is handed out, and wiped as it is. A reseed
+  * mixes 32 bytes read from the kernel into the key, read then and wiped
+  * straight after, (no kernel bytes are kept for later reseeds).
+  *
+  *   uint8_t entropy[32];
+  *   randomBytes(entropy, sizeof(entropy));// the thread's EntropyPool
+  *
+  * @note fork-safe: a child process throws away the output it inherited,
+  * and reseeds from a getrandom() of its own before
+  * its first byte, (a pthread_atfork() handler counts the forks).
+  *
+  * @note not thread-safe, (one per thread, see threadEntropyPool()).
+  *
+  */
+class EntropyPool
+{
+  EntropyPoolOptions _options;
+  EntropyPoolStats _stats;
+
+  std::uint8_t _key[32] = {};
+  std::uint8_t _output[1024];
+  std::size_t _available = 0;
+
+  std::uint64_t _sinceReseed = 0;
+  std::chrono::steady_clock::time_point _reseededAt;
+  std::uint64_t _forks = ~std::uint64_t(0);// never seeded
+
+  void refill();
+
+public:
+  explicit EntropyPool(const EntropyPoolOptions &options = EntropyPoolOptions());
+  ~EntropyPool();
+
+  EntropyPool(const EntropyPool &) = delete;
+  EntropyPool &operator=(const EntropyPool &) = delete;
+
+  /**
+    * @brief fill()
+    *
+    * size random bytes at bytes
+    *
+    * @exception std::system_error if getrandom() fails
+    */
+  void fill(void *bytes, std::size_t size);
+
+  /**
+    * @brief reseed()
+    *
+    * 32 bytes from the kernel mixed into the key now, (and the output
+    * made from the old key dropped)
+    *
+    * @exception std::system_error if getrandom() fails
+    */
+  void reseed();
+
+  const EntropyPoolStats &stats() const { return _stats; }
+  const EntropyPoolOptions &options() const { return _options; }
+};
+
+/**
+  * @brief threadEntropyPool()
+  * @return the EntropyPool of the calling thread, (thread_local, default
+  * options)
+  */
+EntropyPool &threadEntropyPool();
+
+/**
+  * @brief randomBytes()
+  *
+  * size random bytes at bytes, from the calling thread's EntropyPool
+  *
+  */
+inline void randomBytes(void *bytes, std::size_t size)
+{
+  threadEntropyPool().fill(bytes, size);
+}
+
+/**
+  * @brief chacha20Block()
+  *
+  * The 64 byte ChaCha20 block counter of key and nonce, (RFC 8439, 2.3)
+  *
+  */
+void chacha20Block(const std::uint8_t *key, std::uint32_t counter, const std::uint8_t *nonce, std::uint8_t *block);
+
+#endif// _ENTROPYPOOL_HPP
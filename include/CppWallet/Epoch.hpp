@@ -0,0 +1,163 @@
+#ifndef _EPOCH_HPP
+#define _EPOCH_HPP
+
+/**
+ * @brief EpochDomain & EpochGuard
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that retrieve() and find...() hand out references to stored KeyPairs
+ * WHEN another thread removes one of those KeyPairs
+ * THEN its memory has to stay put until no reader can still be using it
+ *
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+  * @brief EpochDomain
+  *
+  * Epoch based reclamation. Every thread that reads a lock-free structure
+  * announces the global epoch it is in, (enter()), objects unlinked from
+  * such a structure are handed to retire(), and are destroyed only once
+  * the global epoch has moved on twice, which it cannot do while some
+  * thread still announces an older epoch.
+  *
+  * A thread keeps its announcement until it calls enter() again, or
+  * quiesce(). So data read by a thread stays valid until that thread's
+  * next enter(), (or for as long as it holds an EpochGuard).
+  *
+  * @note there is one EpochDomain per process, (instance()).
+  *
+  * @note a thread that reads once and then idles holds back reclamation
+  * until it calls quiesce(), or exits.
+  *
+  */
+class EpochDomain
+{
+  struct alignas(64) Participant
+  {
+    std::atomic<std::uint64_t> epoch{ idle };
+    std::atomic<bool> taken{ true };
+    unsigned guards = 0;
+    Participant *next = nullptr;
+  };
+
+  struct Retired
+  {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  static constexpr std::uint64_t idle = UINT64_MAX;
+  static inline thread_local Participant *_self = nullptr;
+
+  std::atomic<std::uint64_t> _epoch{ 0 };
+  std::atomic<Participant *> _participants{ nullptr };
+  mutable std::mutex _lock;
+  std::vector<Retired> _limbo[3];
+  std::size_t _retiredSinceAdvance = 0;
+
+  EpochDomain() = default;
+  Participant &participant() { return _self != nullptr ? *_self : join(); }
+  Participant &join();
+  bool advance();
+
+  friend class EpochGuard;
+
+public:
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+  ~EpochDomain();
+
+  static EpochDomain &instance();
+
+  /**
+    * @brief enter()
+    *
+    * Announce the current epoch, (everything the calling thread read
+    * before may be reclaimed from now on). Costs a load and a compare
+    * unless the epoch moved since the thread last called it.
+    *
+    */
+  void enter()
+  {
+    Participant &self = participant();
+    if (self.guards != 0) return;
+    std::uint64_t epoch = _epoch.load(std::memory_order_acquire);
+    if (self.epoch.load(std::memory_order_relaxed) != epoch) {
+      self.epoch.store(epoch, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  /**
+    * @brief quiesce()
+    *
+    * The calling thread holds on to nothing read so far, (ignored while
+    * it holds an EpochGuard)
+    *
+    */
+  void quiesce();
+
+  /**
+    * @brief retire()
+    *
+    * Have destroy(object) called once no thread can be reading object,
+    * (which has to be unreachable for new readers already)
+    *
+    */
+  void retire(void *object, void (*destroy)(void *));
+
+  template<typename T>
+  void retire(const T *object)
+  {
+    retire(const_cast<T *>(object), [](void *retired) { delete static_cast<T *>(retired); });
+  }
+
+  /**
+    * @brief collect()
+    *
+    * Advance the epoch as far as the threads allow and destroy whatever
+    * became safe to destroy, (retire() does this every so often anyway)
+    *
+    */
+  void collect();
+
+  /**
+    * @brief pending()
+    * @return the number of retired objects not destroyed yet
+    */
+  std::size_t pending() const;
+
+  std::uint64_t epoch() const { return _epoch.load(std::memory_order_relaxed); }
+};
+
+/**
+  * @brief EpochGuard
+  *
+  * Keeps the calling thread in its current epoch for the lifetime of the
+  * guard, so everything read meanwhile stays valid until the guard goes,
+  * (enter() calls made meanwhile change nothing). Guards nest.
+  *
+  */
+class EpochGuard
+{
+  EpochDomain::Participant &_self;
+
+public:
+  EpochGuard() : _self(EpochDomain::instance().participant())
+  {
+    EpochDomain::instance().enter();
+    ++_self.guards;
+  }
+  ~EpochGuard() { --_self.guards; }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+#endif// _EPOCH_HPP
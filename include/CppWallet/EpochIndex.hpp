@@ -0,0 +1,200 @@
+#ifndef _EPOCHINDEX_HPP
+#define _EPOCHINDEX_HPP
+
+/**
+ * @brief EpochIndex
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that lookups vastly outnumber stores and removes
+ * WHEN many threads look up KeyPairs while one thread at a time changes them
+ * THEN the lookups should not need a lock at all
+ *
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "Epoch.hpp"
+#include "KeyPairIndex.hpp"
+
+/**
+  * @brief EpochIndex
+  *
+  * Maps a KeyPairId onto a const T *, (duplicate ids allowed, as with
+  * KeyPairIndex::insertMulti()). Lookups are lock-free and may run while
+  * one writer at a time inserts and erases.
+  *
+  * Linear probing over entries that are filled once, removed entries are
+  * marked rather than shifted, (a reader may be walking over them), and
+  * the table is rebuilt into a fresh one when it fills up, the old table
+  * being handed to EpochDomain::retire().
+  *
+  * @note find() and findIf() have to run after EpochDomain::enter().
+  * @note insert() and erase() have to be serialized by the caller.
+  *
+  */
+template<typename T>
+class EpochIndex
+{
+  static constexpr std::uintptr_t empty = 0;
+  static constexpr std::uintptr_t erased = 1;
+  static constexpr std::size_t minimumBucketCount = 16;
+
+  struct Entry
+  {
+    std::atomic<KeyPairId> keyPairId{ 0 };
+    std::atomic<std::uintptr_t> value{ empty };
+  };
+
+  struct Table
+  {
+    std::size_t mask;
+    std::unique_ptr<Entry[]> entries;
+
+    explicit Table(std::size_t bucketCount) : mask(bucketCount - 1), entries(new Entry[bucketCount]) {}
+    std::size_t home(const KeyPairId &keyPairId) const { return KeyPairIndex::mix(keyPairId) & mask; }
+    std::size_t limit() const { return mask + 1 - (mask + 1) / 4; }
+  };
+
+  std::atomic<Table *> _table;
+  std::size_t _used = 0;// live and erased entries
+  std::size_t _size = 0;
+
+  static std::size_t bucketCountFor(std::size_t capacity)
+  {
+    std::size_t bucketCount = minimumBucketCount;
+    while (bucketCount - bucketCount / 4 < capacity) bucketCount *= 2;
+    return bucketCount;
+  }
+
+  Table *rebuild(std::size_t bucketCount)
+  {
+    Table *old = _table.load(std::memory_order_relaxed);
+    auto table = std::make_unique<Table>(bucketCount);
+    for (std::size_t i = 0; i <= old->mask; ++i) {
+      std::uintptr_t value = old->entries[i].value.load(std::memory_order_relaxed);
+      if (value == empty || value == erased) continue;
+      KeyPairId keyPairId = old->entries[i].keyPairId.load(std::memory_order_relaxed);
+      std::size_t j = table->home(keyPairId);
+      while (table->entries[j].value.load(std::memory_order_relaxed) != empty) j = (j + 1) & table->mask;
+      table->entries[j].keyPairId.store(keyPairId, std::memory_order_relaxed);
+      table->entries[j].value.store(value, std::memory_order_relaxed);
+    }
+    _table.store(table.get(), std::memory_order_release);
+    EpochDomain::instance().retire(old);
+    _used = _size;
+    return table.release();
+  }
+
+public:
+  EpochIndex() : _table(new Table(minimumBucketCount)) {}
+  ~EpochIndex() { delete _table.load(std::memory_order_relaxed); }
+
+  EpochIndex(const EpochIndex &) = delete;
+  EpochIndex &operator=(const EpochIndex &) = delete;
+
+  /**
+    * @brief findIf()
+    * @return the first value stored for keyPairId for which matches(value)
+    * holds, or nullptr
+    */
+  template<typename Predicate>
+  const T *findIf(const KeyPairId &keyPairId, Predicate &&matches) const
+  {
+    const Table *table = _table.load(std::memory_order_acquire);
+    for (std::size_t i = table->home(keyPairId);; i = (i + 1) & table->mask) {
+      const Entry &entry = table->entries[i];
+      std::uintptr_t value = entry.value.load(std::memory_order_acquire);
+      if (value == empty) return nullptr;
+      if (value == erased || entry.keyPairId.load(std::memory_order_relaxed) != keyPairId) continue;
+      const T *found = reinterpret_cast<const T *>(value);
+      if (matches(found)) return found;
+    }
+  }
+
+  const T *find(const KeyPairId &keyPairId) const
+  {
+    return findIf(keyPairId, [](const T *) { return true; });
+  }
+
+  void prefetch(const KeyPairId &keyPairId) const
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    const Table *table = _table.load(std::memory_order_acquire);
+    __builtin_prefetch(&table->entries[table->home(keyPairId)]);
+#else
+    (void)keyPairId;
+#endif
+  }
+
+  /**
+    * @brief insert()
+    *
+    * Add keyPairId => value, (even if keyPairId is present already)
+    *
+    */
+  void insert(const KeyPairId &keyPairId, const T *value)
+  {
+    Table *table = _table.load(std::memory_order_relaxed);
+    if (_used + 1 > table->limit()) table = rebuild(bucketCountFor(_size + 1));
+    std::size_t i = table->home(keyPairId);
+    while (table->entries[i].value.load(std::memory_order_relaxed) != empty) i = (i + 1) & table->mask;
+    table->entries[i].keyPairId.store(keyPairId, std::memory_order_relaxed);
+    table->entries[i].value.store(reinterpret_cast<std::uintptr_t>(value), std::memory_order_release);
+    ++_used;
+    ++_size;
+  }
+
+  /**
+    * @brief erase()
+    * @return false if keyPairId => value was not present
+    */
+  bool erase(const KeyPairId &keyPairId, const T *value)
+  {
+    Table *table = _table.load(std::memory_order_relaxed);
+    auto bits = reinterpret_cast<std::uintptr_t>(value);
+    for (std::size_t i = table->home(keyPairId);; i = (i + 1) & table->mask) {
+      Entry &entry = table->entries[i];
+      std::uintptr_t stored = entry.value.load(std::memory_order_relaxed);
+      if (stored == empty) return false;
+      if (stored == bits && entry.keyPairId.load(std::memory_order_relaxed) == keyPairId) {
+        entry.value.store(erased, std::memory_order_release);
+        --_size;
+        return true;
+      }
+    }
+  }
+
+  /**
+    * @brief reserve()
+    *
+    * Rebuild the table so that capacity entries fit, (writer side)
+    *
+    */
+  void reserve(std::size_t capacity)
+  {
+    if (bucketCountFor(capacity) > _table.load(std::memory_order_relaxed)->mask + 1) rebuild(bucketCountFor(capacity));
+  }
+
+  /**
+    * @brief forEach()
+    *
+    * Visit every (keyPairId, value) pair, (writer side, or after enter())
+    *
+    */
+  template<typename Visitor>
+  void forEach(Visitor &&visitor) const
+  {
+    const Table *table = _table.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i <= table->mask; ++i) {
+      std::uintptr_t value = table->entries[i].value.load(std::memory_order_acquire);
+      if (value != empty && value != erased)
+        visitor(table->entries[i].keyPairId.load(std::memory_order_relaxed), reinterpret_cast<const T *>(value));
+    }
+  }
+
+  std::size_t size() const { return _size; }
+};
+
+#endif// _EPOCHINDEX_HPP
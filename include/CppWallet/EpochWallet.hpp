@@ -0,0 +1,127 @@
+#ifndef _EPOCHWALLET_HPP
+#define _EPOCHWALLET_HPP
+
+/**
+ * @brief EpochWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that find...() is the hottest path of the service
+ * WHEN other threads store() and remove() KeyPairs meanwhile
+ * THEN lookups must take no lock, and the references they return must
+ *      not dangle because of a concurrent remove()
+ *
+ */
+
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "EpochIndex.hpp"
+#include "KeyPairIds.hpp"
+#include "KeyPairRecord.hpp"
+#include "LockedMemory.hpp"
+#include "WalletInterface.hpp"
+
+/**
+  * @brief EpochWallet
+  *
+  * Thread-safe implementation of WalletInterface whose lookups never take
+  * a lock. retrieve(), find...(), try...() and findManyByPublicKeyId()
+  * read EpochIndex tables, store() and remove() are serialized by a mutex,
+  * (as are the list...() methods), and removed KeyPairs are handed to
+  * EpochDomain::retire() rather than deleted.
+  *
+  * @note a reference, (or pointer), returned to a thread stays valid
+  * until that thread's next call to an EpochWallet, even if the KeyPair is
+  * removed meanwhile. To keep several of them, hold an EpochGuard:
+  *
+  *   EpochGuard guard;
+  *   const auto &a = wallet.findByPublicKey(keyA);
+  *   const auto &b = wallet.findByPublicKey(keyB);// a is still good
+  *
+  * @note a thread done with a Wallet for a while should call
+  * EpochDomain::instance().quiesce(), (see EpochDomain).
+  *
+  * @note records come from resource, (lockedMemoryResource() unless told
+  * otherwise, see LockedMemory.hpp), and are wiped when destroyed. A
+  * removed record may be destroyed after the EpochWallet is, so resource
+  * has to outlive the EpochDomain's retired objects too. Past
+  * RLIMIT_MEMLOCK records go on unlocked, (see LockedMemory.hpp).
+  *
+  */
+class EpochWallet implements WalletInterface
+{
+  using Slot = KeyPairIndex::Slot;
+
+  struct Record
+  {
+    KeyPairRecord keyPair;
+    Slot slot;
+    std::pmr::memory_resource *resource;// to give it back to, (it may outlive the EpochWallet)
+
+    Record(const KeyPairInterface &keyPair, Slot slot, std::pmr::memory_resource *resource)
+      : keyPair(keyPair), slot(slot), resource(resource) {}
+  };
+
+  KeyPairIdMode _idMode;
+  std::pmr::memory_resource *_resource;
+  EpochDomain &_epochs;
+  mutable std::mutex _lock;// writers, and listing
+  std::vector<const Record *> _slots;
+  std::vector<Slot> _freeSlots;
+  EpochIndex<Record> _byKeyPairId;
+  EpochIndex<Record> _byPublicKeyId;
+  EpochIndex<Record> _byPrivateKeyId;
+
+  const Record *findPublicKey(const KeyPairId &publicKeyId, std::string_view publicKey) const;
+  const Record *findPrivateKey(const KeyPairId &privateKeyId, std::string_view privateKey) const;
+  WalletStatus insert(const KeyPairInterface &keyPair, KeyPairId &clash);
+  WalletStatus erase(const KeyPairId &keyPairId);
+
+  static const KeyPairInterface *keyPairOf(const Record *record) { return record != nullptr ? &record->keyPair : nullptr; }
+  static void destroy(void *record);
+
+public:
+  explicit EpochWallet(KeyPairIdMode idMode = KeyPairIdMode::Crc32, std::pmr::memory_resource *resource = lockedMemoryResource());
+  virtual ~EpochWallet();
+
+  EpochWallet(const EpochWallet &) = delete;
+  EpochWallet &operator=(const EpochWallet &) = delete;
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  /**
+    * @brief size()
+    * @return the number of KeyPairs stored, (a moment ago)
+    */
+  std::size_t size() const;
+  KeyPairIdMode idMode() const { return _idMode; }
+};
+
+#endif// _EPOCHWALLET_HPP
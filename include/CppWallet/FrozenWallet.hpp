@@ -0,0 +1,244 @@
+#ifndef _FROZENWALLET_HPP
+#define _FROZENWALLET_HPP
+
+/**
+ * @brief FrozenWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a watch-only Wallet that never changes once loaded
+ * WHEN its KeyPairs are looked up
+ * THEN every lookup should be a single probe, (a minimal perfect hash),
+ *      and the snapshot should load from disk as fast as a mapping does
+ *
+ * The frozen Wallet file format, (an image of the FrozenWallet in memory):
+ *
+ *   FrozenWalletHeader                     256 bytes
+ *   WalletFileRecord[count]                in keyPairId position order
+ *   uint32_t[buckets]                      keyPairId pilots
+ *   uint32_t[buckets] x 2                  publicKeyId, privateKeyId pilots
+ *   FrozenWalletEntry[keys] x 2            publicKeyId, privateKeyId tables
+ *   uint32_t[overflowCount] x 2            records sharing an id
+ *
+ * Every section starts on a 4096 byte boundary, numbers are in the byte
+ * order of the machine, (as in WalletFile.hpp).
+ *
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "KeyPairIds.hpp"
+#include "LockedMemory.hpp"
+#include "PerfectHash.hpp"
+#include "WalletFile.hpp"
+#include "WalletInterface.hpp"
+
+/**
+  * @brief FrozenWalletHash
+  *
+  * Where to find a PerfectHash in the image, (and what it was built with)
+  *
+  */
+struct FrozenWalletHash
+{
+  std::uint64_t seed;
+  std::uint64_t keys;
+  std::uint64_t buckets;
+  std::uint64_t pilotsOffset;
+};
+
+/**
+  * @brief FrozenWalletTable
+  *
+  * A publicKeyId or privateKeyId table: one FrozenWalletEntry per distinct
+  * id, at its PerfectHash position
+  *
+  */
+struct FrozenWalletTable
+{
+  FrozenWalletHash hash;
+  std::uint64_t entriesOffset;
+  std::uint64_t overflowOffset;
+  std::uint64_t overflowCount;
+  std::uint64_t reserved;
+};
+
+struct FrozenWalletHeader
+{
+  static constexpr char expectedMagic[8] = { 'C', 'P', 'P', 'W', 'F', 'R', 'Z', 'N' };
+  static constexpr std::uint32_t currentVersion = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;// WalletFileHeader::littleEndian as written
+  std::uint32_t idMode;// KeyPairIdMode
+  std::uint32_t reserved0;
+  std::uint64_t count;
+  std::uint64_t recordsOffset;
+  std::uint64_t fileSize;
+  FrozenWalletHash byKeyPairId;
+  FrozenWalletTable byPublicKeyId;
+  FrozenWalletTable byPrivateKeyId;
+  std::uint32_t bodyChecksum;// crc32() of everything after the header
+  std::uint32_t headerChecksum;// crc32() of the header up to here
+  char reserved[40];
+};
+
+/**
+  * @brief FrozenWalletEntry
+  *
+  * count 1 - slot is the record of id
+  * count n - slot is the first of the n record numbers in the overflow
+  *           section, (different keys sharing a CRC32 id)
+  *
+  */
+struct FrozenWalletEntry
+{
+  KeyPairId id;
+  std::uint32_t slot;
+  std::uint32_t count;
+};
+
+static_assert(sizeof(FrozenWalletHeader) == 256, "the header is 256 bytes");
+static_assert(sizeof(FrozenWalletEntry) == 16, "an entry is 16 bytes");
+
+/**
+  * @brief FrozenWallet
+  *
+  * Read-only implementation of WalletInterface built once, (frozen), from
+  * another Wallet. Each record sits at the PerfectHash position of its
+  * keyPairId, so retrieve() is a pilot and a record; the publicKeyId and
+  * privateKeyId tables hold exactly one entry per distinct id, so a key
+  * based lookup is a pilot, an entry and a record.
+  *
+  *   FrozenWallet frozen(wallet, wallet.idMode());
+  *   frozen.write("keys.frozen");
+  *   ...
+  *   FrozenWallet loaded("keys.frozen");// mapped, nothing to rebuild
+  *
+  * @note store(), remove(), storeMany() and removeMany() throw
+  * WalletReadOnlyException.
+  *
+  * @note lookups are thread-safe, (as with MappedWallet).
+  *
+  * @note a FrozenWallet frozen here keeps its image, (and builds it), in
+  * lockedMemoryResource(), a loaded one is a read-only mapping of the file.
+  *
+  */
+class FrozenWallet implements WalletInterface
+{
+  using Slot = std::uint32_t;
+
+  std::string _path;
+  std::pmr::vector<std::uint64_t> _image{ lockedMemoryResource() };// when frozen here
+  int _fd = -1;// when loaded
+  const char *_map = nullptr;
+  std::size_t _mapSize = 0;
+
+  const FrozenWalletHeader *_header = nullptr;
+  const WalletFileRecord *_records = nullptr;
+  PerfectHash _byKeyPairId;
+  PerfectHash _byPublicKeyId;
+  PerfectHash _byPrivateKeyId;
+  const FrozenWalletEntry *_publicKeyEntries = nullptr;
+  const FrozenWalletEntry *_privateKeyEntries = nullptr;
+  const std::uint32_t *_publicKeyOverflow = nullptr;
+  const std::uint32_t *_privateKeyOverflow = nullptr;
+  KeyPairIdMode _idMode = KeyPairIdMode::Crc32;
+
+  // made lazily, as MappedWallet does
+  WalletFileKeyPair *_views = nullptr;
+  std::atomic<std::uint8_t> *_made = nullptr;
+
+  const char *base() const { return _map != nullptr ? _map : reinterpret_cast<const char *>(_image.data()); }
+  void attach();
+  void close();
+  [[noreturn]] void fail(const std::string &reason);
+  const KeyPairInterface *view(Slot slot) const;
+  template<typename Predicate>
+  const KeyPairInterface *lookup(const PerfectHash &hash, const FrozenWalletEntry *entries, const FrozenWalletTable &table,
+    const std::uint32_t *overflow, const KeyPairId &id, Predicate &&matches) const;
+
+public:
+  /**
+    * @brief FrozenWallet()
+    *
+    * Freeze every KeyPair of wallet, (idMode tells findByPublicKey() and
+    * findByPrivateKey() how to derive ids from keys, see KeyPairIds.hpp)
+    *
+    * @exception WalletFileException if wallet holds 2^31 KeyPairs or more
+    */
+  FrozenWallet(const WalletInterface &wallet, KeyPairIdMode idMode);
+
+  /**
+    * @brief FrozenWallet()
+    *
+    * Map a file written by write()
+    *
+    * @exception WalletFileException if path cannot be read or is not a
+    * valid frozen Wallet file
+    */
+  explicit FrozenWallet(const std::string &path);
+  virtual ~FrozenWallet();
+
+  FrozenWallet(const FrozenWallet &) = delete;
+  FrozenWallet &operator=(const FrozenWallet &) = delete;
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  std::size_t size() const { return _header->count; }
+  KeyPairIdMode idMode() const { return _idMode; }
+
+  /**
+    * @brief memorySize()
+    * @return the bytes of the image, (records, pilots and tables)
+    */
+  std::size_t memorySize() const { return _header->fileSize; }
+
+  /**
+    * @brief write()
+    *
+    * Write the image out, (under a temporary name, flushed and renamed,
+    * as WalletFileWriter does)
+    *
+    * @exception WalletFileException
+    */
+  void write(const std::string &path) const;
+
+  /**
+    * @brief verify()
+    * @return whether the body checksum matches, (reads every page)
+    */
+  bool verify() const;
+};
+
+#endif// _FROZENWALLET_HPP
@@ -0,0 +1,33 @@
+#ifndef _HASH64_HPP
+#define _HASH64_HPP
+
+/**
+ * @brief Hash64
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a CRC32 only has 32 bits to spread millions of keys over
+ * WHEN the Wallet holds enough keys for CRC32 values to collide
+ * THEN a fast 64-bit hash gives KeyPairIds that practically never collide
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+  * @brief hash64()
+  *
+  * A non-cryptographic 64-bit hash in the style of wyhash, (each 128-bit
+  * multiply folds in another 16 bytes of the input).
+  *
+  */
+std::uint64_t hash64(const void *data, std::size_t length, std::uint64_t seed = 0);
+
+inline std::uint64_t hash64(std::string_view data, std::uint64_t seed = 0)
+{
+  return hash64(data.data(), data.size(), seed);
+}
+
+#endif// _HASH64_HPP
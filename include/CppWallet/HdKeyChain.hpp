@@ -0,0 +1,207 @@
+#ifndef _HDKEYCHAIN_HPP
+#define _HDKEYCHAIN_HPP
+
+/**
+ * @brief HdKeyChain
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a Hierarchical Deterministic (HD) wallet derives all of its
+ *       KeyPairs from one seed, (BIP32)
+ * WHEN an address-gap scan derives thousands of sequential children of
+ *      an account's chain
+ * THEN the extended keys along the path, (account, chain), are kept, so
+ *      that each child is one step from its parent rather than a walk
+ *      from the root
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "KeyPair.hpp"
+#include "KeyPairIds.hpp"
+#include "LockedMemory.hpp"
+#include "WalletInterface.hpp"
+
+using HdPath = std::vector<std::uint32_t>;
+
+static constexpr std::uint32_t hdHardened = 0x80000000u;
+
+/**
+  * @brief hdPath()
+  *
+  * The HdPath of "m/44'/0'/0'/0", (', h or H marking a hardened index)
+  *
+  * @exception std::invalid_argument if text is not such a path
+  */
+HdPath hdPath(std::string_view text);
+
+/**
+  * @brief hdPathText()
+  * @return path as hdPath() reads it, ("m/44'/0'/0'/0")
+  */
+std::string hdPathText(const HdPath &path);
+
+/**
+  * @brief HdExtendedKey
+  *
+  * An extended private key, (BIP32), with its public key worked out once,
+  * (it is what a non-hardened child is made from).
+  *
+  */
+struct HdExtendedKey
+{
+  std::uint8_t chainCode[32];
+  std::uint8_t privateKey[32];
+  std::uint8_t publicKey[33];// compressed
+  std::uint8_t depth;
+  std::uint32_t childNumber;
+};
+
+/**
+  * @brief hdMasterKey()
+  *
+  * The master key of seed, (HMAC-SHA512 keyed with "Bitcoin seed")
+  *
+  * @return false in the 1 in 2^127 case of a seed with no valid master key
+  */
+bool hdMasterKey(const void *seed, std::size_t size, HdExtendedKey &master);
+
+/**
+  * @brief hdChildKey()
+  *
+  * The child index of parent, (CKDpriv: hardened from the parent's
+  * private key, otherwise from its public key)
+  *
+  * @return false in the 1 in 2^127 case of an index with no valid child,
+  * (BIP32: go on with the next index)
+  */
+bool hdChildKey(const HdExtendedKey &parent, std::uint32_t index, HdExtendedKey &child);
+
+/**
+  * @brief HdKeyChainOptions
+  *
+  *   idMode   - the ids of the KeyPairs derived, (see KeyPairIds.hpp)
+  *   maxNodes - extended keys kept, (the master aside), the cache is
+  *              emptied when full
+  *
+  */
+struct HdKeyChainOptions
+{
+  KeyPairIdMode idMode = KeyPairIdMode::Crc32;
+  std::size_t maxNodes = 4096;
+};
+
+/**
+  * @brief HdKeyChainStats
+  *
+  *   childSteps - hdChildKey() calls
+  *   nodes      - extended keys kept, (the master included)
+  *
+  */
+struct HdKeyChainStats
+{
+  std::uint64_t childSteps = 0;
+  std::size_t nodes = 0;
+};
+
+/**
+  * @brief HdKeyChain
+  *
+  * The KeyPairs of a BIP32 seed. The extended keys of the paths walked
+  * are kept by path, (the leaves are not), and a path is derived from
+  * the longest of its prefixes that is kept, so the children of a chain
+  * are one hdChildKey() each:
+  *
+  *   HdKeyChain chain(seed);
+  *   HdPath receive = hdPath("m/44'/0'/0'/0");
+  *   chain.storeInto(wallet, receive, 0, 20);// m/44'/0'/0'/0/0 .. 19
+  *   chain.storeInto(wallet, receive, 20, 20);// one step each
+  *
+  * @note the extended keys are kept in memory from resource, (by default
+  * the LockedMemoryResource, see LockedMemory.hpp), and wiped when let
+  * go of.
+  *
+  * @note not thread-safe, (as Wallet is not).
+  *
+  */
+class HdKeyChain
+{
+  HdKeyChainOptions _options;
+  std::pmr::map<HdPath, HdExtendedKey> _nodes;
+  HdKeyChainStats _stats;
+
+  const HdExtendedKey &cached(const HdPath &path, std::size_t length);
+  KeyPair keyPairOf(const HdExtendedKey &key) const;
+  template<typename KeyPairs>
+  void deriveInto(const HdPath &parent, std::uint32_t first, std::size_t count, KeyPairs &keyPairs);
+
+public:
+  /**
+    * @brief HdKeyChain()
+    * @exception std::invalid_argument if seed is not 16 to 64 bytes, (or
+    * has no valid master key)
+    */
+  explicit HdKeyChain(std::string_view seed, const HdKeyChainOptions &options = HdKeyChainOptions(),
+    std::pmr::memory_resource *resource = lockedMemoryResource());
+  ~HdKeyChain();
+
+  HdKeyChain(const HdKeyChain &) = delete;
+  HdKeyChain &operator=(const HdKeyChain &) = delete;
+
+  /**
+    * @brief node()
+    * @return the extended key at path, (kept, as are its ancestors)
+    * @exception std::invalid_argument if an index on path has no child
+    */
+  const HdExtendedKey &node(const HdPath &path);
+
+  /**
+    * @brief keyPair()
+    * @return the KeyPair at path, (its ancestors kept, the caller wipe()s
+    * the KeyPair once done)
+    * @exception std::invalid_argument if an index on path has no child
+    */
+  KeyPair keyPair(const HdPath &path);
+
+  /**
+    * @brief derive()
+    *
+    * The KeyPairs of the children first .. first + count - 1 of parent
+    * appended to keyPairs, (an index with no valid child is skipped)
+    *
+    * @note the KeyPairs hold private keys: a std::pmr::vector on
+    * lockedMemoryResource() wipes them when given back, a std::vector
+    * does not, (its caller calls KeyPair::wipe() once done, and a
+    * reallocation leaves copies behind unless it reserved first).
+    */
+  void derive(const HdPath &parent, std::uint32_t first, std::size_t count, std::vector<KeyPair> &keyPairs);
+  void derive(const HdPath &parent, std::uint32_t first, std::size_t count, std::pmr::vector<KeyPair> &keyPairs);
+
+  /**
+    * @brief storeInto()
+    *
+    * derive() then wallet.storeMany()
+    *
+    * @return the KeyPairs stored, (those the wallet had already are not)
+    */
+  std::size_t storeInto(WalletInterface &wallet, const HdPath &parent, std::uint32_t first, std::size_t count);
+
+  /**
+    * @brief clear()
+    *
+    * Forgets every extended key but the master
+    *
+    */
+  void clear();
+
+  const HdKeyChainStats &stats() const { return _stats; }
+  const HdKeyChainOptions &options() const { return _options; }
+};
+
+#endif// _HDKEYCHAIN_HPP
@@ -0,0 +1,109 @@
+#ifndef _INLINEKEY_HPP
+#define _INLINEKEY_HPP
+
+/**
+ * @brief InlineKey
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that public and private keys have a small, known maximum size
+ * WHEN a Wallet stores millions of them
+ * THEN keeping the key bytes inside the KeyPair saves two heap blocks
+ *      and two pointer chases per KeyPair
+ *
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "LockedMemory.hpp"
+
+/**
+  * @brief InlineKey
+  *
+  * Up to Capacity bytes of key material stored in place, (no heap).
+  * Converts from std::string, const char * and std::string_view, and to
+  * std::string_view, so it can stand in where a std::string was used.
+  *
+  * @note unused bytes are kept zeroed, (an InlineKey is trivially
+  * copyable and can be written to disk as is).
+  *
+  * @note being trivially copyable, an InlineKey has no destructor to wipe
+  * it: whatever holds key material past its use calls wipe().
+  *
+  */
+template<std::size_t Capacity>
+class InlineKey
+{
+  static_assert(Capacity > 0 && Capacity < 256, "the size is kept in one byte");
+
+  std::uint8_t _size = 0;
+  char _bytes[Capacity] = {};
+
+public:
+  static constexpr std::size_t capacity = Capacity;
+
+  InlineKey() = default;
+  InlineKey(std::string_view key) { assign(key); }
+  InlineKey(const std::string &key) { assign(key); }
+  InlineKey(const char *key) { assign(key); }
+
+  template<std::size_t OtherCapacity>
+  InlineKey(const InlineKey<OtherCapacity> &key) { assign(key.view()); }
+
+  /**
+    * @brief assign()
+    * @exception std::length_error if key does not fit
+    */
+  void assign(std::string_view key)
+  {
+    if (key.size() > Capacity) throw std::length_error("key exceeds " + std::to_string(Capacity) + " bytes");
+    std::memcpy(_bytes, key.data(), key.size());
+    std::memset(_bytes + key.size(), 0, Capacity - key.size());
+    _size = static_cast<std::uint8_t>(key.size());
+  }
+
+  /**
+    * @brief wipe()
+    *
+    * Zero the key bytes, (secureZero()), leaving an empty key
+    *
+    */
+  void wipe()
+  {
+    secureZero(_bytes, Capacity);
+    _size = 0;
+  }
+
+  const char *data() const { return _bytes; }
+  std::size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  std::string_view view() const { return std::string_view(_bytes, _size); }
+  operator std::string_view() const { return view(); }
+  std::string str() const { return std::string(_bytes, _size); }
+
+  friend bool operator==(const InlineKey &a, const InlineKey &b)
+  {
+    return a._size == b._size && std::memcmp(a._bytes, b._bytes, a._size) == 0;
+  }
+
+  friend bool operator!=(const InlineKey &a, const InlineKey &b) { return !(a == b); }
+
+  friend std::ostream &operator<<(std::ostream &out, const InlineKey &key)
+  {
+    return out << key.view();
+  }
+};
+
+/**
+  * the key types used by the Wallet, (a private key is 32 bytes, a
+  * public key 33 bytes compressed or 65 bytes uncompressed)
+  */
+using InlinePrivateKey = InlineKey<32>;
+using InlinePublicKey = InlineKey<65>;
+
+#endif// _INLINEKEY_HPP
@@ -0,0 +1,109 @@
+#ifndef _IOBACKEND_HPP
+#define _IOBACKEND_HPP
+
+/**
+ * @brief IoBackend
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a Wallet kept on NVMe, (see DiskWallet)
+ * WHEN many cold KeyPairs are looked up at once
+ * THEN their reads should be in flight together, (one blocking pread()
+ *      after another leaves most of the device idle)
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <extras/interfaces.hpp>
+
+/**
+  * @brief IoBackendKind
+  *
+  *   Pread - one blocking pread()/pwrite() after another, (portable)
+  *   Uring - io_uring, queueDepth requests in flight, submitted and
+  *           reaped in batches, (Linux 5.6 and later)
+  *
+  */
+enum class IoBackendKind : std::uint8_t {
+  Pread,
+  Uring
+};
+
+/**
+  * @brief IoRequest
+  *
+  * One read or write of size bytes at offset. result is set to the bytes
+  * transferred, (fewer than size only at the end of a file), or -errno.
+  *
+  */
+struct IoRequest
+{
+  int fd;
+  void *buffer;
+  std::size_t size;
+  std::uint64_t offset;
+  std::int64_t result;
+};
+
+/**
+  * @brief IoBackendInterface
+  *
+  * Runs batches of IoRequests, each call returning once all of them are
+  * done, (short transfers are continued, EINTR retried).
+  *
+  * @note an IoBackendInterface instance is not thread-safe.
+  *
+  */
+interface IoBackendInterface
+{
+  virtual ~IoBackendInterface() = default;
+
+  virtual void read(IoRequest *requests, std::size_t count) pure;
+
+  /**
+    * @brief write()
+    *
+    * Write every request, then, if sync, fdatasync() the file of the
+    * requests, (which must then all be to the same file)
+    *
+    * @return 0, or the -errno of the first write or sync that failed
+    */
+  virtual int write(IoRequest *requests, std::size_t count, bool sync) pure;
+
+  virtual IoBackendKind kind() const pure;
+  virtual unsigned queueDepth() const pure;
+};
+
+/**
+  * @brief makeIoBackend()
+  *
+  * @return an IoBackendInterface of the kind asked for, (or a Pread one
+  * where io_uring is not available: not Linux, an old kernel, seccomp)
+  */
+std::unique_ptr<IoBackendInterface> makeIoBackend(IoBackendKind kind, unsigned queueDepth = 64);
+
+/**
+  * @brief IoCompletionFilter
+  *
+  * Sees the result of each io_uring completion, (request is nullptr for
+  * the sync), and returns the result the backend goes on with
+  *
+  */
+using IoCompletionFilter = std::function<int(const IoRequest *request, int result)>;
+
+/**
+  * @brief makeIoBackend()
+  *
+  * Same as makeIoBackend() but with every io_uring completion passed
+  * through filter, (for testing: the -EAGAIN and short transfers a
+  * kernel rarely produces on demand)
+  *
+  */
+std::unique_ptr<IoBackendInterface> makeIoBackend(IoBackendKind kind, unsigned queueDepth, IoCompletionFilter filter);
+
+const char *nameOf(IoBackendKind kind);
+
+#endif// _IOBACKEND_HPP
@@ -0,0 +1,123 @@
+#ifndef _KEYPAIR_HPP
+#define _KEYPAIR_HPP
+
+/**
+ * @brief KeyPair
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that KeyPairInterface is all virtual accessors
+ * WHEN a Wallet keeps millions of KeyPairs in flat arrays
+ * THEN it needs a concrete KeyPair whose ids are worked out once, whose
+ *      bytes are all in one place, (no heap), and whose calls need no
+ *      dispatch, (see BasicWallet)
+ *
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include "KeyPairIds.hpp"
+#include "KeyPairInterface.hpp"
+#include "LockedMemory.hpp"
+
+/**
+  * @brief KeyPair
+  *
+  * The value type of a KeyPair: the three ids, (computed once, when it is
+  * made from its keys), and the key bytes, (InlineKey), in a record that
+  * starts on a cache line. The ids and the public key, (what a lookup
+  * reads), come first, so a lookup touches the first two lines only.
+  *
+  *   KeyPair keyPair(publicKey, privateKey, KeyPairIdMode::Hash64);
+  *   std::vector<KeyPair> keyPairs;// flat, (a copy is a copy of bytes)
+  *
+  * @note final, so calls through a KeyPair are direct, (inlined).
+  *
+  * @note a KeyPair owns nothing, copying or moving one copies its bytes
+  * and there is nothing to destroy, (it relocates as a trivially copyable
+  * type would, its virtual table pointer being the same for every KeyPair).
+  * Nothing wipes it either: whatever holds KeyPairs past their use calls
+  * wipe(), (or keeps them in a LockedMemoryResource, which wipes what is
+  * given back).
+  *
+  */
+class alignas(64) KeyPair final implements KeyPairInterface
+{
+  KeyPairId _keyPairId;
+  KeyPairId _publicKeyId;
+  KeyPairId _privateKeyId;
+  KeyPairPublicKey _publicKey;
+  KeyPairPrivateKey _privateKey;
+
+public:
+  static constexpr std::size_t cacheLine = 64;
+
+  /**
+    * @brief KeyPair()
+    *
+    * No keys, (ids 0), a place for one to be copied to, (see
+    * KeyPairGenerator)
+    *
+    */
+  KeyPair() : _keyPairId(0), _publicKeyId(0), _privateKeyId(0) {}
+
+  /**
+    * @brief KeyPair()
+    *
+    * The ids of publicKey and privateKey, (see KeyPairIds.hpp)
+    *
+    */
+  KeyPair(const KeyPairPublicKey &publicKey, const KeyPairPrivateKey &privateKey, KeyPairIdMode mode = KeyPairIdMode::Crc32)
+    : _keyPairId(keyPairIdOf(publicKey, privateKey, mode)),
+      _publicKeyId(publicKeyIdOf(publicKey, mode)),
+      _privateKeyId(privateKeyIdOf(privateKey, mode)),
+      _publicKey(publicKey),
+      _privateKey(privateKey) {}
+
+  /**
+    * @brief KeyPair()
+    *
+    * A copy of keyPair, (its ids as they are)
+    *
+    */
+  explicit KeyPair(const KeyPairInterface &keyPair)
+    : _keyPairId(keyPair.keyPairId()),
+      _publicKeyId(keyPair.publicKeyId()),
+      _privateKeyId(keyPair.privateKeyId()),
+      _publicKey(keyPair.publicKey()),
+      _privateKey(keyPair.privateKey()) {}
+
+  KeyPair(const KeyPair &) = default;
+  KeyPair &operator=(const KeyPair &) = default;
+
+  /**
+    * @brief wipe()
+    *
+    * Zero both keys, (InlineKey::wipe()), and the ids, (the privateKeyId
+    * is a hash of the private key)
+    *
+    */
+  void wipe()
+  {
+    secureZero(&_keyPairId, sizeof(_keyPairId));
+    secureZero(&_publicKeyId, sizeof(_publicKeyId));
+    secureZero(&_privateKeyId, sizeof(_privateKeyId));
+    _publicKey.wipe();
+    _privateKey.wipe();
+  }
+
+  virtual KeyPairId generate(const KeyPairSeedList &) const override { return _keyPairId; }
+
+  virtual const KeyPairId &keyPairId() const override { return _keyPairId; }
+  virtual const KeyPairPublicKey &publicKey() const override { return _publicKey; }
+  virtual const KeyPairId &publicKeyId() const override { return _publicKeyId; }
+  virtual const KeyPairPrivateKey &privateKey() const override { return _privateKey; }
+  virtual const KeyPairId &privateKeyId() const override { return _privateKeyId; }
+};
+
+static_assert(alignof(KeyPair) == KeyPair::cacheLine, "a KeyPair starts on a cache line");
+static_assert(sizeof(KeyPair) == 3 * KeyPair::cacheLine, "a KeyPair is three cache lines, (131 bytes used)");
+static_assert(std::is_trivially_destructible<KeyPair>::value, "a KeyPair owns nothing");
+static_assert(std::is_nothrow_copy_constructible<KeyPair>::value, "copying a KeyPair copies bytes");
+
+#endif// _KEYPAIR_HPP
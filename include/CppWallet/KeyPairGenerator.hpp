@@ -0,0 +1,142 @@
+#ifndef _KEYPAIRGENERATOR_HPP
+#define _KEYPAIRGENERATOR_HPP
+
+/**
+ * @brief KeyPairGenerator
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that KeyPairInterface::generate() makes one KeyPair from a list
+ *       of seeds
+ * WHEN an onboarding job makes hundreds of thousands of them up front
+ * THEN the seed lists are spread over a pool of threads, the entropy is
+ *      drawn once per chunk, (from the thread's EntropyPool), and each
+ *      KeyPair leaves with its public key and its ids
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "KeyPair.hpp"
+#include "KeyPairIds.hpp"
+#include "KeyPairInterface.hpp"
+
+/**
+  * @brief KeyPairGeneratorOptions
+  *
+  *   threads       - generating threads, (the caller being one of them),
+  *                   0 - std::thread::hardware_concurrency()
+  *   idMode        - the ids of the KeyPairs generated, (see KeyPairIds.hpp)
+  *   chunk         - KeyPairs a thread takes at a time, (and draws the
+  *                   entropy for in one go)
+  *   deterministic - the private key comes from the seeds alone, (no
+  *                   entropy: the same seeds make the same KeyPair, for
+  *                   tests and for keys recovered from their seeds)
+  *
+  */
+struct KeyPairGeneratorOptions
+{
+  unsigned threads = 0;
+  KeyPairIdMode idMode = KeyPairIdMode::Crc32;
+  std::size_t chunk = 256;
+  bool deterministic = false;
+};
+
+/**
+  * @brief KeyPairGenerator
+  *
+  * Makes secp256k1 KeyPairs, (see Secp256k1.hpp), from lists of seeds:
+  *
+  *   private key = SHA-256(entropy, seeds, counter)
+  *   public key  = private key * G, (compressed, 33 bytes)
+  *
+  * each seed hashed with its length, (so that {"ab", "c"} and {"a", "bc"}
+  * differ), the counter counting up in the 1 in 2^128 case of a hash that
+  * is not a valid private key. generate() of a batch cuts it into chunks
+  * the threads of the pool, (and the caller), take in turn; each KeyPair
+  * is written where its seeds were, so the order is kept.
+  *
+  *   KeyPairGenerator generator;
+  *   std::vector<KeyPair> keyPairs;
+  *   generator.generate(seedLists, keyPairs);
+  *
+  * @note one batch at a time, (generate() is not reentrant, concurrent
+  * callers are served in turn).
+  *
+  * @note the KeyPairs hold private keys: a std::pmr::vector on
+  * lockedMemoryResource() wipes them when given back, a std::vector, (or
+  * a single KeyPair returned), does not, its caller calls KeyPair::wipe()
+  * once done, (and a reallocation leaves copies behind unless it
+  * reserved first).
+  *
+  */
+class KeyPairGenerator
+{
+  KeyPairGeneratorOptions _options;
+  std::vector<std::thread> _threads;
+
+  std::mutex _batchLock;// one batch at a time
+  std::mutex _lock;
+  std::condition_variable _started;
+  std::condition_variable _finished;
+  std::uint64_t _batch = 0;
+  unsigned _busy = 0;
+  bool _stopping = false;
+
+  std::function<void(std::size_t)> _chunkTask;
+  std::size_t _chunks = 0;
+  std::atomic<std::size_t> _nextChunk{ 0 };
+  std::exception_ptr _error;
+
+  void work();
+  void runChunks();
+  void run(std::size_t chunks, std::function<void(std::size_t)> chunkTask);
+  KeyPair make(const KeyPairSeedList &seeds, const std::uint8_t *entropy, const std::uint64_t *index) const;
+  void generateInto(const std::vector<KeyPairSeedList> &seedLists, KeyPair *keyPairs);
+  void generateInto(std::size_t count, const KeyPairSeedList &seeds, KeyPair *keyPairs);
+
+public:
+  explicit KeyPairGenerator(const KeyPairGeneratorOptions &options = KeyPairGeneratorOptions());
+  ~KeyPairGenerator();
+
+  KeyPairGenerator(const KeyPairGenerator &) = delete;
+  KeyPairGenerator &operator=(const KeyPairGenerator &) = delete;
+
+  /**
+    * @brief generate()
+    * @return a KeyPair made from seeds, (on the calling thread)
+    */
+  KeyPair generate(const KeyPairSeedList &seeds);
+
+  /**
+    * @brief generate()
+    *
+    * keyPairs[i] made from seedLists[i], (keyPairs is resized)
+    *
+    */
+  void generate(const std::vector<KeyPairSeedList> &seedLists, std::vector<KeyPair> &keyPairs);
+  void generate(const std::vector<KeyPairSeedList> &seedLists, std::pmr::vector<KeyPair> &keyPairs);
+
+  /**
+    * @brief generate()
+    *
+    * count KeyPairs made from the same seeds, (their entropy differing,
+    * or, when deterministic, their position in keyPairs)
+    *
+    */
+  void generate(std::size_t count, const KeyPairSeedList &seeds, std::vector<KeyPair> &keyPairs);
+  void generate(std::size_t count, const KeyPairSeedList &seeds, std::pmr::vector<KeyPair> &keyPairs);
+
+  unsigned threads() const { return unsigned(_threads.size()) + 1; }
+  const KeyPairGeneratorOptions &options() const { return _options; }
+};
+
+#endif// _KEYPAIRGENERATOR_HPP
@@ -0,0 +1,57 @@
+#ifndef _KEYPAIRIDPAGER_HPP
+#define _KEYPAIRIDPAGER_HPP
+
+#include <algorithm>
+#include "WalletInterface.hpp"
+
+/**
+  * @brief KeyPairIdPager
+  * 
+  * Walks any WalletInterface with listPage(), one page at a time:
+  * 
+  *   KeyPairIdPager pager(wallet, 4096);
+  *   while (pager.next())
+  *     for (auto keyPairId : pager.page()) ...
+  * 
+  * Memory stays at one page no matter how large the Wallet is, and
+  * cursor() can be saved to resume the walk, (in another process even).
+  * 
+  */
+class KeyPairIdPager
+{
+  const WalletInterface &_wallet;
+  std::size_t _limit;
+  KeyPairIdCursor _cursor;
+  KeyPairIdVector _page;
+
+public:
+  KeyPairIdPager(const WalletInterface &wallet, std::size_t limit, KeyPairIdCursor cursor = firstPage)
+    : _wallet(wallet), _limit(std::max<std::size_t>(limit, 1)), _cursor(cursor)
+  {
+    _page.reserve(_limit);
+  }
+
+  /**
+    * @brief next()
+    * @return false once the walk is over, (page() is then empty)
+    */
+  bool next()
+  {
+    if (_cursor == noMorePages) {
+      _page.clear();
+      return false;
+    }
+    _cursor = _wallet.listPage(_cursor, _limit, _page);
+    return !_page.empty() || _cursor != noMorePages;
+  }
+
+  const KeyPairIdVector &page() const { return _page; }
+
+  /**
+    * @brief cursor()
+    * @return where the walk resumes, (after the current page)
+    */
+  KeyPairIdCursor cursor() const { return _cursor; }
+};
+
+#endif// _KEYPAIRIDPAGER_HPP
@@ -0,0 +1,54 @@
+#ifndef _KEYPAIRIDS_HPP
+#define _KEYPAIRIDS_HPP
+
+/**
+ * @brief KeyPairIds
+ *
+ * The KeyPairId values recommended by KeyPairInterface:
+ *
+ *   publicKeyId  - CRC32 of the public key
+ *   privateKeyId - CRC32 of the private key
+ *   keyPairId    - CRC32 of the public key followed by the private key
+ *
+ * Given only a public (or private) key we can compute its id and search
+ * the Wallet with it, (see Wallet::findByPublicKey()). The ids are worked
+ * out from the bytes of the key, (a std::string_view), so a key sitting
+ * in a receive buffer needs no copy to be looked up.
+ *
+ * A CRC32 only fills 32 bits of a KeyPairId, so with millions of keys
+ * collisions become a certainty. KeyPairIdMode::Hash64 uses hash64()
+ * instead, which fills all 64 bits.
+ *
+ */
+
+#include <string_view>
+#include "KeyPairInterface.hpp"
+#include "Crc32.hpp"
+#include "Hash64.hpp"
+
+enum class KeyPairIdMode {
+  Crc32,
+  Hash64
+};
+
+inline KeyPairId publicKeyIdOf(std::string_view publicKey, KeyPairIdMode mode = KeyPairIdMode::Crc32)
+{
+  if (mode == KeyPairIdMode::Hash64) return static_cast<KeyPairId>(hash64(publicKey));
+  return static_cast<KeyPairId>(crc32(publicKey));
+}
+
+inline KeyPairId privateKeyIdOf(std::string_view privateKey, KeyPairIdMode mode = KeyPairIdMode::Crc32)
+{
+  if (mode == KeyPairIdMode::Hash64) return static_cast<KeyPairId>(hash64(privateKey));
+  return static_cast<KeyPairId>(crc32(privateKey));
+}
+
+inline KeyPairId keyPairIdOf(std::string_view publicKey,
+  std::string_view privateKey,
+  KeyPairIdMode mode = KeyPairIdMode::Crc32)
+{
+  if (mode == KeyPairIdMode::Hash64) return static_cast<KeyPairId>(hash64(privateKey, hash64(publicKey)));
+  return static_cast<KeyPairId>(crc32(privateKey, crc32(publicKey)));
+}
+
+#endif// _KEYPAIRIDS_HPP
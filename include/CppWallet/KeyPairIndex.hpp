@@ -0,0 +1,174 @@
+#ifndef _KEYPAIRINDEX_HPP
+#define _KEYPAIRINDEX_HPP
+
+/**
+ * @brief KeyPairIndex
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a Wallet may hold millions of KeyPairs
+ * WHEN we need to locate one by any of its KeyPairId values
+ * THEN a single probe sequence into an open-addressing table is all it takes
+ *
+ */
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "KeyPairInterface.hpp"
+
+/**
+  * @brief KeyPairIndex
+  *
+  * Maps a KeyPairId onto a slot number, (the position of the KeyPair
+  * inside whatever storage the Wallet uses). The table uses linear
+  * probing over a power-of-two array of entries and removes entries
+  * with backward shifting, so there are no tombstones to clean up.
+  *
+  * @note KeyPairId values are typically CRC32 values, (see KeyPairInterface),
+  * so they are mixed before being turned into a table position.
+  *
+  * @note the table is a single array, (no node per entry), allocated from
+  * a std::pmr::memory_resource, (the default one unless given another).
+  *
+  * @note an index over publicKeyId or privateKeyId values has to accept
+  * different KeyPairs sharing an id, (a CRC32 collision). Such indexes use
+  * insertMulti() and findIf(), which walks the probe sequence until the
+  * caller confirms the slot, (typically by comparing the key bytes).
+  *
+  */
+class KeyPairIndex
+{
+public:
+  using Slot = std::uint32_t;
+  static constexpr Slot npos = UINT32_MAX;
+
+  KeyPairIndex() = default;
+  explicit KeyPairIndex(std::size_t capacity) { reserve(capacity); }
+  explicit KeyPairIndex(std::pmr::memory_resource *resource) : _entries(resource) {}
+
+  /**
+    * @brief insert()
+    * @return false if the keyPairId is already present, (nothing is changed)
+    */
+  bool insert(const KeyPairId &keyPairId, Slot slot);
+
+  /**
+    * @brief insertMulti()
+    *
+    * Insert even if keyPairId is already present, (see findIf())
+    *
+    */
+  void insertMulti(const KeyPairId &keyPairId, Slot slot);
+
+  /**
+    * @brief find()
+    * @return the slot stored for keyPairId or npos
+    */
+  Slot find(const KeyPairId &keyPairId) const
+  {
+    if (_size == 0) return npos;
+    for (std::size_t i = home(keyPairId);; i = (i + 1) & _mask) {
+      const Entry &entry = _entries[i];
+      if (entry.slot == npos) return npos;
+      if (entry.keyPairId == keyPairId) return entry.slot;
+    }
+  }
+
+  /**
+    * @brief findIf()
+    * @return the first slot stored for keyPairId for which matches(slot)
+    * holds, or npos
+    */
+  template<typename Predicate>
+  Slot findIf(const KeyPairId &keyPairId, Predicate &&matches) const
+  {
+    if (_size == 0) return npos;
+    for (std::size_t i = home(keyPairId);; i = (i + 1) & _mask) {
+      const Entry &entry = _entries[i];
+      if (entry.slot == npos) return npos;
+      if (entry.keyPairId == keyPairId && matches(entry.slot)) return entry.slot;
+    }
+  }
+
+  /**
+    * @brief prefetch()
+    *
+    * Start loading the start of the probe sequence for keyPairId, (batch
+    * operations prefetch a few keys ahead of the one they work on)
+    *
+    */
+  void prefetch(const KeyPairId &keyPairId) const
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    if (_size != 0) __builtin_prefetch(&_entries[home(keyPairId)]);
+#else
+    (void)keyPairId;
+#endif
+  }
+
+  /**
+    * @brief erase()
+    * @return false if the keyPairId, (paired with slot), was not present
+    */
+  bool erase(const KeyPairId &keyPairId);
+  bool erase(const KeyPairId &keyPairId, Slot slot);
+
+  /**
+    * @brief reserve()
+    *
+    * Grow the table so that capacity entries fit without a rehash
+    *
+    */
+  void reserve(std::size_t capacity);
+  void clear();
+
+  std::size_t size() const { return _size; }
+  std::size_t bucketCount() const { return _entries.size(); }
+
+  /**
+    * @brief forEach()
+    *
+    * Visit every (keyPairId, slot) pair in table order
+    *
+    */
+  template<typename Visitor>
+  void forEach(Visitor &&visitor) const
+  {
+    for (const Entry &entry : _entries)
+      if (entry.slot != npos) visitor(entry.keyPairId, entry.slot);
+  }
+
+  /**
+    * @brief mix()
+    * @return a well distributed 64-bit value for keyPairId, (murmur3 finalizer)
+    */
+  static std::uint64_t mix(const KeyPairId &keyPairId)
+  {
+    auto h = static_cast<std::uint64_t>(keyPairId);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+private:
+  struct Entry
+  {
+    KeyPairId keyPairId;
+    Slot slot;
+  };
+
+  std::size_t home(const KeyPairId &keyPairId) const { return mix(keyPairId) & _mask; }
+  void grow();
+  void eraseAt(std::size_t i);
+  void rehash(std::size_t bucketCount);
+
+  std::pmr::vector<Entry> _entries;// from the resource of the Wallet, (see RecordArena)
+  std::size_t _mask = 0;
+  std::size_t _size = 0;
+};
+
+#endif// _KEYPAIRINDEX_HPP
@@ -16,12 +16,25 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <vector>
 #include <extras/interfaces.hpp>
+#include "InlineKey.hpp"
+
+//
+// NOTE: the keys are kept inline, (see InlineKey.hpp), rather than in a
+// std::string, they convert to and from std::string and std::string_view.
+//
+
+//
+// NOTE: the std::list aliases are kept for compatibility, the vector
+// aliases are the contiguous alternative, (see WalletInterface::listInto()).
+//
 
 using KeyPairId = long;
 using KeyPairIdList = std::list<KeyPairId>;
-using KeyPairPublicKey = std::string;
-using KeyPairPrivateKey = std::string;
+using KeyPairIdVector = std::vector<KeyPairId>;
+using KeyPairPublicKey = InlinePublicKey;
+using KeyPairPrivateKey = InlinePrivateKey;
 using KeyPairSeed = std::string;
 using KeyPairSeedList = std::list<std::string>;
 
@@ -0,0 +1,43 @@
+#ifndef _KEYPAIRRECORD_HPP
+#define _KEYPAIRRECORD_HPP
+
+#include "KeyPairInterface.hpp"
+
+/**
+  * @brief KeyPairRecord
+  *
+  * The copy of a KeyPairInterface instance that a Wallet keeps, (as the
+  * instance handed to WalletInterface::store() belongs to the caller).
+  *
+  * @note KeyPairs are immutable, so a record is never updated once made.
+  *
+  * @note final, so that calls through a KeyPairRecord, (rather than a
+  * KeyPairInterface), need no virtual dispatch, (see BasicWallet).
+  *
+  */
+class KeyPairRecord final implements KeyPairInterface
+{
+  KeyPairId _keyPairId;
+  KeyPairId _publicKeyId;
+  KeyPairId _privateKeyId;
+  KeyPairPublicKey _publicKey;
+  KeyPairPrivateKey _privateKey;
+
+public:
+  explicit KeyPairRecord(const KeyPairInterface &keyPair)
+    : _keyPairId(keyPair.keyPairId()),
+      _publicKeyId(keyPair.publicKeyId()),
+      _privateKeyId(keyPair.privateKeyId()),
+      _publicKey(keyPair.publicKey()),
+      _privateKey(keyPair.privateKey()) {}
+
+  virtual KeyPairId generate(const KeyPairSeedList &) const override { return _keyPairId; }
+
+  virtual const KeyPairId &keyPairId() const override { return _keyPairId; }
+  virtual const KeyPairPublicKey &publicKey() const override { return _publicKey; }
+  virtual const KeyPairId &publicKeyId() const override { return _publicKeyId; }
+  virtual const KeyPairPrivateKey &privateKey() const override { return _privateKey; }
+  virtual const KeyPairId &privateKeyId() const override { return _privateKeyId; }
+};
+
+#endif// _KEYPAIRRECORD_HPP
@@ -0,0 +1,170 @@
+#ifndef _LOCKEDMEMORY_HPP
+#define _LOCKEDMEMORY_HPP
+
+/**
+ * @brief LockedMemory
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a Wallet holds private keys, (in its records, see Wallet)
+ * WHEN that memory comes from the general heap
+ * THEN the keys can be swapped to disk, end up in core dumps, and linger
+ *      in freed blocks, so they need memory of their own: locked into RAM,
+ *      fenced by guard pages and wiped when given back
+ *
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+/**
+  * @brief secureZero()
+  *
+  * Zero size bytes at data, (a write the compiler may not drop, as it
+  * may a memset() of memory about to be freed)
+  *
+  */
+void secureZero(void *data, std::size_t size);
+
+/**
+  * @brief LockedMemoryOptions
+  *
+  *   slabBytes      - how much is mapped, (and locked), at a time for the
+  *                    small allocations, a multiple of the page size
+  *   requireLock    - throw std::system_error when mlock() fails, (past
+  *                    RLIMIT_MEMLOCK), rather than go on unlocked, (counted
+  *                    in LockedMemoryStats::lockFailures)
+  *   maxLockedBytes - lock no more than this, as if RLIMIT_MEMLOCK were
+  *                    reached, (0 - no limit of its own), to leave the
+  *                    rest of RLIMIT_MEMLOCK to others
+  *
+  */
+struct LockedMemoryOptions
+{
+  std::size_t slabBytes = std::size_t(1) << 20;
+  bool requireLock = false;
+  std::size_t maxLockedBytes = 0;
+};
+
+/**
+  * @brief LockedMemoryStats
+  *
+  *   mappings     - slabs and large allocations mapped
+  *   mappedBytes  - usable bytes of those, (guard pages not counted)
+  *   lockedBytes  - the part of mappedBytes that mlock() accepted
+  *   inUseBytes   - bytes handed out, (rounded up to a size class)
+  *   lockFailures - mappings left unlocked
+  *
+  */
+struct LockedMemoryStats
+{
+  std::size_t mappings = 0;
+  std::size_t mappedBytes = 0;
+  std::size_t lockedBytes = 0;
+  std::size_t inUseBytes = 0;
+  std::size_t lockFailures = 0;
+};
+
+/**
+  * @brief LockedMemoryResource
+  *
+  * A std::pmr::memory_resource for secrets. Memory is mapped a slab at a
+  * time, (one mmap() and one mlock() per slabBytes, not per key), with a
+  * PROT_NONE guard page either side and kept out of core dumps, (and
+  * zeroed in a fork()ed child where the kernel can). Allocations up to
+  * maxSmall bytes come out of the slabs in power of two size classes,
+  * larger ones, (such as the slabs of a RecordArena), get a mapping of
+  * their own. Everything given back is wiped, (secureZero()), before it
+  * is reused or unmapped.
+  *
+  *   LockedMemoryResource locked;
+  *   Wallet wallet(KeyPairIdMode::Hash64, 1000000, &locked, std::pmr::get_default_resource());
+  *   std::pmr::vector<KeyPair> keyPairs(&locked);
+  *
+  * @note thread-safe, (one lock around the bookkeeping), so a single
+  * resource, (lockedMemoryResource()), can serve a whole process.
+  *
+  * @note the slabs of the small allocations stay mapped until the
+  * resource is destroyed, (freed blocks are kept for reuse), so
+  * RLIMIT_MEMLOCK bounds their high water mark, not the churn. A large
+  * allocation is wiped and unmapped as soon as it is given back, (the
+  * next one maps and locks afresh).
+  *
+  * @note a Wallet locks whole records, (a KeyPairRecord is 136 bytes,
+  * not just its 32 private key bytes), so a default 8 MiB RLIMIT_MEMLOCK
+  * holds about 60000 of them. Past it memory is still wiped and kept out
+  * of core dumps but may be swapped out: see lockFailures, locked() and
+  * WalletStats::unlockedRecordBytes, and raise the limit, (or set
+  * requireLock), where that will not do.
+  *
+  */
+class LockedMemoryResource extends std::pmr::memory_resource
+{
+public:
+  static constexpr std::size_t minimumSmall = 16;
+  static constexpr std::size_t maxSmall = 4096;
+
+private:
+  static constexpr std::size_t sizeClasses = 9;// 16 .. 4096
+
+  struct Mapping
+  {
+    char *base;// the first guard page
+    std::size_t length;// the whole mapping
+    bool locked;
+  };
+
+  LockedMemoryOptions _options;
+  std::size_t _page;
+  mutable std::mutex _lock;
+  std::vector<Mapping> _slabs;
+  std::map<const void *, Mapping> _large;
+  std::array<void *, sizeClasses> _free{};
+  char *_next = nullptr;
+  char *_end = nullptr;
+  LockedMemoryStats _stats;
+
+  char *map(std::size_t bytes, Mapping &mapping);
+  void unmap(const Mapping &mapping);
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+  /**
+    * @brief LockedMemoryResource()
+    * @exception std::invalid_argument if slabBytes is not a multiple of
+    * the page size or smaller than maxSmall
+    */
+  explicit LockedMemoryResource(const LockedMemoryOptions &options = LockedMemoryOptions());
+  virtual ~LockedMemoryResource();
+
+  LockedMemoryResource(const LockedMemoryResource &) = delete;
+  LockedMemoryResource &operator=(const LockedMemoryResource &) = delete;
+
+  LockedMemoryStats stats() const;
+
+  /**
+    * @brief locked()
+    * @return whether the memory at pointer, (handed out by this resource
+    * and not given back), is locked
+    */
+  bool locked(const void *pointer) const;
+};
+
+/**
+  * @brief lockedMemoryResource()
+  * @return the LockedMemoryResource of the process, (default options,
+  * made on first use)
+  */
+LockedMemoryResource *lockedMemoryResource();
+
+#endif// _LOCKEDMEMORY_HPP
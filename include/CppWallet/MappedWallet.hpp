@@ -0,0 +1,125 @@
+#ifndef _MAPPEDWALLET_HPP
+#define _MAPPEDWALLET_HPP
+
+/**
+ * @brief MappedWallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a Wallet file, (see WalletFile.hpp), of any size
+ * WHEN the service starts
+ * THEN the Wallet is ready to answer as soon as the file is mapped,
+ *      (pages are read in as lookups touch them)
+ *
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <extras/interfaces.hpp>
+#include "KeyPairIds.hpp"
+#include "WalletFile.hpp"
+#include "WalletInterface.hpp"
+
+/**
+  * @brief MappedWallet
+  *
+  * Read-only implementation of WalletInterface over a memory mapped
+  * Wallet file. Opening checks the header and maps the file, nothing
+  * is read or built in proportion to the number of KeyPairs.
+  *
+  * The KeyPairInterface instances handed out refer to the mapped record,
+  * (their keys are references into the file). They are made the first
+  * time a record is returned and live as long as the MappedWallet.
+  *
+  * @note store(), remove(), storeMany() and removeMany() throw
+  * WalletReadOnlyException.
+  *
+  * @note lookups are thread-safe.
+  *
+  */
+class MappedWallet implements WalletInterface
+{
+  using Slot = std::uint32_t;
+
+  std::string _path;
+  int _fd = -1;
+  const char *_map = nullptr;
+  std::size_t _mapSize = 0;
+  const WalletFileHeader *_header = nullptr;
+  const WalletFileRecord *_records = nullptr;
+  const WalletFileEntry *_byKeyPairId = nullptr;
+  const WalletFileEntry *_byPublicKeyId = nullptr;
+  const WalletFileEntry *_byPrivateKeyId = nullptr;
+  std::uint64_t _mask = 0;
+  KeyPairIdMode _idMode = KeyPairIdMode::Crc32;
+
+  // one lazily made WalletFileKeyPair per record, (calloc'd, so untouched
+  // pages cost nothing), and its state: 0 none, 1 in the making, 2 made
+  WalletFileKeyPair *_views = nullptr;
+  std::atomic<std::uint8_t> *_made = nullptr;
+
+  void close();
+  [[noreturn]] void fail(const std::string &reason);
+
+  const KeyPairInterface *view(Slot slot) const;
+
+  template<typename Predicate>
+  const KeyPairInterface *lookup(const WalletFileEntry *table, const KeyPairId &id, Predicate &&matches) const;
+
+public:
+  /**
+    * @brief MappedWallet()
+    * @exception WalletFileException if path cannot be mapped or is not a
+    * valid Wallet file
+    */
+  explicit MappedWallet(const std::string &path);
+  virtual ~MappedWallet();
+
+  MappedWallet(const MappedWallet &) = delete;
+  MappedWallet &operator=(const MappedWallet &) = delete;
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  std::size_t size() const { return _header->count; }
+  KeyPairIdMode idMode() const { return _idMode; }
+  const std::string &path() const { return _path; }
+  std::uint64_t sequence() const { return _header->sequence; }
+
+  /**
+    * @brief verify()
+    *
+    * Read the whole file and check its checksum, (opening only checks
+    * the header)
+    *
+    * @return false if the file is damaged
+    */
+  bool verify() const;
+};
+
+#endif// _MAPPEDWALLET_HPP
@@ -0,0 +1,93 @@
+#ifndef _PERFECTHASH_HPP
+#define _PERFECTHASH_HPP
+
+/**
+ * @brief PerfectHash
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a set of KeyPairIds that never changes, (see FrozenWallet)
+ * WHEN one of them is looked up
+ * THEN its position should come out of one computation, (no probing),
+ *      and the table should have no empty slots
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include "KeyPairIndex.hpp"
+
+/**
+  * @brief PerfectHash
+  *
+  * A minimal perfect hash function over n distinct KeyPairIds, (each of
+  * them gets a position of its own in [0, n)), of the hash and displace
+  * family: the ids are spread over n / 3 buckets and each bucket has a
+  * pilot, (found when building), that sends all its ids to free positions.
+  * Buckets holding a single id store its position in the pilot, (direct).
+  *
+  * A PerfectHash does not own its pilots, (they live wherever the table
+  * they position into lives, in memory or in a mapped file), and answers
+  * some position for an id that was not in the set: the caller compares
+  * the id stored at that position.
+  *
+  * @note positions depend on KeyPairIndex::mix(), (as the Wallet file
+  * formats do).
+  *
+  */
+class PerfectHash
+{
+  std::uint64_t _seed = 0;
+  std::uint64_t _keys = 0;
+  std::uint64_t _buckets = 0;
+  const std::uint32_t *_pilots = nullptr;
+
+  static std::uint64_t reduce(std::uint64_t hash, std::uint64_t range) { return ((hash >> 32) * range) >> 32; }
+  static std::uint64_t displace(std::uint64_t hash, std::uint32_t pilot)
+  {
+    return KeyPairIndex::mix(KeyPairId(hash ^ (pilot * 0x9e3779b97f4a7c15ULL)));
+  }
+
+public:
+  static constexpr std::uint32_t direct = 0x80000000U;
+  static constexpr std::uint64_t keysPerBucket = 3;
+
+  PerfectHash() = default;
+  PerfectHash(std::uint64_t seed, std::uint64_t keys, std::uint64_t buckets, const std::uint32_t *pilots)
+    : _seed(seed), _keys(keys), _buckets(buckets), _pilots(pilots) {}
+
+  /**
+    * @brief build()
+    *
+    * Find the pilots, (and seed), for keys, which must be distinct and
+    * fewer than 2^31, (a few ns per key)
+    *
+    * @return the pilots, bucketsFor(keys.size()) of them
+    */
+  static std::vector<std::uint32_t> build(const std::vector<KeyPairId> &keys, std::uint64_t &seed);
+  static std::uint64_t bucketsFor(std::uint64_t keys) { return keys / keysPerBucket + 1; }
+
+  /**
+    * @brief position()
+    * @return the position of id, (if it is one of the keys, otherwise
+    * any position), keys must not be 0
+    */
+  std::uint64_t position(const KeyPairId &id) const
+  {
+    std::uint64_t hash = KeyPairIndex::mix(KeyPairId(std::uint64_t(id) ^ _seed));
+    std::uint32_t pilot = _pilots[reduce(hash, _buckets)];
+    return (pilot & direct) != 0 ? pilot & ~direct : reduce(displace(hash, pilot), _keys);
+  }
+
+  void prefetch(const KeyPairId &id) const
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&_pilots[reduce(KeyPairIndex::mix(KeyPairId(std::uint64_t(id) ^ _seed)), _buckets)]);
+#endif
+  }
+
+  std::uint64_t keys() const { return _keys; }
+  std::uint64_t buckets() const { return _buckets; }
+};
+
+#endif// _PERFECTHASH_HPP
@@ -0,0 +1,195 @@
+#ifndef _RECORDARENA_HPP
+#define _RECORDARENA_HPP
+
+/**
+ * @brief RecordArena
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN a bulk import of millions of KeyPairs into a Wallet
+ * WHEN every record, (and every chunk of the container holding it), is a
+ *      separate trip to the heap
+ * THEN allocator time and fragmentation dominate the import, so records
+ *      should be carved from large slabs, recycled on remove() and given
+ *      back all at once
+ *
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "KeyPairIndex.hpp"
+#include "LockedMemory.hpp"
+
+/**
+  * @brief RecordArena
+  *
+  * Numbered slots for Wallet records, (the slot numbers the KeyPairIndex
+  * tables point at), in slabs of slabRecords records each, taken from a
+  * std::pmr::memory_resource. A slot is its slab and its place in the
+  * slab, records never move, (references stay valid until the record is
+  * erased), the slots of erased records are reused first, and the slabs
+  * go back to the resource when the arena does.
+  *
+  *   std::pmr::monotonic_buffer_resource import;
+  *   Wallet wallet(KeyPairIdMode::Hash64, 1000000, &import);
+  *
+  * @note a RecordArena has the member functions of the BasicWallet
+  * storage policies, (see ArenaStorage).
+  *
+  * @note the resource must outlive the arena, the default is
+  * lockedMemoryResource(), (the records kept out of swap and core dumps,
+  * see LockedMemory.hpp), std::pmr::get_default_resource() is new and
+  * delete.
+  *
+  */
+template<typename Record>
+class RecordArena
+{
+public:
+  using Slot = KeyPairIndex::Slot;
+  static constexpr bool stable = true;
+  static constexpr std::size_t slabShift = 10;
+  static constexpr std::size_t slabRecords = std::size_t(1) << slabShift;
+  static constexpr std::size_t slabBytes = slabRecords * sizeof(Record);
+
+private:
+  static constexpr std::size_t slabMask = slabRecords - 1;
+
+  std::pmr::memory_resource *_resource;
+  std::pmr::vector<Record *> _slabs;
+  std::pmr::vector<std::uint8_t> _used;
+  std::pmr::vector<Slot> _freeSlots;
+  std::size_t _unlockedSlabs = 0;// of a LockedMemoryResource past its limit
+
+  Record *address(Slot slot) const { return _slabs[slot >> slabShift] + (slot & slabMask); }
+
+  void addSlab()
+  {
+    if (_slabs.size() == _slabs.capacity()) _slabs.reserve(_slabs.empty() ? 16 : 2 * _slabs.size());
+    _slabs.push_back(static_cast<Record *>(_resource->allocate(slabBytes, alignof(Record))));
+    if (auto locked = dynamic_cast<LockedMemoryResource *>(_resource))
+      if (!locked->locked(_slabs.back())) ++_unlockedSlabs;
+  }
+
+  void release()
+  {
+    if constexpr (!std::is_trivially_destructible<Record>::value)
+      for (std::size_t slot = 0; slot < _used.size(); ++slot)
+        if (_used[slot] != 0) std::destroy_at(address(Slot(slot)));
+    for (Record *slab : _slabs) _resource->deallocate(slab, slabBytes, alignof(Record));
+    _slabs.clear();
+    _used.clear();
+    _freeSlots.clear();
+    _unlockedSlabs = 0;
+  }
+
+public:
+  explicit RecordArena(std::pmr::memory_resource *resource = lockedMemoryResource())
+    : _resource(resource), _slabs(resource), _used(resource), _freeSlots(resource) {}
+
+  RecordArena(RecordArena &&other) noexcept
+    : _resource(other._resource),
+      _slabs(std::move(other._slabs)),
+      _used(std::move(other._used)),
+      _freeSlots(std::move(other._freeSlots)),
+      _unlockedSlabs(other._unlockedSlabs)
+  {
+    other._slabs.clear();
+    other._used.clear();
+    other._freeSlots.clear();
+    other._unlockedSlabs = 0;
+  }
+
+  RecordArena(const RecordArena &) = delete;
+  RecordArena &operator=(const RecordArena &) = delete;
+  ~RecordArena() { release(); }
+
+  /**
+    * @brief emplace()
+    *
+    * Make a record, (Record(arguments...)), in the slot erased last, or
+    * else the next new one
+    *
+    */
+  template<typename... Arguments>
+  Slot emplace(Arguments &&...arguments)
+  {
+    Slot slot;
+    if (_freeSlots.empty()) {
+      slot = static_cast<Slot>(_used.size());
+      if ((slot >> slabShift) == _slabs.size()) addSlab();
+      _used.push_back(0);
+      ::new (static_cast<void *>(address(slot))) Record(std::forward<Arguments>(arguments)...);
+      _used.back() = 1;
+    } else {
+      slot = _freeSlots.back();
+      ::new (static_cast<void *>(address(slot))) Record(std::forward<Arguments>(arguments)...);
+      _freeSlots.pop_back();
+      _used[slot] = 1;
+    }
+    return slot;
+  }
+
+  /**
+    * @brief erase()
+    *
+    * Destroy the record in slot and wipe its bytes, (records hold private
+    * keys), the slot is reused by a later emplace()
+    *
+    */
+  void erase(Slot slot)
+  {
+    std::destroy_at(address(slot));
+    secureZero(address(slot), sizeof(Record));
+    _used[slot] = 0;
+    _freeSlots.push_back(slot);
+  }
+
+  /**
+    * @brief reserve()
+    *
+    * Take the slabs for capacity records now, (one trip to the resource
+    * per slab, before the import rather than during it). The slot flags
+    * grow at least twofold, so that reserve(size() + n) before each of
+    * many small batches stays linear.
+    *
+    */
+  void reserve(std::size_t capacity)
+  {
+    while (_slabs.size() * slabRecords < capacity) addSlab();
+    if (capacity > _used.capacity()) _used.reserve(std::max(capacity, 2 * _used.capacity()));
+  }
+
+  /**
+    * @brief clear()
+    *
+    * Destroy every record and give the slabs back to the resource,
+    * (lockedMemoryResource() wipes them)
+    *
+    */
+  void clear() { release(); }
+
+  const Record &operator[](Slot slot) const { return *address(slot); }
+  bool used(std::size_t slot) const { return _used[slot] != 0; }
+  std::size_t bound() const { return _used.size(); }
+
+  std::pmr::memory_resource *resource() const { return _resource; }
+  std::size_t slabs() const { return _slabs.size(); }
+  std::size_t memorySize() const { return _slabs.size() * slabBytes; }
+
+  /**
+    * @brief unlockedSize()
+    * @return the part of memorySize() in a LockedMemoryResource that
+    * mlock() did not accept, (past RLIMIT_MEMLOCK, see LockedMemory.hpp)
+    */
+  std::size_t unlockedSize() const { return _unlockedSlabs * slabBytes; }
+};
+
+#endif// _RECORDARENA_HPP
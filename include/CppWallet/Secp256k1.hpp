@@ -0,0 +1,97 @@
+#ifndef _SECP256K1_HPP
+#define _SECP256K1_HPP
+
+/**
+ * @brief Secp256k1
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that KeyPairInterface promises a public key with every private key
+ * WHEN a private key is generated
+ * THEN its public key is the generator point of secp256k1 multiplied by
+ *      it, in time that does not depend on the private key
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include "KeyPairInterface.hpp"
+
+static constexpr std::size_t secp256k1PrivateKeyBytes = 32;
+static constexpr std::size_t secp256k1PublicKeyBytes = 33;// compressed
+
+/**
+  * @brief secp256k1ValidPrivateKey()
+  * @return whether the 32 big-endian bytes of privateKey are a scalar in
+  * [1, n), (n the order of the curve)
+  */
+bool secp256k1ValidPrivateKey(const std::uint8_t *privateKey);
+
+/**
+  * @brief secp256k1AddPrivateKeys()
+  *
+  * sum = privateKey + tweak (mod n), (the 32 big-endian bytes of each,
+  * sum may be either of them), as a BIP32 child key is made
+  *
+  * @return false if privateKey is not valid, tweak is not below n, or the
+  * sum is 0, (sum is not written)
+  */
+bool secp256k1AddPrivateKeys(const std::uint8_t *privateKey, const std::uint8_t *tweak, std::uint8_t *sum);
+
+/**
+  * @brief Secp256k1Engine
+  *
+  * The implementations of secp256k1PublicKey(), (all of them compute the
+  * same public key, in time that does not depend on the private key).
+  *
+  *   Window - 4 doublings and an addition per 4 bits of the private key,
+  *            over a table of 16 multiples of the generator, (1.5 KiB)
+  *   Comb   - an addition per 4 bits and no doublings, over a table of
+  *            d * 16^i * G for each of the 64 windows, (60 KiB, made on
+  *            first use)
+  *
+  */
+enum class Secp256k1Engine {
+  Window,
+  Comb
+};
+
+/**
+  * @brief secp256k1PublicKey()
+  *
+  * The compressed public key, (0x02 or 0x03 and the x coordinate, SEC 1),
+  * of the 32 big-endian bytes of privateKey, (Secp256k1Engine::Comb).
+  * Complete addition formulas, (Renes, Costello & Batina), and table
+  * lookups that read every entry of a window, so nothing branches or
+  * indexes on the private key.
+  *
+  * @return false if privateKey is not valid, (publicKey is not written)
+  */
+bool secp256k1PublicKey(const std::uint8_t *privateKey, std::uint8_t *publicKey);
+
+/**
+  * @brief secp256k1PublicKey()
+  * @exception std::invalid_argument if privateKey is not 32 bytes or not
+  * valid
+  */
+KeyPairPublicKey secp256k1PublicKey(const KeyPairPrivateKey &privateKey);
+
+/**
+  * @brief secp256k1PublicKeyWith()
+  *
+  * Same as secp256k1PublicKey() but using the given engine, (for testing
+  * and benchmarks)
+  *
+  */
+bool secp256k1PublicKeyWith(Secp256k1Engine engine, const std::uint8_t *privateKey, std::uint8_t *publicKey);
+
+/**
+  * @brief secp256k1Precompute()
+  *
+  * Makes the comb table now, (rather than in the first
+  * secp256k1PublicKey(), about a millisecond)
+  *
+  */
+void secp256k1Precompute();
+
+#endif// _SECP256K1_HPP
@@ -0,0 +1,66 @@
+#ifndef _SHA256_HPP
+#define _SHA256_HPP
+
+/**
+ * @brief Sha256
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that a private key is made from seeds and fresh entropy, (see
+ *       KeyPairGenerator)
+ * WHEN those are condensed into the 32 bytes of the key
+ * THEN the function doing it must be a cryptographic hash, (crc32() and
+ *      hash64() are for ids only)
+ *
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using Sha256Digest = std::array<std::uint8_t, 32>;
+
+/**
+  * @brief Sha256
+  *
+  * SHA-256, (FIPS 180-4), fed piecewise:
+  *
+  *   Sha256 hash;
+  *   hash.update(entropy, 32);
+  *   for (const auto &seed : seeds) hash.update(seed);
+  *   Sha256Digest digest = hash.finish();
+  *
+  * @note finish() leaves the Sha256 ready for the next message.
+  *
+  */
+class Sha256
+{
+  std::uint32_t _state[8];
+  std::uint8_t _block[64];
+  std::size_t _used = 0;
+  std::uint64_t _length = 0;
+
+  void compress(const std::uint8_t *block);
+
+public:
+  Sha256() { reset(); }
+
+  void reset();
+  void update(const void *data, std::size_t length);
+  void update(std::string_view data) { update(data.data(), data.size()); }
+  Sha256Digest finish();
+};
+
+/**
+  * @brief sha256()
+  * @return the SHA-256 digest of data
+  */
+Sha256Digest sha256(const void *data, std::size_t length);
+
+inline Sha256Digest sha256(std::string_view data)
+{
+  return sha256(data.data(), data.size());
+}
+
+#endif// _SHA256_HPP
@@ -0,0 +1,66 @@
+#ifndef _SHA512_HPP
+#define _SHA512_HPP
+
+/**
+ * @brief Sha512
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that an HD wallet derives every key from its parent, (BIP32)
+ * WHEN a child key and its chain code are made
+ * THEN they are the two halves of an HMAC-SHA512 keyed with the parent's
+ *      chain code, (see HdKeyChain)
+ *
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using Sha512Digest = std::array<std::uint8_t, 64>;
+
+/**
+  * @brief Sha512
+  *
+  * SHA-512, (FIPS 180-4), fed piecewise, as Sha256 is.
+  *
+  * @note finish() leaves the Sha512 ready for the next message.
+  *
+  */
+class Sha512
+{
+  std::uint64_t _state[8];
+  std::uint8_t _block[128];
+  std::size_t _used = 0;
+  std::uint64_t _length = 0;
+
+  void compress(const std::uint8_t *block);
+
+public:
+  Sha512() { reset(); }
+
+  void reset();
+  void update(const void *data, std::size_t length);
+  void update(std::string_view data) { update(data.data(), data.size()); }
+  Sha512Digest finish();
+};
+
+/**
+  * @brief sha512()
+  * @return the SHA-512 digest of data
+  */
+Sha512Digest sha512(const void *data, std::size_t length);
+
+inline Sha512Digest sha512(std::string_view data)
+{
+  return sha512(data.data(), data.size());
+}
+
+/**
+  * @brief hmacSha512()
+  * @return the HMAC-SHA512 of data with key, (RFC 2104)
+  */
+Sha512Digest hmacSha512(const void *key, std::size_t keyLength, const void *data, std::size_t length);
+
+#endif// _SHA512_HPP
@@ -0,0 +1,52 @@
+#ifndef _THROTTLE_HPP
+#define _THROTTLE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/**
+  * @brief Throttle
+  *
+  * Keeps background I/O, (compaction), to a given number of bytes per
+  * second, so the foreground keeps the disk and the page cache:
+  *
+  *   Throttle throttle(64 << 20);
+  *   for (...) {
+  *     write(fd, data, size);
+  *     throttle.pace(size);// sleeps whenever ahead of 64 MiB/s
+  *   }
+  *
+  * Pacing is done every quantum bytes, (so at most quantum bytes go out
+  * in a burst). A Throttle of 0 bytes per second never sleeps.
+  *
+  */
+class Throttle
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::uint64_t _bytesPerSecond;
+  Clock::time_point _start = Clock::now();
+  std::uint64_t _bytes = 0;
+  std::uint64_t _unpaced = 0;
+
+public:
+  static constexpr std::size_t quantum = 256 * 1024;
+
+  explicit Throttle(std::uint64_t bytesPerSecond) : _bytesPerSecond(bytesPerSecond) {}
+
+  bool limited() const { return _bytesPerSecond != 0; }
+
+  void pace(std::size_t bytes)
+  {
+    if (_bytesPerSecond == 0) return;
+    _bytes += bytes;
+    _unpaced += bytes;
+    if (_unpaced < quantum) return;
+    _unpaced = 0;
+    std::chrono::duration<double> due(double(_bytes) / double(_bytesPerSecond));
+    std::this_thread::sleep_until(_start + std::chrono::duration_cast<Clock::duration>(due));
+  }
+};
+
+#endif// _THROTTLE_HPP
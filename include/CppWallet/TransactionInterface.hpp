@@ -16,6 +16,7 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <vector>
 #include <extras/interfaces.hpp>
 #include "KeyPairInterface.hpp"
 
@@ -46,6 +47,7 @@
 
 using TransactionId = long;
 using TransactionIdList = std::list<TransactionId>;
+using TransactionIdVector = std::vector<TransactionId>;
 
 interface TransactionInterface
 {
@@ -85,13 +87,20 @@ interface TransactionInterface
     */
   virtual const TransactionIdList &retrieveAll(
     const KeyPairPublicKey &keyPairPublicKey) pure;
+
+  /**
+    * @brief retrieveAllInto()
+    * 
+    * Same as retrieveAll(), but the TransactionIds are appended to a 
+    * contiguous container supplied, (and reused), by the caller.
+    * 
+    */
+  virtual void retrieveAllInto(
+    const KeyPairPublicKey &keyPairPublicKey, TransactionIdVector &transactionIds) pure;
 };
 
   /** 
-    * TODO: Hierarchical Deterministic (HD) Wallet
-    * white_check_mark
-    * eyes
-    * raised_hands
+    * NOTE: Hierarchical Deterministic (HD) Wallet, see HdKeyChain.hpp
     */
 
 
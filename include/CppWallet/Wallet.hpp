@@ -0,0 +1,200 @@
+#ifndef _WALLET_HPP
+#define _WALLET_HPP
+
+/**
+ * @brief Wallet
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that WalletInterface defines the CRUD surface of a Bitcoin Wallet
+ * WHEN we need a Wallet that holds millions of KeyPairs in memory
+ * THEN every lookup by KeyPairId, publicKeyId or privateKeyId is a hash probe
+ *
+ */
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#include <extras/interfaces.hpp>
+#include "BloomFilter.hpp"
+#include "WalletInterface.hpp"
+#include "KeyPairIds.hpp"
+#include "KeyPairIndex.hpp"
+#include "KeyPairRecord.hpp"
+#include "RecordArena.hpp"
+
+/**
+  * @brief WalletStats
+  *
+  *   size                    - KeyPairs stored
+  *   filtered                - whether the key indexes have BloomFilters
+  *   filterBytes             - memory of both filters
+  *   filterCapacity          - KeyPairs the filters are sized for
+  *   filterFalsePositiveRate - expected share of the missing keys that
+  *                             still get to probe an index
+  *   recordBytes             - memory of the record slabs, (RecordArena)
+  *   unlockedRecordBytes     - the part of recordBytes left unlocked, (a
+  *                             LockedMemoryResource past RLIMIT_MEMLOCK:
+  *                             those records may be swapped out)
+  *
+  */
+struct WalletStats
+{
+  std::size_t size = 0;
+  bool filtered = false;
+  std::size_t filterBytes = 0;
+  std::size_t filterCapacity = 0;
+  double filterFalsePositiveRate = 0;
+  std::size_t recordBytes = 0;
+  std::size_t unlockedRecordBytes = 0;
+};
+
+/**
+  * @brief Wallet
+  *
+  * In-memory implementation of WalletInterface. Each stored KeyPair is
+  * copied into a slot, (slots are recycled after remove()), and three
+  * KeyPairIndex tables map the keyPairId, publicKeyId and privateKeyId
+  * values onto that slot.
+  *
+  * @note findByPublicKey() and findByPrivateKey() rely on the stored
+  * KeyPairs using the ids of the Wallet's KeyPairIdMode, (see KeyPairIds.hpp).
+  * Different keys may share a publicKeyId or privateKeyId, (CRC32 values do
+  * collide), so those indexes keep every KeyPair and the key based finders
+  * compare the key bytes of each candidate. Only the keyPairId has to be
+  * unique, (KeyPairIdMode::Hash64 makes that practical for large Wallets).
+  *
+  * @note references returned by retrieve() and find...() remain valid
+  * until the KeyPair they refer to is removed.
+  *
+  * @note given BloomFilterOptions, the publicKeyId and privateKeyId
+  * indexes each get a BlockedBloomFilter that the finders, (and store()),
+  * ask first: a key the Wallet does not hold is then turned away after
+  * one cache line, most of the time. The filters keep the ids of removed
+  * KeyPairs until they are rebuilt, (each time they fill up, from the
+  * KeyPairs stored then).
+  *
+  * @note records live in the slabs of a RecordArena, and the records and
+  * the index tables come from std::pmr::memory_resources: given a
+  * std::pmr::monotonic_buffer_resource, a bulk import makes a handful of
+  * large allocations, and all of it is given back in one go. Unless
+  * told otherwise the records come from lockedMemoryResource(), so the
+  * private keys are locked in RAM, (and wiped when removed), while the
+  * much larger indexes, (ids and slot numbers), come from the heap.
+  * Whole records are locked, so past RLIMIT_MEMLOCK the slabs go on
+  * unlocked, (stats().unlockedRecordBytes, see LockedMemory.hpp).
+  *
+  */
+class Wallet implements WalletInterface
+{
+  using Slot = KeyPairIndex::Slot;
+
+  RecordArena<KeyPairRecord> _slots;
+  KeyPairIdMode _idMode = KeyPairIdMode::Crc32;
+  KeyPairIndex _byKeyPairId;
+  KeyPairIndex _byPublicKeyId;
+  KeyPairIndex _byPrivateKeyId;
+  std::optional<BlockedBloomFilter> _publicKeyFilter;
+  std::optional<BlockedBloomFilter> _privateKeyFilter;
+
+  const KeyPairInterface *at(Slot slot) const;
+  void refilter(std::size_t capacity);
+  bool mayHavePublicKeyId(const KeyPairId &publicKeyId) const
+  {
+    return !_publicKeyFilter || _publicKeyFilter->mayContain(publicKeyId);
+  }
+  bool mayHavePrivateKeyId(const KeyPairId &privateKeyId) const
+  {
+    return !_privateKeyFilter || _privateKeyFilter->mayContain(privateKeyId);
+  }
+  WalletStatus insert(const KeyPairInterface &keyPair);
+  WalletStatus erase(const KeyPairId &keyPairId);
+  Slot findPublicKey(const KeyPairId &publicKeyId, std::string_view publicKey) const;
+  Slot findPrivateKey(const KeyPairId &privateKeyId, std::string_view privateKey) const;
+
+public:
+  Wallet() = default;
+  explicit Wallet(std::size_t capacity);
+  explicit Wallet(KeyPairIdMode idMode, std::size_t capacity = 0);
+  Wallet(KeyPairIdMode idMode, std::size_t capacity, const BloomFilterOptions &filter);
+  Wallet(KeyPairIdMode idMode, std::size_t capacity, const BloomFilterOptions &filter,
+    std::pmr::memory_resource *resource, std::pmr::memory_resource *indexResource = nullptr);
+
+  /**
+    * @brief Wallet()
+    *
+    * A Wallet whose records are allocated from resource, and its indexes,
+    * (ids and slot numbers, no key material), from indexResource, or from
+    * resource as well when not given, (both must outlive the Wallet)
+    *
+    *   Wallet wallet(KeyPairIdMode::Hash64, count, lockedMemoryResource(), std::pmr::get_default_resource());
+    *
+    */
+  Wallet(KeyPairIdMode idMode, std::size_t capacity, std::pmr::memory_resource *resource,
+    std::pmr::memory_resource *indexResource = nullptr);
+
+  virtual KeyPairId store(const KeyPairInterface &keyPair) override;
+  virtual const KeyPairInterface &retrieve(const KeyPairId &keyPairId) const override;
+  virtual void remove(const KeyPairId &keyPairId) override;
+  virtual KeyPairIdList list() const override;
+  virtual void listInto(KeyPairIdVector &keyPairIds) const override;
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const override;
+
+  virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPair) const override;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &keyPairId) const override;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view publicKey) const override;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &publicKeyId) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view privateKey) const override;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const override;
+
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) override;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) override;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const override;
+
+  /**
+    * @brief size()
+    * @return the number of KeyPairs stored in the Wallet
+    */
+  std::size_t size() const { return _byKeyPairId.size(); }
+
+  /**
+    * @brief idMode()
+    * @return how findByPublicKey() and findByPrivateKey() derive ids
+    */
+  KeyPairIdMode idMode() const { return _idMode; }
+
+  WalletStats stats() const;
+
+  /**
+    * @brief copyKeyPairIds()
+    *
+    * Write every KeyPairId to out, (any output iterator will do)
+    *
+    * @return out, past the last KeyPairId written
+    */
+  template<typename OutputIterator>
+  OutputIterator copyKeyPairIds(OutputIterator out) const
+  {
+    _byKeyPairId.forEach([&out](const KeyPairId &keyPairId, Slot) { *out++ = keyPairId; });
+    return out;
+  }
+
+  /**
+    * @brief reserve()
+    *
+    * Presize the indexes, (useful before a bulk import)
+    *
+    */
+  void reserve(std::size_t capacity);
+};
+
+#endif// _WALLET_HPP
@@ -0,0 +1,203 @@
+#ifndef _WALLETFILE_HPP
+#define _WALLETFILE_HPP
+
+/**
+ * @brief WalletFile
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that the service restarts on every deploy
+ * WHEN the Wallet holds millions of KeyPairs
+ * THEN opening it must not mean reading and indexing all of them again
+ *
+ * The on-disk Wallet format, laid out so that a mapped file can be
+ * queried as is, (see MappedWallet):
+ *
+ *   WalletFileHeader                       128 bytes
+ *   WalletFileRecord[count]                128 bytes each
+ *   WalletFileEntry[bucketCount] x 3       keyPairId, publicKeyId and
+ *                                          privateKeyId tables
+ *
+ * Each table is a linear probing hash table mapping an id onto a record
+ * number, positioned with KeyPairIndex::mix(), (so changing mix() means
+ * a new WalletFileHeader::version). Unused entries hold slot UINT32_MAX.
+ * Every section starts on a 4096 byte boundary. All numbers are stored
+ * in the byte order of the machine, (little endian on everything we
+ * run on, the header is checked for it).
+ *
+ */
+
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "InlineKey.hpp"
+#include "KeyPairIds.hpp"
+#include "LockedMemory.hpp"
+#include "WalletInterface.hpp"
+
+static_assert(sizeof(KeyPairId) == 8, "the file format stores 64 bit KeyPairIds");
+
+struct WalletFileHeader
+{
+  static constexpr char expectedMagic[8] = { 'C', 'P', 'P', 'W', 'A', 'L', 'L', 'T' };
+  static constexpr std::uint32_t currentVersion = 2;
+  static constexpr std::uint32_t littleEndian = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;// littleEndian as written by the writer
+  std::uint32_t idMode;// KeyPairIdMode
+  std::uint32_t reserved0;
+  std::uint64_t count;
+  std::uint64_t bucketCount;
+  std::uint64_t recordsOffset;
+  std::uint64_t byKeyPairIdOffset;
+  std::uint64_t byPublicKeyIdOffset;
+  std::uint64_t byPrivateKeyIdOffset;
+  std::uint64_t fileSize;
+  std::uint64_t sequence;// of the last WalletLog entry a checkpoint covers, (0 - none)
+  std::uint32_t bodyChecksum;// crc32() of everything after the header
+  std::uint32_t headerChecksum;// crc32() of the header up to here
+  char reserved[32];
+};
+
+struct WalletFileRecord
+{
+  KeyPairId keyPairId;
+  KeyPairId publicKeyId;
+  KeyPairId privateKeyId;
+  InlinePublicKey publicKey;
+  InlinePrivateKey privateKey;
+  char reserved[5];
+};
+
+struct WalletFileEntry
+{
+  KeyPairId keyPairId;
+  std::uint32_t slot;
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(WalletFileHeader) == 128, "the header is 128 bytes");
+static_assert(sizeof(WalletFileRecord) == 128, "a record is 128 bytes");
+static_assert(sizeof(WalletFileEntry) == 16, "an entry is 16 bytes");
+static_assert(std::is_trivially_copyable<WalletFileRecord>::value, "records are written as is");
+
+/**
+ * @brief checkWalletFileHeader()
+ *
+ * @return why header, (of a file of fileSize bytes), is not that of a
+ * Wallet file this build can read, (empty if it is)
+ */
+std::string checkWalletFileHeader(const WalletFileHeader &header, std::uint64_t fileSize);
+
+/**
+ * @brief checkWalletFileRecord()
+ *
+ * @return whether the key sizes of record fit their keys, (a damaged
+ * record's may not: reading such a key would run past the record)
+ */
+inline bool checkWalletFileRecord(const WalletFileRecord &record)
+{
+  return record.publicKey.size() <= InlinePublicKey::capacity && record.privateKey.size() <= InlinePrivateKey::capacity;
+}
+
+/**
+ * @brief WalletFileKeyPair
+ *
+ * A KeyPairInterface over a WalletFileRecord, (wherever the record is,
+ * mapped or read into memory), referring to it rather than copying it.
+ *
+ */
+class WalletFileKeyPair implements KeyPairInterface
+{
+  const WalletFileRecord &_record;
+
+public:
+  explicit WalletFileKeyPair(const WalletFileRecord &record) : _record(record) {}
+
+  virtual KeyPairId generate(const KeyPairSeedList &) const override { return _record.keyPairId; }
+  virtual const KeyPairPublicKey &publicKey() const override { return _record.publicKey; }
+  virtual const KeyPairPrivateKey &privateKey() const override { return _record.privateKey; }
+
+  virtual const KeyPairId &keyPairId() const override { return _record.keyPairId; }
+  virtual const KeyPairId &publicKeyId() const override { return _record.publicKeyId; }
+  virtual const KeyPairId &privateKeyId() const override { return _record.privateKeyId; }
+};
+
+/**
+ * @brief WalletFileException
+ *
+ * The file could not be written, opened, or is not a valid Wallet file.
+ *
+ */
+class WalletFileException extends std::runtime_error
+{
+public:
+  WalletFileException(const std::string &path, const std::string &reason)
+    : std::runtime_error(path + ": " + reason) {}
+};
+
+/**
+  * @brief WalletFileWriter
+  *
+  * Collects KeyPairs and writes them out as a Wallet file. The file is
+  * written under a temporary name, flushed to disk and renamed, so a
+  * crash leaves either the old file or the complete new one.
+  *
+  *   WalletFileWriter writer(KeyPairIdMode::Hash64);
+  *   writer.addAll(wallet);
+  *   writer.write("keys.wallet");
+  *
+  * @note the ids of the KeyPairs added are written as they are, the
+  * idMode only tells MappedWallet how to derive ids from keys.
+  *
+  * @note sequence is stored in the header as is, (see DurableWallet).
+  *
+  * @note the records wait for write() in lockedMemoryResource().
+  *
+  */
+class WalletFileWriter
+{
+  KeyPairIdMode _idMode;
+  std::uint64_t _sequence;
+  std::uint64_t _bytesPerSecond = 0;
+  std::pmr::vector<WalletFileRecord> _records{ lockedMemoryResource() };
+
+public:
+  explicit WalletFileWriter(KeyPairIdMode idMode = KeyPairIdMode::Crc32, std::uint64_t sequence = 0)
+    : _idMode(idMode), _sequence(sequence) {}
+
+  void reserve(std::size_t count) { _records.reserve(count); }
+  void add(const KeyPairInterface &keyPair);
+  void addRecord(const WalletFileRecord &record) { _records.push_back(record); }
+
+  /**
+    * @brief throttle()
+    *
+    * Have write() write at most bytesPerSecond, (0 - as fast as it can)
+    *
+    */
+  void throttle(std::uint64_t bytesPerSecond) { _bytesPerSecond = bytesPerSecond; }
+
+  /**
+    * @brief addAll()
+    *
+    * Add every KeyPair of wallet, (in listPage() order)
+    *
+    */
+  void addAll(const WalletInterface &wallet);
+
+  std::size_t size() const { return _records.size(); }
+
+  /**
+    * @brief write()
+    * @exception WalletFileException
+    */
+  void write(const std::string &path) const;
+};
+
+#endif// _WALLETFILE_HPP
@@ -19,12 +19,45 @@
  * 
  */
 
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <list>
+#include <string_view>
+#include <vector>
 #include <extras/interfaces.hpp>
 #include "KeyPairInterface.hpp"
 
 
+/**
+  * @brief KeyPairIdCursor
+  * 
+  * Continuation token for WalletInterface::listPage(). Start a walk with
+  * firstPage, keep passing back whatever listPage() returned, stop when
+  * it returns noMorePages. The value only means something to the Wallet
+  * that produced it, but it can be saved and used to resume later.
+  * 
+  */
+using KeyPairIdCursor = std::uint64_t;
+constexpr KeyPairIdCursor firstPage = 0;
+constexpr KeyPairIdCursor noMorePages = UINT64_MAX;
+
+/**
+  * @brief WalletStatus
+  * 
+  * The per item outcome of the batch operations, (storeMany() etc.),
+  * which report what the single item operations would have thrown.
+  * 
+  */
+enum class WalletStatus : std::uint8_t {
+  Ok,
+  NotFound,// KeyPairNotFoundException
+  AlreadyExists// KeyPairAlreadyExistsException
+};
+
+using WalletStatusVector = std::vector<WalletStatus>;
+using KeyPairBatch = std::vector<const KeyPairInterface *>;
+
 /**
   * @brief WalletInterface
   * 
@@ -83,39 +116,112 @@ interface WalletInterface
     */
   virtual KeyPairIdList list() const pure;
 
+  /**
+    * @brief listInto()
+    * 
+    * @note same as list(), but the KeyPairIds are appended to a contiguous
+    * container supplied by the caller, (so a caller that lists repeatedly
+    * can reuse its capacity and no list nodes get allocated).
+    * 
+    */
+  virtual void listInto(KeyPairIdVector &keyPairIds) const pure;
+
+  /**
+    * @brief listPage()
+    * 
+    * The need has arisen, (see list()): walks the Wallet in pages of at
+    * most limit KeyPairIds, so listing never needs memory in proportion
+    * to the size of the Wallet.
+    * 
+    * @note every KeyPair stored for the whole walk is listed exactly
+    * once, KeyPairs stored or removed during the walk may or may not be.
+    * 
+    * @param cursor firstPage, or the value returned for the previous page
+    * @param limit the most KeyPairIds to return, (0 is taken as 1, so a walk
+    * always moves on)
+    * @param keyPairIds replaced by the KeyPairIds of this page
+    * @return the cursor for the next page, or noMorePages
+    * 
+    */
+  virtual KeyPairIdCursor listPage(
+    const KeyPairIdCursor &cursor, std::size_t limit, KeyPairIdVector &keyPairIds) const pure;
+
   /**
     * @brief find...()
     * 
     * @note depending on what information we need from the wallet
     * the following find methods are implemented. 
     * 
+    * @note keys are looked up by their bytes, (a KeyPairPublicKey, a
+    * std::string or a view into a receive buffer, nothing is copied), a
+    * key longer than any the Wallet holds is simply not found.
+    * 
     * @return a KeyPairInterface using a variety of parameter types
     * @exception KeyPairNotFoundInterface
     * 
     */
   virtual const KeyPairInterface &findByKeyPair(const KeyPairInterface &keyPairInterface) const pure;
   virtual const KeyPairInterface &findByKeyPairId(const KeyPairId &KeyPairId) const pure;
-  virtual const KeyPairInterface &findByPublicKey(const KeyPairPublicKey &keyPairPublicKey) const pure;
+  virtual const KeyPairInterface &findByPublicKey(std::string_view keyPairPublicKey) const pure;
   virtual const KeyPairInterface &findByPublicKeyId(const KeyPairId &KeyPairId) const pure;
-  virtual const KeyPairInterface &findByPrivateKey(const KeyPairPrivateKey &keyPairPrivateKey) const pure;
+  virtual const KeyPairInterface &findByPrivateKey(std::string_view keyPairPrivateKey) const pure;
   virtual const KeyPairInterface &findByPrivateKeyId(const KeyPairId &KeyPairId) const pure;
+
+  /**
+    * @brief tryRetrieve(), tryFind...()
+    * 
+    * @note the same lookups as retrieve() and find...(), except that a
+    * miss is not exceptional here, (probing whether a key belongs to the
+    * Wallet is a common question). Nothing is thrown or allocated.
+    * 
+    * @return a pointer to the KeyPairInterface instance or nullptr
+    * 
+    */
+  virtual const KeyPairInterface *tryRetrieve(const KeyPairId &keyPairId) const pure;
+  virtual const KeyPairInterface *tryFindByKeyPair(const KeyPairInterface &keyPairInterface) const pure;
+  virtual const KeyPairInterface *tryFindByKeyPairId(const KeyPairId &KeyPairId) const pure;
+  virtual const KeyPairInterface *tryFindByPublicKey(std::string_view keyPairPublicKey) const pure;
+  virtual const KeyPairInterface *tryFindByPublicKeyId(const KeyPairId &KeyPairId) const pure;
+  virtual const KeyPairInterface *tryFindByPrivateKey(std::string_view keyPairPrivateKey) const pure;
+  virtual const KeyPairInterface *tryFindByPrivateKeyId(const KeyPairId &KeyPairId) const pure;
+
+  /**
+    * @brief storeMany(), removeMany(), findManyByPublicKeyId()
+    * 
+    * @note batch versions of store(), remove() and tryFindByPublicKeyId(),
+    * (for bulk imports and reconciliation loops). One call covers the
+    * whole batch, so the Wallet can order its work, (prefetching, taking
+    * each lock once, etc.), and nothing is thrown per item.
+    * 
+    * @param results replaced by one WalletStatus, (or one pointer, nullptr
+    * meaning not found), per item, in the order of the input
+    * 
+    */
+  virtual void storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results) pure;
+  virtual void removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results) pure;
+  virtual void findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const pure;
 };
 
 /**
  * @brief KeyPairNotFoundException
  * 
+ * @note the message is formatted into a fixed buffer, (constructing
+ * the exception does not allocate).
+ * 
  */
 class KeyPairNotFoundException extends std::exception
 {
-  std::string _msg;
+  char _msg[24];
 
 public:
   KeyPairNotFoundException(const KeyPairId &KeyPairId)
-    : _msg(std::to_string(KeyPairId)) {}
+  {
+    std::snprintf(_msg, sizeof(_msg), "%ld", KeyPairId);
+  }
 
   const char *what() const noexcept override
   {
-    return _msg.c_str();
+    return _msg;
   };
 };
 
@@ -125,16 +231,50 @@ public:
  */
 class KeyPairAlreadyExistsException extends std::exception
 {
-  std::string _msg;
+  char _msg[24];
 
 public:
   KeyPairAlreadyExistsException(const KeyPairId &KeyPairId)
-    : _msg(std::to_string(KeyPairId)) {}
+  {
+    std::snprintf(_msg, sizeof(_msg), "%ld", KeyPairId);
+  }
+
+  const char *what() const noexcept override
+  {
+    return _msg;
+  };
+};
 
+/**
+ * @brief WalletReadOnlyException
+ *
+ * @note thrown by store(), remove(), (etc.), of a Wallet that cannot
+ * change, (such as one mapped from a Wallet file).
+ *
+ */
+class WalletReadOnlyException extends std::exception
+{
+public:
   const char *what() const noexcept override
   {
-    return _msg.c_str();
+    return "the Wallet is read-only";
   };
 };
 
+/**
+ * @brief found()
+ * 
+ * For implementing retrieve() and find...() on top of their try...()
+ * counterparts.
+ * 
+ * @return *keyPair
+ * @exception KeyPairNotFoundException if keyPair is nullptr
+ * 
+ */
+inline const KeyPairInterface &found(const KeyPairInterface *keyPair, const KeyPairId &keyPairId)
+{
+  if (keyPair == nullptr) throw KeyPairNotFoundException(keyPairId);
+  return *keyPair;
+}
+
 #endif// _WALLETINTERFACE_HPP
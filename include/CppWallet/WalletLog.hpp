@@ -0,0 +1,185 @@
+#ifndef _WALLETLOG_HPP
+#define _WALLETLOG_HPP
+
+/**
+ * @brief WalletLog
+ *
+ * BSAPI-1322:
+ *
+ * GIVEN that store() and remove() have to be durable
+ * WHEN many threads store() and remove() at the same time
+ * THEN their log entries should reach the disk together, one fdatasync()
+ *      per group of callers rather than one per caller
+ *
+ * The log file is a WalletLogHeader followed by WalletLogEntry records,
+ * each carrying its own checksum, so a torn write at the end of the log
+ * is recognised, (and cut off), when the log is opened again.
+ *
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IoBackend.hpp"
+#include "LockedMemory.hpp"
+#include "WalletFile.hpp"
+
+struct WalletLogHeader
+{
+  static constexpr char expectedMagic[8] = { 'C', 'P', 'P', 'W', 'L', 'O', 'G', '1' };
+  static constexpr std::uint32_t currentVersion = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t idMode;// KeyPairIdMode
+  std::uint64_t firstSequence;// of the first entry in this file
+  std::uint32_t reserved;
+  std::uint32_t headerChecksum;// crc32() of the header up to here
+};
+
+enum class WalletLogOp : std::uint8_t {
+  Store = 1,// record holds the KeyPair
+  Remove = 2// only record.keyPairId is set
+};
+
+struct WalletLogEntry
+{
+  std::uint32_t checksum;// crc32() of the rest of the entry
+  WalletLogOp op;
+  char reserved[3];
+  std::uint64_t sequence;
+  WalletFileRecord record;
+};
+
+static_assert(sizeof(WalletLogHeader) == 32, "the log header is 32 bytes");
+static_assert(sizeof(WalletLogEntry) == 144, "a log entry is 144 bytes");
+
+/**
+  * @brief WalletLogOptions
+  *
+  *   commitDelay     - how long the thread that writes a group waits for
+  *                     more callers to join it, (0 - write at once, the
+  *                     callers arriving meanwhile form the next group)
+  *   maxGroupEntries - the most entries written in one group, (a group
+  *                     this large is written without waiting out the
+  *                     commitDelay, the entries beyond it wait for the
+  *                     next group)
+  *   sync            - false trades durability for speed: entries are
+  *                     written but not fdatasync()'d, (they survive the
+  *                     process crashing, not the machine)
+  *   backend         - how a group is written, (IoBackendKind::Uring
+  *                     submits the write and the fdatasync() together)
+  *
+  */
+struct WalletLogOptions
+{
+  std::chrono::microseconds commitDelay{ 0 };
+  std::size_t maxGroupEntries = 4096;
+  bool sync = true;
+  IoBackendKind backend = IoBackendKind::Pread;
+};
+
+/**
+  * @brief WalletLog
+  *
+  * Append-only log of store and remove operations with group commit.
+  * appendStore() and appendRemove() only queue an entry, (cheap, meant
+  * to be called while the caller holds whatever lock orders its
+  * operations), commit() returns once that entry is on disk. Whichever
+  * committing thread finds no write in progress becomes the leader: it
+  * takes the entries queued so far, (up to maxGroupEntries), writes them
+  * with one write() and one fdatasync(), and wakes the threads whose
+  * entries that covered.
+  *
+  * @note after a failed write or sync every commit() throws, (what made
+  * it to disk is unknown, the log has to be opened again).
+  *
+  * @note store entries carry private keys: the queue is kept in
+  * lockedMemoryResource() and wiped once written.
+  *
+  */
+class WalletLog
+{
+public:
+  using Sequence = std::uint64_t;
+  using Replay = std::function<void(const WalletLogEntry &entry)>;
+
+  /**
+    * @brief WalletLog()
+    *
+    * Open, (or create), the log at path and hand every valid entry in it
+    * to replay, in order, before anything can be appended. A damaged tail
+    * is cut off.
+    *
+    * @exception WalletFileException
+    */
+  WalletLog(const std::string &path, KeyPairIdMode idMode, const WalletLogOptions &options, const Replay &replay, Sequence firstSequence = 1);
+  ~WalletLog();
+
+  WalletLog(const WalletLog &) = delete;
+  WalletLog &operator=(const WalletLog &) = delete;
+
+  /**
+    * @brief read()
+    *
+    * Hand every valid entry of the log at path to replay, without
+    * opening it for appending, (for logs no longer written to)
+    *
+    * @return the sequence number of the last valid entry, (the first
+    * sequence number of the log less one if it has none)
+    * @exception WalletFileException
+    */
+  static Sequence read(const std::string &path, KeyPairIdMode idMode, const Replay &replay);
+
+  /**
+    * @brief appendStore(), appendRemove()
+    * @return the sequence number of the queued entry
+    */
+  Sequence appendStore(const KeyPairInterface &keyPair);
+  Sequence appendRemove(const KeyPairId &keyPairId);
+
+  /**
+    * @brief commit()
+    *
+    * Wait until every entry up to sequence is durable
+    *
+    * @exception WalletFileException
+    */
+  void commit(Sequence sequence);
+
+  Sequence firstSequence() const { return _first; }
+  Sequence lastSequence() const;
+  Sequence durableSequence() const;
+  std::uint64_t syncCount() const;
+  const std::string &path() const { return _path; }
+
+private:
+  std::string _path;
+  int _fd = -1;
+  WalletLogOptions _options;
+  Sequence _first = 1;
+  std::uint64_t _end = 0;// where the next group goes, (only the leader moves it)
+  std::unique_ptr<IoBackendInterface> _io;
+
+  mutable std::mutex _lock;
+  std::condition_variable _committed;
+  std::condition_variable _groupFull;
+  std::pmr::vector<WalletLogEntry> _queued{ lockedMemoryResource() };
+  std::pmr::vector<WalletLogEntry> _writing{ lockedMemoryResource() };
+  Sequence _appended = 0;
+  Sequence _durable = 0;
+  bool _leading = false;
+  std::string _failure;
+  std::uint64_t _syncs = 0;
+
+  Sequence queue(WalletLogEntry &entry);
+  void writeGroup();
+};
+
+#endif// _WALLETLOG_HPP
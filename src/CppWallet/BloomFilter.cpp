@@ -0,0 +1,72 @@
+#include "../include/CppWallet/BloomFilter.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static constexpr unsigned maxHashes = 16;
+
+//
+// The ids per block follow a Poisson distribution, (blocks do not fill up
+// evenly), so the rate is that of a plain Bloom filter of blockBits bits
+// averaged over the number of ids that land in a block.
+//
+
+static double estimate(size_t blocks, unsigned hashes, size_t count, unsigned blockBits)
+{
+  if (count == 0) return 0;
+  double perBlock = double(count) / double(blocks);
+  double spread = 12 * sqrt(perBlock) + 2;
+  size_t from = size_t(max(0.0, perBlock - spread)), to = size_t(perBlock + spread);
+  double rate = 0;
+  for (size_t ids = from; ids <= to; ++ids) {
+    double probability = exp(double(ids) * log(perBlock) - perBlock - lgamma(double(ids) + 1));
+    double set = 1 - pow(1 - 1.0 / blockBits, double(hashes) * double(ids));
+    rate += probability * pow(set, double(hashes));
+  }
+  return min(rate, 1.0);
+}
+
+static unsigned bestHashes(size_t blocks, size_t count, unsigned blockBits)
+{
+  unsigned best = 1;
+  for (unsigned hashes = 2; hashes <= maxHashes; ++hashes)
+    if (estimate(blocks, hashes, count, blockBits) < estimate(blocks, best, count, blockBits)) best = hashes;
+  return best;
+}
+
+BlockedBloomFilter::BlockedBloomFilter(const BloomFilterOptions &options) : _options(options)
+{
+  reset(0);
+}
+
+//
+// Start from the bits per id of a plain Bloom filter, (1.44 log2(1/rate)),
+// and add more until the blocked layout meets the rate too, (it needs a
+// few percent more, the blocks that get more than their share of ids
+// answer true more often).
+//
+
+void BlockedBloomFilter::reset(size_t capacity)
+{
+  _capacity = capacity;
+  _count = 0;
+  size_t count = max<size_t>(capacity, 1);
+  double target = min(max(_options.falsePositiveRate, 1e-9), 0.5);
+  size_t blocks = 1;
+  for (double bitsPerId = 1.44 * log2(1 / target); bitsPerId < 64; bitsPerId += 0.25) {
+    blocks = max<size_t>(1, size_t(ceil(double(count) * bitsPerId / blockBits)));
+    if (_options.maxBytes > 0 && blocks * sizeof(Block) > _options.maxBytes) {
+      blocks = max<size_t>(1, _options.maxBytes / sizeof(Block));
+      break;
+    }
+    if (estimate(blocks, bestHashes(blocks, count, blockBits), count, blockBits) <= target) break;
+  }
+  _hashes = bestHashes(blocks, count, blockBits);
+  _blocks.assign(blocks, Block{});
+}
+
+double BlockedBloomFilter::falsePositiveRateFor(size_t count) const
+{
+  return estimate(_blocks.size(), _hashes, count, blockBits);
+}
@@ -0,0 +1,499 @@
+#include "../include/CppWallet/ConcurrentWallet.hpp"
+#include <algorithm>
+#include <mutex>
+
+using namespace std;
+
+using SharedLock = shared_lock<shared_mutex>;
+using ExclusiveLock = unique_lock<shared_mutex>;
+
+ConcurrentWallet::ConcurrentWallet(KeyPairIdMode idMode, unsigned shardBits)
+  : _shardBits(min(shardBits, 16u)), _idMode(idMode)
+{
+  size_t count = size_t(1) << _shardBits;
+  for (size_t i = 0; i < count; ++i) {
+    _shards.push_back(make_unique<Shard>(idMode));
+    _publicKeyRoutes.push_back(make_unique<Route>());
+    _privateKeyRoutes.push_back(make_unique<Route>());
+  }
+}
+
+//
+// The shard number comes from the top bits of the mixed id, the tables
+// inside a shard use the bottom bits, so the two stay independent.
+//
+
+ConcurrentWallet::Slot ConcurrentWallet::shardOf(const KeyPairId &keyPairId) const
+{
+  return _shardBits == 0 ? 0 : static_cast<Slot>(KeyPairIndex::mix(keyPairId) >> (64 - _shardBits));
+}
+
+ConcurrentWallet::Route &ConcurrentWallet::routeOf(const vector<unique_ptr<Route>> &routes, const KeyPairId &id) const
+{
+  return *routes[shardOf(id)];
+}
+
+static void collect(const KeyPairIndex &index, const KeyPairId &id, vector<KeyPairIndex::Slot> &shards)
+{
+  index.findIf(id, [&shards](KeyPairIndex::Slot shard) {
+    if (find(shards.begin(), shards.end(), shard) == shards.end()) shards.push_back(shard);
+    return false;
+  });
+}
+
+void ConcurrentWallet::candidates(const vector<unique_ptr<Route>> &routes, const KeyPairId &id, vector<Slot> &shards) const
+{
+  const Route &route = routeOf(routes, id);
+  SharedLock lock(route.lock);
+  collect(route.shards, id, shards);
+}
+
+void ConcurrentWallet::candidates(const vector<unique_ptr<Route>> &routes, const RoutedIds &ids, vector<Slot> &shards) const
+{
+  for (size_t i = 0; i < ids.size();) {
+    Slot routeShard = ids[i].first;
+    const Route &route = *routes[routeShard];
+    SharedLock lock(route.lock);
+    for (; i < ids.size() && ids[i].first == routeShard; ++i) collect(route.shards, ids[i].second, shards);
+  }
+}
+
+void ConcurrentWallet::lockRoutes(const vector<unique_ptr<Route>> &routes, const RoutedIds &ids, vector<ExclusiveLock> &locks)
+{
+  for (size_t i = 0; i < ids.size(); ++i)
+    if (i == 0 || ids[i].first != ids[i - 1].first) locks.emplace_back(routes[ids[i].first]->lock);
+}
+
+//
+// Almost every id routes to a single shard, so the candidates are
+// gathered on the stack, (the rare long list falls back to a vector).
+//
+
+template<typename Find>
+const KeyPairInterface *ConcurrentWallet::findVia(const vector<unique_ptr<Route>> &routes, const KeyPairId &id, Find &&find) const
+{
+  static constexpr size_t few = 4;
+  Slot shards[few];
+  size_t count = 0;
+  {
+    const Route &route = routeOf(routes, id);
+    SharedLock lock(route.lock);
+    route.shards.findIf(id, [&](Slot shard) {
+      if (find_if(shards, shards + min(count, few), [shard](Slot s) { return s == shard; }) == shards + min(count, few)) {
+        if (count < few) shards[count] = shard;
+        ++count;
+      }
+      return false;
+    });
+  }
+  if (count > few) {
+    vector<Slot> all;
+    candidates(routes, id, all);
+    for (Slot shard : all) {
+      SharedLock lock(_shards[shard]->lock);
+      if (const KeyPairInterface *keyPair = find(_shards[shard]->wallet)) return keyPair;
+    }
+    return nullptr;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    SharedLock lock(_shards[shards[i]]->lock);
+    if (const KeyPairInterface *keyPair = find(_shards[shards[i]]->wallet)) return keyPair;
+  }
+  return nullptr;
+}
+
+//
+// A store() has to make sure that neither key is already stored, and
+// KeyPairs sharing a publicKeyId (or privateKeyId) may live in other
+// shards. So the shards named by the routing indexes are locked too,
+// (shared, in ascending order along with the KeyPair's own shard), and
+// the routes are checked again once locked in case they moved meanwhile.
+//
+
+WalletStatus ConcurrentWallet::insert(const KeyPairInterface &keyPair, KeyPairId &clash)
+{
+  Slot home = shardOf(keyPair.keyPairId());
+  Route &publicKeyRoute = routeOf(_publicKeyRoutes, keyPair.publicKeyId());
+  Route &privateKeyRoute = routeOf(_privateKeyRoutes, keyPair.privateKeyId());
+  vector<Slot> shards, check;
+  for (;;) {
+    shards.assign(1, home);
+    candidates(_publicKeyRoutes, keyPair.publicKeyId(), shards);
+    candidates(_privateKeyRoutes, keyPair.privateKeyId(), shards);
+    sort(shards.begin(), shards.end());
+
+    ExclusiveLock homeLock;
+    vector<SharedLock> otherLocks;
+    for (Slot shard : shards) {
+      if (shard == home)
+        homeLock = ExclusiveLock(_shards[shard]->lock);
+      else
+        otherLocks.emplace_back(_shards[shard]->lock);
+    }
+    ExclusiveLock publicKeyLock(publicKeyRoute.lock);
+    ExclusiveLock privateKeyLock(privateKeyRoute.lock);
+
+    check.clear();
+    collect(publicKeyRoute.shards, keyPair.publicKeyId(), check);
+    collect(privateKeyRoute.shards, keyPair.privateKeyId(), check);
+    bool moved = any_of(check.begin(), check.end(), [&shards](Slot shard) {
+      return !binary_search(shards.begin(), shards.end(), shard);
+    });
+    if (moved) continue;
+    return insertLocked(keyPair, home, publicKeyRoute, privateKeyRoute, shards, clash);
+  }
+}
+
+//
+// The checks and the store of insert(), with keyPair's home shard locked
+// exclusively, the shards its routes name shared, and both routing
+// shards exclusively.
+//
+
+WalletStatus ConcurrentWallet::insertLocked(const KeyPairInterface &keyPair, Slot home, Route &publicKeyRoute, Route &privateKeyRoute,
+  const vector<Slot> &shards, KeyPairId &clash)
+{
+  Wallet &wallet = _shards[home]->wallet;
+  if (wallet.tryRetrieve(keyPair.keyPairId()) != nullptr) {
+    clash = keyPair.keyPairId();
+    return WalletStatus::AlreadyExists;
+  }
+  for (Slot shard : shards) {
+    const Wallet &other = _shards[shard]->wallet;
+    if (other.tryFindByPublicKey(keyPair.publicKey()) != nullptr) {
+      clash = keyPair.publicKeyId();
+      return WalletStatus::AlreadyExists;
+    }
+    if (other.tryFindByPrivateKey(keyPair.privateKey()) != nullptr) {
+      clash = keyPair.privateKeyId();
+      return WalletStatus::AlreadyExists;
+    }
+  }
+  wallet.store(keyPair);
+  publicKeyRoute.shards.insertMulti(keyPair.publicKeyId(), home);
+  privateKeyRoute.shards.insertMulti(keyPair.privateKeyId(), home);
+  return WalletStatus::Ok;
+}
+
+WalletStatus ConcurrentWallet::erase(const KeyPairId &keyPairId)
+{
+  Slot home = shardOf(keyPairId);
+  Shard &shard = *_shards[home];
+  ExclusiveLock lock(shard.lock);
+  const KeyPairInterface *keyPair = shard.wallet.tryRetrieve(keyPairId);
+  if (keyPair == nullptr) return WalletStatus::NotFound;
+  Route &publicKeyRoute = routeOf(_publicKeyRoutes, keyPair->publicKeyId());
+  Route &privateKeyRoute = routeOf(_privateKeyRoutes, keyPair->privateKeyId());
+  ExclusiveLock publicKeyLock(publicKeyRoute.lock);
+  ExclusiveLock privateKeyLock(privateKeyRoute.lock);
+  publicKeyRoute.shards.erase(keyPair->publicKeyId(), home);
+  privateKeyRoute.shards.erase(keyPair->privateKeyId(), home);
+  shard.wallet.remove(keyPairId);
+  return WalletStatus::Ok;
+}
+
+KeyPairId ConcurrentWallet::store(const KeyPairInterface &keyPair)
+{
+  KeyPairId clash;
+  if (insert(keyPair, clash) != WalletStatus::Ok) throw KeyPairAlreadyExistsException(clash);
+  return keyPair.keyPairId();
+}
+
+const KeyPairInterface &ConcurrentWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void ConcurrentWallet::remove(const KeyPairId &keyPairId)
+{
+  if (erase(keyPairId) != WalletStatus::Ok) throw KeyPairNotFoundException(keyPairId);
+}
+
+KeyPairIdList ConcurrentWallet::list() const
+{
+  KeyPairIdList keyPairIds;
+  for (const auto &shard : _shards) {
+    SharedLock lock(shard->lock);
+    shard->wallet.copyKeyPairIds(back_inserter(keyPairIds));
+  }
+  return keyPairIds;
+}
+
+void ConcurrentWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  for (const auto &shard : _shards) {
+    SharedLock lock(shard->lock);
+    shard->wallet.listInto(keyPairIds);
+  }
+}
+
+//
+// A cursor holds the shard number in its top half and the cursor
+// within that shard's Wallet in its bottom half.
+//
+
+KeyPairIdCursor ConcurrentWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  thread_local KeyPairIdVector page;
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  size_t shard = cursor >> 32;
+  KeyPairIdCursor inner = cursor & UINT32_MAX;
+  while (shard < _shards.size() && keyPairIds.size() < limit) {
+    {
+      SharedLock lock(_shards[shard]->lock);
+      inner = _shards[shard]->wallet.listPage(inner, limit - keyPairIds.size(), page);
+    }
+    keyPairIds.insert(keyPairIds.end(), page.begin(), page.end());
+    if (inner == noMorePages) {
+      ++shard;
+      inner = firstPage;
+    }
+  }
+  return shard < _shards.size() ? (KeyPairIdCursor(shard) << 32 | inner) : noMorePages;
+}
+
+const KeyPairInterface &ConcurrentWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &ConcurrentWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &ConcurrentWallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &ConcurrentWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &ConcurrentWallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &ConcurrentWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+const KeyPairInterface *ConcurrentWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  const Shard &shard = *_shards[shardOf(keyPairId)];
+  SharedLock lock(shard.lock);
+  return shard.wallet.tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return tryRetrieve(keyPair.keyPairId());
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  return findVia(_publicKeyRoutes, publicKeyIdOf(publicKey, _idMode), [&publicKey](const Wallet &wallet) {
+    return wallet.tryFindByPublicKey(publicKey);
+  });
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return findVia(_publicKeyRoutes, publicKeyId, [&publicKeyId](const Wallet &wallet) {
+    return wallet.tryFindByPublicKeyId(publicKeyId);
+  });
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  return findVia(_privateKeyRoutes, privateKeyIdOf(privateKey, _idMode), [&privateKey](const Wallet &wallet) {
+    return wallet.tryFindByPrivateKey(privateKey);
+  });
+}
+
+const KeyPairInterface *ConcurrentWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return findVia(_privateKeyRoutes, privateKeyId, [&privateKeyId](const Wallet &wallet) {
+    return wallet.tryFindByPrivateKeyId(privateKeyId);
+  });
+}
+
+//
+// Orders the items of a batch by shard, (a counting sort), so that each
+// lock is taken once per batch rather than once per item.
+//
+
+template<typename ShardOf>
+static vector<uint32_t> groupByShard(size_t items, size_t shards, ShardOf &&shardOf, vector<uint32_t> &offsets)
+{
+  offsets.assign(shards + 1, 0);
+  for (size_t i = 0; i < items; ++i) ++offsets[shardOf(i) + 1];
+  for (size_t s = 0; s < shards; ++s) offsets[s + 1] += offsets[s];
+  vector<uint32_t> order(items);
+  vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < items; ++i) order[next[shardOf(i)]++] = static_cast<uint32_t>(i);
+  return order;
+}
+
+//
+// A batch is written a Wallet shard at a time, (its items grouped by
+// keyPairId, in batch order within a shard), each group taking its locks
+// once, in the order insert() and erase() take them. KeyPairs of one
+// batch that clash with each other but live in different shards are
+// stored in shard order, (the first one stored wins), rather than batch
+// order.
+//
+
+void ConcurrentWallet::storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results)
+{
+  size_t items = keyPairs.size();
+  size_t shards = _shards.size();
+  results.resize(items);
+  vector<uint32_t> offsets;
+  auto order = groupByShard(items, shards, [&](size_t i) { return shardOf(keyPairs[i]->keyPairId()); }, offsets);
+
+  RoutedIds publicKeyIds, privateKeyIds;
+  vector<Slot> locked, check;
+  KeyPairId clash;
+  for (Slot home = 0; home < shards; ++home) {
+    if (offsets[home] == offsets[home + 1]) continue;
+    publicKeyIds.clear();
+    privateKeyIds.clear();
+    for (size_t k = offsets[home]; k < offsets[home + 1]; ++k) {
+      const KeyPairInterface &keyPair = *keyPairs[order[k]];
+      publicKeyIds.emplace_back(shardOf(keyPair.publicKeyId()), keyPair.publicKeyId());
+      privateKeyIds.emplace_back(shardOf(keyPair.privateKeyId()), keyPair.privateKeyId());
+    }
+    sort(publicKeyIds.begin(), publicKeyIds.end());
+    sort(privateKeyIds.begin(), privateKeyIds.end());
+
+    for (;;) {
+      locked.assign(1, home);
+      candidates(_publicKeyRoutes, publicKeyIds, locked);
+      candidates(_privateKeyRoutes, privateKeyIds, locked);
+      sort(locked.begin(), locked.end());
+
+      ExclusiveLock homeLock;
+      vector<SharedLock> otherLocks;
+      for (Slot shard : locked) {
+        if (shard == home)
+          homeLock = ExclusiveLock(_shards[shard]->lock);
+        else
+          otherLocks.emplace_back(_shards[shard]->lock);
+      }
+      vector<ExclusiveLock> routeLocks;
+      lockRoutes(_publicKeyRoutes, publicKeyIds, routeLocks);
+      lockRoutes(_privateKeyRoutes, privateKeyIds, routeLocks);
+
+      check.clear();
+      for (const auto &id : publicKeyIds) collect(_publicKeyRoutes[id.first]->shards, id.second, check);
+      for (const auto &id : privateKeyIds) collect(_privateKeyRoutes[id.first]->shards, id.second, check);
+      bool moved = any_of(check.begin(), check.end(), [&locked](Slot shard) {
+        return !binary_search(locked.begin(), locked.end(), shard);
+      });
+      if (moved) continue;
+
+      for (size_t k = offsets[home]; k < offsets[home + 1]; ++k) {
+        const KeyPairInterface &keyPair = *keyPairs[order[k]];
+        Route &publicKeyRoute = routeOf(_publicKeyRoutes, keyPair.publicKeyId());
+        Route &privateKeyRoute = routeOf(_privateKeyRoutes, keyPair.privateKeyId());
+        check.assign(1, home);
+        collect(publicKeyRoute.shards, keyPair.publicKeyId(), check);
+        collect(privateKeyRoute.shards, keyPair.privateKeyId(), check);
+        results[order[k]] = insertLocked(keyPair, home, publicKeyRoute, privateKeyRoute, check, clash);
+      }
+      break;
+    }
+  }
+}
+
+void ConcurrentWallet::removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results)
+{
+  size_t items = keyPairIds.size();
+  size_t shards = _shards.size();
+  results.resize(items);
+  vector<uint32_t> offsets;
+  auto order = groupByShard(items, shards, [&](size_t i) { return shardOf(keyPairIds[i]); }, offsets);
+
+  RoutedIds publicKeyIds, privateKeyIds;
+  for (Slot home = 0; home < shards; ++home) {
+    if (offsets[home] == offsets[home + 1]) continue;
+    Shard &shard = *_shards[home];
+    ExclusiveLock lock(shard.lock);
+    publicKeyIds.clear();
+    privateKeyIds.clear();
+    for (size_t k = offsets[home]; k < offsets[home + 1]; ++k) {
+      if (const KeyPairInterface *keyPair = shard.wallet.tryRetrieve(keyPairIds[order[k]])) {
+        publicKeyIds.emplace_back(shardOf(keyPair->publicKeyId()), keyPair->publicKeyId());
+        privateKeyIds.emplace_back(shardOf(keyPair->privateKeyId()), keyPair->privateKeyId());
+      }
+    }
+    sort(publicKeyIds.begin(), publicKeyIds.end());
+    sort(privateKeyIds.begin(), privateKeyIds.end());
+    vector<ExclusiveLock> routeLocks;
+    lockRoutes(_publicKeyRoutes, publicKeyIds, routeLocks);
+    lockRoutes(_privateKeyRoutes, privateKeyIds, routeLocks);
+
+    for (size_t k = offsets[home]; k < offsets[home + 1]; ++k) {
+      const KeyPairId &keyPairId = keyPairIds[order[k]];
+      const KeyPairInterface *keyPair = shard.wallet.tryRetrieve(keyPairId);
+      if (keyPair == nullptr) {
+        results[order[k]] = WalletStatus::NotFound;
+        continue;
+      }
+      routeOf(_publicKeyRoutes, keyPair->publicKeyId()).shards.erase(keyPair->publicKeyId(), home);
+      routeOf(_privateKeyRoutes, keyPair->privateKeyId()).shards.erase(keyPair->privateKeyId(), home);
+      shard.wallet.remove(keyPairId);
+      results[order[k]] = WalletStatus::Ok;
+    }
+  }
+}
+
+void ConcurrentWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  size_t items = publicKeyIds.size();
+  size_t shards = _shards.size();
+  results.assign(items, nullptr);
+  vector<uint32_t> offsets;
+
+  // first the routing shards, to learn which Wallet shard to ask
+  vector<Slot> homes(items, KeyPairIndex::npos);
+  auto order = groupByShard(items, shards, [&](size_t i) { return shardOf(publicKeyIds[i]); }, offsets);
+  for (size_t s = 0; s < shards; ++s) {
+    if (offsets[s] == offsets[s + 1]) continue;
+    const Route &route = *_publicKeyRoutes[s];
+    SharedLock lock(route.lock);
+    for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) homes[order[k]] = route.shards.find(publicKeyIds[order[k]]);
+  }
+
+  // then the Wallet shards, (items not routed anywhere are left out)
+  order = groupByShard(items, shards + 1, [&](size_t i) { return homes[i] == KeyPairIndex::npos ? shards : homes[i]; }, offsets);
+  for (size_t s = 0; s < shards; ++s) {
+    if (offsets[s] == offsets[s + 1]) continue;
+    const Shard &shard = *_shards[s];
+    SharedLock lock(shard.lock);
+    for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) results[order[k]] = shard.wallet.tryFindByPublicKeyId(publicKeyIds[order[k]]);
+  }
+}
+
+size_t ConcurrentWallet::size() const
+{
+  size_t count = 0;
+  for (const auto &shard : _shards) {
+    SharedLock lock(shard->lock);
+    count += shard->wallet.size();
+  }
+  return count;
+}
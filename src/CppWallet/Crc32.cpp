@@ -0,0 +1,208 @@
+#include "../include/CppWallet/Crc32.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_X86_64 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+//
+// CRC-32C, bit reflected, (so the polynomial 0x1EDC6F41 reads 0x82F63B78).
+// All the engines below work on the running state, (the complement of the
+// CRC value), crc32() does the complementing on the way in and out.
+//
+
+static constexpr uint32_t reflectedPolynomial = 0x82F63B78;
+
+using Crc32Table = array<array<uint32_t, 256>, 8>;
+
+static constexpr Crc32Table makeCrc32Table()
+{
+  Crc32Table table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ ((crc & 1) ? reflectedPolynomial : 0);
+    table[0][i] = crc;
+  }
+  for (size_t k = 1; k < 8; ++k)
+    for (size_t i = 0; i < 256; ++i)
+      table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+  return table;
+}
+
+static constexpr Crc32Table crc32Table = makeCrc32Table();
+
+static inline uint32_t load32(const uint8_t *p)
+{
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static uint32_t crc32SlicingBy8(const uint8_t *p, size_t length, uint32_t state)
+{
+  const Crc32Table &t = crc32Table;
+  for (; length >= 8; p += 8, length -= 8) {
+    uint32_t lo = state ^ load32(p);
+    uint32_t hi = load32(p + 4);
+    state = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+  }
+  while (length--) state = t[0][(state ^ *p++) & 0xff] ^ (state >> 8);
+  return state;
+}
+
+#ifdef CRC32_X86_64
+
+__attribute__((target("sse4.2"))) static uint32_t crc32Sse42(const uint8_t *p, size_t length, uint32_t state)
+{
+  uint64_t wide = state;
+  for (; length >= 8; p += 8, length -= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    wide = _mm_crc32_u64(wide, word);
+  }
+  state = static_cast<uint32_t>(wide);
+  while (length--) state = _mm_crc32_u8(state, *p++);
+  return state;
+}
+
+//
+// PCLMULQDQ folding, (Intel: "Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ Instruction"), adapted to finish with the crc32 instruction.
+//
+// In the bit reflected world a 16 byte block X holds the polynomial
+// L(x)*x^64 + H(x), (L being the low and H the high quadword). Moving X
+// forward by D bits means multiplying it by x^D, so it can be replaced by
+// the congruent L*(x^(64+D) mod P) + H*(x^D mod P) and xored into the block
+// D bits further on. A carry-less product of two reflected quadwords comes
+// out one bit short, hence the constants are x^(e-1) mod P.
+//
+
+static constexpr uint64_t foldingConstant(unsigned exponent)
+{
+  uint64_t remainder = 1;
+  for (unsigned i = 0; i < exponent - 1; ++i) {
+    remainder <<= 1;
+    if (remainder & (1ULL << 32)) remainder ^= 0x11EDC6F41ULL;
+  }
+  uint64_t reflected = 0;
+  for (unsigned bit = 0; bit < 32; ++bit)
+    if (remainder & (1ULL << bit)) reflected |= 1ULL << (63 - bit);
+  return reflected;
+}
+
+static constexpr uint64_t fold512Low = foldingConstant(512 + 64);
+static constexpr uint64_t fold512High = foldingConstant(512);
+static constexpr uint64_t fold128Low = foldingConstant(128 + 64);
+static constexpr uint64_t fold128High = foldingConstant(128);
+
+// below this the folding setup costs more than it saves
+static constexpr size_t pclmulThreshold = 256;
+
+__attribute__((target("sse4.2,pclmul"))) static inline __m128i fold(__m128i x, __m128i k)
+{
+  return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+__attribute__((target("sse4.2,pclmul"))) static inline __m128i load128(const uint8_t *p)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+__attribute__((target("sse4.2,pclmul"))) static uint32_t crc32Pclmul(const uint8_t *p, size_t length, uint32_t state)
+{
+  if (length < pclmulThreshold) return crc32Sse42(p, length, state);
+
+  const __m128i k512 = _mm_set_epi64x(static_cast<long long>(fold512High), static_cast<long long>(fold512Low));
+  const __m128i k128 = _mm_set_epi64x(static_cast<long long>(fold128High), static_cast<long long>(fold128Low));
+
+  // xoring the state into the first four bytes starts the CRC from it
+  __m128i x1 = _mm_xor_si128(load128(p), _mm_cvtsi32_si128(static_cast<int>(state)));
+  __m128i x2 = load128(p + 16);
+  __m128i x3 = load128(p + 32);
+  __m128i x4 = load128(p + 48);
+  p += 64;
+  length -= 64;
+
+  for (; length >= 64; p += 64, length -= 64) {
+    x1 = _mm_xor_si128(fold(x1, k512), load128(p));
+    x2 = _mm_xor_si128(fold(x2, k512), load128(p + 16));
+    x3 = _mm_xor_si128(fold(x3, k512), load128(p + 32));
+    x4 = _mm_xor_si128(fold(x4, k512), load128(p + 48));
+  }
+
+  x2 = _mm_xor_si128(x2, fold(x1, k128));
+  x3 = _mm_xor_si128(x3, fold(x2, k128));
+  x4 = _mm_xor_si128(x4, fold(x3, k128));
+  for (; length >= 16; p += 16, length -= 16)
+    x4 = _mm_xor_si128(fold(x4, k128), load128(p));
+
+  // x4 is now congruent to everything consumed so far, (starting from 0)
+  uint64_t wide = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(x4)));
+  wide = _mm_crc32_u64(wide, static_cast<uint64_t>(_mm_extract_epi64(x4, 1)));
+  return crc32Sse42(p, length, static_cast<uint32_t>(wide));
+}
+
+#endif// CRC32_X86_64
+
+using Crc32Function = uint32_t (*)(const uint8_t *, size_t, uint32_t);
+
+bool crc32Supported(Crc32Engine engine)
+{
+  switch (engine) {
+  case Crc32Engine::SlicingBy8:
+    return true;
+#ifdef CRC32_X86_64
+  case Crc32Engine::Sse42:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+  case Crc32Engine::Pclmul:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+#endif
+  default:
+    return false;
+  }
+}
+
+static Crc32Function crc32Function(Crc32Engine engine)
+{
+  if (!crc32Supported(engine)) throw invalid_argument("crc32 engine not supported by this CPU");
+  switch (engine) {
+#ifdef CRC32_X86_64
+  case Crc32Engine::Sse42:
+    return crc32Sse42;
+  case Crc32Engine::Pclmul:
+    return crc32Pclmul;
+#endif
+  default:
+    return crc32SlicingBy8;
+  }
+}
+
+static Crc32Engine bestCrc32Engine()
+{
+  for (auto engine : { Crc32Engine::Pclmul, Crc32Engine::Sse42 })
+    if (crc32Supported(engine)) return engine;
+  return Crc32Engine::SlicingBy8;
+}
+
+Crc32Engine crc32Engine()
+{
+  static const Crc32Engine engine = bestCrc32Engine();
+  return engine;
+}
+
+uint32_t crc32(const void *data, size_t length, uint32_t crc)
+{
+  static const Crc32Function function = crc32Function(crc32Engine());
+  return ~function(static_cast<const uint8_t *>(data), length, ~crc);
+}
+
+uint32_t crc32With(Crc32Engine engine, const void *data, size_t length, uint32_t crc)
+{
+  return ~crc32Function(engine)(static_cast<const uint8_t *>(data), length, ~crc);
+}
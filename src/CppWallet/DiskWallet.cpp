@@ -0,0 +1,337 @@
+#include "../include/CppWallet/DiskWallet.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/CppWallet/KeyPairIndex.hpp"
+
+using namespace std;
+
+struct DiskWallet::Lookup
+{
+  KeyPairId id;
+  const string_view *publicKey;// to match, (or nullptr)
+  const string_view *privateKey;// to match, (or nullptr)
+  uint64_t bucket;
+  uint64_t probes;
+  const KeyPairInterface *result;
+};
+
+static constexpr uint64_t pageMask = ~uint64_t(DiskWallet::pageSize - 1);
+
+DiskWallet::DiskWallet(const string &path, const DiskWalletOptions &options)
+  : _path(path), _batch(max(options.queueDepth, 1u))
+{
+  _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (options.direct ? O_DIRECT : 0));
+  if (_fd < 0) throw WalletFileException(path, strerror(errno));
+  try {
+    _pages = static_cast<char *>(lockedMemoryResource()->allocate(_batch * pageSize, pageSize));
+    _io = makeIoBackend(options.backend, options.queueDepth);
+
+    struct stat status;
+    if (::fstat(_fd, &status) != 0) throw WalletFileException(path, strerror(errno));
+    IoRequest request{ _fd, page(0), pageSize, 0, 0 };
+    readPages(&request, 1);
+    memcpy(&_header, page(0), min(size_t(request.result), sizeof(_header)));
+    string problem = checkWalletFileHeader(_header, uint64_t(status.st_size));
+    if (!problem.empty()) throw WalletFileException(path, problem);
+    _mask = _header.bucketCount - 1;
+    _idMode = static_cast<KeyPairIdMode>(_header.idMode);
+    _cached.assign(_header.count, KeyPairIndex::npos);
+  } catch (...) {
+    if (_pages != nullptr) lockedMemoryResource()->deallocate(_pages, _batch * pageSize, pageSize);
+    ::close(_fd);
+    throw;
+  }
+}
+
+DiskWallet::~DiskWallet()
+{
+  lockedMemoryResource()->deallocate(_pages, _batch * pageSize, pageSize);
+  ::close(_fd);
+}
+
+void DiskWallet::readPages(IoRequest *requests, size_t count) const
+{
+  _io->read(requests, count);
+  _reads += count;
+  for (size_t i = 0; i < count; ++i)
+    if (requests[i].result < 0) throw WalletFileException(_path, strerror(int(-requests[i].result)));
+}
+
+//
+// Up to _batch lookups at a time: the table page each one probes next is
+// read for all of them together, (a probe rarely runs on into the next
+// page), then the pages of the candidate records not read before.
+// Probes are bounded, slots and key sizes checked, as with MappedWallet,
+// (a damaged record is not cached, so it is never found).
+//
+
+void DiskWallet::lookupMany(uint64_t tableOffset, Lookup *lookups, size_t count) const
+{
+  vector<size_t> probing, stillProbing;
+  vector<pair<size_t, Slot>> candidates;
+  vector<IoRequest> requests;
+  vector<Slot> unread;
+
+  for (size_t begin = 0; begin < count; begin += _batch) {
+    size_t end = min(count, begin + _batch);
+    probing.clear();
+    candidates.clear();
+    for (size_t i = begin; i < end; ++i) {
+      lookups[i].bucket = KeyPairIndex::mix(lookups[i].id) & _mask;
+      lookups[i].probes = 0;
+      lookups[i].result = nullptr;
+      probing.push_back(i);
+    }
+
+    while (!probing.empty()) {
+      requests.clear();
+      for (size_t k = 0; k < probing.size(); ++k) {
+        uint64_t offset = tableOffset + lookups[probing[k]].bucket * sizeof(WalletFileEntry);
+        requests.push_back(IoRequest{ _fd, page(k), pageSize, offset & pageMask, 0 });
+      }
+      readPages(requests.data(), requests.size());
+      stillProbing.clear();
+      for (size_t k = 0; k < probing.size(); ++k) {
+        Lookup &lookup = lookups[probing[k]];
+        uint64_t pageStart = requests[k].offset, pageEnd = pageStart + uint64_t(requests[k].result);
+        bool done = false;
+        for (;;) {
+          uint64_t offset = tableOffset + lookup.bucket * sizeof(WalletFileEntry);
+          if (offset < pageStart || offset + sizeof(WalletFileEntry) > pageEnd) break;
+          WalletFileEntry entry;
+          memcpy(&entry, page(k) + (offset - pageStart), sizeof(entry));
+          if (entry.slot == KeyPairIndex::npos || lookup.probes++ > _mask) {
+            done = true;
+            break;
+          }
+          if (entry.keyPairId == lookup.id && entry.slot < _header.count) candidates.emplace_back(probing[k], entry.slot);
+          lookup.bucket = (lookup.bucket + 1) & _mask;
+        }
+        // a short read, (a damaged file), ends the probe too
+        if (!done && pageEnd - pageStart == pageSize) stillProbing.push_back(probing[k]);
+      }
+      swap(probing, stillProbing);
+    }
+
+    unread.clear();
+    for (const auto &candidate : candidates)
+      if (_cached[candidate.second] == KeyPairIndex::npos) unread.push_back(candidate.second);
+    sort(unread.begin(), unread.end());
+    unread.erase(unique(unread.begin(), unread.end()), unread.end());
+    for (size_t first = 0; first < unread.size(); first += _batch) {
+      size_t last = min(unread.size(), first + _batch);
+      requests.clear();
+      for (size_t k = first; k < last; ++k) {
+        uint64_t offset = _header.recordsOffset + uint64_t(unread[k]) * sizeof(WalletFileRecord);
+        requests.push_back(IoRequest{ _fd, page(k - first), pageSize, offset & pageMask, 0 });
+      }
+      readPages(requests.data(), requests.size());
+      for (size_t k = first; k < last; ++k) {
+        uint64_t offset = _header.recordsOffset + uint64_t(unread[k]) * sizeof(WalletFileRecord);
+        const IoRequest &request = requests[k - first];
+        if (offset + sizeof(WalletFileRecord) > request.offset + uint64_t(request.result)) continue;
+        WalletFileRecord record;
+        memcpy(&record, page(k - first) + (offset - request.offset), sizeof(record));
+        if (checkWalletFileRecord(record)) _cached[unread[k]] = _records.emplace(WalletFileKeyPair(record));
+        secureZero(&record, sizeof(record));
+      }
+    }
+
+    for (const auto &candidate : candidates) {
+      Lookup &lookup = lookups[candidate.first];
+      Slot cached = _cached[candidate.second];
+      if (lookup.result != nullptr || cached == KeyPairIndex::npos) continue;
+      const KeyPairRecord *record = &_records[cached];
+      if (lookup.publicKey != nullptr && record->publicKey().view() != *lookup.publicKey) continue;
+      if (lookup.privateKey != nullptr && record->privateKey().view() != *lookup.privateKey) continue;
+      lookup.result = record;
+    }
+  }
+}
+
+const KeyPairInterface *DiskWallet::lookup(uint64_t tableOffset, const KeyPairId &id, const string_view *publicKey, const string_view *privateKey) const
+{
+  lock_guard<mutex> lock(_lock);
+  Lookup lookup{ id, publicKey, privateKey, 0, 0, nullptr };
+  lookupMany(tableOffset, &lookup, 1);
+  return lookup.result;
+}
+
+KeyPairId DiskWallet::store(const KeyPairInterface &)
+{
+  throw WalletReadOnlyException();
+}
+
+const KeyPairInterface &DiskWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void DiskWallet::remove(const KeyPairId &)
+{
+  throw WalletReadOnlyException();
+}
+
+KeyPairIdList DiskWallet::list() const
+{
+  KeyPairIdVector keyPairIds;
+  listInto(keyPairIds);
+  return KeyPairIdList(keyPairIds.begin(), keyPairIds.end());
+}
+
+void DiskWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  KeyPairIdVector page;
+  keyPairIds.reserve(keyPairIds.size() + _header.count);
+  for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+    cursor = listPage(cursor, 64 * 1024, page);
+    keyPairIds.insert(keyPairIds.end(), page.begin(), page.end());
+  }
+}
+
+//
+// A cursor is a record number, as with MappedWallet. The records are
+// read _batch pages at a time, (the records section starts on a page
+// and a page holds whole records).
+//
+
+KeyPairIdCursor DiskWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  if (cursor >= _header.count) return noMorePages;
+  uint64_t end = min<uint64_t>(_header.count, cursor + limit);
+  lock_guard<mutex> lock(_lock);
+  vector<IoRequest> requests;
+  uint64_t from = _header.recordsOffset + cursor * sizeof(WalletFileRecord);
+  uint64_t to = _header.recordsOffset + end * sizeof(WalletFileRecord);
+  for (uint64_t offset = from & pageMask; offset < to;) {
+    requests.clear();
+    for (; offset < to && requests.size() < _batch; offset += pageSize)
+      requests.push_back(IoRequest{ _fd, page(requests.size()), pageSize, offset, 0 });
+    readPages(requests.data(), requests.size());
+    for (size_t k = 0; k < requests.size(); ++k) {
+      uint64_t pageStart = requests[k].offset, pageEnd = pageStart + uint64_t(requests[k].result);
+      for (uint64_t record = max(from, pageStart); record + sizeof(WalletFileRecord) <= min(to, pageEnd); record += sizeof(WalletFileRecord)) {
+        KeyPairId keyPairId;
+        memcpy(&keyPairId, page(k) + (record - pageStart) + offsetof(WalletFileRecord, keyPairId), sizeof(keyPairId));
+        keyPairIds.push_back(keyPairId);
+      }
+    }
+  }
+  return end < _header.count ? end : noMorePages;
+}
+
+const KeyPairInterface &DiskWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &DiskWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &DiskWallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &DiskWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &DiskWallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &DiskWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+const KeyPairInterface *DiskWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  return lookup(_header.byKeyPairIdOffset, keyPairId, nullptr, nullptr);
+}
+
+const KeyPairInterface *DiskWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return tryRetrieve(keyPair.keyPairId());
+}
+
+const KeyPairInterface *DiskWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *DiskWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  return lookup(_header.byPublicKeyIdOffset, publicKeyIdOf(publicKey, _idMode), &publicKey, nullptr);
+}
+
+const KeyPairInterface *DiskWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return lookup(_header.byPublicKeyIdOffset, publicKeyId, nullptr, nullptr);
+}
+
+const KeyPairInterface *DiskWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  return lookup(_header.byPrivateKeyIdOffset, privateKeyIdOf(privateKey, _idMode), nullptr, &privateKey);
+}
+
+const KeyPairInterface *DiskWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return lookup(_header.byPrivateKeyIdOffset, privateKeyId, nullptr, nullptr);
+}
+
+void DiskWallet::storeMany(const KeyPairBatch &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void DiskWallet::removeMany(const KeyPairIdVector &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void DiskWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  vector<Lookup> lookups(publicKeyIds.size());
+  for (size_t i = 0; i < publicKeyIds.size(); ++i) lookups[i] = Lookup{ publicKeyIds[i], nullptr, nullptr, 0, 0, nullptr };
+  {
+    lock_guard<mutex> lock(_lock);
+    lookupMany(_header.byPublicKeyIdOffset, lookups.data(), lookups.size());
+  }
+  results.resize(publicKeyIds.size());
+  for (size_t i = 0; i < lookups.size(); ++i) results[i] = lookups[i].result;
+}
+
+uint64_t DiskWallet::reads() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _reads;
+}
+
+void DiskWallet::release()
+{
+  lock_guard<mutex> lock(_lock);
+  _records.clear();
+  fill(_cached.begin(), _cached.end(), KeyPairIndex::npos);
+  secureZero(_pages, _batch * pageSize);
+}
+
+size_t DiskWallet::cachedRecords() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _records.bound();
+}
@@ -0,0 +1,438 @@
+#include "../include/CppWallet/DurableWallet.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/CppWallet/MappedWallet.hpp"
+#include "../include/CppWallet/Throttle.hpp"
+
+using namespace std;
+
+static const char segmentPrefix[] = "wallet-";
+static const char segmentSuffix[] = ".log";
+
+string DurableWallet::segmentName(Sequence firstSequence)
+{
+  char name[48];
+  snprintf(name, sizeof(name), "%s%020llu%s", segmentPrefix, static_cast<unsigned long long>(firstSequence), segmentSuffix);
+  return name;
+}
+
+DurableWallet::DurableWallet(const string &directory, KeyPairIdMode idMode, const WalletLogOptions &options, const WalletCompactionOptions &compaction)
+  : _directory(directory), _idMode(idMode), _logOptions(options), _compaction(compaction), _wallet(idMode)
+{
+  if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) throw WalletFileException(directory, strerror(errno));
+  open();
+  if (_compaction.background) _compactor = thread([this] { compactInBackground(); });
+}
+
+DurableWallet::~DurableWallet()
+{
+  {
+    lock_guard<mutex> lock(_stopLock);
+    _stopping = true;
+  }
+  _stop.notify_all();
+  if (_compactor.joinable()) _compactor.join();
+}
+
+//
+// Load the checkpoint, replay the segments in order, (skipping what the
+// checkpoint covers), and keep appending to the last one. Segments left
+// behind by a compaction that did not get to delete them are deleted.
+//
+
+void DurableWallet::open()
+{
+  string checkpointPath = pathOf(checkpointName);
+  if (::access(checkpointPath.c_str(), F_OK) == 0) {
+    MappedWallet checkpoint(checkpointPath);
+    if (checkpoint.idMode() != _idMode) throw WalletFileException(checkpointPath, "checkpoint of another KeyPairIdMode");
+    KeyPairIdVector page;
+    KeyPairBatch batch;
+    WalletStatusVector results;
+    for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+      cursor = checkpoint.listPage(cursor, 4096, page);
+      batch.clear();
+      for (KeyPairId keyPairId : page) batch.push_back(&checkpoint.retrieve(keyPairId));
+      _wallet.storeMany(batch, results);
+      if (count(results.begin(), results.end(), WalletStatus::Ok) != ptrdiff_t(results.size()))
+        throw WalletFileException(checkpointPath, "inconsistent checkpoint");
+    }
+    _checkpointSequence = _replayed = checkpoint.sequence();
+  }
+
+  vector<pair<Sequence, string>> segments;
+  if (DIR *directory = ::opendir(_directory.c_str())) {
+    size_t prefix = sizeof(segmentPrefix) - 1, suffix = sizeof(segmentSuffix) - 1;
+    while (const dirent *file = ::readdir(directory)) {
+      string name = file->d_name;
+      if (name.size() == segmentName(0).size() && name.compare(0, prefix, segmentPrefix) == 0
+          && name.compare(name.size() - suffix, suffix, segmentSuffix) == 0)
+        segments.emplace_back(strtoull(name.c_str() + prefix, nullptr, 10), name);
+    }
+    ::closedir(directory);
+  } else {
+    throw WalletFileException(_directory, strerror(errno));
+  }
+  sort(segments.begin(), segments.end());
+
+  auto replayer = [this](const WalletLogEntry &entry) { replay(entry); };
+  vector<string> stale;
+  for (size_t i = 0; i + 1 < segments.size(); ++i) {
+    string path = pathOf(segments[i].second);
+    if (WalletLog::read(path, _idMode, replayer) <= _checkpointSequence)
+      stale.push_back(path);
+    else
+      _sealed.push_back(path);
+  }
+  if (segments.empty())
+    _log = make_shared<WalletLog>(pathOf(segmentName(_replayed + 1)), _idMode, _logOptions, replayer, _replayed + 1);
+  else
+    _log = make_shared<WalletLog>(pathOf(segments.back().second), _idMode, _logOptions, replayer);
+  if (_log->lastSequence() != _replayed) throw WalletFileException(_log->path(), "log segments missing");
+  for (const string &path : stale) ::unlink(path.c_str());
+}
+
+//
+// The log only holds operations that succeeded, so one that fails on
+// replay means the log does not belong to what was replayed before it.
+//
+
+void DurableWallet::replay(const WalletLogEntry &entry)
+{
+  if (entry.sequence <= _checkpointSequence) return;
+  if (entry.sequence != _replayed + 1) throw WalletFileException(_directory, "log entry " + to_string(_replayed + 1) + " missing");
+  WalletStatus status = WalletStatus::Ok;
+  if (entry.op == WalletLogOp::Store) {
+    WalletFileKeyPair keyPair(entry.record);
+    KeyPairBatch batch{ &keyPair };
+    WalletStatusVector results;
+    _wallet.storeMany(batch, results);
+    status = results[0];
+  } else if (entry.op == WalletLogOp::Remove) {
+    WalletStatusVector results;
+    _wallet.removeMany(KeyPairIdVector{ entry.record.keyPairId }, results);
+    status = results[0];
+  } else {
+    status = WalletStatus::NotFound;
+  }
+  if (status != WalletStatus::Ok) throw WalletFileException(_directory, "inconsistent log entry " + to_string(entry.sequence));
+  _replayed = entry.sequence;
+}
+
+//
+// A commit that fails leaves operations in _wallet that may not be on
+// disk, and there is no taking them back out, (other threads may have
+// found them already), so the DurableWallet stops there: every call
+// after it throws, until the directory is opened again.
+//
+
+void DurableWallet::commit(WalletLog &log, Sequence sequence)
+{
+  try {
+    log.commit(sequence);
+  } catch (const WalletFileException &exception) {
+    lock_guard<mutex> lock(_writeLock);
+    fail(exception);
+    throw;
+  }
+}
+
+void DurableWallet::fail(const WalletFileException &exception)
+{
+  if (_failed.load(memory_order_relaxed)) return;
+  _failure = string("a log commit failed, (") + exception.what() + ")";
+  _failed.store(true, memory_order_release);
+}
+
+void DurableWallet::healthy() const
+{
+  if (_failed.load(memory_order_acquire)) throw WalletFileException(_directory, _failure);
+}
+
+//
+// Writers take the current segment under _writeLock and commit to it
+// outside, (compact() may have started the next one meanwhile, the
+// shared_ptr keeps the old one open until they are done).
+//
+
+KeyPairId DurableWallet::store(const KeyPairInterface &keyPair)
+{
+  shared_ptr<WalletLog> log;
+  Sequence sequence;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    healthy();
+    _wallet.store(keyPair);
+    log = _log;
+    sequence = log->appendStore(keyPair);
+  }
+  commit(*log, sequence);
+  return keyPair.keyPairId();
+}
+
+void DurableWallet::remove(const KeyPairId &keyPairId)
+{
+  shared_ptr<WalletLog> log;
+  Sequence sequence;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    healthy();
+    _wallet.remove(keyPairId);
+    log = _log;
+    sequence = log->appendRemove(keyPairId);
+  }
+  commit(*log, sequence);
+}
+
+void DurableWallet::storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results)
+{
+  shared_ptr<WalletLog> log;
+  Sequence sequence = 0;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    healthy();
+    _wallet.storeMany(keyPairs, results);
+    log = _log;
+    for (size_t i = 0; i < keyPairs.size(); ++i)
+      if (results[i] == WalletStatus::Ok) sequence = log->appendStore(*keyPairs[i]);
+  }
+  if (sequence != 0) commit(*log, sequence);
+}
+
+void DurableWallet::removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results)
+{
+  shared_ptr<WalletLog> log;
+  Sequence sequence = 0;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    healthy();
+    _wallet.removeMany(keyPairIds, results);
+    log = _log;
+    for (size_t i = 0; i < keyPairIds.size(); ++i)
+      if (results[i] == WalletStatus::Ok) sequence = log->appendRemove(keyPairIds[i]);
+  }
+  if (sequence != 0) commit(*log, sequence);
+}
+
+const WalletLog &DurableWallet::log() const
+{
+  lock_guard<mutex> lock(_writeLock);
+  return *_log;
+}
+
+//
+// Compaction works from the files alone: the KeyPairs of the previous
+// checkpoint that the sealed segments do not remove, plus those the
+// segments store and do not remove again, make the new checkpoint.
+// _sealed is only touched with _compactLock held.
+//
+
+bool DurableWallet::compact()
+{
+  lock_guard<mutex> compacting(_compactLock);
+  Sequence from = _checkpointSequence, upTo;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    healthy();
+    upTo = _log->lastSequence();
+    if (upTo == from) return false;
+    try {
+      _log->commit(upTo);
+    } catch (const WalletFileException &exception) {
+      fail(exception);
+      throw;
+    }
+    if (_log->firstSequence() <= upTo) {
+      auto next = make_shared<WalletLog>(pathOf(segmentName(upTo + 1)), _idMode, _logOptions, [](const WalletLogEntry &) {}, upTo + 1);
+      _sealed.push_back(_log->path());
+      _log = next;
+    }
+  }
+
+  Throttle throttle(_compaction.bytesPerSecond);
+  pmr::unordered_map<KeyPairId, WalletFileRecord> stored(lockedMemoryResource());// private keys
+  unordered_set<KeyPairId> removed;
+  for (const string &path : _sealed) {
+    if (stopping()) return false;
+    WalletLog::read(path, _idMode, [&](const WalletLogEntry &entry) {
+      throttle.pace(sizeof(entry));
+      if (entry.sequence <= from || entry.sequence > upTo) return;
+      if (entry.op == WalletLogOp::Store)
+        stored[entry.record.keyPairId] = entry.record;
+      else if (stored.erase(entry.record.keyPairId) == 0)
+        removed.insert(entry.record.keyPairId);
+    });
+  }
+
+  WalletFileWriter writer(_idMode, upTo);
+  writer.throttle(_compaction.bytesPerSecond);
+  if (from > 0) {
+    MappedWallet checkpoint(pathOf(checkpointName));
+    writer.reserve(checkpoint.size() + stored.size());
+    KeyPairIdVector page;
+    for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+      if (stopping()) return false;
+      cursor = checkpoint.listPage(cursor, 4096, page);
+      throttle.pace(page.size() * sizeof(WalletFileRecord));
+      for (KeyPairId keyPairId : page)
+        if (removed.count(keyPairId) == 0) writer.add(checkpoint.retrieve(keyPairId));
+    }
+  }
+  for (const auto &keyPair : stored) writer.addRecord(keyPair.second);
+  writer.write(pathOf(checkpointName));
+
+  _checkpointSequence = upTo;
+  for (const string &path : _sealed) ::unlink(path.c_str());
+  _sealed.clear();
+  ++_compactions;
+  return true;
+}
+
+bool DurableWallet::compactionDue() const
+{
+  Sequence logged;
+  {
+    lock_guard<mutex> lock(_writeLock);
+    logged = _log->lastSequence() - _checkpointSequence;
+  }
+  return logged > 0 && logged >= _compaction.minEntries && double(logged) >= _compaction.logRatio * double(_wallet.size());
+}
+
+bool DurableWallet::stopping()
+{
+  lock_guard<mutex> lock(_stopLock);
+  return _stopping;
+}
+
+void DurableWallet::compactInBackground()
+{
+  unique_lock<mutex> lock(_stopLock);
+  while (!_stop.wait_for(lock, _compaction.interval, [this] { return _stopping; })) {
+    lock.unlock();
+    try {
+      if (compactionDue()) compact();
+    } catch (const WalletFileException &) {
+      // the log is intact, tried again at the next interval
+    }
+    lock.lock();
+  }
+}
+
+//
+// Everything else is the EpochWallet's, (once healthy()).
+//
+
+const KeyPairInterface &DurableWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  healthy();
+  return _wallet.retrieve(keyPairId);
+}
+
+KeyPairIdList DurableWallet::list() const
+{
+  healthy();
+  return _wallet.list();
+}
+
+void DurableWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  healthy();
+  _wallet.listInto(keyPairIds);
+}
+
+KeyPairIdCursor DurableWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  healthy();
+  return _wallet.listPage(cursor, limit, keyPairIds);
+}
+
+const KeyPairInterface &DurableWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  healthy();
+  return _wallet.findByKeyPair(keyPair);
+}
+
+const KeyPairInterface &DurableWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  healthy();
+  return _wallet.findByKeyPairId(keyPairId);
+}
+
+const KeyPairInterface &DurableWallet::findByPublicKey(string_view publicKey) const
+{
+  healthy();
+  return _wallet.findByPublicKey(publicKey);
+}
+
+const KeyPairInterface &DurableWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  healthy();
+  return _wallet.findByPublicKeyId(publicKeyId);
+}
+
+const KeyPairInterface &DurableWallet::findByPrivateKey(string_view privateKey) const
+{
+  healthy();
+  return _wallet.findByPrivateKey(privateKey);
+}
+
+const KeyPairInterface &DurableWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  healthy();
+  return _wallet.findByPrivateKeyId(privateKeyId);
+}
+
+const KeyPairInterface *DurableWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  healthy();
+  return _wallet.tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  healthy();
+  return _wallet.tryFindByKeyPair(keyPair);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  healthy();
+  return _wallet.tryFindByKeyPairId(keyPairId);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  healthy();
+  return _wallet.tryFindByPublicKey(publicKey);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  healthy();
+  return _wallet.tryFindByPublicKeyId(publicKeyId);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  healthy();
+  return _wallet.tryFindByPrivateKey(privateKey);
+}
+
+const KeyPairInterface *DurableWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  healthy();
+  return _wallet.tryFindByPrivateKeyId(privateKeyId);
+}
+
+void DurableWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  healthy();
+  _wallet.findManyByPublicKeyId(publicKeyIds, results);
+}
@@ -0,0 +1,151 @@
+#include "../include/CppWallet/EntropyPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <pthread.h>
+#include <sys/random.h>
+#include "../include/CppWallet/LockedMemory.hpp"
+
+using namespace std;
+
+static constexpr size_t keyBytes = 32;
+static constexpr size_t blockBytes = 64;
+
+//
+// NOTE: the fork count, (bumped in the child by a pthread_atfork()
+// handler), is what an EntropyPool compares with the count it last
+// seeded at, a load of an atomic per fill().
+//
+
+static atomic<uint64_t> forkCount{ 0 };
+
+static uint64_t forks()
+{
+  static once_flag registered;
+  call_once(registered, [] { ::pthread_atfork(nullptr, nullptr, [] { forkCount.fetch_add(1); }); });
+  return forkCount.load(memory_order_relaxed);
+}
+
+static inline uint32_t rotate(uint32_t x, unsigned n) { return (x << n) | (x >> (32 - n)); }
+
+static inline uint32_t readLittleEndian(const uint8_t *p)
+{
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static inline void quarterRound(uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d)
+{
+  a += b, d = rotate(d ^ a, 16);
+  c += d, b = rotate(b ^ c, 12);
+  a += b, d = rotate(d ^ a, 8);
+  c += d, b = rotate(b ^ c, 7);
+}
+
+void chacha20Block(const uint8_t *key, uint32_t counter, const uint8_t *nonce, uint8_t *block)
+{
+  uint32_t state[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+  for (int i = 0; i < 8; ++i) state[4 + i] = readLittleEndian(key + 4 * i);
+  state[12] = counter;
+  for (int i = 0; i < 3; ++i) state[13 + i] = readLittleEndian(nonce + 4 * i);
+
+  uint32_t x[16];
+  memcpy(x, state, sizeof(x));
+  for (int round = 0; round < 10; ++round) {
+    quarterRound(x[0], x[4], x[8], x[12]);
+    quarterRound(x[1], x[5], x[9], x[13]);
+    quarterRound(x[2], x[6], x[10], x[14]);
+    quarterRound(x[3], x[7], x[11], x[15]);
+    quarterRound(x[0], x[5], x[10], x[15]);
+    quarterRound(x[1], x[6], x[11], x[12]);
+    quarterRound(x[2], x[7], x[8], x[13]);
+    quarterRound(x[3], x[4], x[9], x[14]);
+  }
+  for (int i = 0; i < 16; ++i) {
+    uint32_t word = x[i] + state[i];
+    for (int j = 0; j < 4; ++j) block[4 * i + j] = uint8_t(word >> (8 * j));
+  }
+  secureZero(x, sizeof(x));
+  secureZero(state, sizeof(state));
+}
+
+EntropyPool::EntropyPool(const EntropyPoolOptions &options) : _options(options) {}
+
+EntropyPool::~EntropyPool()
+{
+  secureZero(_key, sizeof(_key));
+  secureZero(_output, sizeof(_output));
+}
+
+//
+// The kernel's bytes are read at the reseed, onto the stack, and wiped
+// as soon as they are mixed in: a reseed every 1 MiB of output makes
+// one getrandom() of 32 bytes cheap, and none are left lying around.
+//
+
+void EntropyPool::reseed()
+{
+  uint64_t seen = forks();
+  uint8_t fresh[keyBytes];
+  uint8_t *bytes = fresh;
+  size_t size = keyBytes;
+  while (size > 0) {
+    ssize_t got = ::getrandom(bytes, size, 0);
+    if (got < 0) {
+      if (errno == EINTR) continue;
+      secureZero(fresh, keyBytes);
+      throw system_error(errno, generic_category(), "getrandom()");
+    }
+    bytes += got;
+    size -= size_t(got);
+  }
+  ++_stats.kernelReads;
+  for (size_t i = 0; i < keyBytes; ++i) _key[i] ^= fresh[i];
+  secureZero(fresh, keyBytes);
+
+  secureZero(_output, sizeof(_output));
+  _available = 0;
+  _sinceReseed = 0;
+  _reseededAt = chrono::steady_clock::now();
+  _forks = seen;
+  ++_stats.reseeds;
+}
+
+// 1 KiB of keystream, its first 32 bytes the next key
+void EntropyPool::refill()
+{
+  if (_sinceReseed >= _options.reseedBytes || chrono::steady_clock::now() - _reseededAt >= _options.reseedInterval)
+    reseed();
+  static constexpr uint8_t nonce[12] = {};
+  for (size_t block = 0; block < sizeof(_output) / blockBytes; ++block)
+    chacha20Block(_key, uint32_t(block), nonce, _output + block * blockBytes);
+  memcpy(_key, _output, keyBytes);
+  secureZero(_output, keyBytes);
+  _available = sizeof(_output) - keyBytes;
+}
+
+void EntropyPool::fill(void *bytes, size_t size)
+{
+  if (_forks != forks()) reseed();
+  auto *to = static_cast<uint8_t *>(bytes);
+  _stats.bytes += size;
+  while (size > 0) {
+    if (_available == 0) refill();
+    size_t take = min(size, _available);
+    uint8_t *from = _output + sizeof(_output) - _available;
+    memcpy(to, from, take);
+    secureZero(from, take);
+    _available -= take;
+    _sinceReseed += take;
+    to += take;
+    size -= take;
+  }
+}
+
+EntropyPool &threadEntropyPool()
+{
+  thread_local EntropyPool pool;
+  return pool;
+}
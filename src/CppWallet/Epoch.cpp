@@ -0,0 +1,106 @@
+#include "../include/CppWallet/Epoch.hpp"
+
+using namespace std;
+
+//
+// Objects retired in epoch e go into _limbo[e % 3]. Advancing the epoch
+// to e + 1 requires every active thread to have announced e, so nobody
+// can still be reading anything retired in e - 2 or before, which is
+// exactly what _limbo[(e + 1) % 3] holds.
+//
+
+static constexpr size_t retiredPerAdvance = 64;
+
+EpochDomain &EpochDomain::instance()
+{
+  static EpochDomain domain;
+  return domain;
+}
+
+EpochDomain::~EpochDomain()
+{
+  for (auto &limbo : _limbo)
+    for (const Retired &retired : limbo) retired.destroy(retired.object);
+  for (Participant *participant = _participants.load(); participant != nullptr;) {
+    Participant *next = participant->next;
+    delete participant;
+    participant = next;
+  }
+}
+
+EpochDomain::Participant &EpochDomain::join()
+{
+  //
+  // Participants are never freed, (a reclaiming thread may be looking at
+  // one), the slot of an exited thread is taken over by the next newcomer.
+  //
+  Participant *participant = _participants.load(memory_order_acquire);
+  for (; participant != nullptr; participant = participant->next) {
+    bool taken = false;
+    if (!participant->taken.load(memory_order_relaxed)
+        && participant->taken.compare_exchange_strong(taken, true, memory_order_acquire))
+      break;
+  }
+  if (participant == nullptr) {
+    participant = new Participant;
+    participant->next = _participants.load(memory_order_relaxed);
+    while (!_participants.compare_exchange_weak(participant->next, participant, memory_order_release)) {}
+  }
+
+  struct Leave
+  {
+    Participant *participant;
+    ~Leave()
+    {
+      participant->epoch.store(idle, memory_order_release);
+      participant->guards = 0;
+      participant->taken.store(false, memory_order_release);
+      _self = nullptr;
+    }
+  };
+  static thread_local Leave leave{ participant };
+  leave.participant = participant;
+  _self = participant;
+  return *participant;
+}
+
+void EpochDomain::quiesce()
+{
+  Participant &self = participant();
+  if (self.guards == 0) self.epoch.store(idle, memory_order_release);
+}
+
+bool EpochDomain::advance()
+{
+  atomic_thread_fence(memory_order_seq_cst);
+  uint64_t epoch = _epoch.load(memory_order_relaxed);
+  for (Participant *participant = _participants.load(memory_order_acquire); participant != nullptr; participant = participant->next) {
+    uint64_t announced = participant->epoch.load(memory_order_acquire);
+    if (announced != idle && announced != epoch) return false;
+  }
+  _epoch.store(epoch + 1, memory_order_release);
+  auto &limbo = _limbo[(epoch + 1) % 3];
+  for (const Retired &retired : limbo) retired.destroy(retired.object);
+  limbo.clear();
+  _retiredSinceAdvance = 0;
+  return true;
+}
+
+void EpochDomain::retire(void *object, void (*destroy)(void *))
+{
+  lock_guard<mutex> lock(_lock);
+  _limbo[_epoch.load(memory_order_relaxed) % 3].push_back(Retired{ object, destroy });
+  if (++_retiredSinceAdvance >= retiredPerAdvance) advance();
+}
+
+void EpochDomain::collect()
+{
+  lock_guard<mutex> lock(_lock);
+  for (int i = 0; i < 3 && advance(); ++i) {}
+}
+
+size_t EpochDomain::pending() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _limbo[0].size() + _limbo[1].size() + _limbo[2].size();
+}
@@ -0,0 +1,256 @@
+#include "../include/CppWallet/EpochWallet.hpp"
+
+using namespace std;
+
+EpochWallet::EpochWallet(KeyPairIdMode idMode, pmr::memory_resource *resource)
+  : _idMode(idMode), _resource(resource), _epochs(EpochDomain::instance()) {}
+
+EpochWallet::~EpochWallet()
+{
+  for (const Record *record : _slots)
+    if (record != nullptr) destroy(const_cast<Record *>(record));
+}
+
+//
+// A Record is wiped before it goes back to its resource, (it holds a
+// private key), whether the EpochWallet or the EpochDomain destroys it.
+//
+
+void EpochWallet::destroy(void *retired)
+{
+  auto record = static_cast<Record *>(retired);
+  pmr::memory_resource *resource = record->resource;
+  record->~Record();
+  secureZero(record, sizeof(Record));
+  resource->deallocate(record, sizeof(Record), alignof(Record));
+}
+
+const EpochWallet::Record *EpochWallet::findPublicKey(const KeyPairId &publicKeyId, string_view publicKey) const
+{
+  return _byPublicKeyId.findIf(publicKeyId, [&publicKey](const Record *record) {
+    return record->keyPair.publicKey().view() == publicKey;
+  });
+}
+
+const EpochWallet::Record *EpochWallet::findPrivateKey(const KeyPairId &privateKeyId, string_view privateKey) const
+{
+  return _byPrivateKeyId.findIf(privateKeyId, [&privateKey](const Record *record) {
+    return record->keyPair.privateKey().view() == privateKey;
+  });
+}
+
+//
+// Writers hold _lock. A Record is published by the keyPairId index
+// first, (so a reader may find it there a moment before it can be found
+// by key), and is retired rather than deleted once unlinked from all three.
+//
+
+WalletStatus EpochWallet::insert(const KeyPairInterface &keyPair, KeyPairId &clash)
+{
+  if (_byKeyPairId.find(keyPair.keyPairId()) != nullptr)
+    clash = keyPair.keyPairId();
+  else if (findPublicKey(keyPair.publicKeyId(), keyPair.publicKey()) != nullptr)
+    clash = keyPair.publicKeyId();
+  else if (findPrivateKey(keyPair.privateKeyId(), keyPair.privateKey()) != nullptr)
+    clash = keyPair.privateKeyId();
+  else {
+    Slot slot;
+    if (_freeSlots.empty()) {
+      slot = static_cast<Slot>(_slots.size());
+      _slots.push_back(nullptr);
+    } else {
+      slot = _freeSlots.back();
+      _freeSlots.pop_back();
+    }
+    void *memory = _resource->allocate(sizeof(Record), alignof(Record));
+    const Record *record = ::new (memory) Record(keyPair, slot, _resource);
+    _slots[slot] = record;
+    _byKeyPairId.insert(keyPair.keyPairId(), record);
+    _byPublicKeyId.insert(keyPair.publicKeyId(), record);
+    _byPrivateKeyId.insert(keyPair.privateKeyId(), record);
+    return WalletStatus::Ok;
+  }
+  return WalletStatus::AlreadyExists;
+}
+
+WalletStatus EpochWallet::erase(const KeyPairId &keyPairId)
+{
+  const Record *record = _byKeyPairId.find(keyPairId);
+  if (record == nullptr) return WalletStatus::NotFound;
+  _byKeyPairId.erase(keyPairId, record);
+  _byPublicKeyId.erase(record->keyPair.publicKeyId(), record);
+  _byPrivateKeyId.erase(record->keyPair.privateKeyId(), record);
+  _slots[record->slot] = nullptr;
+  _freeSlots.push_back(record->slot);
+  _epochs.retire(const_cast<Record *>(record), &EpochWallet::destroy);
+  return WalletStatus::Ok;
+}
+
+KeyPairId EpochWallet::store(const KeyPairInterface &keyPair)
+{
+  _epochs.enter();
+  lock_guard<mutex> lock(_lock);
+  KeyPairId clash;
+  if (insert(keyPair, clash) != WalletStatus::Ok) throw KeyPairAlreadyExistsException(clash);
+  return keyPair.keyPairId();
+}
+
+const KeyPairInterface &EpochWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void EpochWallet::remove(const KeyPairId &keyPairId)
+{
+  _epochs.enter();
+  lock_guard<mutex> lock(_lock);
+  if (erase(keyPairId) != WalletStatus::Ok) throw KeyPairNotFoundException(keyPairId);
+}
+
+KeyPairIdList EpochWallet::list() const
+{
+  lock_guard<mutex> lock(_lock);
+  KeyPairIdList keyPairIds;
+  for (const Record *record : _slots)
+    if (record != nullptr) keyPairIds.push_back(record->keyPair.keyPairId());
+  return keyPairIds;
+}
+
+void EpochWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  lock_guard<mutex> lock(_lock);
+  keyPairIds.reserve(keyPairIds.size() + _byKeyPairId.size());
+  for (const Record *record : _slots)
+    if (record != nullptr) keyPairIds.push_back(record->keyPair.keyPairId());
+}
+
+//
+// A cursor is a slot number, as with Wallet.
+//
+
+KeyPairIdCursor EpochWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  lock_guard<mutex> lock(_lock);
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  if (cursor >= _slots.size()) return noMorePages;
+  size_t slot = cursor;
+  for (; slot < _slots.size() && keyPairIds.size() < limit; ++slot)
+    if (_slots[slot] != nullptr) keyPairIds.push_back(_slots[slot]->keyPair.keyPairId());
+  return slot < _slots.size() ? slot : noMorePages;
+}
+
+const KeyPairInterface &EpochWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &EpochWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &EpochWallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &EpochWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &EpochWallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &EpochWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+const KeyPairInterface *EpochWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  _epochs.enter();
+  return keyPairOf(_byKeyPairId.find(keyPairId));
+}
+
+const KeyPairInterface *EpochWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return tryRetrieve(keyPair.keyPairId());
+}
+
+const KeyPairInterface *EpochWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *EpochWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  _epochs.enter();
+  return keyPairOf(findPublicKey(publicKeyIdOf(publicKey, _idMode), publicKey));
+}
+
+const KeyPairInterface *EpochWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  _epochs.enter();
+  return keyPairOf(_byPublicKeyId.find(publicKeyId));
+}
+
+const KeyPairInterface *EpochWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  _epochs.enter();
+  return keyPairOf(findPrivateKey(privateKeyIdOf(privateKey, _idMode), privateKey));
+}
+
+const KeyPairInterface *EpochWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  _epochs.enter();
+  return keyPairOf(_byPrivateKeyId.find(privateKeyId));
+}
+
+//
+// The batches take _lock once for the whole batch, (the lookups none),
+// and prefetch ahead as Wallet does.
+//
+
+static constexpr size_t prefetchDistance = 8;
+
+void EpochWallet::storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results)
+{
+  _epochs.enter();
+  lock_guard<mutex> lock(_lock);
+  results.resize(keyPairs.size());
+  KeyPairId clash;
+  for (size_t i = 0; i < keyPairs.size(); ++i) results[i] = insert(*keyPairs[i], clash);
+}
+
+void EpochWallet::removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results)
+{
+  _epochs.enter();
+  lock_guard<mutex> lock(_lock);
+  results.resize(keyPairIds.size());
+  for (size_t i = 0; i < keyPairIds.size(); ++i) {
+    if (i + prefetchDistance < keyPairIds.size()) _byKeyPairId.prefetch(keyPairIds[i + prefetchDistance]);
+    results[i] = erase(keyPairIds[i]);
+  }
+}
+
+void EpochWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  _epochs.enter();
+  results.resize(publicKeyIds.size());
+  for (size_t i = 0; i < publicKeyIds.size(); ++i) {
+    if (i + prefetchDistance < publicKeyIds.size()) _byPublicKeyId.prefetch(publicKeyIds[i + prefetchDistance]);
+    results[i] = keyPairOf(_byPublicKeyId.find(publicKeyIds[i]));
+  }
+}
+
+size_t EpochWallet::size() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _byKeyPairId.size();
+}
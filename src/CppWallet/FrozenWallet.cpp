@@ -0,0 +1,476 @@
+#include "../include/CppWallet/FrozenWallet.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/CppWallet/Crc32.hpp"
+
+using namespace std;
+
+static constexpr size_t sectionAlignment = 4096;
+
+static uint64_t aligned(uint64_t offset)
+{
+  return (offset + sectionAlignment - 1) & ~uint64_t(sectionAlignment - 1);
+}
+
+namespace {
+
+  struct TableBuild
+  {
+    uint64_t seed = 0;
+    vector<uint32_t> pilots;
+    vector<FrozenWalletEntry> entries;
+    vector<uint32_t> overflow;
+  };
+
+  //
+  // Sorting (id, record) pairs groups the records that share an id, (a
+  // CRC32 collision), each group gets one entry at the position of the id.
+  //
+
+  TableBuild buildTable(const pmr::vector<WalletFileRecord> &records, KeyPairId WalletFileRecord::*member)
+  {
+    vector<pair<KeyPairId, uint32_t>> ids(records.size());
+    for (size_t slot = 0; slot < records.size(); ++slot) ids[slot] = { records[slot].*member, uint32_t(slot) };
+    sort(ids.begin(), ids.end());
+    vector<KeyPairId> distinct;
+    for (size_t i = 0; i < ids.size(); ++i)
+      if (i == 0 || ids[i].first != ids[i - 1].first) distinct.push_back(ids[i].first);
+
+    TableBuild table;
+    table.pilots = PerfectHash::build(distinct, table.seed);
+    PerfectHash hash(table.seed, distinct.size(), table.pilots.size(), table.pilots.data());
+    table.entries.resize(distinct.size());
+    for (size_t i = 0, j; i < ids.size(); i = j) {
+      for (j = i + 1; j < ids.size() && ids[j].first == ids[i].first;) ++j;
+      FrozenWalletEntry &entry = table.entries[hash.position(ids[i].first)];
+      entry.id = ids[i].first;
+      entry.count = uint32_t(j - i);
+      if (j - i == 1) {
+        entry.slot = ids[i].second;
+      } else {
+        entry.slot = uint32_t(table.overflow.size());
+        for (size_t k = i; k < j; ++k) table.overflow.push_back(ids[k].second);
+      }
+    }
+    return table;
+  }
+
+}// namespace
+
+//
+// The records, (private keys), are only ever copied into
+// lockedMemoryResource(), which wipes them when given back.
+//
+
+FrozenWallet::FrozenWallet(const WalletInterface &wallet, KeyPairIdMode idMode) : _path("FrozenWallet")
+{
+  pmr::vector<WalletFileRecord> collected(lockedMemoryResource());
+  KeyPairIdVector page;
+  for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+    cursor = wallet.listPage(cursor, 4096, page);
+    for (KeyPairId keyPairId : page)
+      if (const KeyPairInterface *keyPair = wallet.tryRetrieve(keyPairId)) {
+        WalletFileRecord record{};
+        record.keyPairId = keyPair->keyPairId();
+        record.publicKeyId = keyPair->publicKeyId();
+        record.privateKeyId = keyPair->privateKeyId();
+        record.publicKey = keyPair->publicKey();
+        record.privateKey = keyPair->privateKey();
+        collected.push_back(record);
+        secureZero(&record, sizeof(record));
+      }
+  }
+  size_t count = collected.size();
+  if (count >= PerfectHash::direct) throw WalletFileException(_path, "too many KeyPairs");
+
+  // the records go in keyPairId position order, retrieve() needs no table
+  vector<KeyPairId> keyPairIds(count);
+  for (size_t i = 0; i < count; ++i) keyPairIds[i] = collected[i].keyPairId;
+  uint64_t seed;
+  vector<uint32_t> pilots = PerfectHash::build(keyPairIds, seed);
+  PerfectHash byKeyPairId(seed, count, pilots.size(), pilots.data());
+  pmr::vector<WalletFileRecord> records(count, lockedMemoryResource());
+  for (const auto &record : collected) records[byKeyPairId.position(record.keyPairId)] = record;
+  collected.clear();
+  collected.shrink_to_fit();
+  TableBuild byPublicKeyId = buildTable(records, &WalletFileRecord::publicKeyId);
+  TableBuild byPrivateKeyId = buildTable(records, &WalletFileRecord::privateKeyId);
+
+  FrozenWalletHeader header{};
+  memcpy(header.magic, FrozenWalletHeader::expectedMagic, sizeof(header.magic));
+  header.version = FrozenWalletHeader::currentVersion;
+  header.byteOrder = WalletFileHeader::littleEndian;
+  header.idMode = static_cast<uint32_t>(idMode);
+  header.count = count;
+  header.recordsOffset = aligned(sizeof(FrozenWalletHeader));
+  uint64_t end = header.recordsOffset + count * sizeof(WalletFileRecord);
+  header.byKeyPairId = FrozenWalletHash{ seed, count, pilots.size(), aligned(end) };
+  end = header.byKeyPairId.pilotsOffset + pilots.size() * sizeof(uint32_t);
+  auto place = [&end](FrozenWalletTable &table, const TableBuild &build) {
+    table.hash = FrozenWalletHash{ build.seed, build.entries.size(), build.pilots.size(), aligned(end) };
+    table.entriesOffset = aligned(table.hash.pilotsOffset + build.pilots.size() * sizeof(uint32_t));
+    table.overflowOffset = aligned(table.entriesOffset + build.entries.size() * sizeof(FrozenWalletEntry));
+    table.overflowCount = build.overflow.size();
+    end = table.overflowOffset + build.overflow.size() * sizeof(uint32_t);
+  };
+  place(header.byPublicKeyId, byPublicKeyId);
+  place(header.byPrivateKeyId, byPrivateKeyId);
+  header.fileSize = end;
+
+  _image.assign((end + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+  char *image = reinterpret_cast<char *>(_image.data());
+  auto put = [image](uint64_t offset, const auto &section) {
+    if (!section.empty()) memcpy(image + offset, section.data(), section.size() * sizeof(section[0]));
+  };
+  put(header.recordsOffset, records);
+  put(header.byKeyPairId.pilotsOffset, pilots);
+  auto copy = [&put](const FrozenWalletTable &table, const TableBuild &build) {
+    put(table.hash.pilotsOffset, build.pilots);
+    put(table.entriesOffset, build.entries);
+    put(table.overflowOffset, build.overflow);
+  };
+  copy(header.byPublicKeyId, byPublicKeyId);
+  copy(header.byPrivateKeyId, byPrivateKeyId);
+  header.bodyChecksum = crc32(image + sizeof(header), end - sizeof(header));
+  header.headerChecksum = crc32(&header, offsetof(FrozenWalletHeader, headerChecksum));
+  memcpy(image, &header, sizeof(header));
+  attach();
+}
+
+//
+// A damaged file must not crash a lookup: every section has to be
+// inside the file, (and aligned), before any pointer is made into it,
+// and a lookup skips records whose key sizes do not fit their keys.
+//
+
+static string checkFrozenWalletHeader(const FrozenWalletHeader &header, uint64_t fileSize)
+{
+  if (fileSize < sizeof(FrozenWalletHeader) || memcmp(header.magic, FrozenWalletHeader::expectedMagic, sizeof(header.magic)) != 0) return "not a frozen Wallet file";
+  if (header.version != FrozenWalletHeader::currentVersion) return "unsupported frozen Wallet file version " + to_string(header.version);
+  if (header.byteOrder != WalletFileHeader::littleEndian) return "frozen Wallet file of another byte order";
+  if (header.headerChecksum != crc32(&header, offsetof(FrozenWalletHeader, headerChecksum))) return "damaged frozen Wallet file header";
+  if (header.fileSize != fileSize) return "truncated frozen Wallet file";
+
+  auto inside = [fileSize](uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % sizeof(uint64_t) == 0 && offset <= fileSize && count <= (fileSize - offset) / size;
+  };
+  auto validHash = [&inside](const FrozenWalletHash &hash) {
+    return hash.buckets == PerfectHash::bucketsFor(hash.keys) && inside(hash.pilotsOffset, hash.buckets, sizeof(uint32_t));
+  };
+  auto validTable = [&](const FrozenWalletTable &table) {
+    return validHash(table.hash)
+           && table.hash.keys <= header.count
+           && table.overflowCount <= header.count
+           && inside(table.entriesOffset, table.hash.keys, sizeof(FrozenWalletEntry))
+           && inside(table.overflowOffset, table.overflowCount, sizeof(uint32_t));
+  };
+  bool valid = header.count < PerfectHash::direct
+               && header.idMode <= static_cast<uint32_t>(KeyPairIdMode::Hash64)
+               && inside(header.recordsOffset, header.count, sizeof(WalletFileRecord))
+               && header.byKeyPairId.keys == header.count
+               && validHash(header.byKeyPairId)
+               && validTable(header.byPublicKeyId)
+               && validTable(header.byPrivateKeyId);
+  return valid ? string() : "inconsistent frozen Wallet file header";
+}
+
+FrozenWallet::FrozenWallet(const string &path) : _path(path)
+{
+  _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (_fd < 0) fail(strerror(errno));
+  struct stat status;
+  if (::fstat(_fd, &status) != 0) fail(strerror(errno));
+  if (size_t(status.st_size) < sizeof(FrozenWalletHeader)) fail("not a frozen Wallet file");
+  _mapSize = size_t(status.st_size);
+  void *map = ::mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) fail(strerror(errno));
+  _map = static_cast<const char *>(map);
+
+  string problem = checkFrozenWalletHeader(*reinterpret_cast<const FrozenWalletHeader *>(_map), _mapSize);
+  if (!problem.empty()) fail(problem);
+  ::madvise(map, _mapSize, MADV_RANDOM);
+  attach();
+}
+
+FrozenWallet::~FrozenWallet()
+{
+  close();
+}
+
+void FrozenWallet::attach()
+{
+  const char *image = base();
+  const auto &header = *reinterpret_cast<const FrozenWalletHeader *>(image);
+  auto pilots = [image](const FrozenWalletHash &hash) {
+    return PerfectHash(hash.seed, hash.keys, hash.buckets, reinterpret_cast<const uint32_t *>(image + hash.pilotsOffset));
+  };
+  _header = &header;
+  _records = reinterpret_cast<const WalletFileRecord *>(image + header.recordsOffset);
+  _byKeyPairId = pilots(header.byKeyPairId);
+  _byPublicKeyId = pilots(header.byPublicKeyId.hash);
+  _byPrivateKeyId = pilots(header.byPrivateKeyId.hash);
+  _publicKeyEntries = reinterpret_cast<const FrozenWalletEntry *>(image + header.byPublicKeyId.entriesOffset);
+  _privateKeyEntries = reinterpret_cast<const FrozenWalletEntry *>(image + header.byPrivateKeyId.entriesOffset);
+  _publicKeyOverflow = reinterpret_cast<const uint32_t *>(image + header.byPublicKeyId.overflowOffset);
+  _privateKeyOverflow = reinterpret_cast<const uint32_t *>(image + header.byPrivateKeyId.overflowOffset);
+  _idMode = static_cast<KeyPairIdMode>(header.idMode);
+
+  size_t count = header.count == 0 ? 1 : header.count;
+  _views = static_cast<WalletFileKeyPair *>(calloc(count, sizeof(WalletFileKeyPair)));
+  _made = static_cast<atomic<uint8_t> *>(calloc(count, sizeof(atomic<uint8_t>)));
+  if (_views == nullptr || _made == nullptr) {
+    close();
+    throw bad_alloc();
+  }
+}
+
+void FrozenWallet::close()
+{
+  free(_views);// a WalletFileKeyPair owns nothing, there is nothing to destroy
+  free(_made);
+  _views = nullptr;
+  _made = nullptr;
+  if (_map != nullptr) ::munmap(const_cast<char *>(_map), _mapSize);
+  if (_fd >= 0) ::close(_fd);
+  _map = nullptr;
+  _fd = -1;
+}
+
+void FrozenWallet::fail(const string &reason)
+{
+  close();
+  throw WalletFileException(_path, reason);
+}
+
+const KeyPairInterface *FrozenWallet::view(Slot slot) const
+{
+  atomic<uint8_t> &made = _made[slot];
+  uint8_t state = made.load(memory_order_acquire);
+  if (state != 2) {
+    if (state == 0 && made.compare_exchange_strong(state, 1, memory_order_acquire)) {
+      new (&_views[slot]) WalletFileKeyPair(_records[slot]);
+      made.store(2, memory_order_release);
+    } else
+      while (made.load(memory_order_acquire) != 2) {}
+  }
+  return &_views[slot];
+}
+
+//
+// One entry per distinct id: the id stored there tells a miss, (a
+// PerfectHash positions any id), from a hit. Slots are checked, as in
+// MappedWallet, so that a damaged file cannot crash a lookup.
+//
+
+template<typename Predicate>
+const KeyPairInterface *FrozenWallet::lookup(const PerfectHash &hash, const FrozenWalletEntry *entries, const FrozenWalletTable &table,
+  const uint32_t *overflow, const KeyPairId &id, Predicate &&matches) const
+{
+  if (hash.keys() == 0) return nullptr;
+  uint64_t position = hash.position(id);
+  if (position >= hash.keys()) return nullptr;
+  const FrozenWalletEntry &entry = entries[position];
+  if (entry.id != id) return nullptr;
+  auto usable = [this, &matches](Slot slot) {
+    return slot < _header->count && checkWalletFileRecord(_records[slot]) && matches(_records[slot]);
+  };
+  if (entry.count == 1) return usable(entry.slot) ? view(entry.slot) : nullptr;
+  if (entry.slot > table.overflowCount || entry.count > table.overflowCount - entry.slot) return nullptr;
+  for (uint32_t i = 0; i < entry.count; ++i) {
+    Slot slot = overflow[entry.slot + i];
+    if (usable(slot)) return view(slot);
+  }
+  return nullptr;
+}
+
+KeyPairId FrozenWallet::store(const KeyPairInterface &)
+{
+  throw WalletReadOnlyException();
+}
+
+const KeyPairInterface &FrozenWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void FrozenWallet::remove(const KeyPairId &)
+{
+  throw WalletReadOnlyException();
+}
+
+KeyPairIdList FrozenWallet::list() const
+{
+  KeyPairIdList keyPairIds;
+  for (size_t slot = 0; slot < _header->count; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+  return keyPairIds;
+}
+
+void FrozenWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  keyPairIds.reserve(keyPairIds.size() + _header->count);
+  for (size_t slot = 0; slot < _header->count; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+}
+
+//
+// A cursor is a record number, (a FrozenWallet never changes).
+//
+
+KeyPairIdCursor FrozenWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  if (cursor >= _header->count) return noMorePages;
+  size_t end = size_t(min<uint64_t>(_header->count, cursor + limit));
+  for (size_t slot = cursor; slot < end; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+  return end < _header->count ? end : noMorePages;
+}
+
+const KeyPairInterface &FrozenWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &FrozenWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &FrozenWallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &FrozenWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &FrozenWallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &FrozenWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+static bool any(const WalletFileRecord &)
+{
+  return true;
+}
+
+const KeyPairInterface *FrozenWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  if (_header->count == 0) return nullptr;
+  uint64_t slot = _byKeyPairId.position(keyPairId);
+  return slot < _header->count && _records[slot].keyPairId == keyPairId && checkWalletFileRecord(_records[slot]) ? view(Slot(slot)) : nullptr;
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return tryRetrieve(keyPair.keyPairId());
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  return lookup(_byPublicKeyId, _publicKeyEntries, _header->byPublicKeyId, _publicKeyOverflow, publicKeyIdOf(publicKey, _idMode),
+    [&publicKey](const WalletFileRecord &record) { return record.publicKey.view() == publicKey; });
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return lookup(_byPublicKeyId, _publicKeyEntries, _header->byPublicKeyId, _publicKeyOverflow, publicKeyId, any);
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  return lookup(_byPrivateKeyId, _privateKeyEntries, _header->byPrivateKeyId, _privateKeyOverflow, privateKeyIdOf(privateKey, _idMode),
+    [&privateKey](const WalletFileRecord &record) { return record.privateKey.view() == privateKey; });
+}
+
+const KeyPairInterface *FrozenWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return lookup(_byPrivateKeyId, _privateKeyEntries, _header->byPrivateKeyId, _privateKeyOverflow, privateKeyId, any);
+}
+
+void FrozenWallet::storeMany(const KeyPairBatch &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void FrozenWallet::removeMany(const KeyPairIdVector &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void FrozenWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  static constexpr size_t prefetchDistance = 8;
+  results.resize(publicKeyIds.size());
+  for (size_t i = 0; i < publicKeyIds.size(); ++i) {
+    if (i + prefetchDistance < publicKeyIds.size() && _byPublicKeyId.keys() > 0) _byPublicKeyId.prefetch(publicKeyIds[i + prefetchDistance]);
+    results[i] = tryFindByPublicKeyId(publicKeyIds[i]);
+  }
+}
+
+void FrozenWallet::write(const string &path) const
+{
+  string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) throw WalletFileException(temporary, strerror(errno));
+  const char *bytes = base();
+  size_t size = _header->fileSize;
+  int error = 0;
+  while (size > 0 && error == 0) {
+    ssize_t written = ::write(fd, bytes, size);
+    if (written < 0 && errno == EINTR) continue;
+    if (written < 0) {
+      error = errno;
+      break;
+    }
+    bytes += written;
+    size -= size_t(written);
+  }
+  if (error == 0 && ::fsync(fd) != 0) error = errno;
+  if (::close(fd) != 0 && error == 0) error = errno;
+  if (error != 0) {
+    ::unlink(temporary.c_str());
+    throw WalletFileException(temporary, strerror(error));
+  }
+  if (::rename(temporary.c_str(), path.c_str()) != 0) {
+    int error = errno;
+    ::unlink(temporary.c_str());
+    throw WalletFileException(path, strerror(error));
+  }
+
+  // make the rename itself durable
+  string directory = path.find('/') == string::npos ? "." : path.substr(0, path.rfind('/') + 1);
+  int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directoryFd >= 0) {
+    ::fsync(directoryFd);
+    ::close(directoryFd);
+  }
+}
+
+bool FrozenWallet::verify() const
+{
+  size_t header = sizeof(FrozenWalletHeader);
+  return crc32(base() + header, _header->fileSize - header) == _header->bodyChecksum;
+}
@@ -0,0 +1,85 @@
+#include "../include/CppWallet/Hash64.hpp"
+#include <cstring>
+
+using namespace std;
+
+static constexpr uint64_t secret0 = 0xa0761d6478bd642fULL;
+static constexpr uint64_t secret1 = 0xe7037ed1a0b428dbULL;
+static constexpr uint64_t secret2 = 0x8ebc6af09c88c6e3ULL;
+static constexpr uint64_t secret3 = 0x589965cc75374cc3ULL;
+
+static inline uint64_t read64(const uint8_t *p)
+{
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint64_t read32(const uint8_t *p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// 1 to 3 bytes, (first, middle and last byte)
+static inline uint64_t read3(const uint8_t *p, size_t length)
+{
+  return (uint64_t(p[0]) << 16) | (uint64_t(p[length >> 1]) << 8) | p[length - 1];
+}
+
+static inline void multiply(uint64_t &a, uint64_t &b)
+{
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  a = static_cast<uint64_t>(product);
+  b = static_cast<uint64_t>(product >> 64);
+}
+
+static inline uint64_t mix(uint64_t a, uint64_t b)
+{
+  multiply(a, b);
+  return a ^ b;
+}
+
+uint64_t hash64(const void *data, size_t length, uint64_t seed)
+{
+  const auto *p = static_cast<const uint8_t *>(data);
+  seed ^= mix(seed ^ secret0, secret1);
+  uint64_t a, b;
+  if (length <= 16) {
+    if (length >= 4) {
+      size_t step = (length >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + step);
+      b = (read32(p + length - 4) << 32) | read32(p + length - 4 - step);
+    } else if (length > 0) {
+      a = read3(p, length);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t remaining = length;
+    if (remaining > 48) {
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+        seed1 = mix(read64(p + 16) ^ secret2, read64(p + 24) ^ seed1);
+        seed2 = mix(read64(p + 32) ^ secret3, read64(p + 40) ^ seed2);
+        p += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (remaining > 16) {
+      seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+    a = read64(p + remaining - 16);
+    b = read64(p + remaining - 8);
+  }
+  a ^= secret1;
+  b ^= seed;
+  multiply(a, b);
+  return mix(a ^ secret0 ^ length, b ^ secret1);
+}
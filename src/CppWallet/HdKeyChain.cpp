@@ -0,0 +1,212 @@
+#include "../include/CppWallet/HdKeyChain.hpp"
+#include <cstring>
+#include <stdexcept>
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "../include/CppWallet/Sha512.hpp"
+
+using namespace std;
+
+static constexpr char masterKeyName[] = "Bitcoin seed";
+
+HdPath hdPath(string_view text)
+{
+  if (text.empty() || (text[0] != 'm' && text[0] != 'M'))
+    throw invalid_argument("an HD path starts with m: " + string(text));
+  HdPath path;
+  size_t at = 1;
+  while (at < text.size()) {
+    if (text[at] != '/' || at + 1 == text.size()) throw invalid_argument("not an HD path: " + string(text));
+    uint64_t index = 0;
+    size_t digits = 0;
+    for (++at; at < text.size() && text[at] >= '0' && text[at] <= '9'; ++at, ++digits) {
+      index = index * 10 + uint64_t(text[at] - '0');
+      if (index >= hdHardened) throw invalid_argument("HD path index out of range: " + string(text));
+    }
+    if (digits == 0) throw invalid_argument("not an HD path: " + string(text));
+    if (at < text.size() && (text[at] == '\'' || text[at] == 'h' || text[at] == 'H')) {
+      index |= hdHardened;
+      ++at;
+    }
+    path.push_back(uint32_t(index));
+  }
+  return path;
+}
+
+string hdPathText(const HdPath &path)
+{
+  string text = "m";
+  for (uint32_t index : path) {
+    text += "/" + to_string(index & ~hdHardened);
+    if (index & hdHardened) text += "'";
+  }
+  return text;
+}
+
+bool hdMasterKey(const void *seed, size_t size, HdExtendedKey &master)
+{
+  Sha512Digest digest = hmacSha512(masterKeyName, sizeof(masterKeyName) - 1, seed, size);
+  bool valid = secp256k1PublicKey(digest.data(), master.publicKey);
+  if (valid) {
+    memcpy(master.privateKey, digest.data(), 32);
+    memcpy(master.chainCode, digest.data() + 32, 32);
+    master.depth = 0;
+    master.childNumber = 0;
+  }
+  secureZero(digest.data(), digest.size());
+  return valid;
+}
+
+bool hdChildKey(const HdExtendedKey &parent, uint32_t index, HdExtendedKey &child)
+{
+  uint8_t data[37];
+  if (index & hdHardened) {
+    data[0] = 0;
+    memcpy(data + 1, parent.privateKey, 32);
+  } else {
+    memcpy(data, parent.publicKey, 33);
+  }
+  for (int i = 0; i < 4; ++i) data[33 + i] = uint8_t(index >> (24 - 8 * i));
+  Sha512Digest digest = hmacSha512(parent.chainCode, sizeof(parent.chainCode), data, sizeof(data));
+  secureZero(data, sizeof(data));
+
+  uint8_t privateKey[32];
+  bool valid = secp256k1AddPrivateKeys(parent.privateKey, digest.data(), privateKey);
+  if (valid) {
+    memcpy(child.privateKey, privateKey, 32);
+    memcpy(child.chainCode, digest.data() + 32, 32);
+    secp256k1PublicKey(child.privateKey, child.publicKey);
+    child.depth = uint8_t(parent.depth + 1);
+    child.childNumber = index;
+  }
+  secureZero(privateKey, sizeof(privateKey));
+  secureZero(digest.data(), digest.size());
+  return valid;
+}
+
+HdKeyChain::HdKeyChain(string_view seed, const HdKeyChainOptions &options, pmr::memory_resource *resource)
+  : _options(options), _nodes(resource)
+{
+  if (seed.size() < 16 || seed.size() > 64) throw invalid_argument("an HD seed is 16 to 64 bytes");
+  HdExtendedKey master;
+  bool valid = hdMasterKey(seed.data(), seed.size(), master);
+  if (valid) _nodes.emplace(HdPath(), master);
+  secureZero(&master, sizeof(master));
+  if (!valid) throw invalid_argument("the HD seed has no valid master key");
+  _stats.nodes = _nodes.size();
+}
+
+HdKeyChain::~HdKeyChain()
+{
+  for (auto &node : _nodes) secureZero(&node.second, sizeof(node.second));
+}
+
+void HdKeyChain::clear()
+{
+  for (auto node = _nodes.begin(); node != _nodes.end();) {
+    if (node->first.empty()) {
+      ++node;
+      continue;
+    }
+    secureZero(&node->second, sizeof(node->second));
+    node = _nodes.erase(node);
+  }
+  _stats.nodes = _nodes.size();
+}
+
+// the extended key of the first length indexes of path, from the longest
+// prefix kept, (the master at least), each step kept
+const HdExtendedKey &HdKeyChain::cached(const HdPath &path, size_t length)
+{
+  HdPath prefix(path.begin(), path.begin() + length);
+  auto found = _nodes.find(prefix);
+  while (found == _nodes.end()) {
+    prefix.pop_back();
+    found = _nodes.find(prefix);
+  }
+  if (prefix.size() == length) return found->second;
+  if (_nodes.size() - 1 + (length - prefix.size()) > _options.maxNodes) {
+    clear();
+    prefix.clear();
+    found = _nodes.find(prefix);
+  }
+
+  const HdExtendedKey *key = &found->second;
+  HdExtendedKey child;
+  while (prefix.size() < length) {
+    uint32_t index = path[prefix.size()];
+    ++_stats.childSteps;
+    prefix.push_back(index);
+    if (!hdChildKey(*key, index, child)) throw invalid_argument(hdPathText(prefix) + " has no valid key, (use the next index)");
+    key = &_nodes.emplace(prefix, child).first->second;
+  }
+  secureZero(&child, sizeof(child));
+  _stats.nodes = _nodes.size();
+  return *key;
+}
+
+KeyPair HdKeyChain::keyPairOf(const HdExtendedKey &key) const
+{
+  KeyPairPrivateKey privateKey(string_view(reinterpret_cast<const char *>(key.privateKey), sizeof(key.privateKey)));
+  KeyPair keyPair(string_view(reinterpret_cast<const char *>(key.publicKey), sizeof(key.publicKey)), privateKey, _options.idMode);
+  secureZero(&privateKey, sizeof(privateKey));
+  return keyPair;
+}
+
+const HdExtendedKey &HdKeyChain::node(const HdPath &path)
+{
+  return cached(path, path.size());
+}
+
+KeyPair HdKeyChain::keyPair(const HdPath &path)
+{
+  if (path.empty()) return keyPairOf(cached(path, 0));
+  const HdExtendedKey &parent = cached(path, path.size() - 1);
+  HdExtendedKey child;
+  ++_stats.childSteps;
+  if (!hdChildKey(parent, path.back(), child)) throw invalid_argument(hdPathText(path) + " has no valid key, (use the next index)");
+  KeyPair keyPair = keyPairOf(child);
+  secureZero(&child, sizeof(child));
+  return keyPair;
+}
+
+template<typename KeyPairs>
+void HdKeyChain::deriveInto(const HdPath &parent, uint32_t first, size_t count, KeyPairs &keyPairs)
+{
+  const HdExtendedKey &key = cached(parent, parent.size());
+  keyPairs.reserve(keyPairs.size() + count);
+  HdExtendedKey child;
+  for (uint64_t index = first; index < uint64_t(first) + count && index <= UINT32_MAX; ++index) {
+    ++_stats.childSteps;
+    if (hdChildKey(key, uint32_t(index), child)) {
+      KeyPair keyPair = keyPairOf(child);
+      keyPairs.push_back(keyPair);
+      keyPair.wipe();
+    }
+  }
+  secureZero(&child, sizeof(child));
+}
+
+void HdKeyChain::derive(const HdPath &parent, uint32_t first, size_t count, vector<KeyPair> &keyPairs)
+{
+  deriveInto(parent, first, count, keyPairs);
+}
+
+void HdKeyChain::derive(const HdPath &parent, uint32_t first, size_t count, pmr::vector<KeyPair> &keyPairs)
+{
+  deriveInto(parent, first, count, keyPairs);
+}
+
+size_t HdKeyChain::storeInto(WalletInterface &wallet, const HdPath &parent, uint32_t first, size_t count)
+{
+  pmr::vector<KeyPair> keyPairs(_nodes.get_allocator().resource());
+  derive(parent, first, count, keyPairs);
+  KeyPairBatch batch;
+  batch.reserve(keyPairs.size());
+  for (const auto &keyPair : keyPairs) batch.push_back(&keyPair);
+  WalletStatusVector results;
+  wallet.storeMany(batch, results);
+  size_t stored = 0;
+  for (auto status : results) stored += status == WalletStatus::Ok;
+  for (auto &keyPair : keyPairs) keyPair.wipe();
+  return stored;
+}
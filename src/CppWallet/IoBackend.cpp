@@ -0,0 +1,303 @@
+#include "../include/CppWallet/IoBackend.hpp"
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CPPWALLET_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+const char *nameOf(IoBackendKind kind)
+{
+  return kind == IoBackendKind::Uring ? "io_uring" : "pread";
+}
+
+//
+// A whole request the blocking way, (what the Pread backend does for
+// every request and the Uring backend for those it cannot submit).
+//
+
+static int64_t transfer(IoRequest &request, bool writing)
+{
+  auto bytes = static_cast<char *>(request.buffer);
+  size_t done = 0;
+  while (done < request.size) {
+    ssize_t moved = writing ? ::pwrite(request.fd, bytes + done, request.size - done, off_t(request.offset + done))
+                            : ::pread(request.fd, bytes + done, request.size - done, off_t(request.offset + done));
+    if (moved < 0 && errno == EINTR) continue;
+    if (moved < 0) return -errno;
+    if (moved == 0) break;
+    done += size_t(moved);
+  }
+  return int64_t(done);
+}
+
+static int firstError(const IoRequest *requests, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    if (requests[i].result < 0) return int(requests[i].result);
+    if (size_t(requests[i].result) != requests[i].size) return -EIO;
+  }
+  return 0;
+}
+
+namespace {
+
+  class PreadIoBackend implements IoBackendInterface
+  {
+    unsigned _depth;
+
+  public:
+    explicit PreadIoBackend(unsigned depth) : _depth(depth) {}
+
+    virtual void read(IoRequest *requests, size_t count) override
+    {
+      for (size_t i = 0; i < count; ++i) requests[i].result = transfer(requests[i], false);
+    }
+
+    virtual int write(IoRequest *requests, size_t count, bool sync) override
+    {
+      for (size_t i = 0; i < count; ++i) requests[i].result = transfer(requests[i], true);
+      if (int error = firstError(requests, count)) return error;
+      if (sync && count > 0 && ::fdatasync(requests[0].fd) != 0) return -errno;
+      return 0;
+    }
+
+    virtual IoBackendKind kind() const override { return IoBackendKind::Pread; }
+    virtual unsigned queueDepth() const override { return _depth; }
+  };
+
+#ifdef CPPWALLET_IO_URING
+
+  /**
+   * io_uring through the raw system calls, (no liburing needed): one
+   * submission queue entry per request, up to queueDepth in flight,
+   * everything queued meanwhile submitted with the same io_uring_enter()
+   * that waits for the next completion.
+   */
+  class UringIoBackend implements IoBackendInterface
+  {
+    int _ring = -1;
+    unsigned _depth = 0;
+    void *_sqMap = MAP_FAILED;
+    void *_cqMap = MAP_FAILED;
+    void *_sqeMap = MAP_FAILED;
+    size_t _sqMapSize = 0, _cqMapSize = 0, _sqeMapSize = 0;
+
+    unsigned *_sqTail = nullptr, *_sqMask = nullptr, *_sqArray = nullptr;
+    io_uring_sqe *_sqes = nullptr;
+    unsigned *_cqHead = nullptr, *_cqTail = nullptr, *_cqMask = nullptr;
+    io_uring_cqe *_cqes = nullptr;
+    IoCompletionFilter _filter;
+
+    template<typename T>
+    static T *at(void *map, uint32_t offset)
+    {
+      return reinterpret_cast<T *>(static_cast<char *>(map) + offset);
+    }
+
+    int run(IoRequest *requests, size_t count, uint8_t opcode, int syncFd);
+
+    bool open(unsigned depth)
+    {
+      io_uring_params params{};
+      _ring = int(::syscall(__NR_io_uring_setup, depth, &params));
+      if (_ring < 0) return false;
+      // IORING_OP_READ and IORING_OP_WRITE came with IORING_FEAT_RW_CUR_POS, (5.6)
+      if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) return false;
+      _depth = min(depth, params.sq_entries);
+      _sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      _cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if (single) _sqMapSize = _cqMapSize = max(_sqMapSize, _cqMapSize);
+      _sqMap = ::mmap(nullptr, _sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQ_RING);
+      if (_sqMap == MAP_FAILED) return false;
+      _cqMap = single ? _sqMap : ::mmap(nullptr, _cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_CQ_RING);
+      if (_cqMap == MAP_FAILED) return false;
+      _sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+      _sqeMap = ::mmap(nullptr, _sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES);
+      if (_sqeMap == MAP_FAILED) return false;
+
+      _sqTail = at<unsigned>(_sqMap, params.sq_off.tail);
+      _sqMask = at<unsigned>(_sqMap, params.sq_off.ring_mask);
+      _sqArray = at<unsigned>(_sqMap, params.sq_off.array);
+      _sqes = static_cast<io_uring_sqe *>(_sqeMap);
+      _cqHead = at<unsigned>(_cqMap, params.cq_off.head);
+      _cqTail = at<unsigned>(_cqMap, params.cq_off.tail);
+      _cqMask = at<unsigned>(_cqMap, params.cq_off.ring_mask);
+      _cqes = at<io_uring_cqe>(_cqMap, params.cq_off.cqes);
+      return true;
+    }
+
+  public:
+    UringIoBackend(unsigned depth, IoCompletionFilter filter) : _filter(move(filter))
+    {
+      if (!open(depth)) close();
+    }
+
+    virtual ~UringIoBackend() { close(); }
+
+    void close()
+    {
+      if (_sqeMap != MAP_FAILED) ::munmap(_sqeMap, _sqeMapSize);
+      if (_cqMap != MAP_FAILED && _cqMap != _sqMap) ::munmap(_cqMap, _cqMapSize);
+      if (_sqMap != MAP_FAILED) ::munmap(_sqMap, _sqMapSize);
+      if (_ring >= 0) ::close(_ring);
+      _sqeMap = _cqMap = _sqMap = MAP_FAILED;
+      _ring = -1;
+    }
+
+    bool ready() const { return _ring >= 0; }
+
+    virtual void read(IoRequest *requests, size_t count) override
+    {
+      run(requests, count, IORING_OP_READ, -1);
+    }
+
+    virtual int write(IoRequest *requests, size_t count, bool sync) override
+    {
+      int syncResult = run(requests, count, IORING_OP_WRITE, sync && count > 0 ? requests[0].fd : -1);
+      if (int error = firstError(requests, count)) return error;
+      return syncResult;
+    }
+
+    virtual IoBackendKind kind() const override { return IoBackendKind::Uring; }
+    virtual unsigned queueDepth() const override { return _depth; }
+  };
+
+  //
+  // The sync, (if any), is queued only once every write completed, so a
+  // write that comes back short, or with EAGAIN, and is continued cannot
+  // land after it. A sync the ring could not take is done the blocking
+  // way.
+  //
+
+  int UringIoBackend::run(IoRequest *requests, size_t count, uint8_t opcode, int syncFd)
+  {
+    const uint64_t syncIndex = count;
+    for (size_t i = 0; i < count; ++i) requests[i].result = 0;
+    vector<size_t> again;
+    size_t next = 0, completed = 0, total = count + (syncFd >= 0 ? 1 : 0);
+    unsigned inFlight = 0, unsubmitted = 0;
+    bool syncQueued = false, syncAgain = false;
+    int syncResult = 0;
+
+    while (completed < total) {
+      unsigned tail = *_sqTail;
+      while (inFlight < _depth) {
+        io_uring_sqe &sqe = _sqes[tail & *_sqMask];
+        memset(&sqe, 0, sizeof(sqe));
+        if (!again.empty() || next < count) {
+          size_t index;
+          if (again.empty()) {
+            index = next++;
+          } else {
+            index = again.back();
+            again.pop_back();
+          }
+          IoRequest &request = requests[index];
+          sqe.opcode = opcode;
+          sqe.fd = request.fd;
+          sqe.addr = reinterpret_cast<uintptr_t>(request.buffer) + uint64_t(request.result);
+          sqe.len = unsigned(request.size - size_t(request.result));
+          sqe.off = request.offset + uint64_t(request.result);
+          sqe.user_data = index;
+        } else if (syncFd >= 0 && !syncQueued && completed == count) {
+          sqe.opcode = IORING_OP_FSYNC;
+          sqe.fd = syncFd;
+          sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+          sqe.user_data = syncIndex;
+          syncQueued = true;
+        } else {
+          break;
+        }
+        _sqArray[tail & *_sqMask] = tail & *_sqMask;
+        ++tail;
+        ++inFlight;
+        ++unsubmitted;
+      }
+      __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+
+      long entered = ::syscall(__NR_io_uring_enter, _ring, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (entered >= 0) {
+        unsubmitted -= unsigned(entered);
+      } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        // take back what the kernel did not get and do it the blocking way
+        tail -= unsubmitted;
+        __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+        for (unsigned i = 0; i < unsubmitted; ++i) {
+          uint64_t index = _sqes[(tail + i) & *_sqMask].user_data;
+          if (index == syncIndex)
+            syncAgain = true;
+          else
+            requests[index].result = transfer(requests[index], opcode == IORING_OP_WRITE);
+          ++completed;
+        }
+        inFlight -= unsubmitted;
+        unsubmitted = 0;
+        if (inFlight > 0) ::sched_yield();
+      }
+
+      unsigned head = *_cqHead;
+      unsigned ready = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+      for (; head != ready; ++head) {
+        const io_uring_cqe &cqe = _cqes[head & *_cqMask];
+        uint64_t index = cqe.user_data;
+        int result = cqe.res;
+        if (_filter) result = _filter(index == syncIndex ? nullptr : &requests[index], result);
+        --inFlight;
+        if (index == syncIndex) {
+          if (result == -EINTR || result == -EAGAIN) syncAgain = true;
+          else syncResult = result;
+          ++completed;
+          continue;
+        }
+        IoRequest &request = requests[index];
+        if (result == -EINTR || result == -EAGAIN) {
+          again.push_back(index);
+        } else if (result < 0) {
+          request.result = result;
+          ++completed;
+        } else {
+          request.result += result;
+          if (result > 0 && size_t(request.result) < request.size) {
+            again.push_back(index);
+          } else {
+            ++completed;
+          }
+        }
+      }
+      __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    }
+    if (syncAgain && syncFd >= 0) syncResult = ::fdatasync(syncFd) == 0 ? 0 : -errno;
+    return syncResult;
+  }
+
+#endif
+
+}// namespace
+
+unique_ptr<IoBackendInterface> makeIoBackend(IoBackendKind kind, unsigned queueDepth)
+{
+  return makeIoBackend(kind, queueDepth, nullptr);
+}
+
+unique_ptr<IoBackendInterface> makeIoBackend(IoBackendKind kind, unsigned queueDepth, [[maybe_unused]] IoCompletionFilter filter)
+{
+  if (queueDepth == 0) queueDepth = 1;
+#ifdef CPPWALLET_IO_URING
+  if (kind == IoBackendKind::Uring) {
+    auto uring = make_unique<UringIoBackend>(queueDepth, move(filter));
+    if (uring->ready()) return uring;
+  }
+#endif
+  return make_unique<PreadIoBackend>(queueDepth);
+}
@@ -0,0 +1,192 @@
+#include "../include/CppWallet/KeyPairGenerator.hpp"
+#include <algorithm>
+#include <string_view>
+#include "../include/CppWallet/EntropyPool.hpp"
+#include "../include/CppWallet/LockedMemory.hpp"
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "../include/CppWallet/Sha256.hpp"
+
+using namespace std;
+
+static constexpr char domain[] = "CppWallet/KeyPairGenerator";
+static constexpr size_t entropyBytes = 32;
+
+static void hashNumber(Sha256 &hash, uint64_t number)
+{
+  uint8_t bytes[8];
+  for (int i = 0; i < 8; ++i) bytes[i] = uint8_t(number >> (8 * i));
+  hash.update(bytes, sizeof(bytes));
+}
+
+KeyPairGenerator::KeyPairGenerator(const KeyPairGeneratorOptions &options) : _options(options)
+{
+  if (_options.threads == 0) _options.threads = max(1u, thread::hardware_concurrency());
+  _options.chunk = max<size_t>(1, _options.chunk);
+  for (unsigned i = 1; i < _options.threads; ++i) _threads.emplace_back([this] { work(); });
+}
+
+KeyPairGenerator::~KeyPairGenerator()
+{
+  {
+    lock_guard<mutex> guard(_lock);
+    _stopping = true;
+  }
+  _started.notify_all();
+  for (auto &thread : _threads) thread.join();
+}
+
+// a pool thread: each batch started, take chunks until there are none left
+void KeyPairGenerator::work()
+{
+  uint64_t seen = 0;
+  unique_lock<mutex> guard(_lock);
+  for (;;) {
+    _started.wait(guard, [this, &seen] { return _stopping || _batch != seen; });
+    if (_stopping) return;
+    seen = _batch;
+    ++_busy;
+    guard.unlock();
+    runChunks();
+    guard.lock();
+    if (--_busy == 0) _finished.notify_all();
+  }
+}
+
+void KeyPairGenerator::runChunks()
+{
+  for (size_t chunk; (chunk = _nextChunk.fetch_add(1)) < _chunks;) {
+    try {
+      _chunkTask(chunk);
+    } catch (...) {
+      lock_guard<mutex> guard(_lock);
+      if (!_error) _error = current_exception();
+    }
+  }
+}
+
+// The caller takes chunks as well, then waits for the pool threads still
+// in a chunk, (a pool thread is busy from taking the batch to leaving it,
+// so nothing of a batch is touched once _busy is back to 0).
+void KeyPairGenerator::run(size_t chunks, function<void(size_t)> chunkTask)
+{
+  lock_guard<mutex> batch(_batchLock);
+  {
+    unique_lock<mutex> guard(_lock);
+    _finished.wait(guard, [this] { return _busy == 0; });
+    _chunkTask = move(chunkTask);
+    _chunks = chunks;
+    _nextChunk = 0;
+    _error = nullptr;
+    ++_batch;
+  }
+  if (!_threads.empty() && chunks > 1) _started.notify_all();
+  runChunks();
+
+  exception_ptr error;
+  {
+    unique_lock<mutex> guard(_lock);
+    _finished.wait(guard, [this] { return _busy == 0; });
+    _chunkTask = nullptr;
+    _chunks = 0;
+    swap(error, _error);
+  }
+  if (error) rethrow_exception(error);
+}
+
+KeyPair KeyPairGenerator::make(const KeyPairSeedList &seeds, const uint8_t *entropy, const uint64_t *index) const
+{
+  Sha256 hash;
+  Sha256Digest privateKey;
+  uint8_t publicKey[secp256k1PublicKeyBytes];
+  for (uint64_t counter = 0;; ++counter) {
+    hash.update(domain, sizeof(domain));
+    if (entropy != nullptr) hash.update(entropy, entropyBytes);
+    hashNumber(hash, seeds.size());
+    for (const auto &seed : seeds) {
+      hashNumber(hash, seed.size());
+      hash.update(seed);
+    }
+    if (index != nullptr) hashNumber(hash, *index);
+    hashNumber(hash, counter);
+    privateKey = hash.finish();
+    if (secp256k1PublicKey(privateKey.data(), publicKey)) break;
+  }
+
+  KeyPairPrivateKey key(string_view(reinterpret_cast<const char *>(privateKey.data()), privateKey.size()));
+  KeyPair keyPair(string_view(reinterpret_cast<const char *>(publicKey), sizeof(publicKey)), key, _options.idMode);
+  secureZero(privateKey.data(), privateKey.size());
+  secureZero(&key, sizeof(key));
+  return keyPair;
+}
+
+KeyPair KeyPairGenerator::generate(const KeyPairSeedList &seeds)
+{
+  if (_options.deterministic) return make(seeds, nullptr, nullptr);
+  uint8_t entropy[entropyBytes];
+  randomBytes(entropy, sizeof(entropy));
+  KeyPair keyPair = make(seeds, entropy, nullptr);
+  secureZero(entropy, sizeof(entropy));
+  return keyPair;
+}
+
+//
+// A KeyPair is made on the worker's stack, copied to its place in the
+// output and wiped, (no copy of a private key is left behind).
+//
+
+void KeyPairGenerator::generateInto(const vector<KeyPairSeedList> &seedLists, KeyPair *keyPairs)
+{
+  size_t count = seedLists.size(), chunk = _options.chunk;
+  run((count + chunk - 1) / chunk, [&](size_t n) {
+    size_t begin = n * chunk, end = min(count, begin + chunk);
+    vector<uint8_t> entropy(_options.deterministic ? 0 : (end - begin) * entropyBytes);
+    randomBytes(entropy.data(), entropy.size());
+    for (size_t i = begin; i < end; ++i) {
+      KeyPair keyPair = make(seedLists[i], entropy.empty() ? nullptr : &entropy[(i - begin) * entropyBytes], nullptr);
+      keyPairs[i] = keyPair;
+      keyPair.wipe();
+    }
+    secureZero(entropy.data(), entropy.size());
+  });
+}
+
+void KeyPairGenerator::generateInto(size_t count, const KeyPairSeedList &seeds, KeyPair *keyPairs)
+{
+  size_t chunk = _options.chunk;
+  run((count + chunk - 1) / chunk, [&](size_t n) {
+    size_t begin = n * chunk, end = min(count, begin + chunk);
+    vector<uint8_t> entropy(_options.deterministic ? 0 : (end - begin) * entropyBytes);
+    randomBytes(entropy.data(), entropy.size());
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t index = i;
+      KeyPair keyPair = make(seeds, entropy.empty() ? nullptr : &entropy[(i - begin) * entropyBytes], &index);
+      keyPairs[i] = keyPair;
+      keyPair.wipe();
+    }
+    secureZero(entropy.data(), entropy.size());
+  });
+}
+
+void KeyPairGenerator::generate(const vector<KeyPairSeedList> &seedLists, vector<KeyPair> &keyPairs)
+{
+  keyPairs.resize(seedLists.size());
+  generateInto(seedLists, keyPairs.data());
+}
+
+void KeyPairGenerator::generate(const vector<KeyPairSeedList> &seedLists, pmr::vector<KeyPair> &keyPairs)
+{
+  keyPairs.resize(seedLists.size());
+  generateInto(seedLists, keyPairs.data());
+}
+
+void KeyPairGenerator::generate(size_t count, const KeyPairSeedList &seeds, vector<KeyPair> &keyPairs)
+{
+  keyPairs.resize(count);
+  generateInto(count, seeds, keyPairs.data());
+}
+
+void KeyPairGenerator::generate(size_t count, const KeyPairSeedList &seeds, pmr::vector<KeyPair> &keyPairs)
+{
+  keyPairs.resize(count);
+  generateInto(count, seeds, keyPairs.data());
+}
@@ -0,0 +1,116 @@
+#include "../include/CppWallet/KeyPairIndex.hpp"
+
+using namespace std;
+
+//
+// The table is kept at most 3/4 full, which keeps linear probe
+// sequences short while still using memory reasonably well.
+//
+
+static constexpr size_t minimumBucketCount = 16;
+
+static size_t bucketCountFor(size_t capacity)
+{
+  size_t bucketCount = minimumBucketCount;
+  while (bucketCount - bucketCount / 4 < capacity) bucketCount *= 2;
+  return bucketCount;
+}
+
+void KeyPairIndex::grow()
+{
+  if (_size + 1 > _entries.size() - _entries.size() / 4)
+    rehash(bucketCountFor(_size + 1));
+}
+
+bool KeyPairIndex::insert(const KeyPairId &keyPairId, Slot slot)
+{
+  grow();
+  for (size_t i = home(keyPairId);; i = (i + 1) & _mask) {
+    Entry &entry = _entries[i];
+    if (entry.slot == npos) {
+      entry.keyPairId = keyPairId;
+      entry.slot = slot;
+      ++_size;
+      return true;
+    }
+    if (entry.keyPairId == keyPairId) return false;
+  }
+}
+
+void KeyPairIndex::insertMulti(const KeyPairId &keyPairId, Slot slot)
+{
+  grow();
+  size_t i = home(keyPairId);
+  while (_entries[i].slot != npos) i = (i + 1) & _mask;
+  _entries[i].keyPairId = keyPairId;
+  _entries[i].slot = slot;
+  ++_size;
+}
+
+bool KeyPairIndex::erase(const KeyPairId &keyPairId)
+{
+  if (_size == 0) return false;
+  for (size_t i = home(keyPairId);; i = (i + 1) & _mask) {
+    if (_entries[i].slot == npos) return false;
+    if (_entries[i].keyPairId == keyPairId) {
+      eraseAt(i);
+      return true;
+    }
+  }
+}
+
+bool KeyPairIndex::erase(const KeyPairId &keyPairId, Slot slot)
+{
+  if (_size == 0) return false;
+  for (size_t i = home(keyPairId);; i = (i + 1) & _mask) {
+    if (_entries[i].slot == npos) return false;
+    if (_entries[i].keyPairId == keyPairId && _entries[i].slot == slot) {
+      eraseAt(i);
+      return true;
+    }
+  }
+}
+
+void KeyPairIndex::eraseAt(size_t i)
+{
+  //
+  // Backward shift: pull later members of the probe sequence into the
+  // hole unless their home position lies cyclically within (hole, j].
+  //
+  for (size_t j = (i + 1) & _mask; _entries[j].slot != npos; j = (j + 1) & _mask) {
+    size_t k = home(_entries[j].keyPairId);
+    bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+    if (!stays) {
+      _entries[i] = _entries[j];
+      i = j;
+    }
+  }
+  _entries[i].slot = npos;
+  --_size;
+}
+
+void KeyPairIndex::reserve(size_t capacity)
+{
+  size_t bucketCount = bucketCountFor(capacity);
+  if (bucketCount > _entries.size()) rehash(bucketCount);
+}
+
+void KeyPairIndex::clear()
+{
+  _entries.clear();
+  _mask = 0;
+  _size = 0;
+}
+
+void KeyPairIndex::rehash(size_t bucketCount)
+{
+  pmr::vector<Entry> entries(bucketCount, Entry{ KeyPairId(), npos }, _entries.get_allocator());
+  swap(entries, _entries);
+  _mask = bucketCount - 1;
+  for (const Entry &entry : entries) {
+    if (entry.slot == npos) continue;
+    size_t i = home(entry.keyPairId);
+    while (_entries[i].slot != npos) i = (i + 1) & _mask;
+    _entries[i] = entry;
+  }
+}
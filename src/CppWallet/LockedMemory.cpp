@@ -0,0 +1,179 @@
+#include "../include/CppWallet/LockedMemory.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+void secureZero(void *data, size_t size)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+  ::explicit_bzero(data, size);
+#else
+  volatile unsigned char *bytes = static_cast<volatile unsigned char *>(data);
+  while (size-- > 0) *bytes++ = 0;
+#endif
+}
+
+//
+// Size class c holds blocks of minimumSmall << c bytes, each aligned to
+// its size, (a slab starts on a page and blocks are carved in place), so
+// any alignment up to the block size is met.
+//
+
+static size_t sizeClassOf(size_t bytes)
+{
+  size_t sizeClass = 0;
+  while ((LockedMemoryResource::minimumSmall << sizeClass) < bytes) ++sizeClass;
+  return sizeClass;
+}
+
+static size_t roundUp(size_t bytes, size_t multiple) { return (bytes + multiple - 1) / multiple * multiple; }
+
+LockedMemoryResource::LockedMemoryResource(const LockedMemoryOptions &options)
+  : _options(options), _page(size_t(::sysconf(_SC_PAGESIZE)))
+{
+  if (_options.slabBytes < maxSmall || _options.slabBytes % _page != 0)
+    throw invalid_argument("slabBytes must be a multiple of " + to_string(_page) + " and at least " + to_string(maxSmall));
+}
+
+LockedMemoryResource::~LockedMemoryResource()
+{
+  for (const auto &large : _large) unmap(large.second);
+  for (const Mapping &slab : _slabs) unmap(slab);
+}
+
+char *LockedMemoryResource::map(size_t bytes, Mapping &mapping)
+{
+  mapping.length = bytes + 2 * _page;
+  void *base = ::mmap(nullptr, mapping.length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) throw bad_alloc();
+  mapping.base = static_cast<char *>(base);
+  char *usable = mapping.base + _page;
+  if (::mprotect(usable, bytes, PROT_READ | PROT_WRITE) != 0) {
+    ::munmap(base, mapping.length);
+    throw bad_alloc();
+  }
+  bool budget = _options.maxLockedBytes == 0 || _stats.lockedBytes + bytes <= _options.maxLockedBytes;
+  mapping.locked = budget && ::mlock(usable, bytes) == 0;
+  if (!mapping.locked) {
+    int error = budget ? errno : ENOMEM;
+    if (_options.requireLock) {
+      ::munmap(base, mapping.length);
+      throw system_error(error, generic_category(), "mlock() of " + to_string(bytes) + " bytes");
+    }
+    ++_stats.lockFailures;
+  }
+#ifdef MADV_DONTDUMP
+  ::madvise(usable, bytes, MADV_DONTDUMP);
+#endif
+#ifdef MADV_WIPEONFORK
+  ::madvise(usable, bytes, MADV_WIPEONFORK);
+#endif
+  ++_stats.mappings;
+  _stats.mappedBytes += bytes;
+  if (mapping.locked) _stats.lockedBytes += bytes;
+  return usable;
+}
+
+void LockedMemoryResource::unmap(const Mapping &mapping)
+{
+  size_t bytes = mapping.length - 2 * _page;
+  secureZero(mapping.base + _page, bytes);
+  ::munmap(mapping.base, mapping.length);
+  --_stats.mappings;
+  _stats.mappedBytes -= bytes;
+  if (mapping.locked) _stats.lockedBytes -= bytes;
+}
+
+void *LockedMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+  if (alignment > _page) throw bad_alloc();
+  lock_guard<mutex> guard(_lock);
+  size_t size = max({ bytes, alignment, minimumSmall });
+  if (size > maxSmall) {
+    Mapping mapping;
+    size = roundUp(size, _page);
+    char *pointer = map(size, mapping);
+    try {
+      _large.emplace(pointer, mapping);
+    } catch (...) {
+      unmap(mapping);
+      throw;
+    }
+    _stats.inUseBytes += size;
+    return pointer;
+  }
+
+  size_t sizeClass = sizeClassOf(size);
+  size = minimumSmall << sizeClass;
+  void *pointer = _free[sizeClass];
+  if (pointer != nullptr) {
+    memcpy(&_free[sizeClass], pointer, sizeof(void *));
+    secureZero(pointer, sizeof(void *));
+  } else {
+    char *next = _next == nullptr ? nullptr : _next + (-reinterpret_cast<uintptr_t>(_next) & (size - 1));
+    if (next == nullptr || next + size > _end) {
+      if (_slabs.size() == _slabs.capacity()) _slabs.reserve(2 * _slabs.size() + 8);
+      Mapping mapping;
+      next = map(_options.slabBytes, mapping);
+      _slabs.push_back(mapping);
+      _end = next + _options.slabBytes;
+    }
+    pointer = next;
+    _next = next + size;
+  }
+  _stats.inUseBytes += size;
+  return pointer;
+}
+
+void LockedMemoryResource::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+  lock_guard<mutex> guard(_lock);
+  size_t size = max({ bytes, alignment, minimumSmall });
+  if (size > maxSmall) {
+    auto large = _large.find(pointer);
+    _stats.inUseBytes -= large->second.length - 2 * _page;
+    unmap(large->second);
+    _large.erase(large);
+    return;
+  }
+
+  size_t sizeClass = sizeClassOf(size);
+  size = minimumSmall << sizeClass;
+  secureZero(pointer, size);
+  memcpy(pointer, &_free[sizeClass], sizeof(void *));
+  _free[sizeClass] = pointer;
+  _stats.inUseBytes -= size;
+}
+
+LockedMemoryStats LockedMemoryResource::stats() const
+{
+  lock_guard<mutex> guard(_lock);
+  return _stats;
+}
+
+bool LockedMemoryResource::locked(const void *pointer) const
+{
+  auto inside = [pointer, this](const Mapping &mapping) {
+    auto bytes = static_cast<const char *>(pointer);
+    return bytes >= mapping.base + _page && bytes < mapping.base + mapping.length - _page;
+  };
+  lock_guard<mutex> guard(_lock);
+  auto large = _large.upper_bound(pointer);
+  if (large != _large.begin() && inside((--large)->second)) return large->second.locked;
+  for (const Mapping &slab : _slabs)
+    if (inside(slab)) return slab.locked;
+  return false;
+}
+
+LockedMemoryResource *lockedMemoryResource()
+{
+  static LockedMemoryResource resource;
+  return &resource;
+}
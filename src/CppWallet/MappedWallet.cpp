@@ -0,0 +1,253 @@
+#include "../include/CppWallet/MappedWallet.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/CppWallet/KeyPairIndex.hpp"
+
+using namespace std;
+
+MappedWallet::MappedWallet(const string &path) : _path(path)
+{
+  _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (_fd < 0) fail(strerror(errno));
+  struct stat status;
+  if (::fstat(_fd, &status) != 0) fail(strerror(errno));
+  if (size_t(status.st_size) < sizeof(WalletFileHeader)) fail("not a Wallet file");
+  _mapSize = size_t(status.st_size);
+  void *map = ::mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) fail(strerror(errno));
+  _map = static_cast<const char *>(map);
+
+  const auto &header = *reinterpret_cast<const WalletFileHeader *>(_map);
+  string problem = checkWalletFileHeader(header, _mapSize);
+  if (!problem.empty()) fail(problem);
+
+  _header = &header;
+  _records = reinterpret_cast<const WalletFileRecord *>(_map + header.recordsOffset);
+  _byKeyPairId = reinterpret_cast<const WalletFileEntry *>(_map + header.byKeyPairIdOffset);
+  _byPublicKeyId = reinterpret_cast<const WalletFileEntry *>(_map + header.byPublicKeyIdOffset);
+  _byPrivateKeyId = reinterpret_cast<const WalletFileEntry *>(_map + header.byPrivateKeyIdOffset);
+  _mask = header.bucketCount - 1;
+  _idMode = static_cast<KeyPairIdMode>(header.idMode);
+
+  // lookups go anywhere, read ahead would only waste the page cache
+  ::madvise(map, _mapSize, MADV_RANDOM);
+
+  size_t count = header.count == 0 ? 1 : header.count;
+  _views = static_cast<WalletFileKeyPair *>(calloc(count, sizeof(WalletFileKeyPair)));
+  _made = static_cast<atomic<uint8_t> *>(calloc(count, sizeof(atomic<uint8_t>)));
+  if (_views == nullptr || _made == nullptr) {
+    close();
+    throw bad_alloc();
+  }
+}
+
+MappedWallet::~MappedWallet()
+{
+  close();
+}
+
+void MappedWallet::close()
+{
+  free(_views);// a WalletFileKeyPair owns nothing, there is nothing to destroy
+  free(_made);
+  _views = nullptr;
+  _made = nullptr;
+  if (_map != nullptr) ::munmap(const_cast<char *>(_map), _mapSize);
+  if (_fd >= 0) ::close(_fd);
+  _map = nullptr;
+  _fd = -1;
+}
+
+void MappedWallet::fail(const string &reason)
+{
+  close();
+  throw WalletFileException(_path, reason);
+}
+
+//
+// The first thread to return a record makes its WalletFileKeyPair, any other
+// thread wanting it meanwhile waits, (a few nanoseconds, once per record).
+//
+
+const KeyPairInterface *MappedWallet::view(Slot slot) const
+{
+  if (slot == KeyPairIndex::npos) return nullptr;
+  atomic<uint8_t> &made = _made[slot];
+  uint8_t state = made.load(memory_order_acquire);
+  if (state != 2) {
+    if (state == 0 && made.compare_exchange_strong(state, 1, memory_order_acquire)) {
+      new (&_views[slot]) WalletFileKeyPair(_records[slot]);
+      made.store(2, memory_order_release);
+    } else
+      while (made.load(memory_order_acquire) != 2) {}
+  }
+  return &_views[slot];
+}
+
+template<typename Predicate>
+const KeyPairInterface *MappedWallet::lookup(const WalletFileEntry *table, const KeyPairId &id, Predicate &&matches) const
+{
+  // bounded, (and slots and key sizes checked), so that a damaged file cannot hang or crash a lookup
+  uint64_t i = KeyPairIndex::mix(id) & _mask;
+  for (uint64_t probes = 0; probes <= _mask; ++probes, i = (i + 1) & _mask) {
+    const WalletFileEntry &entry = table[i];
+    if (entry.slot == KeyPairIndex::npos) return nullptr;
+    if (entry.keyPairId == id && entry.slot < _header->count && checkWalletFileRecord(_records[entry.slot]) && matches(_records[entry.slot]))
+      return view(entry.slot);
+  }
+  return nullptr;
+}
+
+KeyPairId MappedWallet::store(const KeyPairInterface &)
+{
+  throw WalletReadOnlyException();
+}
+
+const KeyPairInterface &MappedWallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void MappedWallet::remove(const KeyPairId &)
+{
+  throw WalletReadOnlyException();
+}
+
+KeyPairIdList MappedWallet::list() const
+{
+  KeyPairIdList keyPairIds;
+  for (size_t slot = 0; slot < _header->count; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+  return keyPairIds;
+}
+
+void MappedWallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  keyPairIds.reserve(keyPairIds.size() + _header->count);
+  for (size_t slot = 0; slot < _header->count; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+}
+
+//
+// A cursor is a record number, (the file never changes under us).
+//
+
+KeyPairIdCursor MappedWallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  if (cursor >= _header->count) return noMorePages;
+  size_t end = size_t(min<uint64_t>(_header->count, cursor + limit));
+  for (size_t slot = cursor; slot < end; ++slot) keyPairIds.push_back(_records[slot].keyPairId);
+  return end < _header->count ? end : noMorePages;
+}
+
+const KeyPairInterface &MappedWallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &MappedWallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &MappedWallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &MappedWallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &MappedWallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &MappedWallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+static bool any(const WalletFileRecord &)
+{
+  return true;
+}
+
+const KeyPairInterface *MappedWallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  return lookup(_byKeyPairId, keyPairId, any);
+}
+
+const KeyPairInterface *MappedWallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return tryRetrieve(keyPair.keyPairId());
+}
+
+const KeyPairInterface *MappedWallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return tryRetrieve(keyPairId);
+}
+
+const KeyPairInterface *MappedWallet::tryFindByPublicKey(string_view publicKey) const
+{
+  return lookup(_byPublicKeyId, publicKeyIdOf(publicKey, _idMode), [&publicKey](const WalletFileRecord &record) {
+    return record.publicKey.view() == publicKey;
+  });
+}
+
+const KeyPairInterface *MappedWallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return lookup(_byPublicKeyId, publicKeyId, any);
+}
+
+const KeyPairInterface *MappedWallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  return lookup(_byPrivateKeyId, privateKeyIdOf(privateKey, _idMode), [&privateKey](const WalletFileRecord &record) {
+    return record.privateKey.view() == privateKey;
+  });
+}
+
+const KeyPairInterface *MappedWallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return lookup(_byPrivateKeyId, privateKeyId, any);
+}
+
+void MappedWallet::storeMany(const KeyPairBatch &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void MappedWallet::removeMany(const KeyPairIdVector &, WalletStatusVector &)
+{
+  throw WalletReadOnlyException();
+}
+
+void MappedWallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  static constexpr size_t prefetchDistance = 8;
+  results.resize(publicKeyIds.size());
+  for (size_t i = 0; i < publicKeyIds.size(); ++i) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (i + prefetchDistance < publicKeyIds.size())
+      __builtin_prefetch(&_byPublicKeyId[KeyPairIndex::mix(publicKeyIds[i + prefetchDistance]) & _mask]);
+#endif
+    results[i] = tryFindByPublicKeyId(publicKeyIds[i]);
+  }
+}
+
+bool MappedWallet::verify() const
+{
+  size_t header = sizeof(WalletFileHeader);
+  return crc32(_map + header, _mapSize - header) == _header->bodyChecksum;
+}
@@ -0,0 +1,76 @@
+#include "../include/CppWallet/PerfectHash.hpp"
+#include <algorithm>
+
+using namespace std;
+
+static constexpr uint32_t maxPilot = 1U << 22;
+static constexpr uint64_t seedStep = 0x9e3779b97f4a7c15ULL;
+
+//
+// The buckets are placed largest first, (while most positions are free),
+// trying pilots 0, 1, 2, ... until all the ids of a bucket land on free
+// positions, (distinct ones). The buckets of one id come last and take
+// whatever is left, in order. Should a bucket run out of pilots the whole
+// thing starts over with another seed, (it does not, in practice).
+//
+
+vector<uint32_t> PerfectHash::build(const vector<KeyPairId> &keys, uint64_t &seed)
+{
+  uint64_t count = keys.size(), buckets = bucketsFor(count);
+  vector<uint64_t> hashes(count);
+  vector<uint32_t> first(buckets + 1), members(count), pilots(buckets);
+  vector<uint32_t> bySize;
+  vector<uint8_t> taken(count);
+  vector<uint64_t> positions;
+
+  for (seed = 0;; seed += seedStep) {
+    fill(first.begin(), first.end(), 0);
+    for (uint64_t i = 0; i < count; ++i) {
+      hashes[i] = KeyPairIndex::mix(KeyPairId(uint64_t(keys[i]) ^ seed));
+      ++first[reduce(hashes[i], buckets) + 1];
+    }
+    uint32_t largest = 0;
+    for (uint64_t b = 0; b < buckets; ++b) {
+      largest = max(largest, first[b + 1]);
+      first[b + 1] += first[b];
+    }
+    vector<uint32_t> next(first.begin(), first.end() - 1);
+    for (uint64_t i = 0; i < count; ++i) members[next[reduce(hashes[i], buckets)]++] = uint32_t(i);
+
+    bySize.clear();
+    for (uint32_t size = largest; size >= 1; --size)
+      for (uint64_t b = 0; b < buckets; ++b)
+        if (first[b + 1] - first[b] == size) bySize.push_back(uint32_t(b));
+
+    fill(pilots.begin(), pilots.end(), 0);
+    fill(taken.begin(), taken.end(), 0);
+    bool placed = true;
+    uint64_t free = 0;
+    for (uint32_t b : bySize) {
+      uint32_t from = first[b], to = first[b + 1];
+      if (to - from == 1) {
+        while (taken[free]) ++free;
+        taken[free] = 1;
+        pilots[b] = direct | uint32_t(free);
+        continue;
+      }
+      uint32_t pilot = 0;
+      for (; pilot < maxPilot; ++pilot) {
+        positions.clear();
+        for (uint32_t m = from; m < to; ++m) {
+          uint64_t position = reduce(displace(hashes[members[m]], pilot), count);
+          if (taken[position] || find(positions.begin(), positions.end(), position) != positions.end()) break;
+          positions.push_back(position);
+        }
+        if (positions.size() == to - from) break;
+      }
+      if (pilot == maxPilot) {
+        placed = false;
+        break;
+      }
+      for (uint64_t position : positions) taken[position] = 1;
+      pilots[b] = pilot;
+    }
+    if (placed) return pilots;
+  }
+}
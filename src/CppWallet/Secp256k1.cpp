@@ -0,0 +1,493 @@
+#include "../include/CppWallet/Secp256k1.hpp"
+#include <stdexcept>
+#include <vector>
+#include "../include/CppWallet/LockedMemory.hpp"
+
+using namespace std;
+
+//
+// NOTE: field elements are four 64 bit limbs, (least significant first),
+// always reduced below p = 2^256 - 2^32 - 977, so that 2^256 = 0x1000003D1
+// (mod p) folds the high half of a product into the low half. Points are
+// projective, (X : Y : Z), (0 : 1 : 0) being the point at infinity, and
+// added with the complete formulas for a = 0, (Renes, Costello & Batina,
+// algorithms 7, 8 and 9), so there are no special cases to branch on.
+//
+
+using uint128 = unsigned __int128;
+
+struct FieldElement
+{
+  uint64_t limb[4];
+};
+
+struct Point
+{
+  FieldElement x, y, z;
+};
+
+struct AffinePoint
+{
+  FieldElement x, y;
+};
+
+static constexpr FieldElement fieldPrime = { { 0xFFFFFFFEFFFFFC2Full, ~0ull, ~0ull, ~0ull } };
+static constexpr uint64_t foldConstant = 0x1000003D1ull;// 2^256 mod p
+static constexpr uint64_t curveOrder[4] = {
+  0xBFD25E8CD0364141ull, 0xBAAEDCE6AF48A03Bull, 0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull
+};
+static constexpr FieldElement generatorX = { {
+  0x59F2815B16F81798ull, 0x029BFCDB2DCE28D9ull, 0x55A06295CE870B07ull, 0x79BE667EF9DCBBACull
+} };
+static constexpr FieldElement generatorY = { {
+  0x9C47D08FFB10D4B8ull, 0xFD17B448A6855419ull, 0x5DA4FBFC0E1108A8ull, 0x483ADA7726A3C465ull
+} };
+static constexpr uint64_t curveB3 = 21;// 3 * b, (b = 7)
+
+// r - p if r >= p, (r < 2p), selected with a mask rather than a branch
+static inline void subtractPrime(uint64_t r[4], uint64_t carry)
+{
+  uint64_t t[4], borrow = 0;
+  for (int i = 0; i < 4; ++i) {
+    uint128 d = uint128(r[i]) - fieldPrime.limb[i] - borrow;
+    t[i] = uint64_t(d);
+    borrow = uint64_t(d >> 127);
+  }
+  uint64_t keep = uint64_t(0) - (carry | (borrow ^ 1));
+  for (int i = 0; i < 4; ++i) r[i] = (t[i] & keep) | (r[i] & ~keep);
+}
+
+static inline FieldElement add(const FieldElement &a, const FieldElement &b)
+{
+  FieldElement r;
+  uint128 c = 0;
+  for (int i = 0; i < 4; ++i) {
+    c += uint128(a.limb[i]) + b.limb[i];
+    r.limb[i] = uint64_t(c);
+    c >>= 64;
+  }
+  subtractPrime(r.limb, uint64_t(c));
+  return r;
+}
+
+static inline FieldElement subtract(const FieldElement &a, const FieldElement &b)
+{
+  FieldElement r;
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; ++i) {
+    uint128 d = uint128(a.limb[i]) - b.limb[i] - borrow;
+    r.limb[i] = uint64_t(d);
+    borrow = uint64_t(d >> 127);
+  }
+  uint64_t mask = uint64_t(0) - borrow;
+  uint128 c = 0;
+  for (int i = 0; i < 4; ++i) {
+    c += uint128(r.limb[i]) + (fieldPrime.limb[i] & mask);
+    r.limb[i] = uint64_t(c);
+    c >>= 64;
+  }
+  return r;
+}
+
+static inline FieldElement multiply(const FieldElement &a, const FieldElement &b)
+{
+  uint64_t wide[8] = {};
+  for (int i = 0; i < 4; ++i) {
+    uint128 c = 0;
+    for (int j = 0; j < 4; ++j) {
+      c += uint128(a.limb[i]) * b.limb[j] + wide[i + j];
+      wide[i + j] = uint64_t(c);
+      c >>= 64;
+    }
+    wide[i + 4] = uint64_t(c);
+  }
+
+  // low + high * 2^256 = low + high * foldConstant, (twice, the second
+  // fold being at most 34 bits), then once more for the last carry
+  uint64_t r[4];
+  uint128 c = 0;
+  for (int i = 0; i < 4; ++i) {
+    c += uint128(wide[i + 4]) * foldConstant + wide[i];
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  c = uint128(uint64_t(c)) * foldConstant + r[0];
+  r[0] = uint64_t(c);
+  c >>= 64;
+  for (int i = 1; i < 4; ++i) {
+    c += r[i];
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  c = uint128(uint64_t(c) * foldConstant) + r[0];
+  r[0] = uint64_t(c);
+  c >>= 64;
+  for (int i = 1; i < 4; ++i) {
+    c += r[i];
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  subtractPrime(r, 0);
+  return FieldElement{ { r[0], r[1], r[2], r[3] } };
+}
+
+// a * word, (word < 2^32)
+static inline FieldElement multiplyWord(const FieldElement &a, uint64_t word)
+{
+  uint64_t r[4];
+  uint128 c = 0;
+  for (int i = 0; i < 4; ++i) {
+    c += uint128(a.limb[i]) * word;
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  c = uint128(uint64_t(c)) * foldConstant + r[0];
+  r[0] = uint64_t(c);
+  c >>= 64;
+  for (int i = 1; i < 4; ++i) {
+    c += r[i];
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  subtractPrime(r, uint64_t(c));
+  return FieldElement{ { r[0], r[1], r[2], r[3] } };
+}
+
+static inline FieldElement square(const FieldElement &a, int times = 1)
+{
+  FieldElement r = a;
+  for (int i = 0; i < times; ++i) r = multiply(r, r);
+  return r;
+}
+
+// a^(p - 2), (Fermat), by the addition chain of libsecp256k1: 255
+// squarings and 15 multiplications, whatever a
+static FieldElement invert(const FieldElement &a)
+{
+  FieldElement x2 = multiply(square(a), a);
+  FieldElement x3 = multiply(square(x2), a);
+  FieldElement x6 = multiply(square(x3, 3), x3);
+  FieldElement x9 = multiply(square(x6, 3), x3);
+  FieldElement x11 = multiply(square(x9, 2), x2);
+  FieldElement x22 = multiply(square(x11, 11), x11);
+  FieldElement x44 = multiply(square(x22, 22), x22);
+  FieldElement x88 = multiply(square(x44, 44), x44);
+  FieldElement x176 = multiply(square(x88, 88), x88);
+  FieldElement x220 = multiply(square(x176, 44), x44);
+  FieldElement x223 = multiply(square(x220, 3), x3);
+  FieldElement r = multiply(square(x223, 23), x22);
+  r = multiply(square(r, 5), a);
+  r = multiply(square(r, 3), x2);
+  return multiply(square(r, 2), a);
+}
+
+static Point addPoints(const Point &p, const Point &q)
+{
+  FieldElement t0 = multiply(p.x, q.x);
+  FieldElement t1 = multiply(p.y, q.y);
+  FieldElement t2 = multiply(p.z, q.z);
+  FieldElement t3 = multiply(add(p.x, p.y), add(q.x, q.y));
+  FieldElement t4 = add(t0, t1);
+  t3 = subtract(t3, t4);
+  t4 = multiply(add(p.y, p.z), add(q.y, q.z));
+  FieldElement x3 = add(t1, t2);
+  t4 = subtract(t4, x3);
+  x3 = multiply(add(p.x, p.z), add(q.x, q.z));
+  FieldElement y3 = add(t0, t2);
+  y3 = subtract(x3, y3);
+  x3 = add(t0, t0);
+  t0 = add(x3, t0);
+  t2 = multiplyWord(t2, curveB3);
+  FieldElement z3 = add(t1, t2);
+  t1 = subtract(t1, t2);
+  y3 = multiplyWord(y3, curveB3);
+  x3 = multiply(t4, y3);
+  t2 = multiply(t3, t1);
+  x3 = subtract(t2, x3);
+  y3 = multiply(y3, t0);
+  t1 = multiply(t1, z3);
+  y3 = add(t1, y3);
+  t0 = multiply(t0, t3);
+  z3 = multiply(z3, t4);
+  z3 = add(z3, t0);
+  return Point{ x3, y3, z3 };
+}
+
+static Point doublePoint(const Point &p)
+{
+  FieldElement t0 = multiply(p.y, p.y);
+  FieldElement z3 = add(t0, t0);
+  z3 = add(z3, z3);
+  z3 = add(z3, z3);
+  FieldElement t1 = multiply(p.y, p.z);
+  FieldElement t2 = multiply(p.z, p.z);
+  t2 = multiplyWord(t2, curveB3);
+  FieldElement x3 = multiply(t2, z3);
+  FieldElement y3 = add(t0, t2);
+  z3 = multiply(t1, z3);
+  t1 = add(t2, t2);
+  t2 = add(t1, t2);
+  t0 = subtract(t0, t2);
+  y3 = multiply(t0, y3);
+  y3 = add(x3, y3);
+  t1 = multiply(p.x, p.y);
+  x3 = multiply(t0, t1);
+  x3 = add(x3, x3);
+  return Point{ x3, y3, z3 };
+}
+
+// p + q, q affine, (not the point at infinity), algorithm 8
+static Point addAffine(const Point &p, const AffinePoint &q)
+{
+  FieldElement t0 = multiply(p.x, q.x);
+  FieldElement t1 = multiply(p.y, q.y);
+  FieldElement t3 = multiply(add(q.x, q.y), add(p.x, p.y));
+  FieldElement t4 = add(t0, t1);
+  t3 = subtract(t3, t4);
+  t4 = add(multiply(q.y, p.z), p.y);
+  FieldElement y3 = add(multiply(q.x, p.z), p.x);
+  FieldElement x3 = add(t0, t0);
+  t0 = add(x3, t0);
+  FieldElement t2 = multiplyWord(p.z, curveB3);
+  FieldElement z3 = add(t1, t2);
+  t1 = subtract(t1, t2);
+  y3 = multiplyWord(y3, curveB3);
+  x3 = multiply(t4, y3);
+  t2 = multiply(t3, t1);
+  x3 = subtract(t2, x3);
+  y3 = multiply(y3, t0);
+  t1 = multiply(t1, z3);
+  y3 = add(t1, y3);
+  t0 = multiply(t0, t3);
+  z3 = multiply(z3, t4);
+  z3 = add(z3, t0);
+  return Point{ x3, y3, z3 };
+}
+
+// to with the words of from where mask is all ones, (as it is where zero)
+template<typename T>
+static inline void select(T &to, const T &from, uint64_t mask)
+{
+  static_assert(sizeof(T) % sizeof(uint64_t) == 0, "selected a word at a time");
+  uint64_t *t = reinterpret_cast<uint64_t *>(&to);
+  const uint64_t *f = reinterpret_cast<const uint64_t *>(&from);
+  for (size_t i = 0; i < sizeof(T) / sizeof(uint64_t); ++i) t[i] = (t[i] & ~mask) | (f[i] & mask);
+}
+
+static inline uint64_t equalMask(unsigned a, unsigned b)
+{
+  return uint64_t(0) - uint64_t(a == b);
+}
+
+// the digit-th 4 bits of the 32 big-endian bytes of a scalar, (0 the lowest)
+static inline unsigned nibble(const uint8_t *scalar, int digit)
+{
+  return (scalar[31 - digit / 2] >> (4 * (digit & 1))) & 15;
+}
+
+static const Point infinity = { { { 0, 0, 0, 0 } }, { { 1, 0, 0, 0 } }, { { 0, 0, 0, 0 } } };
+
+namespace {
+
+// 0G .. 15G, built on first use, (thread safe, a function local static)
+struct GeneratorWindow
+{
+  Point multiples[16];
+
+  GeneratorWindow()
+  {
+    multiples[0] = infinity;
+    multiples[1] = Point{ generatorX, generatorY, { { 1, 0, 0, 0 } } };
+    for (int i = 2; i < 16; ++i) multiples[i] = addPoints(multiples[i - 1], multiples[1]);
+  }
+};
+
+//
+// NOTE: the comb, (fixed-base windows, as libsecp256k1's ecmult_gen):
+// entries[i][d - 1] = d * 16^i * G, (affine), for the 64 windows of 4
+// bits of a scalar k and the digits d in 1 .. 15, so that
+//
+//   k * G = sum over i of digit(k, i) * 16^i * G
+//
+// is 64 additions of table entries and no doublings. A digit 0 adds
+// nothing, (the sum is kept as it was, with a mask). 61,440 bytes, made
+// on first use, (960 additions and one inversion, shared by all the
+// entries, Montgomery's trick).
+//
+struct GeneratorComb
+{
+  AffinePoint entries[64][15];
+
+  GeneratorComb()
+  {
+    static constexpr int count = 64 * 15;
+    vector<Point> points(count);
+    Point base = { generatorX, generatorY, { { 1, 0, 0, 0 } } };
+    for (int i = 0; i < 64; ++i) {
+      points[i * 15] = base;
+      for (int d = 1; d < 15; ++d) points[i * 15 + d] = addPoints(points[i * 15 + d - 1], base);
+      base = addPoints(points[i * 15 + 14], base);// 16^(i + 1) * G
+    }
+
+    vector<FieldElement> products(count);
+    FieldElement product = { { 1, 0, 0, 0 } };
+    for (int n = 0; n < count; ++n) {
+      products[n] = product;// z[0] * .. * z[n - 1]
+      product = multiply(product, points[n].z);
+    }
+    FieldElement inverse = invert(product);// 1 / (z[0] * .. * z[n])
+    for (int n = count - 1; n >= 0; --n) {
+      FieldElement z = multiply(inverse, products[n]);// 1 / z[n]
+      inverse = multiply(inverse, points[n].z);
+      entries[n / 15][n % 15] = AffinePoint{ multiply(points[n].x, z), multiply(points[n].y, z) };
+    }
+  }
+};
+
+}// namespace
+
+static const GeneratorWindow &generatorWindow()
+{
+  static const GeneratorWindow window;
+  return window;
+}
+
+static const GeneratorComb &generatorComb()
+{
+  static const GeneratorComb comb;
+  return comb;
+}
+
+// 4 doublings and an addition of a table entry per 4 bits, (most first)
+static Point multiplyByWindow(const uint8_t *privateKey)
+{
+  const GeneratorWindow &window = generatorWindow();
+  Point r = infinity, multiple;
+  for (int digit = 63; digit >= 0; --digit) {
+    r = doublePoint(doublePoint(doublePoint(doublePoint(r))));
+    unsigned value = nibble(privateKey, digit);
+    multiple = Point{};
+    for (unsigned i = 0; i < 16; ++i) select(multiple, window.multiples[i], equalMask(i, value));
+    r = addPoints(r, multiple);
+  }
+  secureZero(&multiple, sizeof(multiple));
+  return r;
+}
+
+// an addition of a comb entry per 4 bits, every entry of the window read
+static Point multiplyByComb(const uint8_t *privateKey)
+{
+  const GeneratorComb &comb = generatorComb();
+  Point r = infinity, sum;
+  AffinePoint entry;
+  for (int digit = 0; digit < 64; ++digit) {
+    unsigned value = nibble(privateKey, digit);
+    entry = comb.entries[digit][0];
+    for (unsigned d = 2; d < 16; ++d) select(entry, comb.entries[digit][d - 1], equalMask(d, value));
+    sum = addAffine(r, entry);
+    select(r, sum, ~equalMask(0, value));
+  }
+  secureZero(&entry, sizeof(entry));
+  secureZero(&sum, sizeof(sum));
+  return r;
+}
+
+
+// big-endian bytes to limbs, (least significant first), and back
+static inline void readScalar(const uint8_t *bytes, uint64_t limbs[4])
+{
+  for (int i = 0; i < 4; ++i) {
+    limbs[i] = 0;
+    for (int j = 0; j < 8; ++j) limbs[i] = (limbs[i] << 8) | bytes[(3 - i) * 8 + j];
+  }
+}
+
+static inline void writeScalar(const uint64_t limbs[4], uint8_t *bytes)
+{
+  for (int i = 0; i < 32; ++i) bytes[i] = uint8_t(limbs[3 - i / 8] >> (56 - 8 * (i % 8)));
+}
+
+bool secp256k1ValidPrivateKey(const uint8_t *privateKey)
+{
+  uint64_t limbs[4], borrow = 0, bits = 0;
+  readScalar(privateKey, limbs);
+  for (int i = 0; i < 4; ++i) {
+    uint128 d = uint128(limbs[i]) - curveOrder[i] - borrow;
+    borrow = uint64_t(d >> 127);
+    bits |= limbs[i];
+  }
+  secureZero(limbs, sizeof(limbs));
+  return (borrow & uint64_t(bits != 0)) != 0;
+}
+
+bool secp256k1AddPrivateKeys(const uint8_t *privateKey, const uint8_t *tweak, uint8_t *sum)
+{
+  if (!secp256k1ValidPrivateKey(privateKey)) return false;
+  uint64_t a[4], b[4], r[4], t[4], borrow = 0, bits = 0;
+  readScalar(privateKey, a);
+  readScalar(tweak, b);
+  for (int i = 0; i < 4; ++i) {// b < n, (0 allowed)
+    uint128 d = uint128(b[i]) - curveOrder[i] - borrow;
+    borrow = uint64_t(d >> 127);
+  }
+  bool tweakBelowOrder = borrow != 0;
+
+  uint128 c = 0;
+  for (int i = 0; i < 4; ++i) {
+    c += uint128(a[i]) + b[i];
+    r[i] = uint64_t(c);
+    c >>= 64;
+  }
+  borrow = 0;
+  for (int i = 0; i < 4; ++i) {
+    uint128 d = uint128(r[i]) - curveOrder[i] - borrow;
+    t[i] = uint64_t(d);
+    borrow = uint64_t(d >> 127);
+  }
+  uint64_t keep = uint64_t(0) - (uint64_t(c) | (borrow ^ 1));// r >= n
+  for (int i = 0; i < 4; ++i) {
+    r[i] = (t[i] & keep) | (r[i] & ~keep);
+    bits |= r[i];
+  }
+  bool valid = tweakBelowOrder && bits != 0;
+  if (valid) writeScalar(r, sum);
+  secureZero(a, sizeof(a));
+  secureZero(r, sizeof(r));
+  secureZero(t, sizeof(t));
+  return valid;
+}
+
+bool secp256k1PublicKeyWith(Secp256k1Engine engine, const uint8_t *privateKey, uint8_t *publicKey)
+{
+  if (!secp256k1ValidPrivateKey(privateKey)) return false;
+  Point r = engine == Secp256k1Engine::Comb ? multiplyByComb(privateKey) : multiplyByWindow(privateKey);
+
+  FieldElement inverse = invert(r.z);
+  FieldElement x = multiply(r.x, inverse);
+  FieldElement y = multiply(r.y, inverse);
+  publicKey[0] = uint8_t(2 | (y.limb[0] & 1));
+  writeScalar(x.limb, publicKey + 1);
+  secureZero(&r, sizeof(r));
+  secureZero(&y, sizeof(y));
+  return true;
+}
+
+bool secp256k1PublicKey(const uint8_t *privateKey, uint8_t *publicKey)
+{
+  return secp256k1PublicKeyWith(Secp256k1Engine::Comb, privateKey, publicKey);
+}
+
+KeyPairPublicKey secp256k1PublicKey(const KeyPairPrivateKey &privateKey)
+{
+  if (privateKey.size() != secp256k1PrivateKeyBytes)
+    throw invalid_argument("secp256k1PublicKey(): a private key is 32 bytes");
+  uint8_t publicKey[secp256k1PublicKeyBytes];
+  if (!secp256k1PublicKey(reinterpret_cast<const uint8_t *>(privateKey.data()), publicKey))
+    throw invalid_argument("secp256k1PublicKey(): the private key is 0 or not below the curve order");
+  return KeyPairPublicKey(string_view(reinterpret_cast<const char *>(publicKey), sizeof(publicKey)));
+}
+
+void secp256k1Precompute()
+{
+  generatorComb();
+}
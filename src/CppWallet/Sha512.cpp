@@ -0,0 +1,150 @@
+#include "../include/CppWallet/Sha512.hpp"
+#include <algorithm>
+#include <cstring>
+#include "../include/CppWallet/LockedMemory.hpp"
+
+using namespace std;
+
+static constexpr uint64_t roundConstants[80] = {
+  0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full, 0xe9b5dba58189dbbcull,
+  0x3956c25bf348b538ull, 0x59f111f1b605d019ull, 0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull,
+  0xd807aa98a3030242ull, 0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+  0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull, 0xc19bf174cf692694ull,
+  0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull, 0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull,
+  0x2de92c6f592b0275ull, 0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+  0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full, 0xbf597fc7beef0ee4ull,
+  0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull, 0x06ca6351e003826full, 0x142929670a0e6e70ull,
+  0x27b70a8546d22ffcull, 0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+  0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull, 0x92722c851482353bull,
+  0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull, 0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull,
+  0xd192e819d6ef5218ull, 0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+  0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull, 0x34b0bcb5e19b48a8ull,
+  0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull, 0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull,
+  0x748f82ee5defb2fcull, 0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+  0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull, 0xc67178f2e372532bull,
+  0xca273eceea26619cull, 0xd186b8c721c0c207ull, 0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull,
+  0x06f067aa72176fbaull, 0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+  0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull, 0x431d67c49c100d4cull,
+  0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull, 0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull
+};
+
+static inline uint64_t rotate(uint64_t x, unsigned n) { return (x >> n) | (x << (64 - n)); }
+
+static inline uint64_t readBigEndian(const uint8_t *p)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) value = (value << 8) | p[i];
+  return value;
+}
+
+void Sha512::reset()
+{
+  static constexpr uint64_t initial[8] = {
+    0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+    0x510e527fade682d1ull, 0x9b05688c2b3e6c1full, 0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull
+  };
+  memcpy(_state, initial, sizeof(_state));
+  _used = 0;
+  _length = 0;
+}
+
+void Sha512::compress(const uint8_t *block)
+{
+  uint64_t w[80];
+  for (int i = 0; i < 16; ++i) w[i] = readBigEndian(block + 8 * i);
+  for (int i = 16; i < 80; ++i) {
+    uint64_t s0 = rotate(w[i - 15], 1) ^ rotate(w[i - 15], 8) ^ (w[i - 15] >> 7);
+    uint64_t s1 = rotate(w[i - 2], 19) ^ rotate(w[i - 2], 61) ^ (w[i - 2] >> 6);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint64_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  uint64_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+  for (int i = 0; i < 80; ++i) {
+    uint64_t t1 = h + (rotate(e, 14) ^ rotate(e, 18) ^ rotate(e, 41)) + ((e & f) ^ (~e & g)) + roundConstants[i] + w[i];
+    uint64_t t2 = (rotate(a, 28) ^ rotate(a, 34) ^ rotate(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+  _state[4] += e;
+  _state[5] += f;
+  _state[6] += g;
+  _state[7] += h;
+  secureZero(w, sizeof(w));
+}
+
+void Sha512::update(const void *data, size_t length)
+{
+  const auto *p = static_cast<const uint8_t *>(data);
+  _length += length;
+  if (_used > 0) {
+    size_t take = min(length, sizeof(_block) - _used);
+    memcpy(_block + _used, p, take);
+    _used += take;
+    p += take;
+    length -= take;
+    if (_used < sizeof(_block)) return;
+    compress(_block);
+    _used = 0;
+  }
+  for (; length >= sizeof(_block); p += sizeof(_block), length -= sizeof(_block)) compress(p);
+  if (length > 0) memcpy(_block, p, length);
+  _used = length;
+}
+
+// the length in bits is a 128 bit number, (its high half 0 here)
+Sha512Digest Sha512::finish()
+{
+  uint64_t bits = _length * 8;
+  uint8_t padding[144] = { 0x80 };
+  size_t padded = (_used < 112 ? 112 : 240) - _used;
+  for (int i = 0; i < 8; ++i) padding[padded + 8 + i] = uint8_t(bits >> (56 - 8 * i));
+  update(padding, padded + 16);
+
+  Sha512Digest digest;
+  for (int i = 0; i < 8; ++i)
+    for (int j = 0; j < 8; ++j) digest[8 * i + j] = uint8_t(_state[i] >> (56 - 8 * j));
+  secureZero(_block, sizeof(_block));
+  reset();
+  return digest;
+}
+
+Sha512Digest sha512(const void *data, size_t length)
+{
+  Sha512 hash;
+  hash.update(data, length);
+  return hash.finish();
+}
+
+Sha512Digest hmacSha512(const void *key, size_t keyLength, const void *data, size_t length)
+{
+  uint8_t pad[128] = {};
+  if (keyLength > sizeof(pad)) {
+    Sha512Digest hashed = sha512(key, keyLength);
+    memcpy(pad, hashed.data(), hashed.size());
+    secureZero(hashed.data(), hashed.size());
+  } else if (keyLength > 0) {
+    memcpy(pad, key, keyLength);
+  }
+
+  Sha512 hash;
+  for (auto &byte : pad) byte ^= 0x36;
+  hash.update(pad, sizeof(pad));
+  hash.update(data, length);
+  Sha512Digest inner = hash.finish();
+  for (auto &byte : pad) byte ^= 0x36 ^ 0x5c;
+  hash.update(pad, sizeof(pad));
+  hash.update(inner.data(), inner.size());
+  secureZero(pad, sizeof(pad));
+  secureZero(inner.data(), inner.size());
+  return hash.finish();
+}
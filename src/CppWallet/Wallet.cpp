@@ -0,0 +1,324 @@
+#include "../include/CppWallet/Wallet.hpp"
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+Wallet::Wallet(size_t capacity)
+{
+  reserve(capacity);
+}
+
+Wallet::Wallet(KeyPairIdMode idMode, size_t capacity)
+  : _idMode(idMode)
+{
+  reserve(capacity);
+}
+
+Wallet::Wallet(KeyPairIdMode idMode, size_t capacity, const BloomFilterOptions &filter)
+  : _idMode(idMode), _publicKeyFilter(filter), _privateKeyFilter(filter)
+{
+  reserve(capacity);
+}
+
+Wallet::Wallet(KeyPairIdMode idMode, size_t capacity, const BloomFilterOptions &filter,
+  pmr::memory_resource *resource, pmr::memory_resource *indexResource)
+  : _slots(resource), _idMode(idMode),
+    _byKeyPairId(indexResource != nullptr ? indexResource : resource),
+    _byPublicKeyId(indexResource != nullptr ? indexResource : resource),
+    _byPrivateKeyId(indexResource != nullptr ? indexResource : resource),
+    _publicKeyFilter(filter), _privateKeyFilter(filter)
+{
+  reserve(capacity);
+}
+
+Wallet::Wallet(KeyPairIdMode idMode, size_t capacity, pmr::memory_resource *resource, pmr::memory_resource *indexResource)
+  : _slots(resource), _idMode(idMode),
+    _byKeyPairId(indexResource != nullptr ? indexResource : resource),
+    _byPublicKeyId(indexResource != nullptr ? indexResource : resource),
+    _byPrivateKeyId(indexResource != nullptr ? indexResource : resource)
+{
+  reserve(capacity);
+}
+
+void Wallet::reserve(size_t capacity)
+{
+  _slots.reserve(capacity);
+  _byKeyPairId.reserve(capacity);
+  _byPublicKeyId.reserve(capacity);
+  _byPrivateKeyId.reserve(capacity);
+  if (_publicKeyFilter && capacity > _publicKeyFilter->capacity())
+    refilter(max(capacity, 2 * _publicKeyFilter->capacity()));
+}
+
+//
+// A filter is rebuilt once as many ids went in as it was sized for,
+// (removed ones included), for twice the KeyPairs stored: the rebuilds
+// cost O(1) per store() and drop the ids of the removed KeyPairs.
+//
+
+static constexpr size_t minimumFilterCapacity = 1024;
+
+void Wallet::refilter(size_t capacity)
+{
+  _publicKeyFilter->reset(capacity);
+  _privateKeyFilter->reset(capacity);
+  for (size_t slot = 0; slot < _slots.bound(); ++slot)
+    if (_slots.used(slot)) {
+      _publicKeyFilter->add(_slots[Slot(slot)].publicKeyId());
+      _privateKeyFilter->add(_slots[Slot(slot)].privateKeyId());
+    }
+}
+
+WalletStats Wallet::stats() const
+{
+  WalletStats stats;
+  stats.size = size();
+  if (_publicKeyFilter) {
+    stats.filtered = true;
+    stats.filterBytes = _publicKeyFilter->memorySize() + _privateKeyFilter->memorySize();
+    stats.filterCapacity = _publicKeyFilter->capacity();
+    stats.filterFalsePositiveRate = _publicKeyFilter->falsePositiveRate();
+  }
+  stats.recordBytes = _slots.memorySize();
+  stats.unlockedRecordBytes = _slots.unlockedSize();
+  return stats;
+}
+
+const KeyPairInterface *Wallet::at(Slot slot) const
+{
+  return slot == KeyPairIndex::npos ? nullptr : &_slots[slot];
+}
+
+WalletStatus Wallet::insert(const KeyPairInterface &keyPair)
+{
+  if (_byKeyPairId.find(keyPair.keyPairId()) != KeyPairIndex::npos
+      || findPublicKey(keyPair.publicKeyId(), keyPair.publicKey()) != KeyPairIndex::npos
+      || findPrivateKey(keyPair.privateKeyId(), keyPair.privateKey()) != KeyPairIndex::npos)
+    return WalletStatus::AlreadyExists;
+
+  Slot slot = _slots.emplace(keyPair);
+  _byKeyPairId.insert(keyPair.keyPairId(), slot);
+  _byPublicKeyId.insertMulti(keyPair.publicKeyId(), slot);
+  _byPrivateKeyId.insertMulti(keyPair.privateKeyId(), slot);
+  if (_publicKeyFilter) {
+    if (_publicKeyFilter->count() >= _publicKeyFilter->capacity())
+      refilter(max(2 * size(), minimumFilterCapacity));
+    else {
+      _publicKeyFilter->add(keyPair.publicKeyId());
+      _privateKeyFilter->add(keyPair.privateKeyId());
+    }
+  }
+  return WalletStatus::Ok;
+}
+
+WalletStatus Wallet::erase(const KeyPairId &keyPairId)
+{
+  Slot slot = _byKeyPairId.find(keyPairId);
+  if (slot == KeyPairIndex::npos) return WalletStatus::NotFound;
+  const KeyPairRecord &record = _slots[slot];
+  _byPublicKeyId.erase(record.publicKeyId(), slot);
+  _byPrivateKeyId.erase(record.privateKeyId(), slot);
+  _byKeyPairId.erase(keyPairId);
+  _slots.erase(slot);
+  return WalletStatus::Ok;
+}
+
+KeyPairId Wallet::store(const KeyPairInterface &keyPair)
+{
+  if (insert(keyPair) != WalletStatus::Ok) {
+    //
+    // report the id that clashed, (as store() always has)
+    //
+    if (_byKeyPairId.find(keyPair.keyPairId()) != KeyPairIndex::npos)
+      throw KeyPairAlreadyExistsException(keyPair.keyPairId());
+    if (findPublicKey(keyPair.publicKeyId(), keyPair.publicKey()) != KeyPairIndex::npos)
+      throw KeyPairAlreadyExistsException(keyPair.publicKeyId());
+    throw KeyPairAlreadyExistsException(keyPair.privateKeyId());
+  }
+  return keyPair.keyPairId();
+}
+
+const KeyPairInterface &Wallet::retrieve(const KeyPairId &keyPairId) const
+{
+  return found(tryRetrieve(keyPairId), keyPairId);
+}
+
+void Wallet::remove(const KeyPairId &keyPairId)
+{
+  if (erase(keyPairId) != WalletStatus::Ok) throw KeyPairNotFoundException(keyPairId);
+}
+
+//
+// The batch operations work a few items ahead of themselves, prefetching
+// the index entries the upcoming items will probe, so that the cache
+// misses of consecutive items overlap instead of being paid one by one.
+//
+
+static constexpr size_t prefetchDistance = 8;
+
+void Wallet::storeMany(const KeyPairBatch &keyPairs, WalletStatusVector &results)
+{
+  results.resize(keyPairs.size());
+  reserve(size() + keyPairs.size());
+  for (size_t i = 0; i < keyPairs.size(); ++i) {
+    if (i + prefetchDistance < keyPairs.size()) {
+      const KeyPairInterface &ahead = *keyPairs[i + prefetchDistance];
+      _byKeyPairId.prefetch(ahead.keyPairId());
+      _byPublicKeyId.prefetch(ahead.publicKeyId());
+      _byPrivateKeyId.prefetch(ahead.privateKeyId());
+      if (_publicKeyFilter) {
+        _publicKeyFilter->prefetch(ahead.publicKeyId());
+        _privateKeyFilter->prefetch(ahead.privateKeyId());
+      }
+    }
+    results[i] = insert(*keyPairs[i]);
+  }
+}
+
+void Wallet::removeMany(const KeyPairIdVector &keyPairIds, WalletStatusVector &results)
+{
+  results.resize(keyPairIds.size());
+  for (size_t i = 0; i < keyPairIds.size(); ++i) {
+    if (i + prefetchDistance < keyPairIds.size()) _byKeyPairId.prefetch(keyPairIds[i + prefetchDistance]);
+    results[i] = erase(keyPairIds[i]);
+  }
+}
+
+void Wallet::findManyByPublicKeyId(const KeyPairIdVector &publicKeyIds, KeyPairBatch &results) const
+{
+  results.resize(publicKeyIds.size());
+  for (size_t i = 0; i < publicKeyIds.size(); ++i) {
+    if (i + prefetchDistance < publicKeyIds.size()) {
+      // the filter turns most misses away, their index entries are not needed
+      if (_publicKeyFilter)
+        _publicKeyFilter->prefetch(publicKeyIds[i + prefetchDistance]);
+      else
+        _byPublicKeyId.prefetch(publicKeyIds[i + prefetchDistance]);
+    }
+    results[i] = tryFindByPublicKeyId(publicKeyIds[i]);
+  }
+}
+
+KeyPairIdList Wallet::list() const
+{
+  KeyPairIdList keyPairIds;
+  copyKeyPairIds(back_inserter(keyPairIds));
+  return keyPairIds;
+}
+
+void Wallet::listInto(KeyPairIdVector &keyPairIds) const
+{
+  keyPairIds.reserve(keyPairIds.size() + size());
+  copyKeyPairIds(back_inserter(keyPairIds));
+}
+
+//
+// A cursor is a slot number: slots never move, so a KeyPair stored for
+// the whole walk is met exactly once, (whatever happens around it).
+//
+
+KeyPairIdCursor Wallet::listPage(const KeyPairIdCursor &cursor, size_t limit, KeyPairIdVector &keyPairIds) const
+{
+  limit = max<size_t>(limit, 1);
+  keyPairIds.clear();
+  if (cursor >= _slots.bound()) return noMorePages;
+  size_t slot = cursor;
+  for (; slot < _slots.bound() && keyPairIds.size() < limit; ++slot)
+    if (_slots.used(slot)) keyPairIds.push_back(_slots[Slot(slot)].keyPairId());
+  return slot < _slots.bound() ? slot : noMorePages;
+}
+
+//
+// The throwing lookups are thin wrappers over the try...() ones, so that
+// the cost of an exception is only paid by the callers that ask for it.
+//
+
+const KeyPairInterface &Wallet::findByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return found(tryFindByKeyPair(keyPair), keyPair.keyPairId());
+}
+
+const KeyPairInterface &Wallet::findByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return found(tryFindByKeyPairId(keyPairId), keyPairId);
+}
+
+const KeyPairInterface &Wallet::findByPublicKey(string_view publicKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPublicKey(publicKey)) return *keyPair;
+  throw KeyPairNotFoundException(publicKeyIdOf(publicKey, _idMode));
+}
+
+const KeyPairInterface &Wallet::findByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return found(tryFindByPublicKeyId(publicKeyId), publicKeyId);
+}
+
+const KeyPairInterface &Wallet::findByPrivateKey(string_view privateKey) const
+{
+  if (const KeyPairInterface *keyPair = tryFindByPrivateKey(privateKey)) return *keyPair;
+  throw KeyPairNotFoundException(privateKeyIdOf(privateKey, _idMode));
+}
+
+const KeyPairInterface &Wallet::findByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return found(tryFindByPrivateKeyId(privateKeyId), privateKeyId);
+}
+
+const KeyPairInterface *Wallet::tryRetrieve(const KeyPairId &keyPairId) const
+{
+  return at(_byKeyPairId.find(keyPairId));
+}
+
+const KeyPairInterface *Wallet::tryFindByKeyPair(const KeyPairInterface &keyPair) const
+{
+  return at(_byKeyPairId.find(keyPair.keyPairId()));
+}
+
+const KeyPairInterface *Wallet::tryFindByKeyPairId(const KeyPairId &keyPairId) const
+{
+  return at(_byKeyPairId.find(keyPairId));
+}
+
+//
+// The key based finders derive the id from the key, (see KeyPairIds.hpp),
+// ask the filter, (if any), and probe the matching index until a KeyPair
+// with the very same key turns up, (normally the first candidate).
+//
+
+Wallet::Slot Wallet::findPublicKey(const KeyPairId &publicKeyId, string_view publicKey) const
+{
+  if (!mayHavePublicKeyId(publicKeyId)) return KeyPairIndex::npos;
+  return _byPublicKeyId.findIf(publicKeyId, [this, &publicKey](Slot slot) {
+    return _slots[slot].publicKey().view() == publicKey;
+  });
+}
+
+Wallet::Slot Wallet::findPrivateKey(const KeyPairId &privateKeyId, string_view privateKey) const
+{
+  if (!mayHavePrivateKeyId(privateKeyId)) return KeyPairIndex::npos;
+  return _byPrivateKeyId.findIf(privateKeyId, [this, &privateKey](Slot slot) {
+    return _slots[slot].privateKey().view() == privateKey;
+  });
+}
+
+const KeyPairInterface *Wallet::tryFindByPublicKey(string_view publicKey) const
+{
+  return at(findPublicKey(publicKeyIdOf(publicKey, _idMode), publicKey));
+}
+
+const KeyPairInterface *Wallet::tryFindByPublicKeyId(const KeyPairId &publicKeyId) const
+{
+  return mayHavePublicKeyId(publicKeyId) ? at(_byPublicKeyId.find(publicKeyId)) : nullptr;
+}
+
+const KeyPairInterface *Wallet::tryFindByPrivateKey(string_view privateKey) const
+{
+  return at(findPrivateKey(privateKeyIdOf(privateKey, _idMode), privateKey));
+}
+
+const KeyPairInterface *Wallet::tryFindByPrivateKeyId(const KeyPairId &privateKeyId) const
+{
+  return mayHavePrivateKeyId(privateKeyId) ? at(_byPrivateKeyId.find(privateKeyId)) : nullptr;
+}
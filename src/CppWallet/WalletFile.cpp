@@ -0,0 +1,192 @@
+#include "../include/CppWallet/WalletFile.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/CppWallet/KeyPairIndex.hpp"
+#include "../include/CppWallet/Throttle.hpp"
+
+using namespace std;
+
+static constexpr size_t sectionAlignment = 4096;
+static constexpr size_t minimumBucketCount = 16;
+
+static uint64_t aligned(uint64_t offset)
+{
+  return (offset + sectionAlignment - 1) & ~uint64_t(sectionAlignment - 1);
+}
+
+//
+// Tables are kept at most half full, (a probe that runs into the next
+// page of a mapped file costs a page fault the first time).
+//
+
+static size_t bucketCountFor(size_t count)
+{
+  size_t bucketCount = minimumBucketCount;
+  while (bucketCount < 2 * count) bucketCount *= 2;
+  return bucketCount;
+}
+
+string checkWalletFileHeader(const WalletFileHeader &header, uint64_t fileSize)
+{
+  if (fileSize < sizeof(WalletFileHeader) || memcmp(header.magic, WalletFileHeader::expectedMagic, sizeof(header.magic)) != 0) return "not a Wallet file";
+  if (header.version != WalletFileHeader::currentVersion) return "unsupported Wallet file version " + to_string(header.version);
+  if (header.byteOrder != WalletFileHeader::littleEndian) return "Wallet file of another byte order";
+  if (header.headerChecksum != crc32(&header, offsetof(WalletFileHeader, headerChecksum))) return "damaged Wallet file header";
+  if (header.fileSize != fileSize) return "truncated Wallet file";
+
+  // offset + count * size would wrap for a large enough offset
+  auto inside = [fileSize](uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % sizeof(uint64_t) == 0 && offset <= fileSize && count <= (fileSize - offset) / size;
+  };
+  bool valid = header.count < KeyPairIndex::npos
+               && header.bucketCount >= 2 * header.count
+               && header.bucketCount < fileSize
+               && (header.bucketCount & (header.bucketCount - 1)) == 0
+               && header.idMode <= static_cast<uint32_t>(KeyPairIdMode::Hash64)
+               && inside(header.recordsOffset, header.count, sizeof(WalletFileRecord))
+               && inside(header.byKeyPairIdOffset, header.bucketCount, sizeof(WalletFileEntry))
+               && inside(header.byPublicKeyIdOffset, header.bucketCount, sizeof(WalletFileEntry))
+               && inside(header.byPrivateKeyIdOffset, header.bucketCount, sizeof(WalletFileEntry));
+  return valid ? string() : "inconsistent Wallet file header";
+}
+
+void WalletFileWriter::add(const KeyPairInterface &keyPair)
+{
+  WalletFileRecord record{};
+  record.keyPairId = keyPair.keyPairId();
+  record.publicKeyId = keyPair.publicKeyId();
+  record.privateKeyId = keyPair.privateKeyId();
+  record.publicKey = keyPair.publicKey();
+  record.privateKey = keyPair.privateKey();
+  _records.push_back(record);
+}
+
+void WalletFileWriter::addAll(const WalletInterface &wallet)
+{
+  KeyPairIdVector page;
+  for (KeyPairIdCursor cursor = firstPage; cursor != noMorePages;) {
+    cursor = wallet.listPage(cursor, 4096, page);
+    for (KeyPairId keyPairId : page)
+      if (const KeyPairInterface *keyPair = wallet.tryRetrieve(keyPairId)) add(*keyPair);
+  }
+}
+
+namespace {
+
+  /**
+   * Sequential output to a file descriptor, zero filling up to the
+   * offset of each section and computing the body checksum on the way,
+   * (a throttled Output writes a Throttle::quantum at a time).
+   */
+  class Output
+  {
+    const string &_path;
+    int _fd;
+    Throttle _throttle;
+    uint64_t _offset = 0;
+    uint32_t _crc = 0;
+
+  public:
+    Output(const string &path, int fd, uint64_t bytesPerSecond) : _path(path), _fd(fd), _throttle(bytesPerSecond) {}
+
+    void put(const void *data, size_t size, bool checksummed = true)
+    {
+      if (checksummed) _crc = crc32(data, size, _crc);
+      auto bytes = static_cast<const char *>(data);
+      while (size > 0) {
+        ssize_t written = ::write(_fd, bytes, _throttle.limited() ? min(size, Throttle::quantum) : size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) throw WalletFileException(_path, strerror(errno));
+        bytes += written;
+        size -= size_t(written);
+        _offset += uint64_t(written);
+        _throttle.pace(size_t(written));
+      }
+    }
+
+    void padTo(uint64_t offset)
+    {
+      static const char zeros[sectionAlignment] = {};
+      while (_offset < offset) put(zeros, size_t(min<uint64_t>(offset - _offset, sizeof(zeros))));
+    }
+
+    uint32_t crc() const { return _crc; }
+  };
+
+}// namespace
+
+void WalletFileWriter::write(const string &path) const
+{
+  size_t count = _records.size();
+  if (count >= KeyPairIndex::npos) throw WalletFileException(path, "too many KeyPairs");
+  size_t bucketCount = bucketCountFor(count);
+  uint64_t mask = bucketCount - 1;
+
+  WalletFileHeader header{};
+  memcpy(header.magic, WalletFileHeader::expectedMagic, sizeof(header.magic));
+  header.version = WalletFileHeader::currentVersion;
+  header.byteOrder = WalletFileHeader::littleEndian;
+  header.idMode = static_cast<uint32_t>(_idMode);
+  header.count = count;
+  header.bucketCount = bucketCount;
+  uint64_t tableSize = bucketCount * sizeof(WalletFileEntry);
+  header.recordsOffset = aligned(sizeof(WalletFileHeader));
+  header.byKeyPairIdOffset = aligned(header.recordsOffset + count * sizeof(WalletFileRecord));
+  header.byPublicKeyIdOffset = aligned(header.byKeyPairIdOffset + tableSize);
+  header.byPrivateKeyIdOffset = aligned(header.byPublicKeyIdOffset + tableSize);
+  header.fileSize = header.byPrivateKeyIdOffset + tableSize;
+  header.sequence = _sequence;
+
+  string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) throw WalletFileException(temporary, strerror(errno));
+  try {
+    Output output(temporary, fd, _bytesPerSecond);
+    output.put(&header, sizeof(header), false);// rewritten once the checksums are known
+    output.padTo(header.recordsOffset);
+    output.put(_records.data(), count * sizeof(WalletFileRecord));
+
+    vector<WalletFileEntry> table(bucketCount);
+    auto emit = [&](uint64_t offset, KeyPairId WalletFileRecord::*id) {
+      for (auto &entry : table) entry = WalletFileEntry{ 0, KeyPairIndex::npos, 0 };
+      for (size_t slot = 0; slot < count; ++slot) {
+        KeyPairId keyPairId = _records[slot].*id;
+        uint64_t i = KeyPairIndex::mix(keyPairId) & mask;
+        while (table[i].slot != KeyPairIndex::npos) i = (i + 1) & mask;
+        table[i].keyPairId = keyPairId;
+        table[i].slot = static_cast<uint32_t>(slot);
+      }
+      output.padTo(offset);
+      output.put(table.data(), tableSize);
+    };
+    emit(header.byKeyPairIdOffset, &WalletFileRecord::keyPairId);
+    emit(header.byPublicKeyIdOffset, &WalletFileRecord::publicKeyId);
+    emit(header.byPrivateKeyIdOffset, &WalletFileRecord::privateKeyId);
+
+    header.bodyChecksum = output.crc();
+    header.headerChecksum = crc32(&header, offsetof(WalletFileHeader, headerChecksum));
+    if (::pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))) throw WalletFileException(temporary, strerror(errno));
+    if (::fsync(fd) != 0) throw WalletFileException(temporary, strerror(errno));
+  } catch (...) {
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    throw;
+  }
+  ::close(fd);
+  if (::rename(temporary.c_str(), path.c_str()) != 0) {
+    int error = errno;
+    ::unlink(temporary.c_str());
+    throw WalletFileException(path, strerror(error));
+  }
+
+  // make the rename itself durable
+  string directory = path.find('/') == string::npos ? "." : path.substr(0, path.rfind('/') + 1);
+  int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directoryFd >= 0) {
+    ::fsync(directoryFd);
+    ::close(directoryFd);
+  }
+}
@@ -0,0 +1,256 @@
+#include "../include/CppWallet/WalletLog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static uint32_t checksumOf(const WalletLogEntry &entry)
+{
+  auto bytes = reinterpret_cast<const char *>(&entry);
+  return crc32(bytes + sizeof(entry.checksum), sizeof(entry) - sizeof(entry.checksum));
+}
+
+static bool readFully(int fd, void *data, size_t size)
+{
+  auto bytes = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t got = ::read(fd, bytes, size);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return false;
+    bytes += got;
+    size -= size_t(got);
+  }
+  return true;
+}
+
+static void writeFully(int fd, const void *data, size_t size, const string &path)
+{
+  auto bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd, bytes, size);
+    if (written < 0 && errno == EINTR) continue;
+    if (written < 0) throw WalletFileException(path, strerror(errno));
+    bytes += written;
+    size -= size_t(written);
+  }
+}
+
+static void readHeader(int fd, const string &path, KeyPairIdMode idMode, WalletLogHeader &header)
+{
+  if (!readFully(fd, &header, sizeof(header))
+      || memcmp(header.magic, WalletLogHeader::expectedMagic, sizeof(header.magic)) != 0
+      || header.headerChecksum != crc32(&header, offsetof(WalletLogHeader, headerChecksum)))
+    throw WalletFileException(path, "not a Wallet log");
+  if (header.version != WalletLogHeader::currentVersion) throw WalletFileException(path, "unsupported Wallet log version " + to_string(header.version));
+  if (header.idMode != static_cast<uint32_t>(idMode)) throw WalletFileException(path, "Wallet log of another KeyPairIdMode");
+}
+
+//
+// Replay up to the first entry that is incomplete, damaged or out of
+// sequence, (a write torn by a crash), and return where that is.
+//
+
+static off_t replayEntries(int fd, const string &path, WalletLog::Sequence &next, const WalletLog::Replay &replay)
+{
+  off_t end = sizeof(WalletLogHeader);
+  pmr::vector<WalletLogEntry> chunk(1024, lockedMemoryResource());
+  for (bool more = true; more;) {
+    ssize_t got = ::pread(fd, chunk.data(), chunk.size() * sizeof(WalletLogEntry), end);
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) throw WalletFileException(path, strerror(errno));
+    size_t entries = size_t(got) / sizeof(WalletLogEntry);
+    more = entries == chunk.size();
+    for (size_t i = 0; i < entries; ++i) {
+      const WalletLogEntry &entry = chunk[i];
+      if (entry.checksum != checksumOf(entry) || entry.sequence != next) {
+        more = false;
+        break;
+      }
+      replay(entry);
+      ++next;
+      end += sizeof(WalletLogEntry);
+    }
+  }
+  return end;
+}
+
+WalletLog::WalletLog(const string &path, KeyPairIdMode idMode, const WalletLogOptions &options, const Replay &replay, Sequence firstSequence)
+  : _path(path), _options(options)
+{
+  _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (_fd < 0) throw WalletFileException(path, strerror(errno));
+  try {
+    // one process at a time, (two appending to one log would interleave)
+    if (::flock(_fd, LOCK_EX | LOCK_NB) != 0) throw WalletFileException(path, "in use by another process");
+
+    WalletLogHeader header{};
+    struct stat status;
+    if (::fstat(_fd, &status) != 0) throw WalletFileException(path, strerror(errno));
+    if (status.st_size == 0) {
+      memcpy(header.magic, WalletLogHeader::expectedMagic, sizeof(header.magic));
+      header.version = WalletLogHeader::currentVersion;
+      header.idMode = static_cast<uint32_t>(idMode);
+      header.firstSequence = firstSequence;
+      header.headerChecksum = crc32(&header, offsetof(WalletLogHeader, headerChecksum));
+      writeFully(_fd, &header, sizeof(header), path);
+      if (::fsync(_fd) != 0) throw WalletFileException(path, strerror(errno));
+    } else {
+      readHeader(_fd, path, idMode, header);
+    }
+
+    // a torn tail is cut off
+    Sequence next = _first = header.firstSequence;
+    off_t end = replayEntries(_fd, path, next, replay);
+    if (::ftruncate(_fd, end) != 0) throw WalletFileException(path, strerror(errno));
+    _end = uint64_t(end);
+    _appended = _durable = next - 1;
+    _io = makeIoBackend(options.backend, 2);
+  } catch (...) {
+    ::close(_fd);
+    throw;
+  }
+}
+
+WalletLog::Sequence WalletLog::read(const string &path, KeyPairIdMode idMode, const Replay &replay)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw WalletFileException(path, strerror(errno));
+  try {
+    WalletLogHeader header{};
+    readHeader(fd, path, idMode, header);
+    Sequence next = header.firstSequence;
+    replayEntries(fd, path, next, replay);
+    ::close(fd);
+    return next - 1;
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+WalletLog::~WalletLog()
+{
+  try {
+    commit(lastSequence());
+  } catch (const WalletFileException &) {
+  }
+  ::close(_fd);
+}
+
+WalletLog::Sequence WalletLog::queue(WalletLogEntry &entry)
+{
+  lock_guard<mutex> lock(_lock);
+  entry.sequence = ++_appended;
+  entry.checksum = checksumOf(entry);
+  _queued.push_back(entry);
+  if (_queued.size() >= _options.maxGroupEntries) _groupFull.notify_one();
+  return entry.sequence;
+}
+
+WalletLog::Sequence WalletLog::appendStore(const KeyPairInterface &keyPair)
+{
+  WalletLogEntry entry{};
+  entry.op = WalletLogOp::Store;
+  entry.record.keyPairId = keyPair.keyPairId();
+  entry.record.publicKeyId = keyPair.publicKeyId();
+  entry.record.privateKeyId = keyPair.privateKeyId();
+  entry.record.publicKey = keyPair.publicKey();
+  entry.record.privateKey = keyPair.privateKey();
+  Sequence sequence = queue(entry);
+  secureZero(&entry, sizeof(entry));
+  return sequence;
+}
+
+WalletLog::Sequence WalletLog::appendRemove(const KeyPairId &keyPairId)
+{
+  WalletLogEntry entry{};
+  entry.op = WalletLogOp::Remove;
+  entry.record.keyPairId = keyPairId;
+  return queue(entry);
+}
+
+//
+// Group commit: the first thread to find nobody writing leads, the
+// others wait for it. The leader gives late comers commitDelay to join,
+// takes what is queued, (at most maxGroupEntries, the oldest first), and
+// writes it with _lock released, so the next group queues up meanwhile.
+// A leader whose own entry did not fit goes round again.
+//
+
+void WalletLog::commit(Sequence sequence)
+{
+  unique_lock<mutex> lock(_lock);
+  while (_durable < sequence) {
+    if (!_failure.empty()) throw WalletFileException(_path, _failure);
+    if (_leading) {
+      _committed.wait(lock);
+      continue;
+    }
+    _leading = true;
+    if (_options.commitDelay.count() > 0)
+      _groupFull.wait_for(lock, _options.commitDelay, [this] { return _queued.size() >= _options.maxGroupEntries; });
+    size_t limit = max<size_t>(_options.maxGroupEntries, 1);
+    if (_queued.size() <= limit) {
+      swap(_queued, _writing);
+    } else {
+      _writing.assign(_queued.begin(), _queued.begin() + ptrdiff_t(limit));
+      // wiped while still in the queue, then rotated to its end and
+      // erased, (so no stale copy is left behind in the spare capacity)
+      secureZero(_queued.data(), limit * sizeof(WalletLogEntry));
+      rotate(_queued.begin(), _queued.begin() + ptrdiff_t(limit), _queued.end());
+      _queued.erase(_queued.end() - ptrdiff_t(limit), _queued.end());
+    }
+    Sequence upTo = _writing.back().sequence;
+    lock.unlock();
+    string failure;
+    try {
+      writeGroup();
+    } catch (const WalletFileException &exception) {
+      failure = exception.what();
+    }
+    lock.lock();
+    secureZero(_writing.data(), _writing.size() * sizeof(WalletLogEntry));
+    _writing.clear();
+    _leading = false;
+    if (failure.empty())
+      _durable = upTo;
+    else
+      _failure = failure;
+    _committed.notify_all();
+  }
+}
+
+void WalletLog::writeGroup()
+{
+  IoRequest request{ _fd, _writing.data(), _writing.size() * sizeof(WalletLogEntry), _end, 0 };
+  if (int error = _io->write(&request, 1, _options.sync)) throw WalletFileException(_path, strerror(-error));
+  _end += request.size;
+  if (_options.sync) {
+    lock_guard<mutex> lock(_lock);
+    ++_syncs;
+  }
+}
+
+WalletLog::Sequence WalletLog::lastSequence() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _appended;
+}
+
+WalletLog::Sequence WalletLog::durableSequence() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _durable;
+}
+
+uint64_t WalletLog::syncCount() const
+{
+  lock_guard<mutex> lock(_lock);
+  return _syncs;
+}
@@ -0,0 +1,60 @@
+#ifndef _SAMPLEKEYPAIR_HPP
+#define _SAMPLEKEYPAIR_HPP
+
+#include <string>
+#include <extras/interfaces.hpp>
+#include "../include/CppWallet/KeyPairInterface.hpp"
+#include "../include/CppWallet/KeyPairIds.hpp"
+
+/**
+ * class SampleKeyPair
+ *
+ * A KeyPairInterface with explicitly given values, (for feeding real
+ * Wallet implementations in the unit tests).
+ */
+
+class SampleKeyPair implements KeyPairInterface
+{
+  KeyPairId _keyPairId;
+  KeyPairId _publicKeyId;
+  KeyPairId _privateKeyId;
+  KeyPairPublicKey _publicKey;
+  KeyPairPrivateKey _privateKey;
+
+public:
+  SampleKeyPair(KeyPairId keyPairId,
+    KeyPairId publicKeyId,
+    KeyPairId privateKeyId,
+    const KeyPairPublicKey &publicKey,
+    const KeyPairPrivateKey &privateKey)
+    : _keyPairId(keyPairId),
+      _publicKeyId(publicKeyId),
+      _privateKeyId(privateKeyId),
+      _publicKey(publicKey),
+      _privateKey(privateKey) {}
+
+  SampleKeyPair(const KeyPairPublicKey &publicKey,
+    const KeyPairPrivateKey &privateKey,
+    KeyPairIdMode mode = KeyPairIdMode::Crc32)
+    : SampleKeyPair(keyPairIdOf(publicKey, privateKey, mode),
+      publicKeyIdOf(publicKey, mode),
+      privateKeyIdOf(privateKey, mode),
+      publicKey,
+      privateKey) {}
+
+  /**
+   * the n-th sample, (using the ids recommended by KeyPairIds.hpp)
+   */
+  explicit SampleKeyPair(long n, KeyPairIdMode mode = KeyPairIdMode::Crc32)
+    : SampleKeyPair("public-" + std::to_string(n), "private-" + std::to_string(n), mode) {}
+
+  virtual KeyPairId generate(const KeyPairSeedList &) const override { return _keyPairId; };
+  virtual const KeyPairPublicKey &publicKey() const override { return _publicKey; };
+  virtual const KeyPairPrivateKey &privateKey() const override { return _privateKey; };
+
+  virtual const KeyPairId &keyPairId() const override { return _keyPairId; };
+  virtual const KeyPairId &publicKeyId() const override { return _publicKeyId; };
+  virtual const KeyPairId &privateKeyId() const override { return _privateKeyId; };
+};
+
+#endif// _SAMPLEKEYPAIR_HPP
@@ -62,6 +62,13 @@ public:
   virtual const TransactionIdList &retrieveAll(
     const KeyPairPublicKey &) override { return _transactionIdList; };
 
+  virtual void retrieveAllInto(
+    const KeyPairPublicKey &,
+    TransactionIdVector &transactionIds) override
+  {
+    transactionIds.insert(transactionIds.end(), _transactionIdList.begin(), _transactionIdList.end());
+  };
+
   friend bool operator==(const TransactionInterface &, const TransactionInterface &) { return true; }
 };
 
@@ -114,7 +121,7 @@ SCENARIO("Mock TransactionInterface: retrieveAll", "[mock_wallet]")
     correct_answer.push_front(i * 3);
   }
 
-  const auto &publicKey = KeyPairPublicKey();
+  [[maybe_unused]] const auto &publicKey = KeyPairPublicKey();
   Mock<TransactionInterface> mock;
   When(Method(mock, retrieveAll)).AlwaysDo([&correct_answer](const KeyPairPublicKey &) {
     return correct_answer;
@@ -126,3 +133,22 @@ SCENARIO("Mock TransactionInterface: retrieveAll", "[mock_wallet]")
   // REQUIRE(i.retrieveAll(publicKey) == correct_answer);
   // Verify(Method(mock, retrieveAll));
 }
+
+/**
+ * mocked retrieveAllInto
+ */
+
+SCENARIO("Mock TransactionInterface: retrieveAllInto", "[mock_wallet]")
+{
+  TransactionIdVector correct_answer = { 2, 3, 5, 7 };
+  Mock<TransactionInterface> mock;
+  When(Method(mock, retrieveAllInto)).AlwaysDo([&correct_answer](const KeyPairPublicKey &, TransactionIdVector &transactionIds) {
+    transactionIds.insert(transactionIds.end(), correct_answer.begin(), correct_answer.end());
+  });
+
+  TransactionIdVector transactionIds;
+  TransactionInterface &i = mock.get();
+  i.retrieveAllInto(KeyPairPublicKey(), transactionIds);
+  REQUIRE(transactionIds == correct_answer);
+  Verify(Method(mock, retrieveAllInto));
+}
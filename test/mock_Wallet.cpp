@@ -116,6 +116,45 @@ SCENARIO("Mock WalletInterface: list", "[mock_wallet]")
   Verify(Method(mock, list));
 }
 
+/**
+ * mocked listInto
+ */
+
+SCENARIO("Mock WalletInterface: listInto", "[mock_wallet]")
+{
+  KeyPairIdVector correct_answer = { 1, 2, 3 };
+  Mock<WalletInterface> mock;
+  When(Method(mock, listInto)).AlwaysDo([&correct_answer](KeyPairIdVector &keyPairIds) {
+    keyPairIds.insert(keyPairIds.end(), correct_answer.begin(), correct_answer.end());
+  });
+
+  KeyPairIdVector keyPairIds;
+  WalletInterface &i = mock.get();
+  i.listInto(keyPairIds);
+  REQUIRE(keyPairIds == correct_answer);
+  Verify(Method(mock, listInto));
+}
+
+/**
+ * mocked listPage
+ */
+
+SCENARIO("Mock WalletInterface: listPage", "[mock_wallet]")
+{
+  Mock<WalletInterface> mock;
+  When(Method(mock, listPage)).AlwaysDo([](const KeyPairIdCursor &cursor, std::size_t, KeyPairIdVector &keyPairIds) {
+    keyPairIds.assign(1, KeyPairId(cursor));
+    return cursor < 2 ? cursor + 1 : noMorePages;
+  });
+
+  KeyPairIdVector keyPairIds;
+  WalletInterface &i = mock.get();
+  REQUIRE(i.listPage(firstPage, 10, keyPairIds) == 1);
+  REQUIRE(i.listPage(2, 10, keyPairIds) == noMorePages);
+  REQUIRE(keyPairIds == KeyPairIdVector{ 2 });
+  Verify(Method(mock, listPage)).Twice();
+}
+
 /**
  * mocked KeyPairNotFoundException
  */
@@ -245,3 +284,54 @@ SCENARIO("Mock WalletInterface: findByPrivateKeyId", "[mock_wallet]")
   REQUIRE(i.findByPrivateKeyId(KeyPairId()) == correct_answer);
   Verify(Method(mock, findByPrivateKeyId));
 }
+
+/**
+ * mocked tryRetrieve
+ */
+
+SCENARIO("Mock WalletInterface: tryRetrieve", "[mock_wallet]")
+{
+  const auto &correct_answer = MockKeyPair();
+  Mock<WalletInterface> mock;
+  When(Method(mock, tryRetrieve)).AlwaysDo([&correct_answer](const KeyPairId &keyPairId) {
+    return keyPairId == KeyPairId() ? &correct_answer : nullptr;
+  });
+
+  WalletInterface &i = mock.get();
+  REQUIRE(i.tryRetrieve(KeyPairId()) == &correct_answer);
+  REQUIRE(i.tryRetrieve(KeyPairId(1)) == nullptr);
+  Verify(Method(mock, tryRetrieve)).Twice();
+}
+
+/**
+ * mocked tryFindByPublicKey
+ */
+
+SCENARIO("Mock WalletInterface: tryFindByPublicKey", "[mock_wallet]")
+{
+  Mock<WalletInterface> mock;
+  When(Method(mock, tryFindByPublicKey)).AlwaysReturn(nullptr);
+
+  WalletInterface &i = mock.get();
+  REQUIRE(i.tryFindByPublicKey(KeyPairPublicKey()) == nullptr);
+  Verify(Method(mock, tryFindByPublicKey));
+}
+
+/**
+ * mocked storeMany
+ */
+
+SCENARIO("Mock WalletInterface: storeMany", "[mock_wallet]")
+{
+  Mock<WalletInterface> mock;
+  When(Method(mock, storeMany)).AlwaysDo([](const KeyPairBatch &keyPairs, WalletStatusVector &results) {
+    results.assign(keyPairs.size(), WalletStatus::Ok);
+  });
+
+  const auto &keyPair = MockKeyPair();
+  WalletStatusVector results;
+  WalletInterface &i = mock.get();
+  i.storeMany(KeyPairBatch{ &keyPair, &keyPair }, results);
+  REQUIRE(results == WalletStatusVector{ WalletStatus::Ok, WalletStatus::Ok });
+  Verify(Method(mock, storeMany));
+}
@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/BasicWallet.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+template<typename Engine>
+static void verifyEngine(Engine &wallet, KeyPairIdMode mode)
+{
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n, mode));
+  REQUIRE(wallet.size() == 1000);
+  size_t misses = 0;
+  for (long n = 0; n < 1000; ++n) {
+    SampleKeyPair keyPair(n, mode);
+    const typename Engine::Record *found = wallet.tryRetrieve(keyPair.keyPairId());
+    misses += found == nullptr
+              || found->publicKey() != keyPair.publicKey()
+              || wallet.tryFindByPublicKey(keyPair.publicKey()) != found
+              || wallet.tryFindByPrivateKey(keyPair.privateKey()) != found
+              || wallet.tryFindByPublicKeyId(keyPair.publicKeyId()) != found
+              || wallet.tryFindByPrivateKeyId(keyPair.privateKeyId()) != found;
+  }
+  REQUIRE(misses == 0);
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(7, mode)), KeyPairAlreadyExistsException);
+  REQUIRE(wallet.tryStore(SampleKeyPair(7, mode)) == WalletStatus::AlreadyExists);
+  REQUIRE_THROWS_AS(wallet.findByPublicKey("some public key"), KeyPairNotFoundException);
+  REQUIRE(wallet.tryFindByPublicKey(string(100, 'x')) == nullptr);
+
+  for (long n = 0; n < 1000; n += 2) wallet.remove(SampleKeyPair(n, mode).keyPairId());
+  REQUIRE(wallet.size() == 500);
+  REQUIRE(wallet.tryRemove(SampleKeyPair(0, mode).keyPairId()) == WalletStatus::NotFound);
+  REQUIRE(wallet.tryFindByPublicKey(SampleKeyPair(0, mode).publicKey()) == nullptr);
+  REQUIRE(wallet.retrieve(SampleKeyPair(1, mode).keyPairId()).publicKey() == SampleKeyPair(1, mode).publicKey());
+  wallet.store(SampleKeyPair(0, mode));
+  REQUIRE(wallet.findByPrivateKey(SampleKeyPair(0, mode).privateKey()).keyPairId() == SampleKeyPair(0, mode).keyPairId());
+
+  size_t visited = 0;
+  wallet.forEach([&visited](const typename Engine::Record &) { ++visited; });
+  REQUIRE(visited == 501);
+}
+
+SCENARIO("Verify BasicWallet: StableStorage, ContiguousStorage, Hash64KeyPairIds", "[wallet]")
+{
+  BasicWallet<> stable;
+  verifyEngine(stable, KeyPairIdMode::Crc32);
+
+  BasicWallet<ContiguousStorage> contiguous(100);
+  verifyEngine(contiguous, KeyPairIdMode::Crc32);
+
+  BasicWallet<StableStorage, Hash64KeyPairIds> hashed;
+  REQUIRE(hashed.idMode == KeyPairIdMode::Hash64);
+  verifyEngine(hashed, KeyPairIdMode::Hash64);
+
+  BasicWallet<ArenaStorage> arena(100);
+  verifyEngine(arena, KeyPairIdMode::Crc32);
+
+  BasicWallet<ContiguousStorage, Hash64KeyPairIds, KeyPair> dense;
+  verifyEngine(dense, KeyPairIdMode::Hash64);
+  dense.forEach([](const KeyPair &keyPair) { REQUIRE(reinterpret_cast<uintptr_t>(&keyPair) % KeyPair::cacheLine == 0); });
+}
+
+SCENARIO("Verify BasicWallet: publicKeyId collisions", "[wallet]")
+{
+  BasicWallet<> wallet;
+  SampleKeyPair keyPair("key A", "secret A");
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), privateKeyIdOf("secret B"), "key B", "secret B");
+  wallet.store(collision);
+  wallet.store(keyPair);
+  REQUIRE(wallet.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+  wallet.remove(collision.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == keyPair.keyPairId());
+}
+
+SCENARIO("Verify WalletAdapter: a BasicWallet as a WalletInterface", "[wallet]")
+{
+  WalletAdapter<BasicWallet<>> adapter;
+  WalletInterface &wallet = adapter;
+  vector<SampleKeyPair> keyPairs;
+  for (long n = 0; n < 300; ++n) keyPairs.emplace_back(n);
+  KeyPairBatch batch;
+  for (const auto &keyPair : keyPairs) batch.push_back(&keyPair);
+  batch.push_back(&keyPairs[7]);
+  WalletStatusVector results;
+  wallet.storeMany(batch, results);
+  REQUIRE(results.back() == WalletStatus::AlreadyExists);
+  REQUIRE(adapter.size() == 300);
+
+  SampleKeyPair keyPair(42);
+  const KeyPairInterface &found = wallet.retrieve(keyPair.keyPairId());
+  REQUIRE(&found == adapter.engine().tryRetrieve(keyPair.keyPairId()));
+  REQUIRE(&wallet.findByPublicKey(keyPair.publicKey()) == &found);
+  REQUIRE(&wallet.findByPrivateKeyId(keyPair.privateKeyId()) == &found);
+  REQUIRE(wallet.tryFindByKeyPair(keyPair) == &found);
+  REQUIRE_THROWS_AS(wallet.retrieve(12345), KeyPairNotFoundException);
+
+  KeyPairIdVector publicKeyIds = { keyPairs[3].publicKeyId(), 424242 };
+  KeyPairBatch batchFound;
+  wallet.findManyByPublicKeyId(publicKeyIds, batchFound);
+  REQUIRE(batchFound[0]->keyPairId() == keyPairs[3].keyPairId());
+  REQUIRE(batchFound[1] == nullptr);
+
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(wallet, 64);
+  while (pager.next()) seen.insert(pager.page().begin(), pager.page().end());
+  REQUIRE(seen.size() == 300);
+  REQUIRE(wallet.list().size() == 300);
+
+  KeyPairIdVector keyPairIds = { keyPairs[0].keyPairId(), keyPairs[0].keyPairId() };
+  wallet.removeMany(keyPairIds, results);
+  REQUIRE(results[0] == WalletStatus::Ok);
+  REQUIRE(results[1] == WalletStatus::NotFound);
+  REQUIRE(adapter.size() == 299);
+}
+
+SCENARIO("Verify WalletAdapter: storeMany of many small batches", "[wallet]")
+{
+  WalletAdapter<BasicWallet<ContiguousStorage>> adapter;
+  vector<SampleKeyPair> keyPairs;
+  for (long n = 0; n < 20000; ++n) keyPairs.emplace_back(n);
+  WalletStatusVector results;
+  const KeyPairRecord *first = nullptr;
+  size_t moves = 0;
+  for (const auto &keyPair : keyPairs) {
+    adapter.storeMany(KeyPairBatch{ &keyPair }, results);
+    REQUIRE(results[0] == WalletStatus::Ok);
+    const KeyPairRecord *record = adapter.engine().tryRetrieve(keyPairs[0].keyPairId());
+    moves += record != first;
+    first = record;
+  }
+  REQUIRE(adapter.size() == 20000);
+  // the records grow twofold, (not once per batch)
+  REQUIRE(moves < 40);
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/ConcurrentWallet.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify ConcurrentWallet: store, retrieve, remove", "[wallet]")
+{
+  ConcurrentWallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  REQUIRE(wallet.size() == 1000);
+  SampleKeyPair keyPair(421);
+  REQUIRE(wallet.retrieve(keyPair.keyPairId()).publicKey() == keyPair.publicKey());
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKey(keyPair.privateKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKeyId(keyPair.privateKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(421)), KeyPairAlreadyExistsException);
+  wallet.remove(keyPair.keyPairId());
+  REQUIRE(wallet.size() == 999);
+  REQUIRE(wallet.tryRetrieve(keyPair.keyPairId()) == nullptr);
+  REQUIRE(wallet.tryFindByPublicKey(keyPair.publicKey()) == nullptr);
+  REQUIRE(wallet.tryFindByPrivateKeyId(keyPair.privateKeyId()) == nullptr);
+  REQUIRE_THROWS_AS(wallet.remove(keyPair.keyPairId()), KeyPairNotFoundException);
+}
+
+SCENARIO("Verify ConcurrentWallet: keys clashing across shards", "[wallet]")
+{
+  ConcurrentWallet wallet(KeyPairIdMode::Crc32, 4);
+  SampleKeyPair keyPair("key A", "secret A");
+  wallet.store(keyPair);
+  // same public key under keyPairIds landing in other shards
+  for (KeyPairId keyPairId = 1; keyPairId < 64; ++keyPairId)
+    REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(keyPairId, keyPair.publicKeyId(), keyPairId, "key A", "secret " + to_string(keyPairId))),
+      KeyPairAlreadyExistsException);
+  REQUIRE(wallet.size() == 1);
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), 1002, "key B", "secret B");
+  wallet.store(collision);
+  REQUIRE(wallet.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.tryFindByPublicKey("key B") == nullptr);// not found under its own publicKeyId
+  REQUIRE(wallet.retrieve(collision.keyPairId()).publicKey() == collision.publicKey());
+  wallet.remove(keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == collision.keyPairId());
+}
+
+SCENARIO("Verify ConcurrentWallet: listPage, findManyByPublicKeyId", "[wallet]")
+{
+  ConcurrentWallet wallet;
+  KeyPairIdVector publicKeyIds;
+  for (long n = 0; n < 500; ++n) {
+    wallet.store(SampleKeyPair(n));
+    publicKeyIds.push_back(SampleKeyPair(n).publicKeyId());
+  }
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(wallet, 7);
+  while (pager.next()) {
+    REQUIRE(pager.page().size() <= 7);
+    seen.insert(pager.page().begin(), pager.page().end());
+  }
+  REQUIRE(seen.size() == 500);
+  seen.clear();
+  KeyPairIdPager single(wallet, 0);
+  while (single.next()) seen.insert(single.page().begin(), single.page().end());
+  REQUIRE(seen.size() == 500);
+  KeyPairIdVector keyPairIds;
+  wallet.listInto(keyPairIds);
+  REQUIRE(keyPairIds.size() == 500);
+
+  publicKeyIds.push_back(KeyPairId(12345));
+  KeyPairBatch found;
+  wallet.findManyByPublicKeyId(publicKeyIds, found);
+  REQUIRE(found.size() == 501);
+  for (long n = 0; n < 500; ++n) REQUIRE(found[n]->keyPairId() == SampleKeyPair(n).keyPairId());
+  REQUIRE(found[500] == nullptr);
+}
+
+SCENARIO("Verify ConcurrentWallet: readers and writers at once", "[wallet]")
+{
+  ConcurrentWallet wallet;
+  const long preloaded = 2000, written = 2000;
+  for (long n = 0; n < preloaded; ++n) wallet.store(SampleKeyPair(n));
+
+  atomic<long> misses{ 0 };
+  vector<thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&wallet, &misses, t] {
+      for (long n = t; n < preloaded; n += 4) {
+        SampleKeyPair keyPair(n);
+        const KeyPairInterface *found = wallet.tryFindByPublicKey(keyPair.publicKey());
+        if (found == nullptr || found->keyPairId() != keyPair.keyPairId()) ++misses;
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&wallet, t] {
+      for (long n = preloaded + t; n < preloaded + written; n += 2) wallet.store(SampleKeyPair(n));
+      for (long n = preloaded + t; n < preloaded + written; n += 4) wallet.remove(SampleKeyPair(n).keyPairId());
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  REQUIRE(misses == 0);
+  REQUIRE(wallet.size() == preloaded + written / 2);
+}
+
+SCENARIO("Verify ConcurrentWallet: storeMany, removeMany a shard at a time", "[wallet]")
+{
+  ConcurrentWallet wallet(KeyPairIdMode::Crc32, 4);
+  vector<SampleKeyPair> keyPairs;
+  for (long n = 0; n < 1000; ++n) keyPairs.emplace_back(n);
+  // the same public key under keyPairIds landing in other shards
+  SampleKeyPair keyPair("key A", "secret A");
+  for (KeyPairId keyPairId = 1; keyPairId < 16; ++keyPairId)
+    keyPairs.emplace_back(keyPairId, keyPair.publicKeyId(), keyPairId, "key A", "secret " + to_string(keyPairId));
+  KeyPairBatch batch;
+  for (const auto &k : keyPairs) batch.push_back(&k);
+  batch.push_back(&keyPairs[7]);
+
+  WalletStatusVector results;
+  wallet.storeMany(batch, results);
+  REQUIRE(results.size() == batch.size());
+  REQUIRE(count(results.begin(), results.begin() + 1000, WalletStatus::Ok) == 1000);
+  REQUIRE(count(results.begin() + 1000, results.end() - 1, WalletStatus::Ok) == 1);// one "key A"
+  REQUIRE(results.back() == WalletStatus::AlreadyExists);
+  REQUIRE(wallet.size() == 1001);
+  REQUIRE(wallet.findByPublicKey(keyPairs[999].publicKey()).keyPairId() == keyPairs[999].keyPairId());
+  REQUIRE(wallet.tryFindByPublicKey("key A") != nullptr);
+
+  KeyPairIdVector keyPairIds;
+  for (long n = 0; n < 1000; n += 2) keyPairIds.push_back(keyPairs[n].keyPairId());
+  keyPairIds.push_back(keyPairs[0].keyPairId());
+  keyPairIds.push_back(424242);
+  wallet.removeMany(keyPairIds, results);
+  REQUIRE(count(results.begin(), results.end(), WalletStatus::Ok) == 500);
+  REQUIRE(results[500] == WalletStatus::NotFound);
+  REQUIRE(results[501] == WalletStatus::NotFound);
+  REQUIRE(wallet.size() == 501);
+  REQUIRE(wallet.tryFindByPublicKey(keyPairs[0].publicKey()) == nullptr);
+  REQUIRE(wallet.tryFindByPrivateKeyId(keyPairs[0].privateKeyId()) == nullptr);
+  REQUIRE(wallet.findByPrivateKey(keyPairs[1].privateKey()).keyPairId() == keyPairs[1].keyPairId());
+
+  // batches and single stores racing for the same KeyPairs
+  ConcurrentWallet shared;
+  atomic<long> stored{ 0 };
+  vector<thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&shared, &keyPairs, &stored, t] {
+      WalletStatusVector statuses;
+      for (size_t first = 0; first < 1000; first += 100) {
+        KeyPairBatch part;
+        for (size_t n = first; n < first + 100; ++n) part.push_back(&keyPairs[n]);
+        if (t % 2 == 0) {
+          shared.storeMany(part, statuses);
+          stored += count(statuses.begin(), statuses.end(), WalletStatus::Ok);
+        } else {
+          for (const KeyPairInterface *k : part) {
+            try {
+              shared.store(*k);
+              ++stored;
+            } catch (const KeyPairAlreadyExistsException &) {
+              // another thread stored it first
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  REQUIRE(stored == 1000);
+  REQUIRE(shared.size() == 1000);
+}
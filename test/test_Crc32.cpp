@@ -0,0 +1,55 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/Crc32.hpp"
+#include "../include/CppWallet/KeyPairIds.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static const Crc32Engine allEngines[] = { Crc32Engine::SlicingBy8, Crc32Engine::Sse42, Crc32Engine::Pclmul };
+
+SCENARIO("Verify Crc32: known values", "[crc32]")
+{
+  REQUIRE(crc32("") == 0x00000000);
+  REQUIRE(crc32("123456789") == 0xE3069283);
+  REQUIRE(crc32("The quick brown fox jumps over the lazy dog") == 0x22620404);
+  REQUIRE(crc32(string(32, '\0')) == 0x8A9136AA);
+  REQUIRE(crc32(string(32, '\xff')) == 0x62A8AB43);
+}
+
+SCENARIO("Verify Crc32: every engine agrees", "[crc32]")
+{
+  vector<uint8_t> data(4096);
+  uint32_t seed = 0x12345678;
+  for (auto &byte : data) {
+    seed = seed * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(seed >> 16);
+  }
+  for (auto engine : allEngines) {
+    if (!crc32Supported(engine)) continue;
+    for (size_t length = 0; length <= data.size(); length += (length < 600 ? 1 : 97)) {
+      uint32_t expected = crc32With(Crc32Engine::SlicingBy8, data.data(), length);
+      REQUIRE(crc32With(engine, data.data(), length) == expected);
+      REQUIRE(crc32With(engine, data.data() + 3, length - (length < 3 ? length : 3), 0x9abcdef0)
+              == crc32With(Crc32Engine::SlicingBy8, data.data() + 3, length - (length < 3 ? length : 3), 0x9abcdef0));
+    }
+  }
+}
+
+SCENARIO("Verify Crc32: piecewise", "[crc32]")
+{
+  string text = "The quick brown fox jumps over the lazy dog";
+  REQUIRE(crc32(text.substr(10), crc32(text.substr(0, 10))) == crc32(text));
+  REQUIRE(crc32Supported(crc32Engine()));
+}
+
+SCENARIO("Verify KeyPairIds: CRC32 of the keys", "[crc32]")
+{
+  KeyPairPublicKey publicKey = "public";
+  KeyPairPrivateKey privateKey = "private";
+  REQUIRE(publicKeyIdOf(publicKey) == KeyPairId(crc32(publicKey)));
+  REQUIRE(privateKeyIdOf(privateKey) == KeyPairId(crc32(privateKey)));
+  REQUIRE(keyPairIdOf(publicKey, privateKey) == KeyPairId(crc32(publicKey.str() + privateKey.str())));
+}
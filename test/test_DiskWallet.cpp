@@ -0,0 +1,176 @@
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/DiskWallet.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string walletFilePath(const string &name)
+{
+  return "/tmp/cppwallet-test-" + name + ".wallet";
+}
+
+// have the record of keyPairId claim 255 byte keys, (an InlineKey starts with its size)
+static void damageKeySizes(const string &path, const KeyPairId &keyPairId)
+{
+  fstream file(path, ios::in | ios::out | ios::binary);
+  WalletFileHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  for (uint64_t slot = 0; slot < header.count; ++slot) {
+    uint64_t offset = header.recordsOffset + slot * sizeof(WalletFileRecord);
+    WalletFileRecord record;
+    file.seekg(streamoff(offset));
+    file.read(reinterpret_cast<char *>(&record), sizeof(record));
+    if (record.keyPairId != keyPairId) continue;
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, publicKey)));
+    file.put('\xff');
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, privateKey)));
+    file.put('\xff');
+  }
+}
+
+SCENARIO("Verify DiskWallet: find..., findManyByPublicKeyId, listPage", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 3000; ++n) wallet.store(SampleKeyPair(n));
+  string path = walletFilePath("disk");
+  WalletFileWriter writer;
+  writer.addAll(wallet);
+  writer.write(path);
+
+  for (IoBackendKind backend : { IoBackendKind::Pread, IoBackendKind::Uring }) {
+    DiskWalletOptions options;
+    options.backend = backend;
+    options.queueDepth = 16;
+    DiskWallet disk(path, options);
+    REQUIRE(disk.size() == 3000);
+    SampleKeyPair keyPair(1234);
+    const KeyPairInterface &found = disk.retrieve(keyPair.keyPairId());
+    REQUIRE(found.publicKey() == keyPair.publicKey());
+    REQUIRE(found.privateKey() == keyPair.privateKey());
+    REQUIRE(&disk.findByPublicKey(keyPair.publicKey()) == &found);
+    REQUIRE(&disk.findByPrivateKey(keyPair.privateKey()) == &found);
+    REQUIRE(&disk.findByPublicKeyId(keyPair.publicKeyId()) == &found);
+    REQUIRE(&disk.findByPrivateKeyId(keyPair.privateKeyId()) == &found);
+    REQUIRE(disk.tryRetrieve(KeyPairId(12345)) == nullptr);
+    REQUIRE_THROWS_AS(disk.findByPublicKey("some public key"), KeyPairNotFoundException);
+    REQUIRE_THROWS_AS(disk.store(SampleKeyPair(5000)), WalletReadOnlyException);
+    REQUIRE_THROWS_AS(disk.remove(keyPair.keyPairId()), WalletReadOnlyException);
+
+    KeyPairIdVector publicKeyIds;
+    for (long n = 0; n < 3100; n += 3) publicKeyIds.push_back(SampleKeyPair(n).publicKeyId());
+    KeyPairBatch results;
+    uint64_t reads = disk.reads();
+    disk.findManyByPublicKeyId(publicKeyIds, results);
+    REQUIRE(disk.reads() > reads);
+    REQUIRE(results.size() == publicKeyIds.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      long n = long(i) * 3;
+      if (n < 3000) {
+        REQUIRE(results[i] != nullptr);
+        REQUIRE(results[i]->publicKey() == SampleKeyPair(n).publicKey());
+      } else {
+        REQUIRE(results[i] == nullptr);
+      }
+    }
+
+    set<KeyPairId> seen;
+    KeyPairIdPager pager(disk, 77);
+    while (pager.next()) seen.insert(pager.page().begin(), pager.page().end());
+    REQUIRE(seen.size() == 3000);
+    REQUIRE(disk.list().size() == 3000);
+  }
+  remove(path.c_str());
+}
+
+SCENARIO("Verify DiskWallet: publicKeyId collisions, damaged files", "[wallet]")
+{
+  string path = walletFilePath("disk-collisions");
+  SampleKeyPair keyPair("key A", "secret A");
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), 1002, "key B", "secret B");
+  WalletFileWriter writer(KeyPairIdMode::Crc32);
+  writer.add(collision);
+  writer.add(keyPair);
+  writer.write(path);
+  {
+    DiskWallet disk(path);
+    REQUIRE(disk.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+    REQUIRE(disk.retrieve(1001).publicKey() == collision.publicKey());
+    KeyPairIdVector keyPairIds;
+    REQUIRE(disk.listPage(firstPage, 10, keyPairIds) == noMorePages);
+    REQUIRE(keyPairIds == KeyPairIdVector{ 1001, keyPair.keyPairId() });
+  }
+
+  REQUIRE_THROWS_AS(DiskWallet(path + ".missing"), WalletFileException);
+  {
+    ofstream damaged(path, ios::binary | ios::in | ios::out);
+    damaged.seekp(20);
+    damaged.put('\x7f');
+  }
+  REQUIRE_THROWS_AS(DiskWallet(path), WalletFileException);
+  remove(path.c_str());
+}
+
+SCENARIO("Verify DiskWallet: cached records, release()", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 3000; ++n) wallet.store(SampleKeyPair(n));
+  string path = walletFilePath("disk-release");
+  WalletFileWriter writer;
+  writer.addAll(wallet);
+  writer.write(path);
+
+  LockedMemoryResource &locked = *lockedMemoryResource();
+  size_t before = locked.stats().inUseBytes;
+  {
+    DiskWallet disk(path);
+    REQUIRE(disk.cachedRecords() == 0);
+    for (long n = 0; n < 100; ++n) REQUIRE(disk.tryRetrieve(SampleKeyPair(n).keyPairId()) != nullptr);
+    REQUIRE(disk.cachedRecords() == 100);
+    REQUIRE(disk.tryRetrieve(SampleKeyPair(42).keyPairId()) != nullptr);
+    REQUIRE(disk.cachedRecords() == 100);// read once
+    REQUIRE(locked.stats().inUseBytes >= before + 100 * sizeof(KeyPairRecord));
+
+    uint64_t reads = disk.reads();
+    size_t cached = locked.stats().inUseBytes;
+    disk.release();
+    REQUIRE(disk.cachedRecords() == 0);
+    REQUIRE(locked.stats().inUseBytes + 100 * sizeof(KeyPairRecord) <= cached);
+    SampleKeyPair keyPair(42);
+    REQUIRE(disk.findByPrivateKey(keyPair.privateKey()).keyPairId() == keyPair.keyPairId());
+    REQUIRE(disk.reads() > reads);// read again
+    REQUIRE(disk.cachedRecords() == 1);
+  }
+  REQUIRE(locked.stats().inUseBytes == before);
+  remove(path.c_str());
+}
+
+SCENARIO("Verify DiskWallet: records with damaged key sizes are not found", "[wallet]")
+{
+  string path = walletFilePath("disk-key-sizes");
+  WalletFileWriter writer;
+  for (long n = 0; n < 100; ++n) writer.add(SampleKeyPair(n));
+  writer.write(path);
+  SampleKeyPair damaged(99), intact(98);
+  damageKeySizes(path, damaged.keyPairId());
+
+  DiskWallet disk(path);
+  REQUIRE(disk.tryRetrieve(damaged.keyPairId()) == nullptr);
+  REQUIRE(disk.tryFindByPublicKey(damaged.publicKey()) == nullptr);
+  REQUIRE(disk.tryFindByPrivateKeyId(damaged.privateKeyId()) == nullptr);
+  KeyPairBatch results;
+  disk.findManyByPublicKeyId(KeyPairIdVector{ damaged.publicKeyId(), intact.publicKeyId() }, results);
+  REQUIRE(results[0] == nullptr);
+  REQUIRE(results[1] != nullptr);
+  REQUIRE(results[1]->keyPairId() == intact.keyPairId());
+  REQUIRE(disk.cachedRecords() == 1);
+  remove(path.c_str());
+}
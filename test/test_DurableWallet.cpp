@@ -0,0 +1,251 @@
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/DurableWallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static void removeWalletDirectory(const string &directory)
+{
+  if (DIR *files = opendir(directory.c_str())) {
+    while (const dirent *file = readdir(files))
+      if (file->d_name[0] != '.') remove((directory + "/" + file->d_name).c_str());
+    closedir(files);
+  }
+  rmdir(directory.c_str());
+}
+
+static string walletDirectory(const string &name)
+{
+  string directory = "/tmp/cppwallet-test-" + name;
+  removeWalletDirectory(directory);
+  return directory;
+}
+
+static bool exists(const string &path)
+{
+  return access(path.c_str(), F_OK) == 0;
+}
+
+SCENARIO("Verify DurableWallet: store, remove, reopen", "[wallet]")
+{
+  string directory = walletDirectory("durable");
+  {
+    DurableWallet wallet(directory);
+    for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+    wallet.remove(SampleKeyPair(7).keyPairId());
+    REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(8)), KeyPairAlreadyExistsException);
+    REQUIRE_THROWS_AS(wallet.remove(SampleKeyPair(7).keyPairId()), KeyPairNotFoundException);
+    SampleKeyPair a(200), b(201);
+    WalletStatusVector results;
+    wallet.storeMany(KeyPairBatch{ &a, &b, &a }, results);
+    REQUIRE(results == WalletStatusVector{ WalletStatus::Ok, WalletStatus::Ok, WalletStatus::AlreadyExists });
+    REQUIRE(wallet.log().durableSequence() == 103);
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == 101);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(7).keyPairId()) == nullptr);
+  REQUIRE(wallet.findByPublicKey(SampleKeyPair(201).publicKey()).keyPairId() == SampleKeyPair(201).keyPairId());
+  REQUIRE(wallet.retrieve(SampleKeyPair(99).keyPairId()).privateKey() == SampleKeyPair(99).privateKey());
+  wallet.store(SampleKeyPair(7));
+  REQUIRE(wallet.log().lastSequence() == 104);
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: a failed commit fails the Wallet", "[wallet]")
+{
+  string directory = walletDirectory("failed");
+  {
+    WalletCompactionOptions compaction;
+    compaction.background = false;
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, WalletLogOptions(), compaction);
+    wallet.store(SampleKeyPair(1));
+
+    // no room to write the next entry, (EFBIG rather than SIGXFSZ)
+    struct stat status;
+    REQUIRE(stat(wallet.log().path().c_str(), &status) == 0);
+    rlimit saved, limit;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    limit = saved;
+    limit.rlim_cur = rlim_t(status.st_size);
+    auto handler = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+    REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(2)), WalletFileException);
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, handler);
+
+    REQUIRE(wallet.failed());
+    REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(3)), WalletFileException);
+    REQUIRE_THROWS_AS(wallet.tryRetrieve(SampleKeyPair(1).keyPairId()), WalletFileException);
+    REQUIRE_THROWS_AS(wallet.tryRetrieve(SampleKeyPair(2).keyPairId()), WalletFileException);
+    REQUIRE_THROWS_AS(wallet.compact(), WalletFileException);
+  }
+  DurableWallet wallet(directory);
+  REQUIRE_FALSE(wallet.failed());
+  REQUIRE(wallet.size() == 1);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(2).keyPairId()) == nullptr);
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: a torn tail is cut off, a foreign log refused", "[wallet]")
+{
+  string directory = walletDirectory("torn");
+  {
+    DurableWallet wallet(directory);
+    for (long n = 0; n < 10; ++n) wallet.store(SampleKeyPair(n));
+  }
+  string path = directory + "/" + DurableWallet::segmentName(1);
+  {
+    ofstream log(path, ios::binary | ios::app);
+    log << string(sizeof(WalletLogEntry) / 2, 'x');
+  }
+  {
+    DurableWallet wallet(directory);
+    REQUIRE(wallet.size() == 10);
+    wallet.store(SampleKeyPair(10));
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == 11);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(10).keyPairId()) != nullptr);
+  REQUIRE_THROWS_AS(DurableWallet(directory), WalletFileException);
+  removeWalletDirectory(directory);
+
+  DurableWallet(directory, KeyPairIdMode::Crc32);
+  REQUIRE_THROWS_AS(DurableWallet(directory, KeyPairIdMode::Hash64), WalletFileException);
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: concurrent store() share an fdatasync()", "[wallet]")
+{
+  string directory = walletDirectory("group");
+  const int threads = 8;
+  const long perThread = 50;
+  WalletLogOptions options;
+  options.commitDelay = chrono::microseconds(200);
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, options);
+    vector<thread> storers;
+    for (int t = 0; t < threads; ++t)
+      storers.emplace_back([&wallet, t] {
+        for (long n = 0; n < perThread; ++n) wallet.store(SampleKeyPair(t * perThread + n));
+      });
+    for (auto &storer : storers) storer.join();
+    REQUIRE(wallet.size() == size_t(threads * perThread));
+    REQUIRE(wallet.log().durableSequence() == uint64_t(threads * perThread));
+    REQUIRE(wallet.log().syncCount() < uint64_t(threads * perThread));
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == size_t(threads * perThread));
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: a log written through io_uring", "[wallet]")
+{
+  string directory = walletDirectory("uring");
+  WalletLogOptions options;
+  options.backend = IoBackendKind::Uring;
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, options);
+    for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+    wallet.remove(SampleKeyPair(50).keyPairId());
+    REQUIRE(wallet.log().syncCount() == 101);
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == 99);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(50).keyPairId()) == nullptr);
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: log groups of at most maxGroupEntries", "[wallet]")
+{
+  string directory = walletDirectory("groups");
+  WalletLogOptions options;
+  options.maxGroupEntries = 4;
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, options);
+    vector<SampleKeyPair> keyPairs;
+    for (long n = 0; n < 10; ++n) keyPairs.emplace_back(n);
+    KeyPairBatch batch;
+    for (const auto &keyPair : keyPairs) batch.push_back(&keyPair);
+    WalletStatusVector results;
+    wallet.storeMany(batch, results);
+    REQUIRE(wallet.log().durableSequence() == 10);
+    REQUIRE(wallet.log().syncCount() == 3);// 4 + 4 + 2
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == 10);
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: compact() checkpoints and drops log segments", "[wallet]")
+{
+  string directory = walletDirectory("compact");
+  WalletCompactionOptions compaction;
+  compaction.background = false;
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, WalletLogOptions(), compaction);
+    for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+    for (long n = 0; n < 50; ++n) wallet.remove(SampleKeyPair(n).keyPairId());
+    REQUIRE(wallet.compact());
+    REQUIRE_FALSE(wallet.compact());
+    REQUIRE(wallet.checkpointSequence() == 150);
+    REQUIRE_FALSE(exists(directory + "/" + DurableWallet::segmentName(1)));
+    REQUIRE(exists(directory + "/" + DurableWallet::checkpointName));
+
+    // removed from the checkpoint, stored again, and new ones
+    wallet.remove(SampleKeyPair(60).keyPairId());
+    wallet.remove(SampleKeyPair(61).keyPairId());
+    wallet.store(SampleKeyPair(61));
+    for (long n = 100; n < 110; ++n) wallet.store(SampleKeyPair(n));
+    wallet.remove(SampleKeyPair(105).keyPairId());
+  }
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, WalletLogOptions(), compaction);
+    REQUIRE(wallet.size() == 58);
+    REQUIRE(wallet.checkpointSequence() == 150);
+    REQUIRE(wallet.compact());
+    REQUIRE(wallet.checkpointSequence() == 164);
+    REQUIRE(wallet.log().firstSequence() == 165);
+  }
+  DurableWallet wallet(directory, KeyPairIdMode::Crc32, WalletLogOptions(), compaction);
+  REQUIRE(wallet.size() == 58);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(60).keyPairId()) == nullptr);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(61).keyPairId()) != nullptr);
+  REQUIRE(wallet.tryRetrieve(SampleKeyPair(105).keyPairId()) == nullptr);
+  REQUIRE(wallet.findByPrivateKey(SampleKeyPair(109).privateKey()).keyPairId() == SampleKeyPair(109).keyPairId());
+  removeWalletDirectory(directory);
+}
+
+SCENARIO("Verify DurableWallet: background compaction while finding", "[wallet]")
+{
+  string directory = walletDirectory("background");
+  WalletCompactionOptions compaction;
+  compaction.minEntries = 200;
+  compaction.logRatio = 0;
+  compaction.interval = chrono::milliseconds(5);
+  WalletLogOptions options;
+  options.sync = false;
+  {
+    DurableWallet wallet(directory, KeyPairIdMode::Crc32, options, compaction);
+    for (long n = 0; n < 1000; ++n) {
+      wallet.store(SampleKeyPair(n));
+      REQUIRE(wallet.tryFindByPublicKey(SampleKeyPair(n / 2).publicKey()) != nullptr);
+    }
+    for (int wait = 0; wait < 1000 && wallet.compactions() == 0; ++wait) this_thread::sleep_for(chrono::milliseconds(5));
+    REQUIRE(wallet.compactions() > 0);
+  }
+  DurableWallet wallet(directory);
+  REQUIRE(wallet.size() == 1000);
+  removeWalletDirectory(directory);
+}
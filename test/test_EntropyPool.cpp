@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../include/CppWallet/EntropyPool.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string hex(const uint8_t *bytes, size_t size)
+{
+  static const char digits[] = "0123456789abcdef";
+  string text;
+  for (size_t i = 0; i < size; ++i) {
+    text += digits[bytes[i] >> 4];
+    text += digits[bytes[i] & 15];
+  }
+  return text;
+}
+
+SCENARIO("Verify EntropyPool: ChaCha20 block, (RFC 8439)", "[wallet]")
+{
+  uint8_t key[32], nonce[12] = { 0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0 }, block[64];
+  for (int i = 0; i < 32; ++i) key[i] = uint8_t(i);
+  chacha20Block(key, 1, nonce, block);
+  REQUIRE(hex(block, 64)
+          == "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+             "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e");
+
+  uint8_t zero[32] = {};
+  chacha20Block(zero, 0, zero, block);
+  REQUIRE(hex(block, 64)
+          == "76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7"
+             "da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586");
+}
+
+SCENARIO("Verify EntropyPool: kernel reads, reseeds", "[wallet]")
+{
+  EntropyPool pool(EntropyPoolOptions{ 4096, chrono::hours(1) });
+  REQUIRE(pool.stats().kernelReads == 0);// nothing until the first fill()
+
+  set<string> seen;
+  uint8_t bytes[32];
+  for (int i = 0; i < 1000; ++i) {
+    pool.fill(bytes, sizeof(bytes));
+    seen.insert(hex(bytes, sizeof(bytes)));
+  }
+  REQUIRE(seen.size() == 1000);
+  REQUIRE(pool.stats().bytes == 32000);
+  REQUIRE(pool.stats().reseeds >= 32000 / 4096);
+  REQUIRE(pool.stats().reseeds <= 32000 / 4096 + 1);
+  REQUIRE(pool.stats().kernelReads == pool.stats().reseeds);// 32 bytes read at each reseed, none ahead
+
+  uint8_t large[5000];
+  memset(large, 0, sizeof(large));
+  pool.fill(large, sizeof(large));
+  size_t zeros = 0;
+  for (auto byte : large) zeros += byte == 0;
+  REQUIRE(zeros < 100);
+
+  uint64_t reseeds = pool.stats().reseeds;
+  pool.reseed();
+  REQUIRE(pool.stats().reseeds == reseeds + 1);
+  REQUIRE(pool.stats().kernelReads == reseeds + 1);
+
+  EntropyPool timed(EntropyPoolOptions{ 1 << 20, chrono::milliseconds(0) });
+  for (int i = 0; i < 100; ++i) timed.fill(large, 1000);// a reseed every 1 KiB
+  REQUIRE(timed.stats().reseeds >= 99);
+  REQUIRE(timed.stats().kernelReads == timed.stats().reseeds);
+}
+
+SCENARIO("Verify EntropyPool: per thread, fork-safe", "[wallet]")
+{
+  EntropyPool *mine = &threadEntropyPool();
+  EntropyPool *other = nullptr;
+  thread([&other] { other = &threadEntropyPool(); }).join();
+  REQUIRE(mine == &threadEntropyPool());
+  REQUIRE(mine != other);
+
+  // a child must not repeat what its parent will hand out next
+  uint8_t warm[16];
+  randomBytes(warm, sizeof(warm));
+  int ends[2];
+  REQUIRE(::pipe(ends) == 0);
+  pid_t child = ::fork();
+  if (child == 0) {
+    uint8_t bytes[32];
+    randomBytes(bytes, sizeof(bytes));
+    ssize_t written = ::write(ends[1], bytes, sizeof(bytes));
+    ::_exit(written == ssize_t(sizeof(bytes)) ? 0 : 1);
+  }
+  uint8_t parent[32], fromChild[32];
+  randomBytes(parent, sizeof(parent));
+  REQUIRE(::read(ends[0], fromChild, sizeof(fromChild)) == ssize_t(sizeof(fromChild)));
+  int status = 0;
+  ::waitpid(child, &status, 0);
+  ::close(ends[0]);
+  ::close(ends[1]);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(memcmp(parent, fromChild, sizeof(parent)) != 0);
+}
@@ -0,0 +1,98 @@
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/EpochWallet.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify EpochWallet: store, retrieve, remove", "[wallet]")
+{
+  EpochWallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  REQUIRE(wallet.size() == 1000);
+  SampleKeyPair keyPair(421);
+  REQUIRE(wallet.retrieve(keyPair.keyPairId()).publicKey() == keyPair.publicKey());
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKey(keyPair.privateKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKeyId(keyPair.privateKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(421)), KeyPairAlreadyExistsException);
+  wallet.remove(keyPair.keyPairId());
+  REQUIRE(wallet.size() == 999);
+  REQUIRE(wallet.tryRetrieve(keyPair.keyPairId()) == nullptr);
+  REQUIRE(wallet.tryFindByPublicKey(keyPair.publicKey()) == nullptr);
+  REQUIRE_THROWS_AS(wallet.remove(keyPair.keyPairId()), KeyPairNotFoundException);
+  wallet.store(keyPair);
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(wallet, 64);
+  while (pager.next()) seen.insert(pager.page().begin(), pager.page().end());
+  REQUIRE(seen.size() == 1000);
+}
+
+SCENARIO("Verify EpochWallet: removed KeyPairs outlive the references to them", "[wallet]")
+{
+  EpochWallet wallet;
+  SampleKeyPair keyPair(7);
+  wallet.store(keyPair);
+  EpochDomain &epochs = EpochDomain::instance();
+  epochs.collect();
+  {
+    EpochGuard guard;
+    const KeyPairInterface &held = wallet.findByPublicKey(keyPair.publicKey());
+    thread([&wallet, &keyPair] { wallet.remove(keyPair.keyPairId()); }).join();
+    epochs.collect();
+    REQUIRE(epochs.pending() >= 1);
+    REQUIRE(held.publicKey() == keyPair.publicKey());
+    REQUIRE(wallet.tryRetrieve(keyPair.keyPairId()) == nullptr);
+    REQUIRE(held.keyPairId() == keyPair.keyPairId());
+  }
+  epochs.quiesce();
+  epochs.collect();
+  REQUIRE(epochs.pending() == 0);
+}
+
+SCENARIO("Verify EpochWallet: lock-free readers while writers store and remove", "[wallet]")
+{
+  EpochWallet wallet(KeyPairIdMode::Hash64);
+  const long preloaded = 2000, written = 4000;
+  for (long n = 0; n < preloaded; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+
+  atomic<bool> writing{ true };
+  atomic<long> misses{ 0 };
+  vector<thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&, t] {
+      do {
+        for (long n = t; n < preloaded; n += 3) {
+          SampleKeyPair keyPair(n, KeyPairIdMode::Hash64);
+          const KeyPairInterface *found = wallet.tryFindByPublicKey(keyPair.publicKey());
+          if (found == nullptr || found->privateKey() != keyPair.privateKey()) ++misses;
+        }
+        // the KeyPairs coming and going, (whatever is found has to be intact)
+        for (long n = preloaded; n < preloaded + written; n += 7) {
+          SampleKeyPair keyPair(n, KeyPairIdMode::Hash64);
+          const KeyPairInterface *found = wallet.tryRetrieve(keyPair.keyPairId());
+          if (found != nullptr && found->publicKey() != keyPair.publicKey()) ++misses;
+        }
+      } while (writing);
+      EpochDomain::instance().quiesce();
+    });
+  }
+  for (int round = 0; round < 3; ++round) {
+    for (long n = preloaded; n < preloaded + written; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    for (long n = preloaded; n < preloaded + written; ++n) wallet.remove(SampleKeyPair(n, KeyPairIdMode::Hash64).keyPairId());
+  }
+  writing = false;
+  for (auto &reader : readers) reader.join();
+  REQUIRE(misses == 0);
+  REQUIRE(wallet.size() == preloaded);
+}
@@ -0,0 +1,200 @@
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/FrozenWallet.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "../include/CppWallet/PerfectHash.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string frozenFilePath(const string &name)
+{
+  return "/tmp/cppwallet-test-" + name + ".frozen";
+}
+
+// have the record of keyPairId claim 255 byte keys, (an InlineKey starts with its size)
+static void damageKeySizes(const string &path, const KeyPairId &keyPairId)
+{
+  fstream file(path, ios::in | ios::out | ios::binary);
+  FrozenWalletHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  for (uint64_t slot = 0; slot < header.count; ++slot) {
+    uint64_t offset = header.recordsOffset + slot * sizeof(WalletFileRecord);
+    WalletFileRecord record;
+    file.seekg(streamoff(offset));
+    file.read(reinterpret_cast<char *>(&record), sizeof(record));
+    if (record.keyPairId != keyPairId) continue;
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, publicKey)));
+    file.put('\xff');
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, privateKey)));
+    file.put('\xff');
+  }
+}
+
+SCENARIO("Verify PerfectHash: a position of its own for every key", "[wallet]")
+{
+  for (size_t count : { 0, 1, 2, 3, 100, 10000 }) {
+    vector<KeyPairId> keys;
+    for (size_t n = 0; n < count; ++n) keys.push_back(KeyPairId(n * 2654435761U));
+    uint64_t seed;
+    vector<uint32_t> pilots = PerfectHash::build(keys, seed);
+    REQUIRE(pilots.size() == PerfectHash::bucketsFor(count));
+    PerfectHash hash(seed, count, pilots.size(), pilots.data());
+    vector<bool> used(count);
+    size_t clashes = 0;
+    for (KeyPairId key : keys) {
+      uint64_t position = hash.position(key);
+      REQUIRE(position < count);
+      clashes += used[position];
+      used[position] = true;
+    }
+    REQUIRE(clashes == 0);
+  }
+}
+
+SCENARIO("Verify FrozenWallet: freeze, find...", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  FrozenWallet frozen(wallet, wallet.idMode());
+  REQUIRE(frozen.size() == 1000);
+  REQUIRE(frozen.verify());
+
+  size_t misses = 0;
+  for (long n = 0; n < 1000; ++n) {
+    SampleKeyPair keyPair(n);
+    const KeyPairInterface *found = frozen.tryRetrieve(keyPair.keyPairId());
+    misses += found == nullptr
+              || found->publicKey() != keyPair.publicKey()
+              || frozen.tryFindByPublicKey(keyPair.publicKey()) != found
+              || frozen.tryFindByPrivateKey(keyPair.privateKey()) != found
+              || frozen.tryFindByPublicKeyId(keyPair.publicKeyId()) != found
+              || frozen.tryFindByPrivateKeyId(keyPair.privateKeyId()) != found;
+  }
+  REQUIRE(misses == 0);
+  REQUIRE(frozen.tryRetrieve(KeyPairId(12345)) == nullptr);
+  REQUIRE(frozen.tryFindByPublicKeyId(KeyPairId(12345)) == nullptr);
+  REQUIRE_THROWS_AS(frozen.findByPublicKey("some public key"), KeyPairNotFoundException);
+  REQUIRE_THROWS_AS(frozen.store(SampleKeyPair(5000)), WalletReadOnlyException);
+  REQUIRE_THROWS_AS(frozen.remove(SampleKeyPair(1).keyPairId()), WalletReadOnlyException);
+
+  KeyPairIdVector publicKeyIds = { SampleKeyPair(3).publicKeyId(), 424242 };
+  KeyPairBatch results;
+  frozen.findManyByPublicKeyId(publicKeyIds, results);
+  REQUIRE(results[0]->keyPairId() == SampleKeyPair(3).keyPairId());
+  REQUIRE(results[1] == nullptr);
+
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(frozen, 100);
+  while (pager.next()) seen.insert(pager.page().begin(), pager.page().end());
+  REQUIRE(seen.size() == 1000);
+}
+
+SCENARIO("Verify FrozenWallet: write, load, publicKeyId collisions", "[wallet]")
+{
+  string path = frozenFilePath("load");
+  Wallet wallet;
+  SampleKeyPair keyPair("key A", "secret A");
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), 1002, "key B", "secret B");
+  wallet.store(collision);
+  wallet.store(keyPair);
+  for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+  FrozenWallet(wallet, KeyPairIdMode::Crc32).write(path);
+
+  FrozenWallet loaded(path);
+  REQUIRE(loaded.size() == 102);
+  REQUIRE(loaded.verify());
+  REQUIRE(loaded.idMode() == KeyPairIdMode::Crc32);
+  REQUIRE(loaded.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+  REQUIRE(loaded.tryFindByPublicKeyId(keyPair.publicKeyId()) != nullptr);
+  REQUIRE(loaded.retrieve(1001).publicKey() == collision.publicKey());
+  REQUIRE(loaded.findByPrivateKey(SampleKeyPair(42).privateKey()).keyPairId() == SampleKeyPair(42).keyPairId());
+
+  Wallet empty;
+  FrozenWallet(empty, KeyPairIdMode::Crc32).write(path);
+  FrozenWallet none(path);
+  REQUIRE(none.size() == 0);
+  REQUIRE(none.tryRetrieve(keyPair.keyPairId()) == nullptr);
+  REQUIRE(none.tryFindByPublicKey("key A") == nullptr);
+  KeyPairIdVector keyPairIds;
+  REQUIRE(none.listPage(firstPage, 10, keyPairIds) == noMorePages);
+  remove(path.c_str());
+}
+
+SCENARIO("Verify FrozenWallet: damaged files are refused", "[wallet]")
+{
+  string path = frozenFilePath("damaged");
+  REQUIRE_THROWS_AS(FrozenWallet(path + ".missing"), WalletFileException);
+
+  Wallet wallet;
+  for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+  FrozenWallet frozen(wallet, KeyPairIdMode::Crc32);
+  frozen.write(path);
+  {
+    fstream file(path, ios::in | ios::out | ios::binary);
+    file.seekp(40);
+    file.put('\x7f');// inside the header
+  }
+  REQUIRE_THROWS_AS(FrozenWallet(path), WalletFileException);
+
+  frozen.write(path);
+  {
+    fstream file(path, ios::in | ios::out | ios::binary);
+    file.seekp(5000);
+    file.put('\x7f');// inside a record
+  }
+  FrozenWallet loaded(path);
+  REQUIRE_FALSE(loaded.verify());
+  remove(path.c_str());
+}
+
+SCENARIO("Verify FrozenWallet: records with damaged key sizes are not found", "[wallet]")
+{
+  string path = frozenFilePath("key-sizes");
+  Wallet wallet;
+  SampleKeyPair keyPair("key A", "secret A");
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), 1002, "key B", "secret B");
+  wallet.store(collision);
+  wallet.store(keyPair);
+  for (long n = 0; n < 100; ++n) wallet.store(SampleKeyPair(n));
+  FrozenWallet(wallet, KeyPairIdMode::Crc32).write(path);
+  SampleKeyPair damaged(42);
+  damageKeySizes(path, damaged.keyPairId());
+  damageKeySizes(path, collision.keyPairId());// one of an overflow list
+
+  FrozenWallet loaded(path);
+  REQUIRE_FALSE(loaded.verify());
+  REQUIRE(loaded.tryRetrieve(damaged.keyPairId()) == nullptr);
+  REQUIRE(loaded.tryFindByPublicKey(damaged.publicKey()) == nullptr);
+  REQUIRE(loaded.tryFindByPrivateKey(damaged.privateKey()) == nullptr);
+  REQUIRE(loaded.tryFindByPrivateKeyId(damaged.privateKeyId()) == nullptr);
+  REQUIRE(loaded.tryFindByPublicKey("key B") == nullptr);
+  REQUIRE(loaded.tryRetrieve(collision.keyPairId()) == nullptr);
+  REQUIRE(loaded.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(loaded.findByPrivateKey(SampleKeyPair(43).privateKey()).keyPairId() == SampleKeyPair(43).keyPairId());
+  remove(path.c_str());
+}
+
+SCENARIO("Verify FrozenWallet: frozen in locked memory", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  LockedMemoryResource &locked = *lockedMemoryResource();
+  size_t before = locked.stats().inUseBytes;
+  {
+    FrozenWallet frozen(wallet, KeyPairIdMode::Crc32);
+    REQUIRE(locked.stats().inUseBytes >= before + 1000 * sizeof(WalletFileRecord));
+    const KeyPairInterface &found = frozen.retrieve(SampleKeyPair(7).keyPairId());
+    REQUIRE(locked.locked(&found.privateKey()));
+  }
+  REQUIRE(locked.stats().inUseBytes == before);
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <set>
+#include <string>
+
+#include "../include/CppWallet/Hash64.hpp"
+#include "../include/CppWallet/KeyPairIds.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify Hash64: deterministic, seeded", "[hash64]")
+{
+  REQUIRE(hash64("public key") == hash64(string("public key")));
+  REQUIRE(hash64("public key") != hash64("public kez"));
+  REQUIRE(hash64("public key", 1) != hash64("public key", 2));
+}
+
+SCENARIO("Verify Hash64: every length", "[hash64]")
+{
+  string data;
+  set<uint64_t> seen;
+  for (size_t length = 0; length < 200; ++length) {
+    REQUIRE(seen.insert(hash64(data)).second);
+    data.push_back(static_cast<char>('a' + length % 26));
+  }
+  // a single flipped bit changes the value, (wherever it is)
+  string key(65, '\x42');
+  uint64_t value = hash64(key);
+  for (size_t i = 0; i < key.size(); ++i) {
+    string flipped = key;
+    flipped[i] ^= 1;
+    REQUIRE(hash64(flipped) != value);
+  }
+}
+
+SCENARIO("Verify KeyPairIds: KeyPairIdMode::Hash64", "[hash64]")
+{
+  KeyPairPublicKey publicKey = "public";
+  KeyPairPrivateKey privateKey = "private";
+  REQUIRE(publicKeyIdOf(publicKey, KeyPairIdMode::Hash64) == KeyPairId(hash64(publicKey)));
+  REQUIRE(privateKeyIdOf(privateKey, KeyPairIdMode::Hash64) == KeyPairId(hash64(privateKey)));
+  REQUIRE(keyPairIdOf(publicKey, privateKey, KeyPairIdMode::Hash64) != keyPairIdOf(publicKey, privateKey));
+}
@@ -0,0 +1,150 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/HdKeyChain.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string fromHex(const string &text)
+{
+  string bytes;
+  for (size_t i = 0; i < text.size(); i += 2) bytes += char(stoi(text.substr(i, 2), nullptr, 16));
+  return bytes;
+}
+
+static string bytesOf(const uint8_t *bytes, size_t size)
+{
+  return string(reinterpret_cast<const char *>(bytes), size);
+}
+
+struct Bip32Vector
+{
+  const char *path;
+  const char *chainCode;
+  const char *privateKey;
+  const char *publicKey;
+};
+
+// BIP32 test vector 1
+static const string seed1 = fromHex("000102030405060708090a0b0c0d0e0f");
+static const Bip32Vector vector1[] = {
+  { "m", "873dff81c02f525623fd1fe5167eac3a55a049de3d314bb42ee227ffed37d508",
+    "e8f32e723decf4051aefac8e2c93c9c5b214313817cdb01a1494b917c8436b35",
+    "0339a36013301597daef41fbe593a02cc513d0b55527ec2df1050e2e8ff49c85c2" },
+  { "m/0H", "47fdacbd0f1097043b78c63c20c34ef4ed9a111d980047ad16282c7ae6236141",
+    "edb2e14f9ee77d26dd93b4ecede8d16ed408ce149b6cd80b0715a2d911a0afea",
+    "035a784662a4a20a65bf6aab9ae98a6c068a81c52e4b032c0fb5400c706cfccc56" },
+  { "m/0H/1", "2a7857631386ba23dacac34180dd1983734e444fdbf774041578e9b6adb37c19",
+    "3c6cb8d0f6a264c91ea8b5030fadaa8e538b020f0a387421a12de9319dc93368",
+    "03501e454bf00751f24b1b489aa925215d66af2234e3891c3b21a52bedb3cd711c" },
+  { "m/0H/1/2H", "04466b9cc8e161e966409ca52986c584f07e9dc81f735db683c3ff6ec7b1503f",
+    "cbce0d719ecf7431d88e6a89fa1483e02e35092af60c042b1df2ff59fa424dca",
+    "0357bfe1e341d01c69fe5654309956cbea516822fba8a601743a012a7896ee8dc2" },
+  { "m/0H/1/2H/2", "cfb71883f01676f587d023cc53a35bc7f88f724b1f8c2892ac1275ac822a3edd",
+    "0f479245fb19a38a1954c5c7c0ebab2f9bdfd96a17563ef28a6a4b1a2a764ef4",
+    "02e8445082a72f29b75ca48748a914df60622a609cacfce8ed0e35804560741d29" },
+  { "m/0H/1/2H/2/1000000000", "c783e67b921d2beb8f6b389cc646d7263b4145701dadd2161548a8b078e65e9e",
+    "471b76e389e528d6de6d816857e012c5455051cad6660850e58372a6c3e6e7c8",
+    "022a471424da5e657499d1ff51cb43c47481a03b1e77f951fe64cec9f5a48f7011" },
+};
+
+SCENARIO("Verify HdKeyChain: paths", "[wallet]")
+{
+  REQUIRE(hdPath("m").empty());
+  REQUIRE(hdPath("m/44'/0'/0'/0/7") == HdPath{ 44 | hdHardened, hdHardened, hdHardened, 0, 7 });
+  REQUIRE(hdPath("M/0H/1h/2147483647") == HdPath{ hdHardened, 1 | hdHardened, 2147483647 });
+  REQUIRE(hdPathText(hdPath("m/44h/0/3'")) == "m/44'/0/3'");
+  for (const char *bad : { "", "44/0", "m/", "m//0", "m/x", "m/0/", "m/2147483648", "m/0''" })
+    REQUIRE_THROWS_AS(hdPath(bad), invalid_argument);
+}
+
+SCENARIO("Verify HdKeyChain: BIP32 test vectors", "[wallet]")
+{
+  HdKeyChain chain(seed1);
+  for (const auto &expected : vector1) {
+    const HdExtendedKey &key = chain.node(hdPath(expected.path));
+    REQUIRE(bytesOf(key.chainCode, 32) == fromHex(expected.chainCode));
+    REQUIRE(bytesOf(key.privateKey, 32) == fromHex(expected.privateKey));
+    REQUIRE(bytesOf(key.publicKey, 33) == fromHex(expected.publicKey));
+    REQUIRE(key.depth == hdPath(expected.path).size());
+
+    KeyPair keyPair = HdKeyChain(seed1).keyPair(hdPath(expected.path));
+    REQUIRE(keyPair.privateKey() == fromHex(expected.privateKey));
+    REQUIRE(keyPair.publicKey() == fromHex(expected.publicKey));
+    REQUIRE(keyPair.keyPairId() == keyPairIdOf(keyPair.publicKey(), keyPair.privateKey(), KeyPairIdMode::Crc32));
+  }
+
+  // BIP32 test vector 2, (a non-hardened index past 2^31 - 1 is hardened)
+  HdKeyChain chain2(fromHex("fffcf9f6f3f0edeae7e4e1dedbd8d5d2cfccc9c6c3c0bdbab7b4b1aeaba8a5a2"
+                            "9f9c999693908d8a8784817e7b7875726f6c696663605d5a5754514e4b484542"));
+  REQUIRE(chain2.keyPair(hdPath("m/0/2147483647'/1")).privateKey()
+          == fromHex("704addf544a06e5ee4bea37098463c23613da32020d604506da8c0518e1da4b7"));
+
+  REQUIRE_THROWS_AS(HdKeyChain(string(15, 'x')), invalid_argument);
+  REQUIRE_THROWS_AS(HdKeyChain(string(65, 'x')), invalid_argument);
+}
+
+SCENARIO("Verify HdKeyChain: a child is one step from its cached parent", "[wallet]")
+{
+  HdKeyChain chain(seed1, HdKeyChainOptions{ KeyPairIdMode::Hash64, 4096 });
+  HdPath receive = hdPath("m/44'/0'/0'/0");
+  vector<KeyPair> keyPairs;
+  chain.derive(receive, 0, 20, keyPairs);
+  REQUIRE(keyPairs.size() == 20);
+  REQUIRE(chain.stats().childSteps == 4 + 20);// the path once, then a step a child
+  REQUIRE(chain.stats().nodes == 5);// m, m/44', m/44'/0', m/44'/0'/0', m/44'/0'/0'/0
+
+  chain.derive(receive, 20, 20, keyPairs);
+  REQUIRE(chain.stats().childSteps == 4 + 40);
+  HdPath child = receive;
+  child.push_back(25);
+  REQUIRE(keyPairs[25].privateKey() == chain.keyPair(child).privateKey());
+  REQUIRE(keyPairs[25].keyPairId() == HdKeyChain(seed1, HdKeyChainOptions{ KeyPairIdMode::Hash64, 4096 }).keyPair(child).keyPairId());
+  REQUIRE(chain.stats().childSteps == 4 + 41);
+
+  chain.keyPair(hdPath("m/44'/0'/0'/1/0"));// a sibling chain, (one step from the account)
+  REQUIRE(chain.stats().childSteps == 4 + 41 + 2);
+
+  chain.clear();
+  REQUIRE(chain.stats().nodes == 1);
+  REQUIRE(chain.node(hdPath("m/0H")).depth == 1);
+
+  HdKeyChain small(seed1, HdKeyChainOptions{ KeyPairIdMode::Crc32, 3 });
+  small.node(hdPath("m/1/2/3"));
+  REQUIRE(small.stats().nodes == 4);
+  small.node(hdPath("m/4"));// full, emptied first
+  REQUIRE(small.stats().nodes == 2);
+}
+
+SCENARIO("Verify HdKeyChain: into a Wallet", "[wallet]")
+{
+  Wallet wallet;
+  HdKeyChain chain(seed1);
+  HdPath receive = hdPath("m/44'/0'/0'/0");
+  REQUIRE(chain.storeInto(wallet, receive, 0, 20) == 20);
+  REQUIRE(chain.storeInto(wallet, receive, 10, 20) == 10);// 10 .. 19 were there
+  REQUIRE(wallet.size() == 30);
+
+  HdPath child = receive;
+  child.push_back(29);
+  KeyPair keyPair = chain.keyPair(child);
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+}
+
+SCENARIO("Verify HdKeyChain: derive into locked memory", "[wallet]")
+{
+  HdKeyChain chain(seed1);
+  HdPath receive = hdPath("m/44'/0'/0'/0");
+  vector<KeyPair> plain;
+  chain.derive(receive, 0, 10, plain);
+
+  LockedMemoryResource locked;
+  std::pmr::vector<KeyPair> keyPairs(&locked);
+  chain.derive(receive, 0, 10, keyPairs);
+  REQUIRE(keyPairs.size() == 10);
+  REQUIRE(locked.stats().inUseBytes >= 10 * sizeof(KeyPair));
+  for (size_t i = 0; i < keyPairs.size(); ++i) REQUIRE(keyPairs[i].keyPairId() == plain[i].keyPairId());
+}
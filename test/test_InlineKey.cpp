@@ -0,0 +1,53 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "../include/CppWallet/InlineKey.hpp"
+#include "../include/CppWallet/KeyPairInterface.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify InlineKey: layout", "[inline_key]")
+{
+  REQUIRE(is_trivially_copyable<InlinePublicKey>::value);
+  REQUIRE(is_trivially_copyable<InlinePrivateKey>::value);
+  REQUIRE(sizeof(InlinePublicKey) == 66);
+  REQUIRE(sizeof(InlinePrivateKey) == 33);
+  REQUIRE(is_same<KeyPairPublicKey, InlinePublicKey>::value);
+  REQUIRE(is_same<KeyPairPrivateKey, InlinePrivateKey>::value);
+}
+
+SCENARIO("Verify InlineKey: conversions", "[inline_key]")
+{
+  string bytes("\x02\x79\xbe\x66\x00\x7e", 6);
+  KeyPairPublicKey publicKey = bytes;
+  REQUIRE(publicKey.size() == 6);
+  REQUIRE(publicKey.str() == bytes);
+  REQUIRE(string_view(publicKey) == string_view(bytes));
+  REQUIRE(publicKey == KeyPairPublicKey(string_view(bytes)));
+  REQUIRE(publicKey != KeyPairPublicKey("\x02\x79"));
+  REQUIRE(KeyPairPublicKey().empty());
+
+  KeyPairPrivateKey privateKey = publicKey;
+  REQUIRE(privateKey.view() == publicKey.view());
+
+  ostringstream out;
+  out << KeyPairPublicKey("abc");
+  REQUIRE(out.str() == "abc");
+}
+
+SCENARIO("Verify InlineKey: capacity", "[inline_key]")
+{
+  REQUIRE(KeyPairPrivateKey(string(32, 'k')).size() == 32);
+  REQUIRE(KeyPairPublicKey(string(65, 'k')).size() == 65);
+  REQUIRE_THROWS_AS(KeyPairPrivateKey(string(33, 'k')), length_error);
+  REQUIRE_THROWS_AS(KeyPairPublicKey(string(66, 'k')), length_error);
+
+  // a shorter key leaves no trace of a longer one
+  KeyPairPrivateKey key(string(32, 'k'));
+  key.assign("short");
+  REQUIRE(key == KeyPairPrivateKey("short"));
+  REQUIRE(key.data()[31] == '\0');
+}
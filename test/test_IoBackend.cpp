@@ -0,0 +1,92 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/IoBackend.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify IoBackend: batched writes, reads, short reads and errors", "[wallet]")
+{
+  for (IoBackendKind kind : { IoBackendKind::Pread, IoBackendKind::Uring }) {
+    auto io = makeIoBackend(kind, 4);
+    REQUIRE(io->queueDepth() <= 4);
+    string path = string("/tmp/cppwallet-test-io-") + nameOf(kind);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    REQUIRE(fd >= 0);
+
+    vector<string> blocks;
+    vector<IoRequest> writes;
+    for (int i = 0; i < 100; ++i) blocks.push_back(string(100, char('a' + i % 26)));
+    for (int i = 0; i < 100; ++i) writes.push_back(IoRequest{ fd, &blocks[i][0], 100, uint64_t(i) * 100, 0 });
+    REQUIRE(io->write(writes.data(), writes.size(), true) == 0);
+
+    vector<string> read(101, string(100, '\0'));
+    vector<IoRequest> reads;
+    for (int i = 100; i >= 0; --i) reads.push_back(IoRequest{ fd, &read[i][0], 100, uint64_t(i) * 100 + 50, 0 });
+    io->read(reads.data(), reads.size());
+    REQUIRE(reads[0].result == 0);// past the end
+    REQUIRE(reads[1].result == 50);// at the end
+    REQUIRE(read[99].substr(0, 50) == string(50, char('a' + 99 % 26)));
+    for (int i = 0; i < 99; ++i) {
+      REQUIRE(reads[100 - i].result == 100);
+      REQUIRE(read[i] == string(50, char('a' + i % 26)) + string(50, char('a' + (i + 1) % 26)));
+    }
+
+    IoRequest bad{ -1, &read[0][0], 100, 0, 0 };
+    io->read(&bad, 1);
+    REQUIRE(bad.result == -EBADF);
+    REQUIRE(io->write(&bad, 1, false) == -EBADF);
+    close(fd);
+    remove(path.c_str());
+  }
+}
+
+SCENARIO("Verify IoBackend: the sync follows writes continued after EAGAIN or a short write", "[wallet]")
+{
+  vector<IoRequest> writes;
+  vector<const IoRequest *> completions;// in order, (nullptr - the sync)
+  bool injected[2] = { false, false };
+  auto io = makeIoBackend(IoBackendKind::Uring, 8, [&](const IoRequest *request, int result) {
+    completions.push_back(request);
+    if (request == &writes[1] && !injected[0]) {
+      injected[0] = true;
+      this_thread::sleep_for(chrono::milliseconds(100));// time for a sync queued already to finish
+      return -EAGAIN;
+    }
+    if (request == &writes[2] && !injected[1] && result > 1) {
+      injected[1] = true;
+      return result / 2;
+    }
+    return result;
+  });
+  if (io->kind() != IoBackendKind::Uring) return;// no io_uring here
+
+  string path = "/tmp/cppwallet-test-io-again";
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  REQUIRE(fd >= 0);
+  vector<string> blocks;
+  for (int i = 0; i < 4; ++i) blocks.push_back(string(4096, char('a' + i)));
+  for (int i = 0; i < 4; ++i) writes.push_back(IoRequest{ fd, &blocks[i][0], 4096, uint64_t(i) * 4096, 0 });
+  REQUIRE(io->write(writes.data(), writes.size(), true) == 0);
+  REQUIRE(injected[0]);
+  REQUIRE(injected[1]);
+
+  // every write completed, (the continued ones twice), before the sync
+  REQUIRE(completions.size() == 4 + 2 + 1);
+  REQUIRE(completions.back() == nullptr);
+  for (size_t i = 0; i + 1 < completions.size(); ++i) REQUIRE(completions[i] != nullptr);
+
+  string read(4 * 4096, '\0');
+  REQUIRE(pread(fd, &read[0], read.size(), 0) == ssize_t(read.size()));
+  for (int i = 0; i < 4; ++i) REQUIRE(read.substr(size_t(i) * 4096, 4096) == blocks[i]);
+  close(fd);
+  remove(path.c_str());
+}
@@ -0,0 +1,57 @@
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "../include/CppWallet/KeyPair.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify KeyPair: layout", "[wallet]")
+{
+  REQUIRE(alignof(KeyPair) == 64);
+  REQUIRE(sizeof(KeyPair) == 192);
+  REQUIRE(is_trivially_destructible<KeyPair>::value);
+  REQUIRE(is_nothrow_copy_constructible<KeyPair>::value);
+  REQUIRE(is_nothrow_copy_assignable<KeyPair>::value);
+
+  vector<KeyPair> keyPairs;
+  for (long n = 0; n < 100; ++n) keyPairs.emplace_back(SampleKeyPair(n));
+  for (const auto &keyPair : keyPairs) REQUIRE(reinterpret_cast<uintptr_t>(&keyPair) % KeyPair::cacheLine == 0);
+}
+
+SCENARIO("Verify KeyPair: ids computed once, from the keys", "[wallet]")
+{
+  for (KeyPairIdMode mode : { KeyPairIdMode::Crc32, KeyPairIdMode::Hash64 }) {
+    SampleKeyPair sample(42, mode);
+    KeyPair keyPair(sample.publicKey(), sample.privateKey(), mode);
+    REQUIRE(keyPair.keyPairId() == sample.keyPairId());
+    REQUIRE(keyPair.publicKeyId() == sample.publicKeyId());
+    REQUIRE(keyPair.privateKeyId() == sample.privateKeyId());
+    REQUIRE(keyPair.publicKey() == sample.publicKey());
+    REQUIRE(keyPair.privateKey() == sample.privateKey());
+    REQUIRE(keyPair.generate({}) == keyPair.keyPairId());
+  }
+  KeyPair keyPair("public", "private");
+  REQUIRE(keyPair.publicKeyId() == publicKeyIdOf("public"));
+  REQUIRE(&keyPair.publicKeyId() == &keyPair.publicKeyId());
+}
+
+SCENARIO("Verify KeyPair: a copy of any KeyPairInterface", "[wallet]")
+{
+  SampleKeyPair collision(1001, 7, 8, "key B", "secret B");
+  KeyPair keyPair(collision);
+  REQUIRE(keyPair.keyPairId() == 1001);
+  REQUIRE(keyPair.publicKeyId() == 7);
+  REQUIRE(keyPair.privateKeyId() == 8);
+
+  const KeyPairInterface &any = keyPair;
+  KeyPair copy(any);
+  REQUIRE(copy.publicKey() == "key B");
+
+  KeyPair other("public", "private");
+  other = copy;
+  REQUIRE(other.keyPairId() == 1001);
+  REQUIRE(other.privateKey() == "secret B");
+}
@@ -0,0 +1,99 @@
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/CppWallet/KeyPairGenerator.hpp"
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static vector<KeyPairSeedList> sampleSeedLists(size_t count)
+{
+  vector<KeyPairSeedList> seedLists;
+  for (size_t n = 0; n < count; ++n) seedLists.push_back({ "account", to_string(n), "2026-10-17" });
+  return seedLists;
+}
+
+SCENARIO("Verify KeyPairGenerator: KeyPairs with their public keys and ids", "[wallet]")
+{
+  for (KeyPairIdMode mode : { KeyPairIdMode::Crc32, KeyPairIdMode::Hash64 }) {
+    KeyPairGenerator generator(KeyPairGeneratorOptions{ 3, mode, 7, false });
+    REQUIRE(generator.threads() == 3);
+    vector<KeyPair> keyPairs;
+    generator.generate(sampleSeedLists(100), keyPairs);
+    REQUIRE(keyPairs.size() == 100);
+    set<string> privateKeys;
+    for (const auto &keyPair : keyPairs) {
+      REQUIRE(keyPair.privateKey().size() == secp256k1PrivateKeyBytes);
+      REQUIRE(keyPair.publicKey() == secp256k1PublicKey(keyPair.privateKey()));
+      REQUIRE(keyPair.keyPairId() == keyPairIdOf(keyPair.publicKey(), keyPair.privateKey(), mode));
+      REQUIRE(keyPair.publicKeyId() == publicKeyIdOf(keyPair.publicKey(), mode));
+      REQUIRE(keyPair.privateKeyId() == privateKeyIdOf(keyPair.privateKey(), mode));
+      privateKeys.insert(string(keyPair.privateKey().view()));
+    }
+    REQUIRE(privateKeys.size() == 100);
+
+    KeyPair one = generator.generate({ "account", "0", "2026-10-17" });
+    REQUIRE(one.publicKey() == secp256k1PublicKey(one.privateKey()));
+    REQUIRE(one.privateKey() != keyPairs[0].privateKey());// fresh entropy every time
+  }
+}
+
+SCENARIO("Verify KeyPairGenerator: deterministic, (whatever the threads)", "[wallet]")
+{
+  vector<KeyPair> alone, pooled, repeated;
+  KeyPairGenerator(KeyPairGeneratorOptions{ 1, KeyPairIdMode::Crc32, 256, true }).generate(sampleSeedLists(50), alone);
+  KeyPairGenerator generator(KeyPairGeneratorOptions{ 4, KeyPairIdMode::Crc32, 3, true });
+  generator.generate(sampleSeedLists(50), pooled);
+  REQUIRE(pooled.size() == alone.size());
+  for (size_t i = 0; i < alone.size(); ++i) {
+    REQUIRE(pooled[i].privateKey() == alone[i].privateKey());
+    REQUIRE(pooled[i].keyPairId() == alone[i].keyPairId());
+  }
+  REQUIRE(generator.generate(sampleSeedLists(50)[17]).privateKey() == alone[17].privateKey());
+
+  // the seeds hashed with their lengths
+  REQUIRE(generator.generate({ "ab", "c" }).privateKey() != generator.generate({ "a", "bc" }).privateKey());
+
+  // the same seeds, one KeyPair per position
+  generator.generate(40, { "account" }, repeated);
+  REQUIRE(repeated.size() == 40);
+  set<string> privateKeys;
+  for (const auto &keyPair : repeated) privateKeys.insert(string(keyPair.privateKey().view()));
+  REQUIRE(privateKeys.size() == 40);
+  generator.generate(0, { "account" }, repeated);
+  REQUIRE(repeated.empty());
+}
+
+SCENARIO("Verify KeyPairGenerator: one pool, batch after batch", "[wallet]")
+{
+  KeyPairGenerator generator(KeyPairGeneratorOptions{ 4, KeyPairIdMode::Hash64, 1, false });
+  vector<KeyPair> keyPairs;
+  for (size_t count : { 0, 1, 2, 5, 33, 200 }) {
+    generator.generate(count, { "onboarding" }, keyPairs);
+    REQUIRE(keyPairs.size() == count);
+    for (const auto &keyPair : keyPairs) REQUIRE(keyPair.publicKey().size() == secp256k1PublicKeyBytes);
+  }
+}
+
+SCENARIO("Verify KeyPairGenerator: into locked memory", "[wallet]")
+{
+  KeyPairGenerator generator(KeyPairGeneratorOptions{ 2, KeyPairIdMode::Crc32, 5, true });
+  vector<KeyPair> plain;
+  generator.generate(sampleSeedLists(30), plain);
+
+  LockedMemoryResource locked;
+  std::pmr::vector<KeyPair> keyPairs(&locked);
+  generator.generate(sampleSeedLists(30), keyPairs);
+  REQUIRE(keyPairs.size() == 30);
+  REQUIRE(locked.stats().inUseBytes >= 30 * sizeof(KeyPair));
+  for (size_t i = 0; i < keyPairs.size(); ++i) REQUIRE(keyPairs[i].privateKey() == plain[i].privateKey());
+
+  generator.generate(12, { "account" }, keyPairs);
+  REQUIRE(keyPairs.size() == 12);
+  REQUIRE(keyPairs[3].publicKey() == secp256k1PublicKey(keyPairs[3].privateKey()));
+  for (auto &keyPair : plain) keyPair.wipe();
+  REQUIRE(plain[0].privateKey().empty());
+}
@@ -0,0 +1,193 @@
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../include/CppWallet/Epoch.hpp"
+#include "../include/CppWallet/EpochWallet.hpp"
+#include "../include/CppWallet/KeyPair.hpp"
+#include "../include/CppWallet/LockedMemory.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static bool allZero(const void *data, size_t size)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i)
+    if (bytes[i] != 0) return false;
+  return true;
+}
+
+// whether writing to address kills a child process with SIGSEGV
+static bool faults(char *address)
+{
+  pid_t child = ::fork();
+  if (child == 0) {
+    ::signal(SIGSEGV, SIG_DFL);
+    *static_cast<volatile char *>(address) = 1;
+    ::_exit(0);
+  }
+  int status = 0;
+  ::waitpid(child, &status, 0);
+  return WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV;
+}
+
+SCENARIO("Verify LockedMemoryResource: size classes, reuse, wiping", "[wallet]")
+{
+  LockedMemoryResource resource(LockedMemoryOptions{ 64 * 1024, false });
+  set<void *> blocks;
+  for (size_t n = 0; n < 1000; ++n) {
+    size_t bytes = 1 + n % 300;
+    char *block = static_cast<char *>(resource.allocate(bytes, 8));
+    REQUIRE(reinterpret_cast<uintptr_t>(block) % 8 == 0);
+    REQUIRE(allZero(block, bytes));
+    memset(block, 0xA5, bytes);
+    blocks.insert(block);
+    resource.deallocate(block, bytes, 8);
+    REQUIRE(allZero(block + sizeof(void *), bytes > sizeof(void *) ? bytes - sizeof(void *) : 0));
+  }
+  REQUIRE(blocks.size() < 10);// one block per size class, over and over
+  REQUIRE(resource.stats().inUseBytes == 0);
+
+  vector<void *> live;
+  for (size_t n = 0; n < 5000; ++n) live.push_back(resource.allocate(48, 16));
+  REQUIRE(set<void *>(live.begin(), live.end()).size() == live.size());
+  LockedMemoryStats stats = resource.stats();
+  REQUIRE(stats.inUseBytes == 5000 * 64);
+  REQUIRE(stats.mappings == 5);// 64 KiB slabs, (not a mapping per block)
+  REQUIRE(stats.mappedBytes == 5 * 64 * 1024);
+  REQUIRE(stats.lockedBytes + stats.lockFailures * 64 * 1024 == stats.mappedBytes);
+  for (void *block : live) resource.deallocate(block, 48, 16);
+
+  void *page = resource.allocate(8192, 4096);
+  REQUIRE(reinterpret_cast<uintptr_t>(page) % 4096 == 0);
+  REQUIRE(resource.stats().mappings == 6);
+  resource.deallocate(page, 8192, 4096);
+  REQUIRE(resource.stats().mappings == 5);
+
+  REQUIRE_THROWS_AS(LockedMemoryResource(LockedMemoryOptions{ 1000, false }), invalid_argument);
+  REQUIRE(lockedMemoryResource() == lockedMemoryResource());
+  REQUIRE(lockedMemoryResource()->is_equal(*lockedMemoryResource()));
+  REQUIRE_FALSE(resource.is_equal(*lockedMemoryResource()));
+}
+
+SCENARIO("Verify LockedMemoryResource: guard pages", "[wallet]")
+{
+  LockedMemoryResource resource;
+  size_t page = size_t(::sysconf(_SC_PAGESIZE));
+  char *large = static_cast<char *>(resource.allocate(3 * page, 64));
+  large[0] = 1;
+  large[3 * page - 1] = 1;
+  REQUIRE(faults(large - 1));
+  REQUIRE(faults(large + 3 * page));
+  resource.deallocate(large, 3 * page, 64);
+
+  char *small = static_cast<char *>(resource.allocate(16, 16));
+  REQUIRE(faults(small - 1));// the first block of a slab
+  resource.deallocate(small, 16, 16);
+}
+
+SCENARIO("Verify LockedMemoryResource: Wallet records and KeyPairs", "[wallet]")
+{
+  LockedMemoryResource locked;
+  {
+    Wallet wallet(KeyPairIdMode::Hash64, 0, &locked, std::pmr::get_default_resource());
+    for (long n = 0; n < 3000; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    // the record slabs, (and their slot bookkeeping), the indexes are elsewhere
+    REQUIRE(locked.stats().inUseBytes >= wallet.stats().recordBytes);
+    REQUIRE(locked.stats().inUseBytes < wallet.stats().recordBytes + 16 * 1024);
+
+    SampleKeyPair keyPair(7, KeyPairIdMode::Hash64);
+    const KeyPairInterface *record = &wallet.retrieve(keyPair.keyPairId());
+    REQUIRE(record->privateKey() == keyPair.privateKey());
+    wallet.remove(keyPair.keyPairId());
+    REQUIRE(allZero(record, sizeof(KeyPairRecord)));// wiped on remove()
+    REQUIRE(wallet.findByPrivateKey(SampleKeyPair(8, KeyPairIdMode::Hash64).privateKey()).keyPairId()
+            == SampleKeyPair(8, KeyPairIdMode::Hash64).keyPairId());
+  }
+  REQUIRE(locked.stats().inUseBytes == 0);
+
+  std::pmr::vector<KeyPair> keyPairs(&locked);
+  for (long n = 0; n < 100; ++n) keyPairs.emplace_back(SampleKeyPair(n));
+  REQUIRE(reinterpret_cast<uintptr_t>(keyPairs.data()) % KeyPair::cacheLine == 0);
+  REQUIRE(keyPairs[42].keyPairId() == SampleKeyPair(42).keyPairId());
+  REQUIRE(locked.stats().inUseBytes >= 100 * sizeof(KeyPair));
+}
+
+SCENARIO("Verify LockedMemoryResource: the default for Wallet, EpochWallet records", "[wallet]")
+{
+  LockedMemoryResource &locked = *lockedMemoryResource();
+  EpochDomain &epochs = EpochDomain::instance();
+  epochs.quiesce();
+  epochs.collect();
+  size_t before = locked.stats().inUseBytes;
+  {
+    Wallet wallet(KeyPairIdMode::Hash64);
+    EpochWallet epochWallet(KeyPairIdMode::Hash64);
+    for (long n = 0; n < 1000; ++n) {
+      wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+      epochWallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    }
+    REQUIRE(locked.stats().inUseBytes >= before + 2000 * sizeof(KeyPairRecord));
+    for (long n = 0; n < 500; ++n) epochWallet.remove(SampleKeyPair(n, KeyPairIdMode::Hash64).keyPairId());
+  }
+  epochs.quiesce();
+  epochs.collect();
+  REQUIRE(locked.stats().inUseBytes == before);
+}
+
+SCENARIO("Verify InlineKey, KeyPair: wipe()", "[wallet]")
+{
+  SampleKeyPair sample(42);
+  KeyPairPrivateKey key = sample.privateKey();
+  key.wipe();
+  REQUIRE(key.size() == 0);
+  REQUIRE(allZero(key.data(), KeyPairPrivateKey::capacity));
+
+  KeyPair keyPair(sample);
+  keyPair.wipe();
+  REQUIRE(keyPair.privateKey().size() == 0);
+  REQUIRE(keyPair.publicKey().size() == 0);
+  REQUIRE(allZero(keyPair.privateKey().data(), KeyPairPrivateKey::capacity));
+  REQUIRE(allZero(&keyPair.keyPairId(), sizeof(KeyPairId)));
+  REQUIRE(allZero(&keyPair.privateKeyId(), sizeof(KeyPairId)));
+}
+
+SCENARIO("Verify LockedMemoryResource: maxLockedBytes, unlocked Wallet records reported", "[wallet]")
+{
+  LockedMemoryOptions options;
+  options.maxLockedBytes = 2 * RecordArena<KeyPairRecord>::slabBytes;
+  LockedMemoryResource locked(options);
+  Wallet wallet(KeyPairIdMode::Hash64, 0, &locked, std::pmr::get_default_resource());
+  for (long n = 0; n < long(RecordArena<KeyPairRecord>::slabRecords); ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+  REQUIRE(wallet.stats().unlockedRecordBytes == 0);
+  REQUIRE(locked.locked(&wallet.retrieve(SampleKeyPair(0, KeyPairIdMode::Hash64).keyPairId())));
+
+  // the slabs past the budget go on unlocked, and say so
+  for (long n = long(RecordArena<KeyPairRecord>::slabRecords); n < 3 * long(RecordArena<KeyPairRecord>::slabRecords); ++n)
+    wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+  WalletStats stats = wallet.stats();
+  REQUIRE(stats.recordBytes == 3 * RecordArena<KeyPairRecord>::slabBytes);
+  REQUIRE(stats.unlockedRecordBytes > 0);
+  REQUIRE(locked.stats().lockFailures > 0);
+  REQUIRE(locked.stats().lockedBytes <= options.maxLockedBytes);
+  const KeyPairInterface &last = wallet.retrieve(SampleKeyPair(3 * long(RecordArena<KeyPairRecord>::slabRecords) - 1, KeyPairIdMode::Hash64).keyPairId());
+  REQUIRE_FALSE(locked.locked(&last));
+  REQUIRE_FALSE(locked.locked(&stats));// not from this resource
+
+  options.requireLock = true;
+  LockedMemoryResource strict(options);
+  void *within = strict.allocate(options.maxLockedBytes / 2, 64);
+  REQUIRE(strict.locked(within));
+  REQUIRE_THROWS_AS(strict.allocate(options.maxLockedBytes, 64), std::system_error);
+  strict.deallocate(within, options.maxLockedBytes / 2, 64);
+}
@@ -0,0 +1,174 @@
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/Crc32.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "../include/CppWallet/MappedWallet.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string walletFilePath(const string &name)
+{
+  return "/tmp/cppwallet-test-" + name + ".wallet";
+}
+
+// have the record of keyPairId claim 255 byte keys, (an InlineKey starts with its size)
+static void damageKeySizes(const string &path, const KeyPairId &keyPairId)
+{
+  fstream file(path, ios::in | ios::out | ios::binary);
+  WalletFileHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  for (uint64_t slot = 0; slot < header.count; ++slot) {
+    uint64_t offset = header.recordsOffset + slot * sizeof(WalletFileRecord);
+    WalletFileRecord record;
+    file.seekg(streamoff(offset));
+    file.read(reinterpret_cast<char *>(&record), sizeof(record));
+    if (record.keyPairId != keyPairId) continue;
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, publicKey)));
+    file.put('\xff');
+    file.seekp(streamoff(offset + offsetof(WalletFileRecord, privateKey)));
+    file.put('\xff');
+  }
+}
+
+SCENARIO("Verify MappedWallet: write, map, find...", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  string path = walletFilePath("find");
+  WalletFileWriter writer;
+  writer.addAll(wallet);
+  writer.write(path);
+
+  MappedWallet mapped(path);
+  REQUIRE(mapped.size() == 1000);
+  REQUIRE(mapped.verify());
+  SampleKeyPair keyPair(421);
+  const KeyPairInterface &found = mapped.retrieve(keyPair.keyPairId());
+  REQUIRE(found.publicKey() == keyPair.publicKey());
+  REQUIRE(found.privateKey() == keyPair.privateKey());
+  REQUIRE(&mapped.findByPublicKey(keyPair.publicKey()) == &found);
+  REQUIRE(&mapped.findByPrivateKey(keyPair.privateKey()) == &found);
+  REQUIRE(&mapped.findByPublicKeyId(keyPair.publicKeyId()) == &found);
+  REQUIRE(&mapped.findByPrivateKeyId(keyPair.privateKeyId()) == &found);
+  REQUIRE(mapped.tryRetrieve(KeyPairId(12345)) == nullptr);
+  REQUIRE_THROWS_AS(mapped.findByPublicKey("some public key"), KeyPairNotFoundException);
+  REQUIRE_THROWS_AS(mapped.store(SampleKeyPair(5000)), WalletReadOnlyException);
+  REQUIRE_THROWS_AS(mapped.remove(keyPair.keyPairId()), WalletReadOnlyException);
+
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(mapped, 100);
+  while (pager.next()) seen.insert(pager.page().begin(), pager.page().end());
+  REQUIRE(seen.size() == 1000);
+  remove(path.c_str());
+}
+
+SCENARIO("Verify MappedWallet: publicKeyId collisions, empty files", "[wallet]")
+{
+  string path = walletFilePath("collisions");
+  SampleKeyPair keyPair("key A", "secret A");
+  SampleKeyPair collision(1001, keyPair.publicKeyId(), 1002, "key B", "secret B");
+  WalletFileWriter writer(KeyPairIdMode::Crc32);
+  writer.add(collision);
+  writer.add(keyPair);
+  writer.write(path);
+  {
+    MappedWallet mapped(path);
+    REQUIRE(mapped.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+    REQUIRE(mapped.retrieve(1001).publicKey() == collision.publicKey());
+  }
+
+  WalletFileWriter().write(path);
+  MappedWallet empty(path);
+  REQUIRE(empty.size() == 0);
+  REQUIRE(empty.tryRetrieve(keyPair.keyPairId()) == nullptr);
+  KeyPairIdVector keyPairIds;
+  REQUIRE(empty.listPage(firstPage, 10, keyPairIds) == noMorePages);
+  remove(path.c_str());
+}
+
+SCENARIO("Verify MappedWallet: damaged files are refused", "[wallet]")
+{
+  string path = walletFilePath("damaged");
+  REQUIRE_THROWS_AS(MappedWallet(path + ".missing"), WalletFileException);
+
+  WalletFileWriter writer;
+  for (long n = 0; n < 100; ++n) writer.add(SampleKeyPair(n));
+  writer.write(path);
+  {
+    fstream file(path, ios::in | ios::out | ios::binary);
+    file.seekp(20);
+    file.put('\x7f');// inside the header
+  }
+  REQUIRE_THROWS_AS(MappedWallet(path), WalletFileException);
+
+  writer.write(path);
+  {
+    fstream file(path, ios::in | ios::out | ios::binary);
+    file.seekp(5000);
+    file.put('\x7f');// inside a record
+  }
+  MappedWallet mapped(path);
+  REQUIRE_FALSE(mapped.verify());
+  remove(path.c_str());
+}
+
+SCENARIO("Verify MappedWallet: section offsets that wrap or are misaligned are refused", "[wallet]")
+{
+  string path = walletFilePath("offsets");
+  WalletFileWriter writer;
+  for (long n = 0; n < 100; ++n) writer.add(SampleKeyPair(n));
+  writer.write(path);
+  WalletFileHeader header;
+  {
+    ifstream file(path, ios::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  }
+  REQUIRE(checkWalletFileHeader(header, header.fileSize).empty());
+
+  // offset + bucketCount * sizeof(WalletFileEntry) wraps to 8
+  WalletFileHeader wrapped = header;
+  wrapped.byKeyPairIdOffset = 8 - wrapped.bucketCount * sizeof(WalletFileEntry);
+  wrapped.headerChecksum = crc32(&wrapped, offsetof(WalletFileHeader, headerChecksum));
+  REQUIRE(checkWalletFileHeader(wrapped, wrapped.fileSize) == "inconsistent Wallet file header");
+  {
+    fstream file(path, ios::in | ios::out | ios::binary);
+    file.write(reinterpret_cast<const char *>(&wrapped), sizeof(wrapped));
+  }
+  REQUIRE_THROWS_AS(MappedWallet(path), WalletFileException);
+
+  WalletFileHeader misaligned = header;
+  misaligned.recordsOffset += 4;
+  misaligned.headerChecksum = crc32(&misaligned, offsetof(WalletFileHeader, headerChecksum));
+  REQUIRE(checkWalletFileHeader(misaligned, misaligned.fileSize) == "inconsistent Wallet file header");
+  remove(path.c_str());
+}
+
+SCENARIO("Verify MappedWallet: records with damaged key sizes are not found", "[wallet]")
+{
+  string path = walletFilePath("key-sizes");
+  WalletFileWriter writer;
+  for (long n = 0; n < 100; ++n) writer.add(SampleKeyPair(n));
+  writer.write(path);
+  SampleKeyPair damaged(99), intact(98);// the last record, (its keys would run off the records)
+  damageKeySizes(path, damaged.keyPairId());
+
+  MappedWallet mapped(path);
+  REQUIRE_FALSE(mapped.verify());
+  REQUIRE(mapped.tryRetrieve(damaged.keyPairId()) == nullptr);
+  REQUIRE(mapped.tryFindByPublicKey(damaged.publicKey()) == nullptr);
+  REQUIRE(mapped.tryFindByPublicKeyId(damaged.publicKeyId()) == nullptr);
+  REQUIRE(mapped.tryFindByPrivateKey(damaged.privateKey()) == nullptr);
+  REQUIRE(mapped.tryFindByPrivateKeyId(damaged.privateKeyId()) == nullptr);
+  REQUIRE_THROWS_AS(mapped.retrieve(damaged.keyPairId()), KeyPairNotFoundException);
+  REQUIRE(mapped.findByPrivateKey(intact.privateKey()).keyPairId() == intact.keyPairId());
+  remove(path.c_str());
+}
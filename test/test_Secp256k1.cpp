@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "../include/CppWallet/Secp256k1.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string fromHex(const string &text)
+{
+  string bytes;
+  for (size_t i = 0; i < text.size(); i += 2) bytes += char(stoi(text.substr(i, 2), nullptr, 16));
+  return bytes;
+}
+
+static KeyPairPrivateKey scalar(uint8_t last)
+{
+  string bytes(32, '\0');
+  bytes[31] = char(last);
+  return bytes;
+}
+
+static const string curveOrder = fromHex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141");
+
+SCENARIO("Verify Secp256k1: multiples of the generator", "[wallet]")
+{
+  REQUIRE(secp256k1PublicKey(scalar(1)) == fromHex("0279BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798"));
+  REQUIRE(secp256k1PublicKey(scalar(2)) == fromHex("02C6047F9441ED7D6D3045406E95C07CD85C778E4B8CEF3CA7ABAC09B95C709EE5"));
+  REQUIRE(secp256k1PublicKey(scalar(3)) == fromHex("02F9308A019258C31049344F85F89D5229B531C845836F99B08601F113BCE036F9"));
+  REQUIRE(secp256k1PublicKey(scalar(16)) == fromHex("03E60FCE93B59E9EC53011AABC21C23E97B2A31369B87A5AE9C44EE89E2A6DEC0A"));
+
+  string last = curveOrder;
+  last[31] = char(last[31] - 1);// n - 1 = -1, (-G: same x, the other y)
+  REQUIRE(secp256k1PublicKey(KeyPairPrivateKey(last))
+          == fromHex("0379BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798"));
+  string key = "7F";
+  for (int i = 0; i < 31; ++i) key += "AB";
+  REQUIRE(secp256k1PublicKey(KeyPairPrivateKey(fromHex(key)))
+          == fromHex("03EC09CDA438DAA7EF770632942A47698AC87B1D004AD7E70C051C33F216F66699"));
+}
+
+SCENARIO("Verify Secp256k1: private keys in [1, n)", "[wallet]")
+{
+  auto bytes = [](const string &key) { return reinterpret_cast<const uint8_t *>(key.data()); };
+  REQUIRE_FALSE(secp256k1ValidPrivateKey(bytes(string(32, '\0'))));
+  REQUIRE(secp256k1ValidPrivateKey(bytes(string(scalar(1).view()))));
+  REQUIRE_FALSE(secp256k1ValidPrivateKey(bytes(curveOrder)));
+  REQUIRE_FALSE(secp256k1ValidPrivateKey(bytes(string(32, '\xff'))));
+  string below = curveOrder;
+  below[31] = char(below[31] - 1);
+  REQUIRE(secp256k1ValidPrivateKey(bytes(below)));
+
+  uint8_t publicKey[secp256k1PublicKeyBytes] = {};
+  REQUIRE_FALSE(secp256k1PublicKey(bytes(curveOrder), publicKey));
+  REQUIRE(publicKey[0] == 0);
+  REQUIRE_THROWS_AS(secp256k1PublicKey(KeyPairPrivateKey(curveOrder)), invalid_argument);
+  REQUIRE_THROWS_AS(secp256k1PublicKey(KeyPairPrivateKey("short")), invalid_argument);
+}
+
+SCENARIO("Verify Secp256k1: every engine agrees", "[wallet]")
+{
+  uint8_t privateKey[secp256k1PrivateKeyBytes], window[secp256k1PublicKeyBytes], comb[secp256k1PublicKeyBytes];
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  for (int n = 0; n < 300; ++n) {
+    for (auto &byte : privateKey) {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      byte = uint8_t(seed >> 56);
+    }
+    if (n % 3 == 1) memset(privateKey, 0, 24);// digits of 0, (the comb adds nothing)
+    if (n % 5 == 2) memset(privateKey + 8, 0xff, 8);// and of 15
+    bool valid = secp256k1ValidPrivateKey(privateKey);
+    REQUIRE(secp256k1PublicKeyWith(Secp256k1Engine::Window, privateKey, window) == valid);
+    REQUIRE(secp256k1PublicKeyWith(Secp256k1Engine::Comb, privateKey, comb) == valid);
+    if (valid) REQUIRE(memcmp(window, comb, sizeof(comb)) == 0);
+  }
+
+  secp256k1Precompute();
+  memset(privateKey, 0, sizeof(privateKey));
+  privateKey[0] = 0x10;// 16^63 * G, (the last window of the comb)
+  REQUIRE(secp256k1PublicKeyWith(Secp256k1Engine::Comb, privateKey, comb));
+  REQUIRE(secp256k1PublicKeyWith(Secp256k1Engine::Window, privateKey, window));
+  REQUIRE(memcmp(window, comb, sizeof(comb)) == 0);
+}
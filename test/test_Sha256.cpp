@@ -0,0 +1,40 @@
+#include <string>
+
+#include "../include/CppWallet/Sha256.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string hex(const Sha256Digest &digest)
+{
+  static const char digits[] = "0123456789abcdef";
+  string text;
+  for (auto byte : digest) {
+    text += digits[byte >> 4];
+    text += digits[byte & 15];
+  }
+  return text;
+}
+
+SCENARIO("Verify Sha256: known values", "[wallet]")
+{
+  REQUIRE(hex(sha256("")) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  REQUIRE(hex(sha256("abc")) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  REQUIRE(hex(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"))
+          == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+  REQUIRE(hex(sha256(string(1000000, 'a'))) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+SCENARIO("Verify Sha256: piecewise", "[wallet]")
+{
+  string text(300, '\0');
+  for (size_t i = 0; i < text.size(); ++i) text[i] = char(i * 7);
+  for (size_t cut = 0; cut <= text.size(); cut += 13) {
+    Sha256 hash;
+    hash.update(string_view(text).substr(0, cut));
+    hash.update(string_view(text).substr(cut));
+    REQUIRE(hash.finish() == sha256(text));
+    hash.update(text);// ready for the next message
+    REQUIRE(hash.finish() == sha256(text));
+  }
+}
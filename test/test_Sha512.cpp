@@ -0,0 +1,53 @@
+#include <string>
+
+#include "../include/CppWallet/Sha512.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+static string hex(const Sha512Digest &digest)
+{
+  static const char digits[] = "0123456789abcdef";
+  string text;
+  for (auto byte : digest) {
+    text += digits[byte >> 4];
+    text += digits[byte & 15];
+  }
+  return text;
+}
+
+SCENARIO("Verify Sha512: known values", "[wallet]")
+{
+  REQUIRE(hex(sha512(""))
+          == "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+             "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e");
+  REQUIRE(hex(sha512("abc"))
+          == "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+             "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+  REQUIRE(hex(sha512(string(1000000, 'a')))
+          == "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+             "de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b");
+
+  string text(500, '\0');
+  for (size_t i = 0; i < text.size(); ++i) text[i] = char(i * 13);
+  for (size_t cut = 0; cut <= text.size(); cut += 17) {
+    Sha512 hash;
+    hash.update(string_view(text).substr(0, cut));
+    hash.update(string_view(text).substr(cut));
+    REQUIRE(hash.finish() == sha512(text));
+  }
+}
+
+SCENARIO("Verify Sha512: HMAC-SHA512, (RFC 4231)", "[wallet]")
+{
+  string data = "what do ya want for nothing?";
+  REQUIRE(hex(hmacSha512("Jefe", 4, data.data(), data.size()))
+          == "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+             "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737");
+
+  string key(131, '\xaa');// longer than a block, (hashed first)
+  data = "Test Using Larger Than Block-Size Key - Hash Key First";
+  REQUIRE(hex(hmacSha512(key.data(), key.size(), data.data(), data.size()))
+          == "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f352"
+             "6b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598");
+}
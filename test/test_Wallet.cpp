@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <iostream>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <vector>
+#include <extras/interfaces.hpp>
+
+#include "../include/CppWallet/BloomFilter.hpp"
+#include "../include/CppWallet/KeyPairIdPager.hpp"
+#include "../include/CppWallet/Wallet.hpp"
+#include "SampleKeyPair.hpp"
+#include "catch.hpp"
+
+using namespace std;
+
+SCENARIO("Verify Wallet: store, retrieve", "[wallet]")
+{
+  Wallet wallet;
+  SampleKeyPair keyPair(1);
+  REQUIRE(wallet.store(keyPair) == keyPair.keyPairId());
+  REQUIRE(wallet.size() == 1);
+  const KeyPairInterface &stored = wallet.retrieve(keyPair.keyPairId());
+  REQUIRE(stored.publicKey() == keyPair.publicKey());
+  REQUIRE(stored.privateKey() == keyPair.privateKey());
+  REQUIRE(stored.publicKeyId() == keyPair.publicKeyId());
+  REQUIRE(stored.privateKeyId() == keyPair.privateKeyId());
+  REQUIRE_THROWS_AS(wallet.retrieve(KeyPairId(12345)), KeyPairNotFoundException);
+}
+
+SCENARIO("Verify Wallet: KeyPairAlreadyExistsException", "[wallet]")
+{
+  Wallet wallet;
+  wallet.store(SampleKeyPair(1));
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(1)), KeyPairAlreadyExistsException);
+  REQUIRE(wallet.size() == 1);
+}
+
+SCENARIO("Verify Wallet: remove", "[wallet]")
+{
+  Wallet wallet;
+  wallet.store(SampleKeyPair(1));
+  wallet.store(SampleKeyPair(2));
+  wallet.remove(SampleKeyPair(1).keyPairId());
+  REQUIRE(wallet.size() == 1);
+  REQUIRE_THROWS_AS(wallet.retrieve(SampleKeyPair(1).keyPairId()), KeyPairNotFoundException);
+  REQUIRE_THROWS_AS(wallet.findByPublicKeyId(SampleKeyPair(1).publicKeyId()), KeyPairNotFoundException);
+  REQUIRE_THROWS_AS(wallet.remove(SampleKeyPair(1).keyPairId()), KeyPairNotFoundException);
+  REQUIRE(wallet.retrieve(SampleKeyPair(2).keyPairId()).publicKey() == SampleKeyPair(2).publicKey());
+  wallet.store(SampleKeyPair(1));
+  REQUIRE(wallet.size() == 2);
+}
+
+SCENARIO("Verify Wallet: find...", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  SampleKeyPair keyPair(421);
+  REQUIRE(wallet.findByKeyPair(keyPair).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByKeyPairId(keyPair.keyPairId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(keyPair.publicKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKeyId(keyPair.privateKeyId()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKey(keyPair.privateKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.findByPublicKey("nobody"), KeyPairNotFoundException);
+}
+
+SCENARIO("Verify Wallet: list", "[wallet]")
+{
+  Wallet wallet(100);
+  set<KeyPairId> expected;
+  for (long n = 0; n < 100; ++n) expected.insert(wallet.store(SampleKeyPair(n)));
+  for (long n = 0; n < 100; n += 2) {
+    wallet.remove(SampleKeyPair(n).keyPairId());
+    expected.erase(SampleKeyPair(n).keyPairId());
+  }
+  KeyPairIdList keyPairIds = wallet.list();
+  REQUIRE(set<KeyPairId>(keyPairIds.begin(), keyPairIds.end()) == expected);
+
+  KeyPairIdVector keyPairIdVector = { 0 };
+  wallet.listInto(keyPairIdVector);
+  REQUIRE(keyPairIdVector.size() == expected.size() + 1);
+  REQUIRE(set<KeyPairId>(keyPairIdVector.begin() + 1, keyPairIdVector.end()) == expected);
+
+  set<KeyPairId> copied;
+  wallet.copyKeyPairIds(inserter(copied, copied.end()));
+  REQUIRE(copied == expected);
+}
+
+SCENARIO("Verify KeyPairIndex: insert, find, erase", "[wallet]")
+{
+  KeyPairIndex index;
+  for (KeyPairId id = 0; id < 10000; ++id) REQUIRE(index.insert(id * 7, static_cast<KeyPairIndex::Slot>(id)));
+  REQUIRE_FALSE(index.insert(7, 0));
+  for (KeyPairId id = 0; id < 10000; id += 3) REQUIRE(index.erase(id * 7));
+  for (KeyPairId id = 0; id < 10000; ++id) {
+    auto expected = (id % 3 == 0) ? KeyPairIndex::npos : static_cast<KeyPairIndex::Slot>(id);
+    REQUIRE(index.find(id * 7) == expected);
+  }
+}
+
+SCENARIO("Verify Wallet: findByPublicKey, findByPrivateKey using CRC32 ids", "[wallet]")
+{
+  Wallet wallet;
+  SampleKeyPair keyPair("some public key", "some private key");
+  wallet.store(keyPair);
+  REQUIRE(wallet.findByPublicKey("some public key").keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKey("some private key").keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.findByPrivateKey("some public key"), KeyPairNotFoundException);
+}
+
+SCENARIO("Verify Wallet: publicKeyId collisions", "[wallet]")
+{
+  Wallet wallet;
+  SampleKeyPair keyPair("key A", "secret A");
+  KeyPairId sharedId = keyPair.publicKeyId();
+  SampleKeyPair collision(1001, sharedId, privateKeyIdOf("secret B"), "key B", "secret B");
+  wallet.store(collision);
+  wallet.store(keyPair);
+  REQUIRE(wallet.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(1002, sharedId, 1003, "key A", "secret C")), KeyPairAlreadyExistsException);
+  wallet.remove(collision.keyPairId());
+  REQUIRE(wallet.findByPublicKey("key A").keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPublicKeyId(sharedId).keyPairId() == keyPair.keyPairId());
+}
+
+SCENARIO("Verify Wallet: KeyPairIdMode::Hash64", "[wallet]")
+{
+  Wallet wallet(KeyPairIdMode::Hash64);
+  REQUIRE(wallet.idMode() == KeyPairIdMode::Hash64);
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+  SampleKeyPair keyPair(77, KeyPairIdMode::Hash64);
+  REQUIRE(wallet.findByPublicKey(keyPair.publicKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.findByPrivateKey(keyPair.privateKey()).keyPairId() == keyPair.keyPairId());
+  REQUIRE_THROWS_AS(wallet.findByPublicKey(SampleKeyPair(77).publicKey().str() + "x"), KeyPairNotFoundException);
+}
+
+SCENARIO("Verify Wallet: tryRetrieve, tryFind...", "[wallet]")
+{
+  Wallet wallet;
+  SampleKeyPair keyPair(5);
+  wallet.store(keyPair);
+  REQUIRE(wallet.tryRetrieve(keyPair.keyPairId()) == &wallet.retrieve(keyPair.keyPairId()));
+  REQUIRE(wallet.tryFindByKeyPair(keyPair) == &wallet.retrieve(keyPair.keyPairId()));
+  REQUIRE(wallet.tryFindByKeyPairId(keyPair.keyPairId())->keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.tryFindByPublicKey(keyPair.publicKey())->keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.tryFindByPublicKeyId(keyPair.publicKeyId())->keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.tryFindByPrivateKey(keyPair.privateKey())->keyPairId() == keyPair.keyPairId());
+  REQUIRE(wallet.tryFindByPrivateKeyId(keyPair.privateKeyId())->keyPairId() == keyPair.keyPairId());
+
+  SampleKeyPair missing(6);
+  REQUIRE(wallet.tryRetrieve(missing.keyPairId()) == nullptr);
+  REQUIRE(wallet.tryFindByKeyPair(missing) == nullptr);
+  REQUIRE(wallet.tryFindByKeyPairId(missing.keyPairId()) == nullptr);
+  REQUIRE(wallet.tryFindByPublicKey(missing.publicKey()) == nullptr);
+  REQUIRE(wallet.tryFindByPublicKeyId(missing.publicKeyId()) == nullptr);
+  REQUIRE(wallet.tryFindByPrivateKey(missing.privateKey()) == nullptr);
+  REQUIRE(wallet.tryFindByPrivateKeyId(missing.privateKeyId()) == nullptr);
+}
+
+SCENARIO("Verify Wallet: findByPublicKey, findByPrivateKey straight out of a buffer", "[wallet]")
+{
+  for (KeyPairIdMode mode : { KeyPairIdMode::Crc32, KeyPairIdMode::Hash64 }) {
+    Wallet wallet(mode);
+    SampleKeyPair keyPair(5, mode);
+    wallet.store(keyPair);
+    string buffer = "header" + keyPair.publicKey().str() + keyPair.privateKey().str() + "trailer";
+    string_view publicKey(buffer.data() + 6, keyPair.publicKey().size());
+    string_view privateKey(publicKey.data() + publicKey.size(), keyPair.privateKey().size());
+    REQUIRE(wallet.tryFindByPublicKey(publicKey) == &wallet.retrieve(keyPair.keyPairId()));
+    REQUIRE(wallet.tryFindByPrivateKey(privateKey) == &wallet.retrieve(keyPair.keyPairId()));
+    REQUIRE(wallet.findByPublicKey(publicKey).keyPairId() == keyPair.keyPairId());
+    REQUIRE(wallet.findByPrivateKey(privateKey).keyPairId() == keyPair.keyPairId());
+    REQUIRE(wallet.tryFindByPublicKey(string_view(buffer.data() + 6, publicKey.size() - 1)) == nullptr);
+
+    // longer than any key, (not found rather than std::length_error)
+    REQUIRE(wallet.tryFindByPublicKey(buffer) == nullptr);
+    REQUIRE(wallet.tryFindByPrivateKey(buffer) == nullptr);
+    REQUIRE_THROWS_AS(wallet.findByPublicKey(buffer), KeyPairNotFoundException);
+  }
+}
+
+SCENARIO("Verify KeyPairNotFoundException: what()", "[wallet]")
+{
+  Wallet wallet;
+  try {
+    wallet.retrieve(-1234567890123L);
+    FAIL("KeyPairNotFoundException expected");
+  } catch (const KeyPairNotFoundException &ex) {
+    REQUIRE(string(ex.what()) == "-1234567890123");
+  }
+  REQUIRE(string(KeyPairAlreadyExistsException(42).what()) == "42");
+}
+
+SCENARIO("Verify Wallet: listPage, KeyPairIdPager", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 1000; ++n) wallet.store(SampleKeyPair(n));
+  for (long n = 0; n < 1000; n += 10) wallet.remove(SampleKeyPair(n).keyPairId());
+
+  KeyPairIdVector page;
+  KeyPairIdCursor cursor = wallet.listPage(firstPage, 64, page);
+  REQUIRE(page.size() == 64);
+  REQUIRE(cursor != noMorePages);
+
+  // a walk survives store() and remove() between pages
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(wallet, 64);
+  size_t pages = 0;
+  while (pager.next()) {
+    REQUIRE(pager.page().size() <= 64);
+    for (auto keyPairId : pager.page()) REQUIRE(seen.insert(keyPairId).second);
+    if (++pages == 3) {
+      wallet.remove(SampleKeyPair(999).keyPairId());
+      wallet.store(SampleKeyPair(2000));
+    }
+  }
+  REQUIRE(pager.cursor() == noMorePages);
+  for (long n = 1; n < 999; ++n)
+    if (n % 10 != 0) REQUIRE(seen.count(SampleKeyPair(n).keyPairId()) == 1);
+  REQUIRE(seen.count(SampleKeyPair(0).keyPairId()) == 0);
+
+  // and resumes from a saved cursor
+  KeyPairIdPager first(wallet, 100);
+  first.next();
+  KeyPairIdPager resumed(wallet, 100, first.cursor());
+  resumed.next();
+  REQUIRE(resumed.page().front() != first.page().front());
+}
+
+SCENARIO("Verify Wallet: listPage with a limit of 0", "[wallet]")
+{
+  Wallet wallet;
+  for (long n = 0; n < 10; ++n) wallet.store(SampleKeyPair(n));
+
+  KeyPairIdVector page;
+  KeyPairIdCursor cursor = wallet.listPage(firstPage, 0, page);
+  REQUIRE(page.size() == 1);
+  REQUIRE(cursor != firstPage);
+
+  // a pager with a limit of 0 still finishes its walk
+  set<KeyPairId> seen;
+  KeyPairIdPager pager(wallet, 0);
+  while (pager.next()) {
+    REQUIRE(pager.page().size() == 1);
+    seen.insert(pager.page().front());
+  }
+  REQUIRE(seen.size() == 10);
+}
+
+SCENARIO("Verify Wallet: storeMany, removeMany, findManyByPublicKeyId", "[wallet]")
+{
+  Wallet wallet;
+  vector<SampleKeyPair> keyPairs;
+  for (long n = 0; n < 500; ++n) keyPairs.emplace_back(n);
+  KeyPairBatch batch;
+  for (const auto &keyPair : keyPairs) batch.push_back(&keyPair);
+  batch.push_back(&keyPairs[7]);
+
+  WalletStatusVector results;
+  wallet.storeMany(batch, results);
+  REQUIRE(results.size() == batch.size());
+  REQUIRE(count(results.begin(), results.end(), WalletStatus::Ok) == 500);
+  REQUIRE(results.back() == WalletStatus::AlreadyExists);
+  REQUIRE(wallet.size() == 500);
+
+  KeyPairIdVector publicKeyIds = { keyPairs[3].publicKeyId(), 424242, keyPairs[499].publicKeyId() };
+  KeyPairBatch found;
+  wallet.findManyByPublicKeyId(publicKeyIds, found);
+  REQUIRE(found.size() == 3);
+  REQUIRE(found[0]->keyPairId() == keyPairs[3].keyPairId());
+  REQUIRE(found[1] == nullptr);
+  REQUIRE(found[2]->keyPairId() == keyPairs[499].keyPairId());
+
+  KeyPairIdVector keyPairIds;
+  for (long n = 0; n < 500; n += 2) keyPairIds.push_back(keyPairs[n].keyPairId());
+  keyPairIds.push_back(keyPairs[0].keyPairId());
+  wallet.removeMany(keyPairIds, results);
+  REQUIRE(count(results.begin(), results.end(), WalletStatus::Ok) == 250);
+  REQUIRE(results.back() == WalletStatus::NotFound);
+  REQUIRE(wallet.size() == 250);
+  REQUIRE(wallet.tryRetrieve(keyPairs[1].keyPairId()) != nullptr);
+}
+
+SCENARIO("Verify BlockedBloomFilter: no false negatives, false positive rate", "[wallet]")
+{
+  BlockedBloomFilter filter(BloomFilterOptions{ 0.01, 0 });
+  filter.reset(100000);
+  for (long n = 0; n < 100000; ++n) filter.add(n * 7919);
+  REQUIRE(filter.count() == 100000);
+  REQUIRE(filter.falsePositiveRate() <= 0.01);
+  REQUIRE(filter.memorySize() < 100000 * 2);
+  size_t falseNegatives = 0;
+  for (long n = 0; n < 100000; ++n) falseNegatives += !filter.mayContain(n * 7919);
+  REQUIRE(falseNegatives == 0);
+
+  size_t falsePositives = 0;
+  for (long n = 0; n < 100000; ++n) falsePositives += filter.mayContain(n * 7919 + 1);
+  REQUIRE(falsePositives > 0);
+  REQUIRE(falsePositives < 100000 * 0.02);
+
+  BlockedBloomFilter small(BloomFilterOptions{ 0.0001, 4096 });
+  small.reset(100000);
+  REQUIRE(small.memorySize() == 4096);
+  for (long n = 0; n < 100000; ++n) small.add(n);
+  REQUIRE(small.falsePositiveRate() > 0.0001);
+  REQUIRE(small.mayContain(12345));
+
+  small.reset(10);
+  REQUIRE(small.count() == 0);
+  REQUIRE_FALSE(small.mayContain(12345));
+}
+
+SCENARIO("Verify Wallet: BloomFilterOptions", "[wallet]")
+{
+  Wallet wallet(KeyPairIdMode::Crc32, 0, BloomFilterOptions{ 0.001, 0 });
+  REQUIRE(wallet.stats().filtered);
+  for (long n = 0; n < 5000; ++n) wallet.store(SampleKeyPair(n));
+  for (long n = 0; n < 5000; n += 3) wallet.remove(SampleKeyPair(n).keyPairId());
+  for (long n = 5000; n < 6000; ++n) wallet.store(SampleKeyPair(n));
+
+  for (long n = 0; n < 6000; ++n) {
+    SampleKeyPair keyPair(n);
+    bool stored = n >= 5000 || n % 3 != 0;
+    REQUIRE((wallet.tryFindByPublicKey(keyPair.publicKey()) != nullptr) == stored);
+    REQUIRE((wallet.tryFindByPrivateKey(keyPair.privateKey()) != nullptr) == stored);
+    REQUIRE((wallet.tryFindByPublicKeyId(keyPair.publicKeyId()) != nullptr) == stored);
+    REQUIRE((wallet.tryFindByPrivateKeyId(keyPair.privateKeyId()) != nullptr) == stored);
+  }
+  REQUIRE_THROWS_AS(wallet.findByPublicKey("not in the wallet"), KeyPairNotFoundException);
+  REQUIRE_THROWS_AS(wallet.store(SampleKeyPair(5001)), KeyPairAlreadyExistsException);
+  wallet.store(SampleKeyPair(3));
+
+  WalletStats stats = wallet.stats();
+  REQUIRE(stats.size == wallet.size());
+  REQUIRE(stats.filterCapacity >= wallet.size());
+  REQUIRE(stats.filterBytes > 0);
+  REQUIRE(stats.filterFalsePositiveRate <= 0.001);
+
+  Wallet plain;
+  plain.store(SampleKeyPair(1));
+  REQUIRE_FALSE(plain.stats().filtered);
+  REQUIRE(plain.stats().filterBytes == 0);
+}
+
+namespace {
+
+// counts what the Wallet asks of the heap
+class CountingResource : public std::pmr::memory_resource
+{
+  std::pmr::memory_resource *_upstream = std::pmr::new_delete_resource();
+
+public:
+  size_t allocations = 0;
+  size_t outstanding = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override
+  {
+    ++allocations;
+    outstanding += bytes;
+    return _upstream->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+  {
+    outstanding -= bytes;
+    _upstream->deallocate(pointer, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+}// namespace
+
+SCENARIO("Verify Wallet: records and indexes from a std::pmr::memory_resource", "[wallet]")
+{
+  CountingResource resource;
+  {
+    Wallet wallet(KeyPairIdMode::Hash64, 10000, &resource);
+    size_t reserved = resource.allocations;
+    REQUIRE(wallet.stats().recordBytes >= 10000 * sizeof(KeyPairRecord));
+    for (long n = 0; n < 10000; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    REQUIRE(resource.allocations == reserved);// nothing per KeyPair
+
+    // removed records make room for the next ones
+    size_t recordBytes = wallet.stats().recordBytes;
+    const KeyPairInterface *kept = &wallet.retrieve(SampleKeyPair(1, KeyPairIdMode::Hash64).keyPairId());
+    for (long n = 0; n < 10000; n += 2) wallet.remove(SampleKeyPair(n, KeyPairIdMode::Hash64).keyPairId());
+    for (long n = 10000; n < 15000; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    REQUIRE(wallet.stats().recordBytes == recordBytes);
+    REQUIRE(kept == &wallet.retrieve(SampleKeyPair(1, KeyPairIdMode::Hash64).keyPairId()));
+    REQUIRE(wallet.tryFindByPublicKey(SampleKeyPair(14999, KeyPairIdMode::Hash64).publicKey()) != nullptr);
+    REQUIRE(wallet.tryFindByPublicKey(SampleKeyPair(0, KeyPairIdMode::Hash64).publicKey()) == nullptr);
+
+    for (long n = 15000; n < 15300; ++n) wallet.store(SampleKeyPair(n, KeyPairIdMode::Hash64));
+    REQUIRE(wallet.stats().recordBytes > recordBytes);
+    KeyPairIdVector keyPairIds;
+    wallet.listInto(keyPairIds);
+    REQUIRE(keyPairIds.size() == 10300);
+  }
+  REQUIRE(resource.outstanding == 0);
+
+  std::pmr::monotonic_buffer_resource import;
+  Wallet imported(KeyPairIdMode::Crc32, 0, BloomFilterOptions{}, &import);
+  for (long n = 0; n < 3000; ++n) imported.store(SampleKeyPair(n));
+  REQUIRE(imported.size() == 3000);
+  REQUIRE(imported.findByPublicKey(SampleKeyPair(2999).publicKey()).keyPairId() == SampleKeyPair(2999).keyPairId());
+}
+
+SCENARIO("Verify Wallet: storeMany of many small batches", "[wallet]")
+{
+  CountingResource resource;
+  {
+    Wallet wallet(KeyPairIdMode::Crc32, 0, &resource);
+    vector<SampleKeyPair> keyPairs;
+    for (long n = 0; n < 20000; ++n) keyPairs.emplace_back(n);
+    WalletStatusVector results;
+    for (const auto &keyPair : keyPairs) {
+      wallet.storeMany(KeyPairBatch{ &keyPair }, results);
+      REQUIRE(results[0] == WalletStatus::Ok);
+    }
+    REQUIRE(wallet.size() == 20000);
+    // the storage grows twofold, (not once per batch)
+    REQUIRE(resource.allocations < 200);
+  }
+  REQUIRE(resource.outstanding == 0);
+}